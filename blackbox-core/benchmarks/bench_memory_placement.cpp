@@ -0,0 +1,177 @@
+/**
+ * @file bench_memory_placement.cpp
+ * @brief Ingest-ring-sized buffer: heap vs huge-page mapping.
+ *
+ * A 65536-slot array of LogEvent (~256 MB, the ingest ring) is allocated
+ * three ways:
+ *  1. heap:     std::vector (what the ring used before),
+ *  2. mapped:   MappedArray with huge pages off (4 KB pages, prefaulted),
+ *  3. huge:     MappedArray with the default policy (hugetlb or THP).
+ *
+ * Each is then swept like the ring (write a ~300 byte message per slot,
+ * read it back) and probed at random slots (the pool/recent-store access
+ * pattern). Reported per pass: ns per slot and dTLB load misses per slot
+ * from perf_event_open ("n/a" when perf is not permitted, e.g.
+ * perf_event_paranoid > 1 in containers).
+ */
+
+#include "blackbox/common/memory.h"
+#include "blackbox/common/settings.h"
+#include "blackbox/ingest/ring_buffer.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace blackbox;
+
+namespace {
+
+    constexpr size_t SLOTS = 65536;
+    constexpr size_t MESSAGE_BYTES = 300;
+    constexpr size_t RANDOM_PROBES = 4 * SLOTS;
+    constexpr int PASSES = 3;
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // dTLB read misses of this thread; -1 fd if perf is unavailable
+    class DtlbCounter {
+    public:
+        DtlbCounter() {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+        ~DtlbCounter() { if (fd_ >= 0) close(fd_); }
+
+        bool available() const { return fd_ >= 0; }
+
+        void start() {
+            if (fd_ < 0) return;
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+
+        uint64_t stop() {
+            if (fd_ < 0) return 0;
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t count = 0;
+            if (read(fd_, &count, sizeof(count)) != sizeof(count)) return 0;
+            return count;
+        }
+
+    private:
+        int fd_ = -1;
+    };
+
+    struct Pass {
+        double ns_per_slot = 0;
+        double misses_per_slot = 0;
+    };
+
+    volatile uint64_t g_sink = 0;
+
+    // Producer write + consumer read of every slot, in ring order
+    Pass sweep(ingest::LogEvent* slots, DtlbCounter& dtlb, const char* message) {
+        dtlb.start();
+        const uint64_t start = now_ns();
+        for (size_t i = 0; i < SLOTS; ++i) {
+            ingest::LogEvent& e = slots[i];
+            e.timestamp_ns = i;
+            std::memcpy(e.raw_data, message, MESSAGE_BYTES);
+            e.length = MESSAGE_BYTES;
+            e.sample_weight = 1;
+        }
+        uint64_t sum = 0;
+        for (size_t i = 0; i < SLOTS; ++i) {
+            const ingest::LogEvent& e = slots[i];
+            sum += e.length + static_cast<unsigned char>(e.raw_data[e.length / 2]);
+        }
+        const uint64_t elapsed = now_ns() - start;
+        const uint64_t misses = dtlb.stop();
+        g_sink = g_sink + sum;
+        return {static_cast<double>(elapsed) / (2 * SLOTS), static_cast<double>(misses) / (2 * SLOTS)};
+    }
+
+    // Header read at random slots
+    Pass probe(ingest::LogEvent* slots, DtlbCounter& dtlb, const std::vector<uint32_t>& order) {
+        dtlb.start();
+        const uint64_t start = now_ns();
+        uint64_t sum = 0;
+        for (uint32_t index : order) sum += slots[index].length;
+        const uint64_t elapsed = now_ns() - start;
+        const uint64_t misses = dtlb.stop();
+        g_sink = g_sink + sum;
+        return {static_cast<double>(elapsed) / order.size(), static_cast<double>(misses) / order.size()};
+    }
+
+    std::string misses(const DtlbCounter& dtlb, double value) {
+        if (!dtlb.available()) return "n/a";
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.3f", value);
+        return buf;
+    }
+
+    void report(const char* name, ingest::LogEvent* slots, const std::vector<uint32_t>& order) {
+        DtlbCounter dtlb;
+        char message[MESSAGE_BYTES];
+        std::memset(message, 'x', sizeof(message));
+
+        for (int pass = 0; pass < PASSES; ++pass) {
+            const Pass s = sweep(slots, dtlb, message);
+            const Pass p = probe(slots, dtlb, order);
+            std::printf("%-8s %4d %14.2f %14s %14.2f %14s\n", name, pass + 1,
+                        s.ns_per_slot, misses(dtlb, s.misses_per_slot).c_str(),
+                        p.ns_per_slot, misses(dtlb, p.misses_per_slot).c_str());
+        }
+    }
+
+} // namespace
+
+int main() {
+    common::Settings::instance().load_from_env();
+
+    std::vector<uint32_t> order(RANDOM_PROBES);
+    std::mt19937 rng(42);
+    for (auto& index : order) index = static_cast<uint32_t>(rng() % SLOTS);
+
+    std::printf("%zu slots x %zu bytes = %zu MB\n\n", SLOTS, sizeof(ingest::LogEvent),
+                SLOTS * sizeof(ingest::LogEvent) / (1024 * 1024));
+    std::printf("%-8s %4s %14s %14s %14s %14s\n", "buffer", "pass",
+                "sweep ns/slot", "sweep dTLB", "probe ns/slot", "probe dTLB");
+
+    {
+        std::vector<ingest::LogEvent> heap(SLOTS);
+        report("heap", heap.data(), order);
+    }
+    {
+        common::MemoryPolicy policy;
+        policy.huge_pages = false;
+        common::MappedArray<ingest::LogEvent> mapped(SLOTS, policy, "4K mapping");
+        report("mapped", mapped.data(), order);
+    }
+    {
+        common::MemoryPolicy policy = common::MemoryPolicy::for_cpu(0);
+        common::MappedArray<ingest::LogEvent> huge(SLOTS, policy, "Huge mapping");
+        std::printf("(huge: %s pages%s)\n", common::MappedRegion::backing_name(huge.region().backing()),
+                    huge.region().numa_bound() ? ", NUMA bound" : "");
+        report("huge", huge.data(), order);
+    }
+    return 0;
+}
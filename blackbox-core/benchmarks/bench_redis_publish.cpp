@@ -0,0 +1,140 @@
+/**
+ * @file bench_redis_publish.cpp
+ * @brief Alert publish latency against a local redis-server.
+ *
+ * Measures the caller-side cost of RedisClient::publish (what the
+ * processing thread pays) and the end-to-end latency seen by a
+ * subscriber, for a paced stream and for an attack-style burst.
+ *
+ *   redis-server --save "" &
+ *   ./bench_redis_publish            # BLACKBOX_REDIS_HOST / _PORT override
+ */
+
+#include "blackbox/storage/redis_client.h"
+#include "blackbox/common/logger.h"
+#include "blackbox/common/time_utils.h"
+#include <hiredis/hiredis.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace blackbox;
+
+namespace {
+
+    constexpr const char* CHANNEL = "bench_alerts";
+
+    // Typical alert size: header fields + a syslog line
+    std::string make_alert(uint64_t seq) {
+        std::string json = "{\"seq\":" + std::to_string(seq) +
+                           ",\"t\":" + std::to_string(common::TimeUtils::now_ns()) +
+                           ",\"ip\":\"203.0.113.7\",\"score\":0.97,\"reason\":\"AI Anomaly Detection\","
+                           "\"country\":\"DE\",\"msg\":\"";
+        json.append(220, 'x');
+        json += "\"}";
+        return json;
+    }
+
+    uint64_t field(const char* json, const char* key) {
+        const char* p = std::strstr(json, key);
+        return p ? std::strtoull(p + std::strlen(key), nullptr, 10) : 0;
+    }
+
+    struct Subscriber {
+        redisContext* ctx = nullptr;
+        std::vector<uint64_t> latencies_ns;
+        std::atomic<uint64_t> received{0};
+        std::thread thread;
+
+        bool start(const char* host, int port) {
+            struct timeval timeout = {0, 200000};
+            ctx = redisConnectWithTimeout(host, port, timeout);
+            if (!ctx || ctx->err) return false;
+
+            auto* reply = static_cast<redisReply*>(redisCommand(ctx, "SUBSCRIBE %s", CHANNEL));
+            if (!reply) return false;
+            freeReplyObject(reply);
+            redisSetTimeout(ctx, timeout);
+
+            latencies_ns.reserve(1 << 20);
+            thread = std::thread([this] {
+                while (true) {
+                    void* r = nullptr;
+                    if (redisGetReply(ctx, &r) != REDIS_OK || !r) break; // Timeout = done
+                    auto* msg = static_cast<redisReply*>(r);
+                    if (msg->elements == 3 && msg->element[2]->str) {
+                        uint64_t sent = field(msg->element[2]->str, "\"t\":");
+                        latencies_ns.push_back(common::TimeUtils::now_ns() - sent);
+                        received.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    freeReplyObject(msg);
+                }
+            });
+            return true;
+        }
+
+        void stop() {
+            if (thread.joinable()) thread.join();
+            redisFree(ctx);
+        }
+    };
+
+    uint64_t percentile(std::vector<uint64_t>& v, double p) {
+        if (v.empty()) return 0;
+        size_t idx = std::min(v.size() - 1, static_cast<size_t>(p * v.size()));
+        std::nth_element(v.begin(), v.begin() + idx, v.end());
+        return v[idx];
+    }
+
+    void run(const char* label, const char* host, int port, size_t count, std::chrono::microseconds gap) {
+        Subscriber sub;
+        if (!sub.start(host, port)) {
+            std::printf("%-8s cannot connect to redis at %s:%d\n", label, host, port);
+            return;
+        }
+
+        storage::RedisClient client(host, port);
+        while (!client.is_connected()) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        uint64_t enqueue_ns = 0;
+        for (size_t i = 0; i < count; ++i) {
+            // Rendering is not timed: only what publish() costs the caller
+            const std::string alert = make_alert(i);
+            auto t0 = std::chrono::steady_clock::now();
+            client.publish(CHANNEL, alert);
+            enqueue_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0).count();
+            if (gap.count() > 0) std::this_thread::sleep_for(gap);
+        }
+
+        sub.stop(); // Returns once the subscriber times out (stream drained)
+
+        std::printf("%-8s %8zu %10.1f %10.1f %10.1f %10.1f %9llu %9llu\n",
+                    label, count,
+                    static_cast<double>(enqueue_ns) / count,
+                    percentile(sub.latencies_ns, 0.50) / 1000.0,
+                    percentile(sub.latencies_ns, 0.99) / 1000.0,
+                    percentile(sub.latencies_ns, 1.0) / 1000.0,
+                    static_cast<unsigned long long>(client.published()),
+                    static_cast<unsigned long long>(client.dropped()));
+    }
+
+} // namespace
+
+int main() {
+    const char* host = std::getenv("BLACKBOX_REDIS_HOST") ? std::getenv("BLACKBOX_REDIS_HOST") : "127.0.0.1";
+    const int port = std::getenv("BLACKBOX_REDIS_PORT") ? std::atoi(std::getenv("BLACKBOX_REDIS_PORT")) : 6379;
+    common::Logger::instance().set_level(common::LogLevel::WARN);
+
+    std::printf("%-8s %8s %10s %10s %10s %10s %9s %9s\n",
+                "mode", "alerts", "enq ns", "p50 us", "p99 us", "max us", "published", "dropped");
+    run("paced", host, port, 20000, std::chrono::microseconds(50));
+    run("burst", host, port, 100000, std::chrono::microseconds(0));
+    return 0;
+}
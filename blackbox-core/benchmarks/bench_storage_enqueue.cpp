@@ -0,0 +1,102 @@
+/**
+ * @file bench_storage_enqueue.cpp
+ * @brief Measures StorageEngine::enqueue cost per row at 1, 4 and 16 producers.
+ *
+ * The flusher ships to BLACKBOX_CLICKHOUSE_URL. Point it at a local
+ * ClickHouse (docker compose up clickhouse) for realistic recycling;
+ * without a server the batches go to the disk spool, or are dropped
+ * once it is full (both show in the metrics printed at the end). The
+ * spool is a fresh temporary directory per run, removed afterwards, so
+ * runs neither leave data behind nor replay each other's.
+ */
+
+#include "blackbox/storage/storage_engine.h"
+#include "blackbox/common/settings.h"
+#include "blackbox/common/logger.h"
+#include "blackbox/common/metrics.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace blackbox;
+
+namespace {
+
+    constexpr size_t ROWS_PER_PRODUCER = 200000;
+
+    parser::ParsedLog make_log() {
+        parser::ParsedLog log{};
+        log.timestamp = 1700000000000000000ull;
+        log.id = common::IdGenerator::uuid_v7(log.timestamp / 1000000);
+        log.host = "192.168.1.50";
+        log.service = "sshd";
+        log.message = "Failed password for invalid user admin from 203.0.113.7 port 52144 ssh2";
+        log.country = "DE";
+        return log;
+    }
+
+    double run(size_t producers) {
+        // Declared before the engine: removes its spool after it has shut down
+        struct SpoolCleanup {
+            ~SpoolCleanup() {
+                std::error_code ec;
+                std::filesystem::remove_all(common::Settings::instance().db().spool_dir, ec);
+            }
+        } cleanup;
+        storage::StorageEngine engine;
+        std::vector<double> ns_per_row(producers, 0.0);
+        std::vector<std::thread> threads;
+
+        for (size_t t = 0; t < producers; ++t) {
+            threads.emplace_back([&engine, &ns_per_row, t] {
+                const parser::ParsedLog log = make_log();
+
+                // Warm-up: registers the producer and faults in its arenas
+                for (size_t i = 0; i < 4096; ++i) engine.enqueue(log, 0.5f);
+
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < ROWS_PER_PRODUCER; ++i) {
+                    engine.enqueue(log, 0.5f);
+                }
+                auto end = std::chrono::steady_clock::now();
+
+                ns_per_row[t] = std::chrono::duration<double, std::nano>(end - start).count() /
+                                ROWS_PER_PRODUCER;
+                engine.flush_local();
+            });
+        }
+        for (auto& th : threads) th.join();
+
+        double sum = 0.0;
+        for (double v : ns_per_row) sum += v;
+        return sum / producers;
+    }
+
+} // namespace
+
+int main() {
+    // Fail fast when no ClickHouse is listening
+    setenv("BLACKBOX_DB_MAX_RETRIES", "1", 0);
+
+    char spool_dir[] = "/tmp/bench_spool.XXXXXX";
+    if (!mkdtemp(spool_dir)) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    setenv("BLACKBOX_SPOOL_DIR", spool_dir, 1);
+    common::Settings::instance().load_from_env();
+    common::Logger::instance().set_level(common::LogLevel::WARN);
+
+    std::printf("%-10s %14s\n", "producers", "ns/row (avg)");
+    for (size_t producers : {1, 4, 16}) {
+        double ns = run(producers);
+        std::printf("%-10zu %14.1f\n", producers, ns);
+    }
+
+    std::printf("\n%s", common::Metrics::instance().get_prometheus_metrics().c_str());
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file bench_time_utils.cpp
+ * @brief TimeUtils formatting / parsing against the previous libc-based versions.
+ *
+ * The legacy_* functions are copies of the implementations
+ * they replaced (gmtime_r + snprintf, stringstream + mktime), kept here
+ * so the comparison stays reproducible.
+ */
+
+#include "blackbox/common/time_utils.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace blackbox;
+
+namespace {
+
+    constexpr size_t ITERATIONS = 2000000;
+
+    std::string legacy_to_clickhouse_format(uint64_t timestamp_ms) {
+        std::time_t seconds = static_cast<std::time_t>(timestamp_ms / 1000);
+        struct std::tm tm_buf;
+        gmtime_r(&seconds, &tm_buf);
+        char buffer[80]; // Sized for any int fields (silences -Wformat-truncation)
+        std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d",
+                      tm_buf.tm_year + 1900, tm_buf.tm_mon + 1, tm_buf.tm_mday,
+                      tm_buf.tm_hour, tm_buf.tm_min, tm_buf.tm_sec);
+        return std::string(buffer);
+    }
+
+    uint64_t legacy_parse_syslog_time(const std::string& date_str) {
+        std::tm tm_buf = {};
+        auto t = std::time(nullptr);
+        struct std::tm now_tm;
+        localtime_r(&t, &now_tm);
+
+        std::stringstream ss(date_str);
+        static const std::unordered_map<std::string, int> months = {
+            {"Jan", 0}, {"Feb", 1}, {"Mar", 2}, {"Apr", 3}, {"May", 4}, {"Jun", 5},
+            {"Jul", 6}, {"Aug", 7}, {"Sep", 8}, {"Oct", 9}, {"Nov", 10}, {"Dec", 11}
+        };
+        std::string mon_str;
+        int day, hour, min, sec;
+        char sep;
+        ss >> mon_str >> day >> hour >> sep >> min >> sep >> sec;
+        if (months.find(mon_str) != months.end()) tm_buf.tm_mon = months.at(mon_str);
+        tm_buf.tm_mday = day;
+        tm_buf.tm_hour = hour;
+        tm_buf.tm_min = min;
+        tm_buf.tm_sec = sec;
+        tm_buf.tm_year = now_tm.tm_year;
+        tm_buf.tm_isdst = -1;
+        time_t result = std::mktime(&tm_buf);
+        if (result > t + (86400 * 2)) {
+            tm_buf.tm_year -= 1;
+            result = std::mktime(&tm_buf);
+        }
+        return static_cast<uint64_t>(result) * 1000;
+    }
+
+    template <typename Fn>
+    double ns_per_op(Fn&& fn) {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < ITERATIONS; ++i) fn(i);
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+    }
+
+    void report(const char* name, double legacy_ns, double new_ns) {
+        std::printf("%-22s %12.1f %12.1f %9.1fx\n", name, legacy_ns, new_ns, legacy_ns / new_ns);
+    }
+
+} // namespace
+
+int main() {
+    // Rows of one busy second-ish window: 1 ms apart, same day
+    const uint64_t base_ms = 1700000000000ull;
+    const uint64_t now_ns = common::TimeUtils::now_ns();
+
+    std::vector<std::string> syslog_dates;
+    const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    for (int i = 0; i < 1024; ++i) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%s %2d %02d:%02d:%02d", months[i % 12], 1 + i % 28, i % 24, i % 60, (i * 7) % 60);
+        syslog_dates.emplace_back(buf);
+    }
+    const std::string rfc3339 = "2024-11-14T22:13:20.123456+01:00";
+
+    size_t sink = 0;
+    char out[common::TimeUtils::CLICKHOUSE_MS_LENGTH];
+
+    std::printf("%-22s %12s %12s %10s\n", "operation", "legacy ns", "new ns", "speedup");
+
+    report("clickhouse format",
+           ns_per_op([&](size_t i) { sink += legacy_to_clickhouse_format(base_ms + i).size(); }),
+           ns_per_op([&](size_t i) {
+               common::TimeUtils::format_clickhouse_ms(base_ms + i, out);
+               sink += static_cast<size_t>(out[18]);
+           }));
+
+    report("syslog parse",
+           ns_per_op([&](size_t i) { sink += legacy_parse_syslog_time(syslog_dates[i & 1023]); }),
+           ns_per_op([&](size_t i) { sink += common::TimeUtils::parse_rfc3164(syslog_dates[i & 1023], now_ns); }));
+
+    std::printf("%-22s %12s %12.1f\n", "rfc3339 parse", "-",
+                ns_per_op([&](size_t) { sink += common::TimeUtils::parse_rfc3339(rfc3339); }));
+
+    return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file bench_wait_strategy.cpp
+ * @brief Consumer wake-up latency vs idle CPU for each wait mode.
+ *
+ * For every preset a consumer thread waits on an SPSC queue:
+ *  1. idle:    nothing arrives for IDLE_SECONDS; the consumer's own CPU
+ *              time over that period is reported as % of one core.
+ *  2. wake-up: single messages arrive after a fixed gap; the delay from
+ *              push to pop is reported (p50 / p99) per gap. Short gaps
+ *              land in the spin phase, long ones after the consumer parked.
+ *
+ * "yield" reproduces the previous loop (std::this_thread::yield forever).
+ * Results depend heavily on core count: with a single core, spinning
+ * consumers also delay the producer.
+ */
+
+#include "blackbox/common/spsc_queue.h"
+#include "blackbox/common/wait_strategy.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace blackbox;
+
+namespace {
+
+    constexpr double IDLE_SECONDS = 1.0;
+    constexpr size_t SAMPLES_PER_GAP = 500;
+    constexpr uint64_t STOP = ~uint64_t(0);
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    uint64_t thread_cpu_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    struct Channel {
+        common::SpscQueue<uint64_t, 1024> queue;
+        common::Parker parker;
+
+        void send(uint64_t value) {
+            while (!queue.try_push(value)) std::this_thread::yield();
+            parker.notify();
+        }
+    };
+
+    struct Result {
+        double idle_cpu_percent = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> p50_p99; // Per gap
+        uint64_t parks = 0;
+    };
+
+    Result run(const common::WaitPolicy& policy, const std::vector<std::chrono::microseconds>& gaps) {
+        Channel channel;
+        std::vector<uint64_t> latencies;
+        latencies.reserve(SAMPLES_PER_GAP * gaps.size());
+        std::atomic<uint64_t> idle_cpu_ns{0};
+
+        std::thread consumer([&] {
+            common::WaitStrategy waiter(policy);
+            uint64_t value;
+            const uint64_t cpu_start = thread_cpu_ns();
+            bool idle_measured = false;
+
+            for (;;) {
+                if (!channel.queue.try_pop(value)) {
+                    waiter.idle(channel.parker, [&] { return !channel.queue.empty(); });
+                    continue;
+                }
+                waiter.reset();
+
+                // The first message marks the end of the idle phase
+                if (!idle_measured) {
+                    idle_cpu_ns = thread_cpu_ns() - cpu_start;
+                    idle_measured = true;
+                    continue;
+                }
+                if (value == STOP) break;
+                latencies.push_back(now_ns() - value);
+            }
+        });
+
+        // 1. Idle phase
+        std::this_thread::sleep_for(std::chrono::duration<double>(IDLE_SECONDS));
+        channel.send(0);
+
+        // 2. Wake-up phase
+        for (auto gap : gaps) {
+            for (size_t i = 0; i < SAMPLES_PER_GAP; ++i) {
+                const uint64_t until = now_ns() + static_cast<uint64_t>(gap.count()) * 1000;
+                if (gap.count() >= 200) {
+                    std::this_thread::sleep_for(gap);
+                } else {
+                    while (now_ns() < until) common::cpu_relax();
+                }
+                channel.send(now_ns());
+            }
+        }
+        channel.send(STOP);
+        consumer.join();
+
+        Result result;
+        result.idle_cpu_percent = 100.0 * static_cast<double>(idle_cpu_ns.load()) / (IDLE_SECONDS * 1e9);
+        result.parks = channel.parker.parks();
+        for (size_t g = 0; g < gaps.size(); ++g) {
+            auto first = latencies.begin() + static_cast<std::ptrdiff_t>(g * SAMPLES_PER_GAP);
+            auto last = first + static_cast<std::ptrdiff_t>(SAMPLES_PER_GAP);
+            std::sort(first, last);
+            result.p50_p99.emplace_back(first[SAMPLES_PER_GAP / 2], first[SAMPLES_PER_GAP * 99 / 100]);
+        }
+        return result;
+    }
+
+} // namespace
+
+int main() {
+    const std::vector<std::chrono::microseconds> gaps = {
+        std::chrono::microseconds(10), std::chrono::microseconds(200), std::chrono::microseconds(5000)};
+
+    std::printf("cores: %u, idle window %.1f s, %zu samples per gap\n\n",
+                std::thread::hardware_concurrency(), IDLE_SECONDS, SAMPLES_PER_GAP);
+    std::printf("%-9s %9s %8s", "mode", "idle cpu", "parks");
+    for (auto gap : gaps) {
+        std::printf("  %14s", ("gap " + std::to_string(gap.count()) + "us p50/p99").c_str());
+    }
+    std::printf("   (wake-up, us)\n");
+
+    const common::WaitPolicy legacy_yield{0, 0, false, std::chrono::microseconds(0)};
+    const std::pair<const char*, common::WaitPolicy> modes[] = {
+        {"yield", legacy_yield},
+        {"spin", common::WaitPolicy::from_name("spin")},
+        {"latency", common::WaitPolicy::from_name("latency")},
+        {"balanced", common::WaitPolicy::from_name("balanced")},
+        {"power", common::WaitPolicy::from_name("power")},
+    };
+
+    for (const auto& [name, policy] : modes) {
+        const Result r = run(policy, gaps);
+        std::printf("%-9s %8.1f%% %8llu", name, r.idle_cpu_percent, static_cast<unsigned long long>(r.parks));
+        for (const auto& [p50, p99] : r.p50_p99) {
+            std::printf("  %6.1f / %6.1f", p50 / 1000.0, p99 / 1000.0);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file alert_dispatcher.h
+ * @brief Alert Aggregation and Rate-Shaped Dispatch Stage.
+ *
+ * The processing thread only copies a compact AlertRecord into an SPSC
+ * queue. A dedicated dispatcher thread hands every record to AlertManager
+ * (dedup, active defense) as it dequeues it, so a block never waits for
+ * a window or a token. It then folds the record into one aggregate per
+ * (source, reason) for a short window and emits a summary: count,
+ * first/last seen, max score and what active defense did.
+ *
+ * Each summary goes to:
+ *  - the log:   token-bucket shaped
+ *  - Redis:     token-bucket shaped
+ *
+ * During a flood, thousands of hosts crossing the threshold cost the
+ * processing thread one memcpy each, and the sinks see at most their
+ * configured rate. Summaries over budget are counted, not queued.
+ */
+
+#ifndef BLACKBOX_ANALYSIS_ALERT_DISPATCHER_H
+#define BLACKBOX_ANALYSIS_ALERT_DISPATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "blackbox/common/spsc_queue.h"
+#include "blackbox/ingest/rate_limiter.h" // TokenBucket
+#include "blackbox/storage/redis_client.h"
+
+namespace blackbox::analysis {
+
+    /**
+     * @brief One threshold crossing, stored inline (longer fields are truncated).
+     */
+    struct AlertRecord {
+        uint64_t timestamp_ns;
+        float score;
+        uint8_t source_len;
+        uint8_t reason_len;
+        uint16_t message_len;
+        char country[4];
+        char source[46];     // INET6_ADDRSTRLEN
+        char reason[64];
+        char message[256];   // Sample shown on the dashboard
+    };
+
+    class AlertDispatcher {
+    public:
+        /**
+         * @brief Starts the dispatcher thread.
+         * @param redis Dashboard publisher (may be null: Redis sink disabled)
+         * @param channel Redis channel for summaries
+         */
+        AlertDispatcher(storage::RedisClient* redis, std::string channel);
+
+        /**
+         * @brief Emits what is still aggregated and stops the thread.
+         */
+        ~AlertDispatcher();
+
+        AlertDispatcher(const AlertDispatcher&) = delete;
+        AlertDispatcher& operator=(const AlertDispatcher&) = delete;
+
+        /**
+         * @brief Queue one alert. Never blocks, never allocates.
+         * Single producer: call from the processing thread only.
+         * @return false if the queue was full (alert dropped and counted)
+         */
+        bool submit(std::string_view source, std::string_view reason, float score,
+                    uint64_t timestamp_ns, std::string_view country, std::string_view message);
+
+        size_t queued() const { return queue_->size(); }
+
+    private:
+        static constexpr size_t QUEUE_DEPTH = 4096;     // ~1.6 MB of records
+        static constexpr size_t MAX_AGGREGATES = 16384; // Open (source, reason) windows
+
+        struct Aggregate {
+            std::string source;
+            std::string reason;
+            std::string country;
+            std::string message;            // From the first record
+            uint64_t count = 0;
+            uint64_t first_seen_ns = 0;
+            uint64_t last_seen_ns = 0;
+            float max_score = 0.0f;
+            uint64_t alerted = 0;           // Records AlertManager alerted on
+            uint64_t blocked = 0;           // ... and blocked (distinct sources under "*")
+        };
+
+        // Windows close in the order they opened (fixed length)
+        struct Deadline {
+            std::chrono::steady_clock::time_point at;
+            std::string key;
+        };
+
+        void dispatcher_worker();
+
+        // Runs active defense for one record, then folds it into its
+        // aggregate (opens a window if needed)
+        void fold(const AlertRecord& record, std::chrono::steady_clock::time_point now);
+
+        // Emits every aggregate whose window closed (all if 'everything')
+        void flush_due(std::chrono::steady_clock::time_point now, bool everything);
+
+        void emit(const Aggregate& summary, std::chrono::steady_clock::time_point now);
+
+        static bool take_token(ingest::TokenBucket& bucket, std::chrono::steady_clock::time_point now);
+
+        storage::RedisClient* redis_;
+        std::string channel_;
+        std::chrono::milliseconds window_;
+
+        // Processing thread -> dispatcher
+        std::unique_ptr<common::SpscQueue<AlertRecord, QUEUE_DEPTH>> queue_;
+        std::atomic<bool> running_{true};
+        std::atomic<bool> idle_{false};        // Dispatcher is (about to be) waiting
+        std::mutex wake_mutex_;
+        std::condition_variable wake_cv_;
+
+        // Dispatcher thread only
+        std::unordered_map<std::string, Aggregate> open_;
+        std::deque<Deadline> deadlines_;
+        ingest::TokenBucket log_bucket_;
+        ingest::TokenBucket redis_bucket_;
+        std::vector<char> json_buffer_;
+
+        std::thread dispatcher_thread_;
+    };
+
+} // namespace blackbox::analysis
+
+#endif // BLACKBOX_ANALYSIS_ALERT_DISPATCHER_H
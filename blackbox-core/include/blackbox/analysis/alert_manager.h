@@ -3,20 +3,24 @@
  * @brief Active Defense & Incident Response System.
  * 
  * Handles immediate reactions to Critical Threats.
- * Includes logic to prevent alert spam (Deduplication).
+ * Includes logic to prevent alert spam (Deduplication): a fixed-size,
+ * lock-free cooldown table keyed by binary source IP and rule.
  */
 
 #ifndef BLACKBOX_ANALYSIS_ALERT_MANAGER_H
 #define BLACKBOX_ANALYSIS_ALERT_MANAGER_H
 
+#include <cstdint>
 #include <string>
 #include <string_view>
-#include <unordered_map>
-#include <chrono>
-#include <mutex>
+#include "blackbox/analysis/cooldown_table.h"
 
 namespace blackbox::analysis {
 
+    // What trigger_alert did. It logs nothing itself: the caller reports
+    // the outcome through its own (rate-shaped) log sink.
+    enum class AlertOutcome { Suppressed, Alerted, Blocked };
+
     class AlertManager {
     public:
         // Singleton pattern to maintain global deduplication state
@@ -30,33 +34,35 @@ namespace blackbox::analysis {
          * 
          * @param source_ip The attacker's IP
          * @param score The anomaly score (0.0 - 1.0)
-         * @param message The raw log message
+         * @param message The alert reason (rule name or detector); alerts are
+         *                deduplicated per source and reason
+         * @return Suppressed (below threshold or in cooldown), Alerted, or
+         *         Blocked (ban queued)
          */
-        void trigger_alert(std::string_view source_ip, float score, std::string_view message);
+        AlertOutcome trigger_alert(std::string_view source_ip, float score, std::string_view message);
 
     private:
-        AlertManager() = default;
+        AlertManager();
 
         /**
-         * @brief Execute a system command to block the IP.
+         * @brief Hand the IP to the BlockListManager for a firewall ban.
          * WARNING: Only runs if configuration allows active blocking.
          */
         void execute_block_action(const std::string& ip);
 
         /**
-         * @brief Checks if we have already alerted on this IP recently.
+         * @brief Checks if we have already alerted on this source/reason recently.
          * @return true if we should alert, false if we are in cooldown.
          */
-        bool should_trigger(const std::string& ip);
-
-        // STATE
-        // Map of IP Address -> Last Alert Timestamp
-        std::unordered_map<std::string, std::chrono::steady_clock::time_point> cooldown_map_;
-        std::mutex map_mutex_;
+        bool should_trigger(std::string_view source, std::string_view reason);
 
         // CONFIG
-        const int COOLDOWN_SECONDS = 300; // 5 Minutes
+        static constexpr int COOLDOWN_SECONDS = 300; // 5 Minutes
         const float CRITICAL_THRESHOLD = 0.95f;
+
+        // STATE
+        // (Source IP, rule) -> Last Alert Timestamp. Fixed memory, no lock.
+        CooldownTable cooldown_;
     };
 
 } // namespace blackbox::analysis
@@ -5,6 +5,15 @@
  * Manages the lifecycle of Active Defense blocks.
  * Automatically removes bans after a cooldown period to prevent
  * firewall table exhaustion and permanent false positives.
+ *
+ * Callers never touch the firewall: block/unblock record the state and
+ * queue an operation. A dedicated thread coalesces everything queued
+ * within a few milliseconds into one FirewallBackend transaction.
+ *
+ * Bans are keyed by binary address (common::IpKey). Expiry uses a
+ * min-heap of deadlines with lazy deletion: the expiry thread sleeps
+ * until the earliest deadline and only touches bans that are due, so
+ * expiring costs O(expired log n) regardless of how many bans exist.
  */
 
 #ifndef BLACKBOX_ANALYSIS_BLOCK_LIST_MANAGER_H
@@ -12,17 +21,24 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include <queue>
+#include <memory>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include "blackbox/analysis/firewall_backend.h"
+#include "blackbox/common/ip_address.h"
 
 namespace blackbox::analysis {
 
     struct BlockEntry {
-        std::string ip;
         std::chrono::steady_clock::time_point start_time;
+        std::chrono::steady_clock::time_point expires_at;
         int duration_seconds;
+        uint64_t generation; // Matches the live heap entry (older ones are stale)
     };
 
     class BlockListManager {
@@ -37,42 +53,74 @@ namespace blackbox::analysis {
         /**
          * @brief Ban an IP address at the OS level.
          *
-         * @param ip The IPv4 string
+         * @param ip The IPv4 or IPv6 string
          * @param duration_seconds How long to ban (default 600s = 10 mins)
          */
         void block_ip(const std::string& ip, int duration_seconds = 600);
+        void block_ip(const common::IpKey& ip, int duration_seconds = 600);
 
         /**
          * @brief Manually remove a ban.
          */
         void unblock_ip(const std::string& ip);
+        void unblock_ip(const common::IpKey& ip);
 
         /**
          * @brief Check if an IP is currently blocked by us.
          */
         bool is_blocked(const std::string& ip);
+        bool is_blocked(const common::IpKey& ip);
+
+        size_t active_count();
 
     private:
         BlockListManager();
 
+        struct Expiry {
+            std::chrono::steady_clock::time_point at;
+            common::IpKey ip;
+            uint64_t generation;
+
+            // Inverted so std::priority_queue yields the earliest deadline
+            bool operator<(const Expiry& other) const { return at > other.at; }
+        };
+
         /**
-         * @brief Background loop that checks for expired bans.
+         * @brief Background loop that sleeps until the next ban deadline.
          */
         void expiration_worker();
 
         /**
-         * @brief Executes the actual shell command.
-         * @param add True to add rule, False to delete rule.
+         * @brief Queues firewall operations for the next transaction.
          */
-        void execute_firewall_command(const std::string& ip, bool add);
+        void submit(FirewallOp op);
+        void submit(std::vector<FirewallOp>& ops);
 
-        // STATE
-        std::unordered_map<std::string, BlockEntry> active_blocks_;
-        std::mutex mutex_;
+        /**
+         * @brief Background loop that batches queued operations into the backend.
+         */
+        void firewall_worker();
 
-        // WORKER
+        // STATE (guarded by mutex_)
+        std::unordered_map<common::IpKey, BlockEntry, common::IpKeyHash> active_blocks_;
+        std::priority_queue<Expiry> expiry_heap_;
+        uint64_t next_generation_ = 0;
+        std::mutex mutex_;
+        std::condition_variable expiry_cv_;
+
+        // FIREWALL (pending_ guarded by pending_mutex_; ops are queued while
+        // holding mutex_, so the lock order is mutex_ -> pending_mutex_)
+        std::unique_ptr<FirewallBackend> backend_;
+        std::vector<FirewallOp> pending_;
+        std::mutex pending_mutex_;
+        std::condition_variable pending_cv_;
+        std::chrono::milliseconds batch_window_;
+        bool firewall_stopping_ = false;
+
+        // WORKERS
         std::atomic<bool> running_;
         std::thread worker_thread_;
+        std::thread firewall_thread_;
     };
 
 } // namespace blackbox::analysis
@@ -0,0 +1,76 @@
+/**
+ * @file cooldown_table.h
+ * @brief Fixed-Capacity, Lock-Free Alert Cooldown Table.
+ *
+ * Remembers when each (source, rule) pair last alerted so repeats inside
+ * the cooldown are suppressed. Memory is allocated once: under a
+ * spoofed-source flood the table recycles slots instead of growing.
+ *
+ * Layout: open addressing over groups of 8 slots (two cache lines). A key
+ * probes only its own group. Each slot is two atomic words:
+ *  - key:   64-bit fingerprint of (binary IP, rule id), 0 = empty
+ *  - stamp: (last alert ms << 1) | CLOCK reference bit, 0 = being written
+ *
+ * When a group is full, CLOCK (second chance) picks the victim: expired
+ * entries go first, then entries whose reference bit is clear; a pass
+ * clears the bits it skips. All updates are CAS, so concurrent callers
+ * never block; a lost race costs at most one missed or one extra alert.
+ */
+
+#ifndef BLACKBOX_ANALYSIS_COOLDOWN_TABLE_H
+#define BLACKBOX_ANALYSIS_COOLDOWN_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "blackbox/common/ip_address.h"
+
+namespace blackbox::analysis {
+
+    class CooldownTable {
+    public:
+        /**
+         * @param capacity Number of slots (rounded up to a power of two, min 64)
+         * @param cooldown_ms Minimum time between two alerts of the same pair
+         */
+        CooldownTable(size_t capacity, uint64_t cooldown_ms);
+
+        CooldownTable(const CooldownTable&) = delete;
+        CooldownTable& operator=(const CooldownTable&) = delete;
+
+        /**
+         * @brief Records an alert attempt for (ip, rule_id) at 'now_ms'.
+         * @return true if the pair is outside its cooldown (alert), false if
+         *         it alerted recently (suppress)
+         */
+        bool try_trigger(const common::IpKey& ip, uint32_t rule_id, uint64_t now_ms);
+
+        size_t capacity() const { return (group_mask_ + 1) * GROUP; }
+
+    private:
+        static constexpr size_t GROUP = 8;
+
+        struct Slot {
+            std::atomic<uint64_t> key{0};
+            std::atomic<uint64_t> stamp{0};
+        };
+
+        // Cache-line aligned so a probe touches exactly two lines
+        struct alignas(64) Group {
+            Slot slots[GROUP];
+        };
+
+        static uint64_t fingerprint(const common::IpKey& ip, uint32_t rule_id);
+
+        // Claims 'slot' for 'key' at 'now_ms' after its stamp was CAS'ed to 0
+        static void fill(Slot& slot, uint64_t key, uint64_t now_ms);
+
+        std::unique_ptr<Group[]> groups_;
+        size_t group_mask_;
+        uint64_t cooldown_ms_;
+    };
+
+} // namespace blackbox::analysis
+
+#endif // BLACKBOX_ANALYSIS_COOLDOWN_TABLE_H
@@ -0,0 +1,112 @@
+/**
+ * @file firewall_backend.h
+ * @brief Kernel Firewall Backends for Active Defense.
+ *
+ * Bans live in two nftables sets (ban4 / ban6) of a dedicated table,
+ * matched by one rule each, so lookup cost in the kernel does not grow
+ * with the number of bans. Elements carry a timeout and are expired by
+ * the kernel itself.
+ *
+ * The nftables backend talks nfnetlink directly (no shell, no nft
+ * binary): every apply() is one atomic transaction carrying all pending
+ * additions and removals.
+ *
+ * Backends:
+ *  - "nftables": kernel sets via netlink (needs CAP_NET_ADMIN).
+ *  - "dryrun":   records operations only (tests, local runs).
+ */
+
+#ifndef BLACKBOX_ANALYSIS_FIREWALL_BACKEND_H
+#define BLACKBOX_ANALYSIS_FIREWALL_BACKEND_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "blackbox/common/ip_address.h"
+
+namespace blackbox::analysis {
+
+    struct FirewallOp {
+        enum class Type { Block, Unblock };
+
+        Type type;
+        common::IpKey ip;
+        int timeout_seconds = 0;  // Block only: kernel-side expiry (0 = none)
+    };
+
+    class FirewallBackend {
+    public:
+        virtual ~FirewallBackend() = default;
+
+        /**
+         * @brief Prepares the kernel state (table, sets, rules).
+         * @return false if the backend is unusable (e.g. missing privileges)
+         */
+        virtual bool init() = 0;
+
+        /**
+         * @brief Applies a group of operations as one transaction.
+         * @return Number of operations that failed (0 = all applied)
+         */
+        virtual size_t apply(const std::vector<FirewallOp>& ops) = 0;
+
+        virtual const char* name() const = 0;
+
+        /**
+         * @brief Builds the backend selected by 'kind' ("nftables" or "dryrun").
+         * Falls back to dry-run (with an error log) if the kernel backend
+         * cannot be initialised, so the pipeline keeps running.
+         */
+        static std::unique_ptr<FirewallBackend> create(const std::string& kind, const std::string& table);
+    };
+
+    class NftablesBackend : public FirewallBackend {
+    public:
+        explicit NftablesBackend(std::string table);
+        ~NftablesBackend() override;
+
+        NftablesBackend(const NftablesBackend&) = delete;
+        NftablesBackend& operator=(const NftablesBackend&) = delete;
+
+        bool init() override;
+        size_t apply(const std::vector<FirewallOp>& ops) override;
+        const char* name() const override { return "nftables"; }
+
+    private:
+        // Sends one batch; returns 0 or the first errno reported by the kernel
+        int transact(const std::vector<char>& batch);
+
+        std::string table_;
+        int fd_ = -1;
+        uint32_t seq_ = 0;
+    };
+
+    /**
+     * @brief Logs ops instead of applying them. Also the fallback when
+     * nftables is unavailable, so it may run for the collector's lifetime:
+     * only the newest HISTORY_LIMIT ops are kept.
+     */
+    class DryRunBackend : public FirewallBackend {
+    public:
+        static constexpr size_t HISTORY_LIMIT = 4096;
+
+        bool init() override { return true; }
+        size_t apply(const std::vector<FirewallOp>& ops) override;
+        const char* name() const override { return "dryrun"; }
+
+        // Newest ops applied (at most HISTORY_LIMIT), oldest first
+        std::vector<FirewallOp> history() const;
+        size_t transactions() const;
+
+    private:
+        mutable std::mutex mutex_;
+        std::vector<FirewallOp> history_;   // Ring once full
+        size_t history_next_ = 0;           // Slot of the oldest op when full
+        size_t transactions_ = 0;
+    };
+
+} // namespace blackbox::analysis
+
+#endif // BLACKBOX_ANALYSIS_FIREWALL_BACKEND_H
@@ -14,6 +14,7 @@
 #include <string_view>
 #include <vector>
 #include <memory>
+#include <optional>
 #include "blackbox/parser/parser_engine.h" // For ParsedLog
 
 namespace blackbox::analysis {
@@ -0,0 +1,101 @@
+/**
+ * @file ip_address.h
+ * @brief Binary IP Address Key.
+ *
+ * One 16-byte representation for both families: IPv6 as is, IPv4 as
+ * the IPv4-mapped address ::ffff:a.b.c.d. Keying tables by IpKey avoids
+ * string allocation, hashing of text and "1.2.3.4" vs "::ffff:1.2.3.4"
+ * duplicates.
+ */
+
+#ifndef BLACKBOX_COMMON_IP_ADDRESS_H
+#define BLACKBOX_COMMON_IP_ADDRESS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <netinet/in.h>
+
+namespace blackbox::common {
+
+    struct IpKey {
+        std::array<uint8_t, 16> bytes{};
+
+        /**
+         * @brief Parses an IPv4 or IPv6 literal ("203.0.113.7", "2001:db8::1").
+         * @return std::nullopt if the text is not an address
+         */
+        static std::optional<IpKey> parse(std::string_view text);
+
+        /**
+         * @brief From an IPv4 address in network byte order (sockaddr_in::sin_addr).
+         */
+        static IpKey from_v4(uint32_t addr_be) {
+            IpKey key;
+            key.bytes[10] = 0xFF;
+            key.bytes[11] = 0xFF;
+            std::memcpy(key.bytes.data() + 12, &addr_be, 4);
+            return key;
+        }
+
+        /**
+         * @brief From 16 IPv6 address bytes (sockaddr_in6::sin6_addr).
+         */
+        static IpKey from_v6(const uint8_t* addr) {
+            IpKey key;
+            std::memcpy(key.bytes.data(), addr, 16);
+            return key;
+        }
+
+        /**
+         * @brief From a socket address (AF_INET or AF_INET6), e.g. what
+         * recvfrom()/accept() filled in.
+         * @return std::nullopt for other families
+         */
+        static std::optional<IpKey> from_sockaddr(const sockaddr* addr) {
+            if (addr->sa_family == AF_INET) {
+                return from_v4(reinterpret_cast<const sockaddr_in*>(addr)->sin_addr.s_addr);
+            }
+            if (addr->sa_family == AF_INET6) {
+                return from_v6(reinterpret_cast<const sockaddr_in6*>(addr)->sin6_addr.s6_addr);
+            }
+            return std::nullopt;
+        }
+
+        bool is_v4() const {
+            static constexpr uint8_t V4_MAPPED[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+            return std::memcmp(bytes.data(), V4_MAPPED, sizeof(V4_MAPPED)) == 0;
+        }
+
+        // The 4 address bytes of an IPv4 key (network order)
+        const uint8_t* v4_bytes() const { return bytes.data() + 12; }
+
+        /**
+         * @brief Dotted quad for IPv4, RFC 5952 text for IPv6.
+         */
+        std::string to_string() const;
+
+        bool operator==(const IpKey& other) const { return bytes == other.bytes; }
+        bool operator!=(const IpKey& other) const { return bytes != other.bytes; }
+        bool operator<(const IpKey& other) const { return bytes < other.bytes; }
+    };
+
+    struct IpKeyHash {
+        size_t operator()(const IpKey& key) const {
+            uint64_t hi, lo;
+            std::memcpy(&hi, key.bytes.data(), 8);
+            std::memcpy(&lo, key.bytes.data() + 8, 8);
+            // Mix both halves (IPv4 keys differ only in 'lo')
+            uint64_t h = (hi ^ 0x9E3779B97F4A7C15ull) * 0xBF58476D1CE4E5B9ull ^ lo;
+            h = (h ^ (h >> 31)) * 0x94D049BB133111EBull;
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+
+} // namespace blackbox::common
+
+#endif // BLACKBOX_COMMON_IP_ADDRESS_H
@@ -0,0 +1,103 @@
+/**
+ * @file json_writer.h
+ * @brief Allocation-free JSON Serializer.
+ *
+ * Writes compact JSON into a caller-provided buffer. Commas are placed
+ * automatically; strings are escaped per RFC 8259 (quote, backslash and
+ * every control character), scanning 32 bytes at a time with AVX2.
+ * Non-ASCII input is validated as UTF-8 and ill-formed sequences are
+ * replaced with U+FFFD, so raw bytes from hostile senders cannot make
+ * the output invalid. Numbers go through std::to_chars (shortest
+ * round-trip for floats).
+ *
+ * Nothing is ever allocated. If the buffer is too small the writer
+ * stops, ok() turns false and the caller decides what to do.
+ */
+
+#ifndef BLACKBOX_COMMON_JSON_WRITER_H
+#define BLACKBOX_COMMON_JSON_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace blackbox::common {
+
+    class JsonWriter {
+    public:
+        JsonWriter(char* buffer, size_t capacity)
+            : buf_(buffer), cap_(capacity) {}
+
+        // --- Structure ---
+        JsonWriter& begin_object();
+        JsonWriter& end_object();
+        JsonWriter& begin_array();
+        JsonWriter& end_array();
+
+        /**
+         * @brief Object member name (the next value call supplies its value).
+         */
+        JsonWriter& key(std::string_view name);
+
+        // --- Values ---
+        JsonWriter& value(std::string_view str);
+        JsonWriter& value(const char* str) { return value(std::string_view(str)); }
+        JsonWriter& value(int64_t v);
+        JsonWriter& value(uint64_t v);
+        JsonWriter& value(int v) { return value(static_cast<int64_t>(v)); }
+        JsonWriter& value(unsigned v) { return value(static_cast<uint64_t>(v)); }
+        JsonWriter& value(float v);   // NaN / Inf are written as null
+        JsonWriter& value(double v);
+        JsonWriter& value(bool v);
+        JsonWriter& null();
+
+        /**
+         * @brief Shorthand for key(name).value(v).
+         */
+        template <typename T>
+        JsonWriter& field(std::string_view name, T v) { return key(name).value(v); }
+
+        // --- Result ---
+        bool ok() const { return !overflow_; }
+        size_t size() const { return len_; }
+        std::string_view view() const { return {buf_, len_}; }
+
+        void reset() {
+            len_ = 0;
+            depth_ = 0;
+            has_items_ = 0;
+            after_key_ = false;
+            overflow_ = false;
+        }
+
+        /**
+         * @brief Worst-case output size of value(str) for an input of n bytes.
+         */
+        static constexpr size_t max_escaped_size(size_t n) { return n * 6 + 2; }
+
+        /**
+         * @brief Longest prefix of str within max_bytes that does not split
+         * a UTF-8 sequence (for truncating free text before serializing).
+         */
+        static std::string_view utf8_prefix(std::string_view str, size_t max_bytes);
+
+    private:
+        void separator();
+        void put(char c);
+        void put(const char* data, size_t n);
+        void escape(std::string_view str);
+
+        char* buf_;
+        size_t cap_;
+        size_t len_ = 0;
+
+        // One bit per nesting level: "this container already has an item"
+        uint64_t has_items_ = 0;
+        uint32_t depth_ = 0;
+        bool after_key_ = false;
+        bool overflow_ = false;
+    };
+
+} // namespace blackbox::common
+
+#endif // BLACKBOX_COMMON_JSON_WRITER_H
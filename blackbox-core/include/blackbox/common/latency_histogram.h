@@ -0,0 +1,122 @@
+/**
+ * @file latency_histogram.h
+ * @brief Per-Stage Latency Histograms (HDR-style, Lock-Free).
+ *
+ * Every recording thread owns a block of log-linear histograms
+ * (8 linear sub-buckets per power of two, ~12% relative error, 1 ns to
+ * ~68 s). record() is a couple of shifts and one uncontended increment
+ * on thread-local memory; no lock, no shared cache line. Scrapes merge
+ * all blocks and export Prometheus histograms.
+ *
+ * Usage:
+ *   const uint64_t t0 = TimeUtils::now_ns();
+ *   parse(...);
+ *   LatencyHistograms::record(Stage::Parse, TimeUtils::now_ns() - t0);
+ */
+
+#ifndef BLACKBOX_COMMON_LATENCY_HISTOGRAM_H
+#define BLACKBOX_COMMON_LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace blackbox::common {
+
+    // Pipeline stages with their own histogram
+    enum class Stage : uint8_t {
+        RingDwell,       // UDP/TCP push -> processing thread pop
+        Parse,
+        Enrich,          // GeoIP
+        Rules,
+        Inference,
+        StorageEnqueue,
+        EndToEnd,        // Ingest timestamp -> verdict stored
+        COUNT
+    };
+
+    class LatencyHistograms {
+    public:
+        static constexpr int SUB_BITS = 3;                         // 8 sub-buckets per octave
+        static constexpr int MAX_BITS = 36;                        // ~68.7 s in ns
+        static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) << SUB_BITS;
+        static constexpr size_t STAGES = static_cast<size_t>(Stage::COUNT);
+
+        /**
+         * @brief Bucket index for a latency in nanoseconds.
+         */
+        static constexpr size_t bucket_of(uint64_t ns) {
+            if (ns < (1ull << SUB_BITS)) return static_cast<size_t>(ns);
+            const int msb = 63 - std::countl_zero(ns);
+            if (msb >= MAX_BITS) return BUCKETS - 1;
+            const int shift = msb - SUB_BITS;
+            return (static_cast<size_t>(shift + 1) << SUB_BITS) |
+                   static_cast<size_t>((ns >> shift) & ((1u << SUB_BITS) - 1));
+        }
+
+        /**
+         * @brief Upper bound (inclusive, ns) of a bucket.
+         */
+        static constexpr uint64_t bucket_upper(size_t index) {
+            if (index < (1u << SUB_BITS)) return index;
+            const size_t shift = (index >> SUB_BITS) - 1;
+            const uint64_t mantissa = (1ull << SUB_BITS) | (index & ((1u << SUB_BITS) - 1));
+            return ((mantissa + 1) << shift) - 1;
+        }
+
+        /**
+         * @brief Record one latency for the calling thread. Lock-free, ~ns.
+         */
+        static void record(Stage stage, uint64_t ns) {
+            Block* block = tls_block_;
+            if (!block) block = register_thread();
+
+            const auto s = static_cast<size_t>(stage);
+            // Single writer per block: plain load/store, no locked RMW
+            auto& bucket = block->counts[s][bucket_of(ns)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            auto& sum = block->sum_ns[s];
+            sum.store(sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Merged view of one stage across all threads.
+         */
+        struct Snapshot {
+            std::array<uint64_t, BUCKETS> counts{};
+            uint64_t count = 0;
+            uint64_t sum_ns = 0;
+
+            /**
+             * @brief Approximate quantile in ns (bucket upper bound), q in [0, 1].
+             */
+            uint64_t quantile(double q) const;
+        };
+
+        static Snapshot snapshot(Stage stage);
+
+        /**
+         * @brief Appends every stage as a Prometheus histogram
+         * (blackbox_stage_latency_seconds{stage="..."}).
+         */
+        static void render_prometheus(std::string& out);
+
+        static const char* stage_name(Stage stage);
+
+    private:
+        struct Block {
+            std::array<std::array<std::atomic<uint64_t>, BUCKETS>, STAGES> counts{};
+            std::array<std::atomic<uint64_t>, STAGES> sum_ns{};
+        };
+
+        static Block* register_thread();
+
+        static inline thread_local Block* tls_block_ = nullptr;
+    };
+
+} // namespace blackbox::common
+
+#endif // BLACKBOX_COMMON_LATENCY_HISTOGRAM_H
@@ -1,14 +1,32 @@
 /**
  * @file logger.h
- * @brief Thread-safe, Color-coded Application Logger.
+ * @brief Asynchronous, Color-coded Application Logger.
+ *
+ * LOG_* calls never touch a lock or the console. The calling thread
+ * copies a compact record (level, raw timestamp, __FILE__ pointer,
+ * line, message bytes) into its own SPSC ring; a background sink
+ * thread formats the timestamp and writes batches with writev() to
+ * stdout or to a size-rotated file.
+ *
+ * If a thread logs faster than the sink drains, new records are
+ * dropped and counted; the sink reports the loss in the log itself.
+ * CRITICAL records wake the sink at once, but LOG_CRITICAL does not wait
+ * for the write; the atexit hook and the crash handler drain what is left.
  */
 
 #ifndef BLACKBOX_COMMON_LOGGER_H
 #define BLACKBOX_COMMON_LOGGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
-#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/uio.h>
 
 namespace blackbox::common {
 
@@ -34,25 +52,102 @@ namespace blackbox::common {
         void set_level(LogLevel level);
 
         /**
-         * @brief Write a message to stdout/stderr safely.
+         * @brief Switch output to a file, rotated at max_bytes (path.1 ... path.N).
+         * @return false if the file cannot be opened (stdout is kept)
+         */
+        bool set_file_sink(const std::string& path, uint64_t max_bytes, int max_files);
+
+        /**
+         * @brief Queue a message for the sink thread (lock-free, never blocks).
+         * Messages longer than MAX_MESSAGE bytes are truncated.
          */
         void log(LogLevel level, std::string_view message, const char* file, int line);
 
+        /**
+         * @brief Block until everything logged so far has been written.
+         */
+        void flush();
+
+        /**
+         * @brief Cheap level check, so the macros skip building filtered messages.
+         */
+        bool enabled(LogLevel level) const { return level >= min_level_.load(std::memory_order_relaxed); }
+
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+        static constexpr size_t MAX_MESSAGE = 480;
+
     private:
-        Logger() = default;
-        
-        std::mutex mutex_; // Prevents threads from mixing output
-        LogLevel min_level_ = LogLevel::INFO;
+        Logger();
+        ~Logger() = default; // Never runs: the instance is leaked, see instance()
+
+        /**
+         * @brief Drains the rings and stops the sink (atexit). Later calls log synchronously.
+         */
+        void shutdown();
+
+        // Fixed-size binary record; formatting happens on the sink thread
+        struct Record {
+            uint64_t timestamp_ns;
+            const char* file;       // Static string (__FILE__), doubles as the call-site id
+            int32_t line;
+            uint8_t level;
+            uint8_t truncated;
+            uint16_t length;
+            char message[MAX_MESSAGE];
+        };
+
+        struct ThreadRing;
+        ThreadRing& local_ring();
+
+        void sink_worker();
+        size_t drain(bool final_pass);
+        void write_batch(const iovec* iov, int count, size_t bytes);
+        void rotate_file();
+        void write_line(std::string_view line);
+
+        std::atomic<LogLevel> min_level_{LogLevel::INFO};
+        std::atomic<uint64_t> dropped_{0};
+        uint64_t dropped_reported_ = 0;   // Sink thread only
+
+        // Per-thread rings (registered once per thread)
+        std::mutex registry_mutex_;
+        std::vector<std::shared_ptr<ThreadRing>> rings_;
+
+        // Sink
+        std::atomic<bool> running_{true};
+        std::atomic<uint64_t> flush_requests_{0};
+        std::atomic<uint64_t> flush_done_{0};
+        std::atomic<bool> sink_idle_{false};   // Sink is (about to be) parked on wake_cv_
+        std::mutex wake_mutex_;
+        std::condition_variable wake_cv_;
+        std::condition_variable flushed_cv_;
+        std::thread sink_thread_;
+
+        // Output (sink thread only, except during set_file_sink)
+        std::mutex output_mutex_;
+        int fd_ = 1;                       // stdout
+        bool color_ = true;
+        std::string file_path_;
+        uint64_t file_max_bytes_ = 0;
+        int file_max_count_ = 0;
+        uint64_t file_bytes_ = 0;
     };
 
 } // namespace blackbox::common
 
 // CONVENIENCE MACROS
 // Using macros allows us to automatically capture __FILE__ and __LINE__
-#define LOG_DEBUG(msg) blackbox::common::Logger::instance().log(blackbox::common::LogLevel::DEBUG, msg, __FILE__, __LINE__)
-#define LOG_INFO(msg)  blackbox::common::Logger::instance().log(blackbox::common::LogLevel::INFO, msg, __FILE__, __LINE__)
-#define LOG_WARN(msg)  blackbox::common::Logger::instance().log(blackbox::common::LogLevel::WARN, msg, __FILE__, __LINE__)
-#define LOG_ERROR(msg) blackbox::common::Logger::instance().log(blackbox::common::LogLevel::ERROR, msg, __FILE__, __LINE__)
-#define LOG_CRITICAL(msg) blackbox::common::Logger::instance().log(blackbox::common::LogLevel::CRITICAL, msg, __FILE__, __LINE__)
+#define BB_LOG_AT(level, msg) \
+    do { \
+        auto& bb_logger_ = blackbox::common::Logger::instance(); \
+        if (bb_logger_.enabled(level)) bb_logger_.log(level, msg, __FILE__, __LINE__); \
+    } while (0)
+
+#define LOG_DEBUG(msg)    BB_LOG_AT(blackbox::common::LogLevel::DEBUG, msg)
+#define LOG_INFO(msg)     BB_LOG_AT(blackbox::common::LogLevel::INFO, msg)
+#define LOG_WARN(msg)     BB_LOG_AT(blackbox::common::LogLevel::WARN, msg)
+#define LOG_ERROR(msg)    BB_LOG_AT(blackbox::common::LogLevel::ERROR, msg)
+#define LOG_CRITICAL(msg) BB_LOG_AT(blackbox::common::LogLevel::CRITICAL, msg)
 
-#endif // BLACKBOX_COMMON_LOGGER_H
\ No newline at end of file
+#endif // BLACKBOX_COMMON_LOGGER_H
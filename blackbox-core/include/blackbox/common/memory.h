@@ -0,0 +1,146 @@
+/**
+ * @file memory.h
+ * @brief Huge-Page, NUMA-Aware Allocation for Large Long-Lived Buffers.
+ *
+ * The ingest ring alone is ~256 MB of slots. On 4 KB pages that is 65536
+ * TLB entries for one sequential sweep, and the pages land on whichever
+ * NUMA node first touched them. MappedRegion maps such buffers directly:
+ *
+ *  1. explicit huge pages (MAP_HUGETLB, 2 MB) if the pool has room,
+ *  2. else a 2 MB-aligned mapping with MADV_HUGEPAGE (THP),
+ *  3. else plain pages.
+ *
+ * The range is then bound (preferred, not strict) to the consumer's NUMA
+ * node and pre-faulted, so the first events don't pay for page faults.
+ * Every step degrades quietly: the worst case is what malloc would give.
+ *
+ * Meant for a handful of big startup allocations, not general use.
+ */
+
+#ifndef BLACKBOX_COMMON_MEMORY_H
+#define BLACKBOX_COMMON_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace blackbox::common {
+
+    struct MemoryPolicy {
+        bool huge_pages = true;   // Try MAP_HUGETLB, then THP
+        int numa_node = -1;       // Preferred node, -1 = first touch
+        bool prefault = true;     // Fault every page in now
+
+        /**
+         * @brief Policy from Settings for a buffer consumed on 'cpu'
+         * (its NUMA node is looked up; -1 = no binding).
+         */
+        static MemoryPolicy for_cpu(int cpu);
+    };
+
+    class MappedRegion {
+    public:
+        enum class Backing : uint8_t { None, HugeTlb, TransparentHuge, Normal };
+
+        MappedRegion() = default;
+        ~MappedRegion();
+
+        MappedRegion(MappedRegion&& other) noexcept { swap(other); }
+        MappedRegion& operator=(MappedRegion&& other) noexcept {
+            MappedRegion(std::move(other)).swap(*this);
+            return *this;
+        }
+        MappedRegion(const MappedRegion&) = delete;
+        MappedRegion& operator=(const MappedRegion&) = delete;
+
+        /**
+         * @brief Maps at least 'bytes' (zero-filled).
+         * @param label Name for the startup log line
+         * @throws std::bad_alloc only if even plain pages cannot be mapped
+         */
+        static MappedRegion allocate(size_t bytes, const MemoryPolicy& policy, const char* label);
+
+        void* data() const { return data_; }
+        size_t size() const { return size_; }
+        Backing backing() const { return backing_; }
+        bool numa_bound() const { return numa_bound_; }
+
+        static const char* backing_name(Backing backing);
+
+        /**
+         * @brief NUMA node of a CPU (from sysfs), -1 if unknown.
+         */
+        static int numa_node_of_cpu(int cpu);
+
+    private:
+        void swap(MappedRegion& other) noexcept {
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+            std::swap(backing_, other.backing_);
+            std::swap(numa_bound_, other.numa_bound_);
+        }
+
+        void* data_ = nullptr;
+        size_t size_ = 0;             // Mapped length (multiple of the page size)
+        Backing backing_ = Backing::None;
+        bool numa_bound_ = false;
+    };
+
+    /**
+     * @brief Fixed-size array of T in a MappedRegion.
+     * Elements are value-initialized in place and destroyed with the array.
+     */
+    template <typename T>
+    class MappedArray {
+    public:
+        MappedArray() = default;
+
+        MappedArray(size_t count, const MemoryPolicy& policy, const char* label)
+            : region_(MappedRegion::allocate(count * sizeof(T), policy, label)),
+              items_(static_cast<T*>(region_.data())),
+              count_(count)
+        {
+            // Fresh mappings are zero-filled: that already is a trivial T's value
+            if constexpr (!std::is_trivially_default_constructible_v<T>) {
+                for (size_t i = 0; i < count_; ++i) new (items_ + i) T();
+            }
+        }
+
+        ~MappedArray() { destroy(); }
+
+        MappedArray(MappedArray&& other) noexcept { *this = std::move(other); }
+        MappedArray& operator=(MappedArray&& other) noexcept {
+            if (this != &other) {
+                destroy();
+                region_ = std::move(other.region_);
+                items_ = std::exchange(other.items_, nullptr);
+                count_ = std::exchange(other.count_, 0);
+            }
+            return *this;
+        }
+
+        T& operator[](size_t i) { return items_[i]; }
+        const T& operator[](size_t i) const { return items_[i]; }
+        T* data() { return items_; }
+        size_t size() const { return count_; }
+
+        const MappedRegion& region() const { return region_; }
+
+    private:
+        void destroy() {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (size_t i = 0; i < count_; ++i) items_[i].~T();
+            }
+            count_ = 0;
+        }
+
+        MappedRegion region_;
+        T* items_ = nullptr;
+        size_t count_ = 0;
+    };
+
+} // namespace blackbox::common
+
+#endif // BLACKBOX_COMMON_MEMORY_H
@@ -4,14 +4,23 @@
  * 
  * Tracks system performance (EPS, Drops, Latency) using atomic counters.
  * Includes a background reporter to log system health.
+ *
+ * Components that own a queue can register gauge callbacks (ring
+ * occupancy, in-flight batches...) that are sampled on each scrape.
  */
 
 #ifndef BLACKBOX_COMMON_METRICS_H
 #define BLACKBOX_COMMON_METRICS_H
 
 #include <atomic>
+#include <functional>
+#include <mutex>
 #include <thread>
-#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "blackbox/common/system_stats.h"
 
 namespace blackbox::common {
 
@@ -29,14 +38,35 @@ namespace blackbox::common {
         // Ingestion Layer
         void inc_packets_received(size_t count = 1);
         void inc_packets_dropped(size_t count = 1);
+        void inc_ingest_backpressure(size_t count = 1); // Ring full: the pipeline pushed back
+        void inc_tcp_frames_truncated(size_t count = 1); // TCP frame longer than an event slot
 
         // AI Layer
         void inc_inferences_run(size_t count = 1);
         void inc_threats_detected(size_t count = 1);
 
+        // Alert Fan-out (Redis)
+        void inc_alerts_published(size_t count = 1);
+        void inc_alerts_dropped(size_t count = 1);
+
         // Storage Layer
         void inc_db_rows_written(size_t count = 1);
         void inc_db_errors(size_t count = 1);
+        void inc_db_rows_dropped(size_t count = 1);
+        void inc_db_batches_rejected(size_t count = 1); // 4xx: the batch itself is bad, never retried
+
+        // Disk Spool (overflow while ClickHouse is unavailable)
+        void inc_spool_rows_written(size_t count = 1);
+        void inc_spool_rows_replayed(size_t count = 1);
+        void set_spool_depth(uint64_t bytes, uint64_t rows, uint64_t oldest_age_ms);
+
+        // Active Defense (firewall set updates)
+        void inc_firewall_updates(size_t count = 1);
+        void inc_firewall_errors(size_t count = 1);
+        void inc_packets_banned(size_t count = 1);
+        void inc_alert_dedup_evictions(size_t count = 1);
+        void inc_alert_summaries(size_t count = 1);
+        void inc_alerts_shaped(size_t count = 1);
 
         // ==========================================
         // Management
@@ -52,23 +82,83 @@ namespace blackbox::common {
          */
         void stop();
 
+        /**
+         * @brief Adds a gauge sampled on every scrape (name must be unique).
+         * The callback runs on the admin thread; it must be cheap and lock-free
+         * with respect to the hot path (e.g. an atomic load).
+         */
+        void register_gauge(const std::string& name, const std::string& help, std::function<double()> sample);
+
+        /**
+         * @brief Same as register_gauge() for a monotonically increasing
+         * value owned by a component (exported with TYPE counter).
+         * Removed with unregister_gauge().
+         */
+        void register_counter(const std::string& name, const std::string& help, std::function<double()> sample);
+
+        /**
+         * @brief Removes a gauge; call before the object its callback reads is destroyed.
+         */
+        void unregister_gauge(const std::string& name);
+
+        /**
+         * @brief Renders all counters, gauges, per-thread CPU and stage
+         * latency histograms in the Prometheus text format.
+         *
+         * The text is built in a buffer reused across scrapes and system
+         * stats come from the SystemStats cache (no /proc reads per scrape).
+         */
+        std::string get_prometheus_metrics();
+
     private:
         Metrics() = default;
         ~Metrics();
 
         void reporter_worker(int interval_seconds);
 
+        void register_sampled(const std::string& name, const std::string& help,
+                              std::function<double()> sample, const char* type);
+
         // ATOMIC COUNTERS (Lock-Free)
         std::atomic<uint64_t> packets_rx_{0};
         std::atomic<uint64_t> packets_dropped_{0};
+        std::atomic<uint64_t> ingest_backpressure_{0};
+        std::atomic<uint64_t> tcp_truncated_{0};
         std::atomic<uint64_t> inferences_{0};
         std::atomic<uint64_t> threats_{0};
+        std::atomic<uint64_t> alerts_published_{0};
+        std::atomic<uint64_t> alerts_dropped_{0};
         std::atomic<uint64_t> db_written_{0};
         std::atomic<uint64_t> db_errors_{0};
+        std::atomic<uint64_t> db_dropped_{0};
+        std::atomic<uint64_t> db_rejected_{0};
+        std::atomic<uint64_t> spool_written_{0};
+        std::atomic<uint64_t> spool_replayed_{0};
+        std::atomic<uint64_t> spool_bytes_{0};   // Gauge
+        std::atomic<uint64_t> spool_rows_{0};    // Gauge
+        std::atomic<uint64_t> spool_age_ms_{0};  // Gauge
+        std::atomic<uint64_t> firewall_updates_{0};
+        std::atomic<uint64_t> firewall_errors_{0};
+        std::atomic<uint64_t> packets_banned_{0};
+        std::atomic<uint64_t> alert_dedup_evictions_{0};
+        std::atomic<uint64_t> alert_summaries_{0};
+        std::atomic<uint64_t> alerts_shaped_{0};
 
         // Reporter State
         std::atomic<bool> running_{false};
         std::thread reporter_thread_;
+
+        // Scrape State (guarded by scrape_mutex_)
+        struct Gauge {
+            std::string name;
+            std::string help;
+            std::function<double()> sample;
+            const char* type;   // "gauge" or "counter"
+        };
+        std::mutex scrape_mutex_;
+        std::vector<Gauge> gauges_;
+        std::string scrape_buffer_;
+        SystemStats::Snapshot system_snapshot_;
     };
 
 } // namespace blackbox::common
@@ -0,0 +1,127 @@
+/**
+ * @file mpmc_queue.h
+ * @brief Bounded Multi-Producer Multi-Consumer Queue.
+ *
+ * Array of cells, each with a sequence number (D. Vyukov's design):
+ * producers and consumers claim a position with one CAS on their own
+ * index and then hand the cell over through its sequence number.
+ * No locks, no allocation after construction.
+ *
+ * Capacity is a runtime value (rounded up to a power of two) because
+ * stage queue depths are configurable; see SpscQueue for the
+ * compile-time single-producer variant.
+ */
+
+#ifndef BLACKBOX_COMMON_MPMC_QUEUE_H
+#define BLACKBOX_COMMON_MPMC_QUEUE_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace blackbox::common {
+
+    /**
+     * @tparam T Element type (should be cheap to move, e.g. a pointer)
+     */
+    template <typename T>
+    class MpmcQueue {
+    public:
+        explicit MpmcQueue(size_t capacity)
+            : mask_(std::bit_ceil(capacity < 2 ? size_t{2} : capacity) - 1),
+              cells_(new Cell[mask_ + 1])
+        {
+            for (size_t i = 0; i <= mask_; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpmcQueue(const MpmcQueue&) = delete;
+        MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+        /**
+         * @brief Any thread.
+         * @return false if full (value is left untouched)
+         */
+        bool try_push(T& value) {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            Cell* cell;
+            for (;;) {
+                cell = &cells_[pos & mask_];
+                // acquire: the consumer that freed this cell is done with it
+                const size_t seq = cell->sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false; // Cell still holds the value from one lap ago
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->value = std::move(value);
+            // release: the value is visible before the cell is marked full
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Any thread.
+         * @return false if empty
+         */
+        bool try_pop(T& out) {
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            Cell* cell;
+            for (;;) {
+                cell = &cells_[pos & mask_];
+                const size_t seq = cell->sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false; // Not written yet
+                } else {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+
+            out = std::move(cell->value);
+            // release: we are done reading before producers of the next lap reuse it
+            cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Approximate number of queued elements (any thread).
+         */
+        size_t size() const {
+            const size_t dequeued = dequeue_pos_.load(std::memory_order_acquire);
+            const size_t enqueued = enqueue_pos_.load(std::memory_order_acquire);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        bool empty() const { return size() == 0; }
+
+        size_t capacity() const { return mask_ + 1; }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value{};
+        };
+
+        const size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+
+        // Producers and consumers each contend on their own line
+        alignas(64) std::atomic<size_t> enqueue_pos_{0};
+        alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    };
+
+} // namespace blackbox::common
+
+#endif // BLACKBOX_COMMON_MPMC_QUEUE_H
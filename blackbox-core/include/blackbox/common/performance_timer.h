@@ -7,6 +7,9 @@
  *    PerformanceTimer t("AI_Inference", 5); // Warn if takes > 5ms
  *    brain->evaluate();
  * } // Destructor logs automatically if slow
+ *
+ * For hot loops, prefer BB_PROFILE_ZONE (profiler.h): it aggregates
+ * instead of logging.
  */
 
 #ifndef BLACKBOX_COMMON_PERFORMANCE_TIMER_H
@@ -0,0 +1,134 @@
+/**
+ * @file profiler.h
+ * @brief Aggregating Profiling Zones (TSC-based).
+ *
+ * Unlike PerformanceTimer (which can only log), a zone accumulates
+ * count / total / max per thread in its own cache-line slot and the
+ * registry merges all threads on demand (/debug/zones, /metrics).
+ * Entering and leaving a zone costs two TSC reads and three stores on
+ * thread-local memory; nothing is allocated.
+ *
+ * Usage:
+ *   void RowBatch::serialize(...) {
+ *       BB_PROFILE_ZONE("storage.serialize");
+ *       ...
+ *   }
+ *
+ * Build with -DBLACKBOX_ENABLE_PROFILING=OFF to compile every zone out.
+ */
+
+#ifndef BLACKBOX_COMMON_PROFILER_H
+#define BLACKBOX_COMMON_PROFILER_H
+
+#ifndef BLACKBOX_PROFILING
+#define BLACKBOX_PROFILING 1
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "blackbox/common/tsc_clock.h"
+
+namespace blackbox::common {
+
+    class Profiler {
+    public:
+        static constexpr size_t MAX_ZONES = 256;
+
+        struct ZoneStats {
+            const char* name;
+            const char* file;
+            int line;
+            uint64_t count;
+            uint64_t total_ns;
+            uint64_t max_ns;
+        };
+
+        /**
+         * @brief Assigns an id to a call site (once, from the macro's static).
+         * Sites beyond MAX_ZONES share an "(overflow)" zone.
+         */
+        static uint32_t register_zone(const char* name, const char* file, int line);
+
+        /**
+         * @brief Adds one measurement to the calling thread's slot. Lock-free.
+         */
+        static void record(uint32_t zone, uint64_t ticks) {
+            Block* block = tls_block_;
+            if (!block) block = register_thread();
+
+            // Single writer per slot: plain load/store, no locked RMW
+            Slot& slot = block->slots[zone];
+            slot.count.store(slot.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            slot.total_ticks.store(slot.total_ticks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+            if (ticks > slot.max_ticks.load(std::memory_order_relaxed)) {
+                slot.max_ticks.store(ticks, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief All zones with at least one hit, merged across threads.
+         */
+        static std::vector<ZoneStats> snapshot();
+
+        /**
+         * @brief JSON array of zones (admin endpoint).
+         */
+        static std::string to_json();
+
+        /**
+         * @brief Appends blackbox_zone_* counters in the Prometheus text format.
+         */
+        static void render_prometheus(std::string& out);
+
+    private:
+        // One zone in one thread, alone on its cache line
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> total_ticks{0};
+            std::atomic<uint64_t> max_ticks{0};
+        };
+
+        struct Block {
+            Slot slots[MAX_ZONES];
+        };
+
+        static Block* register_thread();
+
+        static inline thread_local Block* tls_block_ = nullptr;
+    };
+
+    /**
+     * @brief RAII zone: rdtsc on entry, rdtscp on exit.
+     */
+    class ScopedZone {
+    public:
+        explicit ScopedZone(uint32_t zone) : zone_(zone), start_(TscClock::now()) {}
+        ~ScopedZone() { Profiler::record(zone_, TscClock::now_end() - start_); }
+
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+
+    private:
+        uint32_t zone_;
+        uint64_t start_;
+    };
+
+} // namespace blackbox::common
+
+#define BB_PROFILE_CONCAT_INNER(a, b) a##b
+#define BB_PROFILE_CONCAT(a, b) BB_PROFILE_CONCAT_INNER(a, b)
+
+#if BLACKBOX_PROFILING
+// 'name' must be a string literal (checked by the "" concatenation)
+#define BB_PROFILE_ZONE(name) \
+    static const uint32_t BB_PROFILE_CONCAT(bb_zone_id_, __LINE__) = \
+        blackbox::common::Profiler::register_zone("" name "", __FILE__, __LINE__); \
+    blackbox::common::ScopedZone BB_PROFILE_CONCAT(bb_zone_, __LINE__)(BB_PROFILE_CONCAT(bb_zone_id_, __LINE__))
+#else
+#define BB_PROFILE_ZONE(name) static_assert(true, "" name "")
+#endif
+
+#endif // BLACKBOX_COMMON_PROFILER_H
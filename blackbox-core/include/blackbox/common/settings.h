@@ -15,6 +15,9 @@ namespace blackbox::common {
         uint16_t udp_port = 514;
         uint16_t admin_port = 8081;
         size_t ring_buffer_size = 65536;
+        int admin_max_connections = 32;     // Further connections are refused
+        int admin_timeout_ms = 10000;       // Per request (read) and per response (write)
+        std::string consumer_wait = "balanced"; // Idle ring consumer: spin / latency / balanced / power
     };
 
     struct AIConfig {
@@ -22,7 +25,12 @@ namespace blackbox::common {
         std::string vocab_path = "config/vocab.txt";
         std::string scaler_path = "config/scaler_params.txt";
         float anomaly_threshold = 0.8f;
-        int batch_size = 32;
+        int batch_size = 32;              // Initial (or fixed) micro-batch size
+        bool adaptive_batching = true;    // Tune batch size / fill deadline at runtime
+        int batch_min = 8;
+        int batch_max = 512;
+        int batch_max_wait_us = 200;      // Longest a batch may wait to fill
+        int latency_budget_ms = 50;       // End-to-end p99 target for the controller
     };
 
     struct EnrichmentConfig {
@@ -35,6 +43,18 @@ namespace blackbox::common {
         std::string clickhouse_url = "http://localhost:8123";
         size_t flush_batch_size = 1000;
         int flush_interval_ms = 1000;
+        size_t max_inflight_batches = 4;   // Concurrent INSERTs on the wire
+        int max_retries = 5;               // Attempts per batch before giving up
+        int retry_backoff_ms = 100;        // Base delay, doubled on every retry
+
+        // Disk Spool (overflow while ClickHouse is slow or down)
+        std::string spool_dir = "/var/lib/blackbox/spool"; // Empty disables spooling
+        uint64_t spool_max_bytes = 2ull << 30;             // Total disk budget
+        uint64_t spool_segment_bytes = 64ull << 20;        // Rotate segments at this size
+        int spool_replay_rows_per_sec = 50000;             // Replay rate limit
+
+        // Event ids: UUIDv7 (time-ordered) instead of random v4
+        bool time_ordered_ids = false;
 
         // Redis (Real-time Alerts)
         std::string redis_host = "localhost";
@@ -42,6 +62,71 @@ namespace blackbox::common {
         std::string redis_channel = "sentry_alerts";
     };
 
+    struct RecentStoreConfig {
+        int window_sec = 300;   // History kept for /query/recent
+        size_t memory_mb = 64;  // Fixed budget, allocated at startup (0 disables)
+    };
+
+    struct LogConfig {
+        std::string file_path;     // Empty = stdout
+        int max_file_mb = 100;     // Rotate at this size
+        int max_files = 5;         // Rotated files kept (path.1 ... path.N)
+    };
+
+    struct TraceConfig {
+        int sample_every = 0;      // Trace 1 in N events (0 = off)
+        std::string source_ip;     // Also trace every event from this host
+        int buffer_events = 4096;  // Trace ring size (newest kept)
+    };
+
+    struct DefenseConfig {
+        std::string firewall_backend = "nftables"; // "nftables" or "dryrun"
+        std::string firewall_table = "blackbox";   // nftables table (family inet)
+        int firewall_batch_ms = 5;                 // Coalescing window per transaction
+        bool ingest_bpf_filter = false;            // Drop short IPv4 ban lists in a UDP socket filter
+        int alert_dedup_slots = 65536;             // Alert cooldown table size (16 bytes per slot)
+    };
+
+    struct AlertConfig {
+        int window_ms = 1000;      // Aggregation window per (source, reason)
+        int log_rate = 10;         // Summaries/sec to the log (token bucket)
+        int log_burst = 50;
+        int redis_rate = 50;       // Summaries/sec to the dashboard channel
+        int redis_burst = 200;
+    };
+
+    // Processing stages (parse -> enrich -> detect -> persist)
+    struct StageConfig {
+        int queue_depth = 1024;    // Events between two stages (rounded up to a power of 2)
+        int enrich_threads = 1;    // GeoIP lookups
+        int detect_threads = 1;    // Rules + inference (one inference context each)
+        int parse_core = 1;        // CPU to pin to, -1 = not pinned;
+        int enrich_core = -1;      // multi-thread stages use core, core+1, ...
+        int detect_core = -1;
+        int persist_core = -1;
+    };
+
+    // Priority-aware shedding at ingest (see ingest/overload_controller.h)
+    struct OverloadConfig {
+        bool enabled = true;
+        int engage_pct = 50;        // Ring/stage queue fill that starts sampling
+        int severe_pct = 85;        // ... that multiplies the sampling rates
+        int release_pct = 25;       // ... below which sampling stops again
+        int keep_high = 1;          // Keep 1 in N per class while engaged
+        int keep_normal = 4;        //   (Critical is always kept)
+        int keep_low = 16;
+        int severe_factor = 8;      // N multiplier at the severe level
+        int hot_source_sec = 300;   // Sources that alerted stay Critical this long
+        std::string priority_sources; // Comma-separated IPs treated as High (at least)
+    };
+
+    // Large startup buffers: ring, stage event pool, recent store
+    struct MemoryConfig {
+        bool huge_pages = true;    // MAP_HUGETLB if reserved, else THP hint
+        bool numa_bind = true;     // Prefer the consumer thread's NUMA node
+        bool prefault = true;      // Fault pages in at startup
+    };
+
     class Settings {
     public:
         Settings(const Settings&) = delete;
@@ -55,6 +140,14 @@ namespace blackbox::common {
         const AIConfig& ai() const { return ai_; }
         const EnrichmentConfig& enrichment() const { return enrichment_; }
         const DatabaseConfig& db() const { return db_; }
+        const RecentStoreConfig& recent() const { return recent_; }
+        const LogConfig& log() const { return log_; }
+        const TraceConfig& trace() const { return trace_; }
+        const DefenseConfig& defense() const { return defense_; }
+        const AlertConfig& alerts() const { return alerts_; }
+        const StageConfig& stages() const { return stages_; }
+        const OverloadConfig& overload() const { return overload_; }
+        const MemoryConfig& memory() const { return memory_; }
 
     private:
         Settings() = default;
@@ -63,6 +156,14 @@ namespace blackbox::common {
         AIConfig ai_;
         EnrichmentConfig enrichment_;
         DatabaseConfig db_;
+        RecentStoreConfig recent_;
+        LogConfig log_;
+        TraceConfig trace_;
+        DefenseConfig defense_;
+        AlertConfig alerts_;
+        StageConfig stages_;
+        OverloadConfig overload_;
+        MemoryConfig memory_;
     };
 
 } // namespace blackbox::common
@@ -0,0 +1,141 @@
+/**
+ * @file spsc_queue.h
+ * @brief Bounded Single-Producer Single-Consumer Queue.
+ *
+ * Generic sibling of ingest::RingBuffer for handing small values
+ * (pointers, compact records) between exactly two threads.
+ * Header-only because it is instantiated with many element types.
+ */
+
+#ifndef BLACKBOX_COMMON_SPSC_QUEUE_H
+#define BLACKBOX_COMMON_SPSC_QUEUE_H
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace blackbox::common {
+
+    /**
+     * @tparam T Element type (should be cheap to move)
+     * @tparam Capacity Number of slots (Must be a power of 2)
+     */
+    template <typename T, size_t Capacity>
+    class SpscQueue {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                      "SpscQueue capacity must be a power of 2");
+
+    public:
+        SpscQueue() = default;
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        /**
+         * @brief Writer method (Producer thread only)
+         * @return false if full (value is left untouched)
+         */
+        bool try_push(T&& value) {
+            const size_t head = head_.load(std::memory_order_relaxed);
+
+            // acquire: ensures we see the latest 'tail' update from the consumer
+            if (head - cached_tail_ >= Capacity) {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (head - cached_tail_ >= Capacity) return false;
+            }
+
+            slots_[head & (Capacity - 1)] = std::move(value);
+
+            // release: the slot write is visible before the new 'head'
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_push(const T& value) {
+            T copy = value;
+            return try_push(std::move(copy));
+        }
+
+        /**
+         * @brief Zero-copy write (Producer thread only): fill the returned
+         * slot in place, then call commit_push().
+         * @return nullptr if full
+         */
+        T* try_claim() {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head - cached_tail_ >= Capacity) {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (head - cached_tail_ >= Capacity) return nullptr;
+            }
+            return &slots_[head & (Capacity - 1)];
+        }
+
+        void commit_push() {
+            head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Reader method (Consumer thread only)
+         * @return false if empty
+         */
+        bool try_pop(T& out) {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+
+            if (tail == cached_head_) {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                if (tail == cached_head_) return false;
+            }
+
+            out = std::move(slots_[tail & (Capacity - 1)]);
+
+            // release: we are done reading before the slot is reused
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Zero-copy read (Consumer thread only): inspect the oldest
+         * slot in place, then call pop_front().
+         * @return nullptr if empty
+         */
+        const T* front() {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail == cached_head_) {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                if (tail == cached_head_) return nullptr;
+            }
+            return &slots_[tail & (Capacity - 1)];
+        }
+
+        void pop_front() {
+            tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Approximate number of queued elements (any thread).
+         */
+        size_t size() const {
+            const size_t tail = tail_.load(std::memory_order_acquire);
+            const size_t head = head_.load(std::memory_order_acquire);
+            return head - tail;
+        }
+
+        bool empty() const { return size() == 0; }
+
+        static constexpr size_t capacity() { return Capacity; }
+
+    private:
+        std::array<T, Capacity> slots_{};
+
+        // Producer-owned line: head + its cached view of tail
+        alignas(64) std::atomic<size_t> head_{0};
+        size_t cached_tail_ = 0;
+
+        // Consumer-owned line: tail + its cached view of head
+        alignas(64) std::atomic<size_t> tail_{0};
+        size_t cached_head_ = 0;
+    };
+
+} // namespace blackbox::common
+
+#endif // BLACKBOX_COMMON_SPSC_QUEUE_H
@@ -1,26 +1,53 @@
 /**
  * @file system_stats.h
  * @brief Resource Usage Monitor (Linux /proc interface).
- * 
+ *
  * Reads process-level CPU and Memory usage.
  * Essential for Kubernetes Liveness probes and Grafana dashboards.
+ *
+ * Readings are cached: the /proc files stay open and are re-read with
+ * pread() at most once per refresh interval, however many callers
+ * (reporter, Prometheus scrapes) ask in between.
  */
 
 #ifndef BLACKBOX_COMMON_SYSTEM_STATS_H
 #define BLACKBOX_COMMON_SYSTEM_STATS_H
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace blackbox::common {
 
     class SystemStats {
     public:
+        // CPU usage of one thread named via ThreadUtils
+        struct ThreadCpu {
+            int tid = 0;
+            std::string name;
+            double cpu_percent = 0.0;   // 100.0 = one full core
+        };
+
+        struct Snapshot {
+            double cpu_percent = 0.0;   // Whole process, 0.0 to 100.0 * NumCores
+            size_t memory_bytes = 0;    // RSS
+            std::vector<ThreadCpu> threads;
+        };
+
         // Singleton
         SystemStats(const SystemStats&) = delete;
         SystemStats& operator=(const SystemStats&) = delete;
         static SystemStats& instance();
 
+        /**
+         * @brief Copies the cached readings into 'out', refreshing them first
+         * if they are older than max_age. 'out' keeps its capacity across calls.
+         */
+        void snapshot(Snapshot& out, std::chrono::milliseconds max_age = DEFAULT_MAX_AGE);
+
         /**
          * @brief Get Resident Set Size (Physical Memory) usage.
          * @return Bytes used by the process.
@@ -28,10 +55,8 @@ namespace blackbox::common {
         size_t get_memory_usage_bytes();
 
         /**
-         * @brief Calculate CPU usage percentage since last call.
-         * 
-         * This is stateful. It compares /proc/stat times between calls.
-         * 
+         * @brief CPU usage percentage between the last two refreshes.
+         *
          * @return double Percentage (0.0 to 100.0 * NumCores)
          */
         double get_cpu_usage_percent();
@@ -42,16 +67,43 @@ namespace blackbox::common {
          */
         long get_uptime_seconds();
 
+        static constexpr std::chrono::milliseconds DEFAULT_MAX_AGE{1000};
+
     private:
         SystemStats();
+        ~SystemStats();
+
+        // Per-thread /proc/self/task/<tid>/stat reader
+        struct ThreadState {
+            int tid = 0;
+            int fd = -1;
+            unsigned long long last_time = 0;
+            bool primed = false;        // last_time holds a real sample
+        };
+
+        /**
+         * @brief Re-reads /proc if the cache is older than max_age. Caller holds mutex_.
+         */
+        void refresh_locked(std::chrono::milliseconds max_age);
+
+        std::mutex mutex_;
+        Snapshot cached_;
+        std::chrono::steady_clock::time_point refreshed_at_{};
+
+        // Open /proc handles
+        int stat_fd_ = -1;      // /proc/stat
+        int self_stat_fd_ = -1; // /proc/self/stat
+        int statm_fd_ = -1;     // /proc/self/statm
+        std::vector<ThreadState> thread_states_;
 
         // CPU Calculation State
         unsigned long long last_total_time_ = 0;
         unsigned long long last_proc_time_ = 0;
-        
+        long num_cores_ = 1;
+
         long page_size_kb_ = 4; // Default 4KB
     };
 
 } // namespace blackbox::common
 
-#endif // BLACKBOX_COMMON_SYSTEM_STATS_H
\ No newline at end of file
+#endif // BLACKBOX_COMMON_SYSTEM_STATS_H
@@ -4,6 +4,9 @@
  * 
  * Provides utilities to pin threads to specific CPU cores 
  * and set real-time scheduling priorities.
+ *
+ * Named threads are also recorded (name + kernel tid) so the metrics
+ * exporter can report per-thread CPU usage.
  */
 
 #ifndef BLACKBOX_COMMON_THREAD_UTILS_H
@@ -17,13 +20,25 @@ namespace blackbox::common {
 
     class ThreadUtils {
     public:
+        struct ThreadInfo {
+            int tid;            // Kernel thread id (/proc/self/task/<tid>)
+            std::string name;
+        };
+
         /**
          * @brief Sets the name of the current thread.
          * Visible in tools like 'htop' and 'gdb'.
          * Limit: 15 chars on Linux.
+         * The thread is added to the registry returned by named_threads().
          */
         static void set_current_thread_name(const std::string& name);
 
+        /**
+         * @brief Every thread named through set_current_thread_name().
+         * Entries for exited threads remain; readers skip tids that are gone.
+         */
+        static std::vector<ThreadInfo> named_threads();
+
         /**
          * @brief Pins the current thread to a specific CPU Core ID.
          * 
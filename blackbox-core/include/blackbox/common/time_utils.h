@@ -4,12 +4,18 @@
  *
  * Optimized timestamp formatting to avoid the overhead of
  * std::stringstream and std::locale in hot paths.
+ *
+ * Calendar math is done in integers (days <-> civil date), so neither
+ * the formatters nor the parsers call into libc time functions. The
+ * formatters keep a per-thread cache of the current "YYYY-MM-DD" prefix,
+ * so rows from the same day only format the time of day. All times are UTC.
  */
 
 #ifndef BLACKBOX_COMMON_TIME_UTILS_H
 #define BLACKBOX_COMMON_TIME_UTILS_H
 
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <chrono>
 
@@ -17,6 +23,9 @@ namespace blackbox::common {
 
     class TimeUtils {
     public:
+        // "YYYY-MM-DD HH:MM:SS.mmm" (ClickHouse DateTime64(3))
+        static constexpr size_t CLICKHOUSE_MS_LENGTH = 23;
+
         /**
          * @brief Get current system time in Nanoseconds.
          * Useful for precise latency tracking.
@@ -40,6 +49,12 @@ namespace blackbox::common {
          */
         static std::string to_clickhouse_format(uint64_t timestamp_ms);
 
+        /**
+         * @brief Writes "YYYY-MM-DD HH:MM:SS.mmm" (CLICKHOUSE_MS_LENGTH chars,
+         * no NUL) to out. No allocation; the date part is cached per thread.
+         */
+        static void format_clickhouse_ms(uint64_t timestamp_ms, char* out);
+
         /**
          * @brief Fast conversion to ISO 8601 "YYYY-MM-DDTHH:MM:SS.mmmZ".
          * Used for JSON logs.
@@ -48,13 +63,40 @@ namespace blackbox::common {
 
         /**
          * @brief Parses standard Syslog date "MMM dd HH:mm:ss".
-         * e.g., "Dec 12 10:00:00" -> Epoch Seconds.
+         * e.g., "Dec 12 10:00:00" -> Epoch Milliseconds.
          *
          * Handles year inference (Syslog doesn't include year).
          */
         static uint64_t parse_syslog_time(const std::string& date_str);
+
+        /**
+         * @brief Fixed-width RFC 3164 timestamp "Mmm dd hh:mm:ss" -> epoch ns.
+         *
+         * The day may be space-padded ("Dec  2"). The year is taken from
+         * now_ns; a date more than two days in its future belongs to the
+         * previous year (December logs read in January). Interpreted as UTC.
+         *
+         * @return epoch ns, or 0 if the text is not a valid timestamp
+         */
+        static uint64_t parse_rfc3164(std::string_view text, uint64_t now_ns);
+
+        /**
+         * @brief RFC 3339 timestamp -> epoch ns.
+         *
+         * "YYYY-MM-DDThh:mm:ss[.frac](Z|+hh:mm|-hh:mm)"; 'T' may also be
+         * 't' or a space, and up to 9 fraction digits are kept.
+         *
+         * @param consumed If set, receives the number of characters parsed
+         * @return epoch ns, or 0 if the text is not a valid timestamp
+         */
+        static uint64_t parse_rfc3339(std::string_view text, size_t* consumed = nullptr);
+
+        /**
+         * @brief Days since 1970-01-01 for a proleptic Gregorian date.
+         */
+        static int64_t days_from_civil(int64_t year, unsigned month, unsigned day);
     };
 
 } // namespace blackbox::common
 
-#endif // BLACKBOX_COMMON_TIME_UTILS_H
\ No newline at end of file
+#endif // BLACKBOX_COMMON_TIME_UTILS_H
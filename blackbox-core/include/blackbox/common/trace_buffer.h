@@ -0,0 +1,112 @@
+/**
+ * @file trace_buffer.h
+ * @brief Sampled Per-Event Pipeline Tracing.
+ *
+ * A sampled event (1 in N, or every event from one source IP) carries a
+ * TraceEvent through the processing loop; each stage boundary stamps
+ * TscClock ticks into it, and the finished event is copied into a
+ * fixed-size lock-free ring. Unsampled events pay one countdown per
+ * event plus a null check per stage.
+ *
+ * The admin endpoint dumps the ring as Chrome trace-event JSON
+ * (opens in Perfetto / chrome://tracing), one track per event.
+ */
+
+#ifndef BLACKBOX_COMMON_TRACE_BUFFER_H
+#define BLACKBOX_COMMON_TRACE_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "blackbox/common/tsc_clock.h"
+
+namespace blackbox::common {
+
+    // Stage boundaries, in pipeline order
+    enum class TracePoint : uint8_t {
+        IngestPush,     // RingBuffer::push (from LogEvent::timestamp_ns)
+        Pop,
+        Parse,
+        GeoIP,
+        Rules,
+        Inference,
+        Alert,
+        Enqueue,
+        COUNT
+    };
+
+    struct TraceEvent {
+        static constexpr size_t POINTS = static_cast<size_t>(TracePoint::COUNT);
+        static constexpr size_t SOURCE_MAX = 47;
+
+        uint64_t stamps[POINTS] = {};     // TscClock ticks, 0 = stage not reached
+        char source[SOURCE_MAX + 1] = {}; // Source host/IP (truncated)
+        float score = 0.0f;
+        bool critical = false;
+
+        void mark(TracePoint point) { stamps[static_cast<size_t>(point)] = TscClock::now(); }
+        void set_source(std::string_view host);
+    };
+
+    class TraceBuffer {
+    public:
+        /**
+         * @param capacity Events kept (rounded up to a power of two)
+         * @param sample_every Trace 1 in N events (0 = no periodic sampling)
+         * @param source_filter Also trace every event from this host (empty = none)
+         */
+        TraceBuffer(size_t capacity, uint32_t sample_every, std::string source_filter);
+
+        TraceBuffer(const TraceBuffer&) = delete;
+        TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+        /**
+         * @brief Sampling decision for one event. Per-thread countdown, no shared writes.
+         */
+        bool should_sample(std::string_view source) {
+            if (!source_filter_.empty() && source == source_filter_) return true;
+            if (sample_every_ == 0) return false;
+            thread_local uint32_t countdown = 1;
+            if (--countdown != 0) return false;
+            countdown = sample_every_;
+            return true;
+        }
+
+        /**
+         * @brief Copies a finished event into the ring (lock-free, any thread).
+         * The oldest event is overwritten when the ring is full.
+         */
+        void publish(const TraceEvent& event);
+
+        /**
+         * @brief Chrome trace-event JSON of the newest 'limit' events (0 = all).
+         * Safe to call while events are being published; torn slots are skipped.
+         */
+        std::string to_chrome_json(size_t limit = 0) const;
+
+        uint64_t published() const { return write_pos_.load(std::memory_order_relaxed); }
+        size_t capacity() const { return mask_ + 1; }
+
+        static const char* span_name(TracePoint end_point);
+
+    private:
+        // Seqlock slot: seq = 2*pos+1 while writing, 2*pos+2 once complete
+        struct Slot {
+            std::atomic<uint64_t> seq{0};
+            TraceEvent event;
+        };
+
+        std::unique_ptr<Slot[]> slots_;
+        size_t mask_;
+        uint32_t sample_every_;
+        std::string source_filter_;
+
+        alignas(64) std::atomic<uint64_t> write_pos_{0};
+    };
+
+} // namespace blackbox::common
+
+#endif // BLACKBOX_COMMON_TRACE_BUFFER_H
@@ -0,0 +1,88 @@
+/**
+ * @file tsc_clock.h
+ * @brief Cycle-Counter Timestamps for Tracing.
+ *
+ * now() reads the invariant TSC (rdtsc, a few ns, no syscall). Ticks
+ * are converted to wall-clock nanoseconds with a linear model
+ * calibrated once against system_clock, so TSC stamps and the ingest
+ * timestamps (LogEvent::timestamp_ns) share one timeline.
+ *
+ * Without an invariant TSC (or off x86) now() falls back to
+ * CLOCK_MONOTONIC nanoseconds and the same conversion applies.
+ */
+
+#ifndef BLACKBOX_COMMON_TSC_CLOCK_H
+#define BLACKBOX_COMMON_TSC_CLOCK_H
+
+#include <cstdint>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BLACKBOX_HAS_RDTSC 1
+#endif
+
+namespace blackbox::common {
+
+    class TscClock {
+    public:
+        /**
+         * @brief Current tick count (TSC cycles, or monotonic ns as fallback).
+         */
+        static uint64_t now() {
+#ifdef BLACKBOX_HAS_RDTSC
+            if (use_tsc_) return __rdtsc();
+#endif
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+        }
+
+        /**
+         * @brief Like now(), but waits for earlier instructions to retire
+         * (rdtscp). Use to close a measured region.
+         */
+        static uint64_t now_end() {
+#ifdef BLACKBOX_HAS_RDTSC
+            if (use_tsc_) {
+                unsigned aux;
+                return __rdtscp(&aux);
+            }
+#endif
+            return now();
+        }
+
+        /**
+         * @brief Measures the tick rate against the wall clock (~10 ms, once).
+         * Call at startup, before any thread converts ticks; later calls are no-ops.
+         */
+        static void calibrate();
+
+        /**
+         * @brief Tick count -> wall-clock ns since epoch.
+         */
+        static uint64_t to_wall_ns(uint64_t ticks);
+
+        /**
+         * @brief Wall-clock ns since epoch -> tick count (e.g. for ingest timestamps).
+         */
+        static uint64_t from_wall_ns(uint64_t wall_ns);
+
+        /**
+         * @brief Tick delta -> ns.
+         */
+        static uint64_t to_ns(uint64_t ticks);
+
+        static bool uses_tsc() { return use_tsc_; }
+        static double ticks_per_ns() { return ticks_per_ns_; }
+
+    private:
+        static inline bool use_tsc_ = false;
+        static inline double ticks_per_ns_ = 1.0;
+        static inline uint64_t anchor_ticks_ = 0;
+        static inline uint64_t anchor_wall_ns_ = 0;
+    };
+
+} // namespace blackbox::common
+
+#endif // BLACKBOX_COMMON_TSC_CLOCK_H
@@ -0,0 +1,135 @@
+/**
+ * @file wait_strategy.h
+ * @brief Spin-then-Park Waiting for Queue Consumers.
+ *
+ * An idle consumer first spins (cheap re-checks with a CPU pause hint),
+ * then yields, then parks on a futex. The producer pays for a wake-up
+ * syscall only when the consumer is actually parked: otherwise notify()
+ * is a fence and one load.
+ *
+ * Parking always has a timeout, so consumers that also do periodic work
+ * while idle (e.g. flushing stale staged rows) keep doing it.
+ *
+ * Modes:
+ *  - "spin":     never parks (dedicated, isolated core; lowest latency)
+ *  - "latency":  long spin, then park
+ *  - "balanced": short spin, a few yields, then park (default)
+ *  - "power":    park almost immediately
+ */
+
+#ifndef BLACKBOX_COMMON_WAIT_STRATEGY_H
+#define BLACKBOX_COMMON_WAIT_STRATEGY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace blackbox::common {
+
+    // Hint to the CPU that we are in a spin loop (frees the sibling hyperthread)
+    inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
+
+    /**
+     * @brief One-consumer futex parking spot, shared with the producer(s).
+     */
+    class Parker {
+    public:
+        /**
+         * @brief Consumer: sleep until notified or 'timeout', unless
+         * 'ready()' turns true after announcing the park.
+         */
+        template <typename Ready>
+        void park(Ready&& ready, std::chrono::microseconds timeout) {
+            parked_.store(1, std::memory_order_relaxed);
+            // Pairs with the fence in notify(): either the producer sees
+            // parked_ == 1, or we see its data in ready()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!ready()) wait(timeout);
+            parked_.store(0, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Producer: call after publishing data. Syscall only if parked.
+         */
+        void notify() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (parked_.load(std::memory_order_relaxed)) wake();
+        }
+
+        /**
+         * @brief Unconditional wake-up (shutdown).
+         */
+        void wake();
+
+        uint64_t parks() const { return parks_.load(std::memory_order_relaxed); }
+
+    private:
+        void wait(std::chrono::microseconds timeout);
+
+        std::atomic<uint32_t> parked_{0};   // Futex word
+        std::atomic<uint64_t> parks_{0};    // Times the consumer went to sleep
+    };
+
+    struct WaitPolicy {
+        uint32_t spin_rounds;                 // pause-loop re-checks before yielding
+        uint32_t yield_rounds;                // sched_yield re-checks before parking
+        bool park;                            // false: keep yielding forever
+        std::chrono::microseconds park_timeout;
+
+        /**
+         * @brief Named presets: "spin", "latency", "balanced", "power".
+         * Unknown names fall back to "balanced".
+         */
+        static WaitPolicy from_name(const std::string& name);
+    };
+
+    /**
+     * @brief Consumer-side state machine (one per consumer thread).
+     *
+     * Usage:
+     *   if (!queue.pop(x)) { strategy.idle(parker, [&] { return !queue.empty(); }); continue; }
+     *   strategy.reset();
+     */
+    class WaitStrategy {
+    public:
+        explicit WaitStrategy(WaitPolicy policy) : policy_(policy) {}
+
+        // Found work: the next idle period starts with spinning again
+        void reset() { rounds_ = 0; }
+
+        // Nothing to do: spend one round of the current phase
+        template <typename Ready>
+        void idle(Parker& parker, Ready&& ready) {
+            if (rounds_ < policy_.spin_rounds) {
+                ++rounds_;
+                cpu_relax();
+            } else if (rounds_ < policy_.spin_rounds + policy_.yield_rounds || !policy_.park) {
+                ++rounds_;
+                std::this_thread::yield();
+            } else {
+                parker.park(ready, policy_.park_timeout);
+            }
+        }
+
+        const WaitPolicy& policy() const { return policy_; }
+
+    private:
+        WaitPolicy policy_;
+        uint32_t rounds_ = 0;
+    };
+
+} // namespace blackbox::common
+
+#endif // BLACKBOX_COMMON_WAIT_STRATEGY_H
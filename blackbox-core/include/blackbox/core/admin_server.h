@@ -1,28 +1,47 @@
 /**
  * @file admin_server.h
  * @brief Lightweight HTTP Server for Ops.
- * 
+ *
  * Exposes /health and /metrics endpoints for Kubernetes and Prometheus.
- * Uses Boost.Asio for async TCP handling.
+ * Other components can register extra GET routes (e.g. /query/recent).
+ *
+ * Async HTTP/1.1 with keep-alive on the server's own io_context and
+ * single background thread: no thread per connection, so a noisy
+ * scraper or a port scan can never take threads from ingestion.
+ * Connections are capped and every request/response has a deadline.
+ * Large bodies (/debug/trace, /query/recent) are streamed to HTTP/1.1
+ * clients as chunks, each write with its own deadline.
  */
 
 #ifndef BLACKBOX_CORE_ADMIN_SERVER_H
 #define BLACKBOX_CORE_ADMIN_SERVER_H
 
 #include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <thread>
 
 namespace blackbox::core {
 
     using boost::asio::ip::tcp;
 
+    // Receives the raw query string (text after '?'), returns the response body
+    using RouteHandler = std::function<std::string(const std::string& query)>;
+
+    class AdminSession;
+
     class AdminServer {
     public:
         /**
          * @brief Initialize the Admin Server.
-         * 
+         *
          * @param port The TCP port to listen on (default 8081)
          */
         explicit AdminServer(short port);
@@ -38,7 +57,18 @@ namespace blackbox::core {
          */
         void stop();
 
+        /**
+         * @brief Registers a GET endpoint. Must be called before start().
+         *
+         * Handlers run on the admin thread, one at a time, so they must not
+         * block on locks held by the processing threads.
+         */
+        void add_route(const std::string& path, RouteHandler handler,
+                       std::string content_type = "application/json");
+
     private:
+        friend class AdminSession;
+
         /**
          * @brief The main event loop for the background thread.
          */
@@ -50,24 +80,101 @@ namespace blackbox::core {
         void start_accept();
 
         /**
-         * @brief Reads request, generates response, writes back.
+         * @brief Generates the HTTP response body (empty = 404).
          */
-        void handle_session(std::shared_ptr<tcp::socket> socket);
+        std::string generate_response(const std::string& request_path, std::string& content_type);
 
-        /**
-         * @brief Generates the HTTP response string.
-         */
-        std::string generate_response(const std::string& request_path);
+        struct Route {
+            RouteHandler handler;
+            std::string content_type;
+        };
 
         // Network Resources
         std::shared_ptr<boost::asio::io_context> io_context_;
         std::unique_ptr<tcp::acceptor> acceptor_;
         std::thread worker_thread_;
-        
+
+        // Read-only once the server is started
+        std::map<std::string, Route> routes_;
+
+        // Limits (from Settings::network())
+        size_t max_connections_;
+        std::chrono::milliseconds timeout_;
+        size_t active_sessions_ = 0;   // Admin thread only
+
         short port_;
-        bool running_ = false;
+        std::atomic<bool> running_{false};
+    };
+
+    /**
+     * @brief One keep-alive admin connection.
+     * Keeps a shared_ptr to itself (enable_shared_from_this) to stay alive
+     * during async operations; everything runs on the admin thread.
+     */
+    class AdminSession : public std::enable_shared_from_this<AdminSession> {
+    public:
+        AdminSession(tcp::socket socket, AdminServer& server);
+        ~AdminSession();
+
+        void start();
+
+    private:
+        void do_read();
+
+        /**
+         * @brief Serves every complete request in the buffer, then reads more.
+         * Headers are scanned incrementally, never twice.
+         */
+        void process_buffer();
+
+        /**
+         * @brief Parses one request head [0, head_len) and queues its response.
+         */
+        void handle_request(std::string_view head);
+
+        /**
+         * @brief Builds the status line and headers in front of 'body_'.
+         */
+        void prepare_response(std::string_view status, std::string_view content_type,
+                              bool send_body, std::string_view extra_headers = {});
+
+        /**
+         * @brief Writes the head and the body, or the next chunk of a
+         * streamed body (one call per chunk).
+         */
+        void do_write();
+
+        /**
+         * @brief (Re)arms the deadline for the current read or write.
+         */
+        void arm_timer();
+        void close();
+
+        tcp::socket socket_;
+        boost::asio::steady_timer timer_;
+        AdminServer& server_;
+
+        // Request side
+        static constexpr size_t MAX_HEAD_BYTES = 8192;
+        std::array<char, 4096> read_buffer_;
+        std::string request_;          // Unparsed bytes (may hold pipelined requests)
+        size_t scan_from_ = 0;         // Where to resume the header terminator search
+
+        // Response side: head and body go out in one gathered write,
+        // bodies above STREAM_THRESHOLD as chunks of STREAM_CHUNK
+        static constexpr size_t STREAM_THRESHOLD = 64 * 1024;
+        static constexpr size_t STREAM_CHUNK = 16 * 1024;
+        std::string head_;
+        std::string body_;
+        size_t body_sent_ = 0;
+        bool chunked_ = false;
+        std::array<char, 24> chunk_size_;   // "<hex>\r\n" of the chunk being written
+        size_t chunk_size_len_ = 0;
+        bool http11_ = true;
+        bool keep_alive_ = true;
+        bool closed_ = false;
     };
 
 } // namespace blackbox::core
 
-#endif // BLACKBOX_CORE_ADMIN_SERVER_H
\ No newline at end of file
+#endif // BLACKBOX_CORE_ADMIN_SERVER_H
@@ -0,0 +1,96 @@
+/**
+ * @file batch_controller.h
+ * @brief Adaptive Micro-Batch Sizing for the Detect Stage.
+ *
+ * Replaces the fixed BLACKBOX_AI_BATCH_SIZE with an AIMD controller that
+ * re-tunes two knobs every control interval:
+ *  - batch size:    grows additively while its input queue backs up and the
+ *                   end-to-end p99 is within budget; halves when the p99
+ *                   exceeds the budget.
+ *  - fill deadline: how long a started batch may wait for more events.
+ *                   Grows only while batches run partly filled under
+ *                   steady traffic with ample headroom; halves otherwise.
+ *                   A trickle of events is never held back.
+ *
+ * The latency signal is the p99 of Stage::EndToEnd over the last
+ * interval (delta of two LatencyHistograms snapshots), so the controller
+ * adds no timing of its own to the hot path.
+ *
+ * Owned and driven by one detect thread; the published values are
+ * atomics so /metrics can read them from any thread.
+ */
+
+#ifndef BLACKBOX_CORE_BATCH_CONTROLLER_H
+#define BLACKBOX_CORE_BATCH_CONTROLLER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "blackbox/common/latency_histogram.h"
+
+namespace blackbox::core {
+
+    struct BatchLimits {
+        size_t initial_batch = 32;
+        size_t min_batch = 8;
+        size_t max_batch = 512;
+        uint64_t max_wait_us = 200;       // Upper bound of the fill deadline
+        uint64_t p99_budget_us = 50000;   // End-to-end p99 target
+        uint64_t interval_ms = 100;       // Control period
+        bool adaptive = true;             // false: fixed initial_batch, no waiting
+    };
+
+    class BatchController {
+    public:
+        /**
+         * @param queue_capacity Depth of the queue batches are taken from;
+         * every bound in 'limits' is capped at half of it
+         */
+        BatchController(const BatchLimits& limits, size_t queue_capacity);
+
+        // Current knobs (owning thread)
+        size_t batch_size() const { return batch_; }
+        uint64_t wait_ns() const { return wait_us_ * 1000; }
+
+        /**
+         * @brief Reports one finished batch.
+         * @param occupancy Queue occupancy seen when the batch started
+         * @param collected Events in the batch
+         * @param now_ns    TimeUtils::now_ns() (drives the control period)
+         */
+        void on_batch(size_t occupancy, size_t collected, uint64_t now_ns);
+
+        // Published for /metrics (any thread)
+        size_t published_batch_size() const { return pub_batch_.load(std::memory_order_relaxed); }
+        uint64_t published_wait_us() const { return pub_wait_us_.load(std::memory_order_relaxed); }
+        uint64_t published_p99_ns() const { return pub_p99_ns_.load(std::memory_order_relaxed); }
+
+    private:
+        // One control step from the interval's averages
+        void adjust(uint64_t p99_ns, bool latency_known, double avg_occupancy, double avg_fill);
+
+        // p99 of EndToEnd since the previous call (0 if too few samples)
+        uint64_t window_p99(bool& known);
+
+        BatchLimits limits_;
+        size_t queue_capacity_;
+
+        size_t batch_;
+        uint64_t wait_us_ = 0;
+
+        // Interval accumulators
+        uint64_t interval_start_ns_ = 0;
+        uint64_t batches_ = 0;
+        uint64_t occupancy_sum_ = 0;
+        uint64_t fill_sum_ = 0;
+
+        common::LatencyHistograms::Snapshot previous_;
+
+        std::atomic<size_t> pub_batch_;
+        std::atomic<uint64_t> pub_wait_us_{0};
+        std::atomic<uint64_t> pub_p99_ns_{0};
+    };
+
+} // namespace blackbox::core
+
+#endif // BLACKBOX_CORE_BATCH_CONTROLLER_H
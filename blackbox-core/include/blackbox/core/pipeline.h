@@ -1,6 +1,15 @@
 /**
  * @file pipeline.h
  * @brief The Main Data Processing Engine.
+ *
+ * Stage graph (each stage on its own thread(s), joined by bounded queues):
+ *
+ *   ingest (io) -> ring -> parse -> enrich xN -> detect xM -> persist
+ *                                                              |
+ *                                        alert dispatcher <----+
+ *
+ * A full queue stalls the stage feeding it; the stall reaches the ingest
+ * ring, where UDP/TCP drop and count.
  */
 
 #ifndef BLACKBOX_CORE_PIPELINE_H
@@ -20,14 +29,19 @@
 #include "blackbox/parser/parser_engine.h"
 #include "blackbox/analysis/inference_engine.h"
 #include "blackbox/analysis/rule_engine.h"
+#include "blackbox/analysis/alert_dispatcher.h"
 #include "blackbox/enrichment/geoip_service.h"
 
 // Storage & Output
 #include "blackbox/storage/storage_engine.h"
 #include "blackbox/storage/redis_client.h"
+#include "blackbox/storage/recent_store.h"
 
 // Ops
 #include "blackbox/core/admin_server.h"
+#include "blackbox/core/batch_controller.h"
+#include "blackbox/core/stage_queue.h"
+#include "blackbox/common/trace_buffer.h"
 
 namespace blackbox::core {
 
@@ -43,12 +57,15 @@ namespace blackbox::core {
     private:
         // Thread Functions
         void ingest_worker();
-        void processing_worker();
+        void parse_worker();
+        void enrich_worker(size_t index);
+        void detect_worker(size_t index);
+        void persist_worker();
 
         // State
         std::atomic<bool> running_{false};
         std::thread ingest_thread_;
-        std::thread processing_thread_;
+        std::vector<std::thread> stage_threads_;
 
         // --- COMPONENTS ---
 
@@ -64,13 +81,29 @@ namespace blackbox::core {
 
         // 3. The Brains
         parser::ParserEngine parser_;
-        std::unique_ptr<analysis::InferenceEngine> brain_;
+        std::vector<std::unique_ptr<analysis::InferenceEngine>> brains_; // One per detect thread
         std::unique_ptr<analysis::RuleEngine> rule_engine_;
         std::unique_ptr<enrichment::GeoIPService> geoip_;
 
         // 4. Persistence & Notifications
         storage::StorageEngine storage_;
         std::unique_ptr<storage::RedisClient> redis_;
+        std::unique_ptr<analysis::AlertDispatcher> alerts_; // Publishes through redis_
+
+        // 5. Recent history for /query/recent (null when disabled)
+        std::unique_ptr<storage::RecentEventStore> recent_;
+
+        // 6. Sampled stage tracing for /debug/trace (null when disabled)
+        std::unique_ptr<common::TraceBuffer> trace_;
+
+        // 7. Stage graph: pooled events and the queue into each stage
+        std::unique_ptr<EventPool> pool_;
+        std::unique_ptr<StageQueue> to_enrich_;
+        std::unique_ptr<StageQueue> to_detect_;
+        std::unique_ptr<StageQueue> to_persist_;
+
+        // 8. Micro-batch size / fill deadline, one per detect thread
+        std::vector<std::unique_ptr<BatchController>> batchers_;
     };
 
 } // namespace blackbox::core
@@ -0,0 +1,150 @@
+/**
+ * @file stage_queue.h
+ * @brief Event Envelopes and Bounded Queues Between Pipeline Stages.
+ *
+ * The pipeline runs as a chain of stages (parse -> enrich -> detect ->
+ * persist), each with its own thread(s). An event travels as a pointer
+ * to a StageEvent taken from a fixed EventPool: the raw bytes and the
+ * ParsedLog views into them stay put while the pointer moves, so a hop
+ * costs one queue operation and no copy.
+ *
+ * Backpressure: StageQueue::push() waits while the next queue is full.
+ * A slow stage therefore stalls its producers one by one up to the
+ * parse stage, which stops draining the ingest ring; UDP/TCP then drop
+ * and count (blackbox_ingest_backpressure_drops_total). Nothing is
+ * dropped between stages.
+ */
+
+#ifndef BLACKBOX_CORE_STAGE_QUEUE_H
+#define BLACKBOX_CORE_STAGE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "blackbox/common/memory.h"
+#include "blackbox/common/mpmc_queue.h"
+#include "blackbox/common/trace_buffer.h"
+#include "blackbox/common/wait_strategy.h"
+#include "blackbox/ingest/ring_buffer.h"
+#include "blackbox/parser/parser_engine.h"
+
+namespace blackbox::core {
+
+    /**
+     * @brief One event in flight between stages (pooled, never copied).
+     */
+    struct StageEvent {
+        ingest::LogEvent raw;        // Owns the bytes 'log' points into
+        parser::ParsedLog log;
+
+        // Verdict (detect stage)
+        float score = 0.0f;
+        bool critical = false;
+        std::string reason;
+
+        // Sampled stage trace
+        bool traced = false;
+        common::TraceEvent trace;
+
+        // Clears the per-event state before reuse (keeps string capacity)
+        void reset() {
+            score = 0.0f;
+            critical = false;
+            reason.clear();
+            traced = false;
+        }
+    };
+
+    /**
+     * @brief Fixed set of StageEvents, allocated once at startup.
+     */
+    class EventPool {
+    public:
+        /**
+         * @param events Pool size (allocated and constructed up front)
+         * @param memory Placement (huge pages, NUMA node of the stages)
+         */
+        EventPool(size_t events, const common::MemoryPolicy& memory);
+
+        EventPool(const EventPool&) = delete;
+        EventPool& operator=(const EventPool&) = delete;
+
+        // nullptr if every event is in flight
+        StageEvent* acquire();
+        void release(StageEvent* event);
+
+        size_t size() const { return size_; }
+        size_t in_flight() const { return size_ - free_.size(); }
+
+    private:
+        size_t size_;
+        common::MappedArray<StageEvent> events_;
+        common::MpmcQueue<StageEvent*> free_;
+    };
+
+    /**
+     * @brief Bounded MPMC hand-off into one stage, with a parking spot
+     * per consumer thread.
+     */
+    class StageQueue {
+    public:
+        /**
+         * @param name Stage fed by this queue (metric names)
+         * @param capacity Events (rounded up to a power of two)
+         * @param consumers Threads of the receiving stage
+         */
+        StageQueue(std::string name, size_t capacity, size_t consumers);
+
+        StageQueue(const StageQueue&) = delete;
+        StageQueue& operator=(const StageQueue&) = delete;
+
+        /**
+         * @brief Producer: waits while the queue is full (backpressure).
+         * @return false only if 'running' turned false while waiting
+         */
+        bool push(StageEvent* event, const std::atomic<bool>& running);
+
+        /**
+         * @brief Consumer: nullptr if empty.
+         */
+        StageEvent* try_pop() {
+            StageEvent* event = nullptr;
+            return queue_.try_pop(event) ? event : nullptr;
+        }
+
+        /**
+         * @brief Consumer 'index': nothing popped, wait per 'strategy'.
+         */
+        void wait(size_t index, common::WaitStrategy& strategy) {
+            strategy.idle(parkers_[index], [this] { return !queue_.empty(); });
+        }
+
+        /**
+         * @brief Wakes every parked consumer (shutdown).
+         */
+        void wake_all();
+
+        const std::string& name() const { return name_; }
+        size_t size() const { return queue_.size(); }
+        size_t capacity() const { return queue_.capacity(); }
+
+        // Pushes that found the queue full (for /metrics)
+        uint64_t full_waits() const { return full_waits_.load(std::memory_order_relaxed); }
+
+    private:
+        void notify() {
+            for (size_t i = 0; i < consumers_; ++i) parkers_[i].notify();
+        }
+
+        std::string name_;
+        common::MpmcQueue<StageEvent*> queue_;
+        size_t consumers_;
+        std::unique_ptr<common::Parker[]> parkers_;
+        std::atomic<uint64_t> full_waits_{0};
+    };
+
+} // namespace blackbox::core
+
+#endif // BLACKBOX_CORE_STAGE_QUEUE_H
@@ -0,0 +1,151 @@
+/**
+ * @file ban_filter.h
+ * @brief Early Drop of Banned Sources at the Ingest Sockets.
+ *
+ * The firewall drops banned sources in the kernel, but only once the
+ * firewall thread has applied the ban, and not at all with the dry-run
+ * backend. The listeners check this filter first, before rate limiting,
+ * string conversion or the ring buffer copy.
+ *
+ * Readers never lock: the banned set is an immutable Snapshot (sorted
+ * keys + bloom filter) published through an atomic pointer. The writer
+ * (BlockListManager's firewall thread) builds a new snapshot per batch of
+ * changes and swaps it in. Replaced snapshots are reclaimed by epoch: each
+ * reading thread announces the epoch it entered in its own slot, and a
+ * snapshot is freed only once no announced epoch predates its
+ * replacement, however long a reader was preempted.
+ *
+ * Optionally (BLACKBOX_BAN_BPF=1) short IPv4 ban lists are also compiled
+ * into a classic BPF filter on the UDP socket, so those datagrams never
+ * reach user space at all.
+ */
+
+#ifndef BLACKBOX_INGEST_BAN_FILTER_H
+#define BLACKBOX_INGEST_BAN_FILTER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "blackbox/common/ip_address.h"
+
+namespace blackbox::ingest {
+
+    class BanFilter {
+    public:
+        // Singleton Access
+        BanFilter(const BanFilter&) = delete;
+        BanFilter& operator=(const BanFilter&) = delete;
+        static BanFilter& instance();
+
+        /**
+         * @brief True if the source is banned. Lock-free, safe from any thread.
+         */
+        bool contains(const common::IpKey& ip) const {
+            if (banned_.load(std::memory_order_relaxed) == 0) return false; // Common case: no bans
+
+            ReaderSlot* slot = reader_slot();
+            if (!slot) return contains_locked(ip);
+
+            // Announce, then load: the writer sees the announcement of any
+            // reader that may still hold the snapshot it replaced
+            slot->epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+            const Snapshot* snapshot = current_.load(std::memory_order_seq_cst);
+
+            const uint64_t h = common::IpKeyHash{}(ip);
+            const bool found = snapshot->might_contain(h) &&
+                               std::binary_search(snapshot->keys.begin(), snapshot->keys.end(), ip);
+
+            slot->epoch.store(0, std::memory_order_release);
+            return found;
+        }
+
+        /**
+         * @brief Applies one batch of changes and publishes a new snapshot.
+         * Called by BlockListManager (single writer).
+         */
+        void update(const std::vector<common::IpKey>& added,
+                    const std::vector<common::IpKey>& removed);
+
+        // Number of banned addresses in the published snapshot
+        size_t size() const { return banned_.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Registers a UDP socket for the optional kernel-side filter.
+         * No-op unless enabled in settings. Call detach_socket() before closing it.
+         */
+        void attach_socket(int fd);
+        void detach_socket(int fd);
+
+    private:
+        BanFilter();
+        ~BanFilter();
+
+        struct Snapshot {
+            std::vector<common::IpKey> keys; // Sorted
+            std::vector<uint64_t> bloom;     // Power-of-two number of bits
+            uint64_t bloom_mask = 0;         // Bits - 1
+
+            // 3 probes from one 64-bit hash (double hashing)
+            bool might_contain(uint64_t h) const {
+                const uint64_t step = (h >> 32) | 1;
+                for (int i = 0; i < 3; ++i) {
+                    const uint64_t bit = (h + i * step) & bloom_mask;
+                    if (!(bloom[bit >> 6] & (uint64_t(1) << (bit & 63)))) return false;
+                }
+                return true;
+            }
+            void add(uint64_t h) {
+                const uint64_t step = (h >> 32) | 1;
+                for (int i = 0; i < 3; ++i) {
+                    const uint64_t bit = (h + i * step) & bloom_mask;
+                    bloom[bit >> 6] |= uint64_t(1) << (bit & 63);
+                }
+            }
+        };
+
+        // One per reading thread; 0 = not inside contains()
+        struct alignas(64) ReaderSlot {
+            std::atomic<uint64_t> epoch{0};
+            std::atomic<bool> owned{false};
+        };
+        static constexpr size_t READER_SLOTS = 64;
+
+        // This thread's slot, claimed on first use and released when the
+        // thread exits; null once every slot is taken
+        ReaderSlot* reader_slot() const;
+
+        // Fallback for threads without a slot: reads under the writer lock
+        bool contains_locked(const common::IpKey& ip) const;
+
+        // Builds the snapshot for 'keys' and swaps it in (writer side)
+        void publish(std::vector<common::IpKey> keys);
+
+        // Frees retired snapshots no announced reader epoch can still see
+        void reclaim();
+
+        // (Re)loads the BPF program on every registered socket
+        void refresh_socket_filters(const std::vector<common::IpKey>& keys);
+
+        std::atomic<const Snapshot*> current_;
+        std::atomic<size_t> banned_{0};     // Keys in current_
+        std::atomic<uint64_t> epoch_{1};    // Bumped on every publish
+        mutable std::array<ReaderSlot, READER_SLOTS> readers_;
+
+        // Writer state
+        mutable std::mutex writer_mutex_;
+        std::vector<common::IpKey> master_; // Sorted, authoritative
+        // Replaced snapshots, with the epoch that replaced them
+        std::deque<std::pair<uint64_t, std::unique_ptr<const Snapshot>>> retired_;
+        std::unique_ptr<const Snapshot> live_; // Owner of current_
+
+        std::vector<int> sockets_; // Sockets carrying the kernel filter
+    };
+
+} // namespace blackbox::ingest
+
+#endif // BLACKBOX_INGEST_BAN_FILTER_H
@@ -0,0 +1,158 @@
+/**
+ * @file overload_controller.h
+ * @brief Priority-Aware Load Shedding at Ingest.
+ *
+ * Without this, a full ring drops whatever arrives next: a debug line
+ * and "Failed password for root" are equally likely to be lost. The
+ * controller engages before that point, driven by the fill level of the
+ * ingest ring and of the stage queues (whichever is higher):
+ *
+ *  - level 0: below the engage watermark (or back below the release
+ *             watermark). Everything is admitted; nothing is classified.
+ *  - level 1: above the engage watermark. Each message is classified
+ *             and kept 1 in N, per class.
+ *  - level 2: above the severe watermark. N is multiplied for every
+ *             class except Critical.
+ *
+ * Classification reads only the bytes already in hand:
+ *  - Critical: PRI severity emerg..err, or a source that alerted recently
+ *  - High:     auth/authpriv/audit/alert facilities, severity warning,
+ *              or a configured priority source
+ *  - Normal:   notice/info, or no PRI at all
+ *  - Low:      debug
+ *
+ * A kept event carries its sampling rate as sample_weight down to its
+ * ClickHouse row, so sum(sample_weight) re-estimates the original volume.
+ */
+
+#ifndef BLACKBOX_INGEST_OVERLOAD_CONTROLLER_H
+#define BLACKBOX_INGEST_OVERLOAD_CONTROLLER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "blackbox/common/ip_address.h"
+#include "blackbox/common/settings.h"
+
+namespace blackbox::ingest {
+
+    enum class TrafficClass : uint8_t {
+        Critical,
+        High,
+        Normal,
+        Low,
+        COUNT
+    };
+
+    class OverloadController {
+    public:
+        static constexpr size_t CLASSES = static_cast<size_t>(TrafficClass::COUNT);
+
+        struct Admission {
+            bool keep;
+            uint32_t weight;    // Events this one stands for (1 = not sampled)
+        };
+
+        // Singleton Access
+        OverloadController(const OverloadController&) = delete;
+        OverloadController& operator=(const OverloadController&) = delete;
+        static OverloadController& instance();
+
+        /**
+         * @brief Applies the settings. Call before the listeners start.
+         */
+        void configure(const common::OverloadConfig& config);
+
+        /**
+         * @brief Ingest decision for one message (listener threads).
+         * Not overloaded: two atomic loads, no classification.
+         * @param source Socket peer (nullptr if unknown)
+         * @param ring_fill Ingest ring occupancy, 0..1
+         */
+        Admission admit(const char* data, size_t len, const common::IpKey* source, double ring_fill) {
+            const uint8_t level = update_level(std::max(to_permille(ring_fill),
+                                                        stage_permille_.load(std::memory_order_relaxed)));
+            if (level == 0) return {true, 1};
+            return sample(classify(data, len, source), level);
+        }
+
+        /**
+         * @brief An admitted message was dropped anyway (ring full): count it per class.
+         */
+        void count_dropped(const char* data, size_t len, const common::IpKey* source);
+
+        /**
+         * @brief Fullest stage queue, 0..1 (sampled by the parse stage).
+         */
+        void set_stage_pressure(double fill) {
+            stage_permille_.store(to_permille(fill), std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief A source raised an alert: keep its events at full rate
+         * for the configured time. Lock-free, any thread.
+         */
+        void note_alert(const common::IpKey& source);
+
+        TrafficClass classify(const char* data, size_t len, const common::IpKey* source) const;
+
+        /**
+         * @brief <PRI> at the start of a syslog message (0..191), -1 if absent.
+         */
+        static int parse_pri(const char* data, size_t len);
+
+        static const char* class_name(TrafficClass cls);
+
+        // For /metrics
+        uint8_t level() const { return level_.load(std::memory_order_relaxed); }
+        uint64_t shed(TrafficClass cls) const { return counters_[index(cls)].shed.load(std::memory_order_relaxed); }
+        uint64_t dropped(TrafficClass cls) const { return counters_[index(cls)].dropped.load(std::memory_order_relaxed); }
+
+    private:
+        OverloadController();
+
+        static constexpr size_t HOT_SLOTS = 4096;   // Recently alerted sources (direct-mapped)
+
+        struct alignas(64) ClassCounters {
+            std::atomic<uint64_t> seen{0};      // Drives 1-in-N sampling
+            std::atomic<uint64_t> shed{0};      // Sampled out
+            std::atomic<uint64_t> dropped{0};   // Admitted, then ring full
+        };
+
+        static size_t index(TrafficClass cls) { return static_cast<size_t>(cls); }
+
+        static uint32_t to_permille(double fill) {
+            return fill <= 0.0 ? 0 : fill >= 1.0 ? 1000 : static_cast<uint32_t>(fill * 1000.0);
+        }
+
+        // Hysteresis; logs transitions
+        uint8_t update_level(uint32_t permille);
+
+        Admission sample(TrafficClass cls, uint8_t level);
+
+        bool recently_alerted(const common::IpKey& source) const;
+
+        bool enabled_ = true;
+        uint32_t engage_permille_ = 500;
+        uint32_t severe_permille_ = 850;
+        uint32_t release_permille_ = 250;
+        std::array<uint32_t, CLASSES> keep_every_{1, 1, 4, 16};   // Level 1
+        uint32_t severe_factor_ = 8;
+        uint32_t hot_ttl_sec_ = 300;
+        std::vector<common::IpKey> priority_sources_;             // Sorted
+
+        // Hot sources: (hash tag << 32) | expiry second, 0 = empty
+        std::unique_ptr<std::atomic<uint64_t>[]> hot_;
+
+        alignas(64) std::atomic<uint8_t> level_{0};
+        std::atomic<uint32_t> stage_permille_{0};
+        std::array<ClassCounters, CLASSES> counters_;
+    };
+
+} // namespace blackbox::ingest
+
+#endif // BLACKBOX_INGEST_OVERLOAD_CONTROLLER_H
@@ -10,6 +10,8 @@
 #include <vector>
 #include <cstdint>
 #include <cstddef>
+#include "blackbox/common/memory.h"
+#include "blackbox/common/wait_strategy.h"
 
 namespace blackbox::ingest {
 
@@ -18,6 +20,14 @@ namespace blackbox::ingest {
         uint64_t timestamp_ns;
         char raw_data[4096]; // Fixed size 4KB buffer
         size_t length;
+        uint32_t sample_weight; // Events this one stands for (overload sampling, 1 = all kept)
+    };
+
+    // One message for RingBuffer::push_batch (bytes are copied)
+    struct RawMessage {
+        const char* data;
+        size_t length;
+        uint32_t sample_weight;
     };
 
     /**
@@ -28,16 +38,27 @@ namespace blackbox::ingest {
     template <size_t Capacity>
     class RingBuffer {
     public:
-        RingBuffer();
+        /**
+         * @param memory Placement of the slots (huge pages, consumer's NUMA node)
+         */
+        explicit RingBuffer(const common::MemoryPolicy& memory = common::MemoryPolicy{});
         ~RingBuffer() = default;
 
         /**
          * @brief Writer method (Called by UDP Server)
          * @param data Raw bytes
          * @param len Length of bytes
+         * @param sample_weight OverloadController weight of this event
          * @return true if successful, false if full
          */
-        bool push(const char* data, size_t len);
+        bool push(const char* data, size_t len, uint32_t sample_weight = 1);
+
+        /**
+         * @brief Writer method for several messages at once (TCP framing):
+         * one index commit and at most one consumer wake-up for all of them.
+         * @return Messages pushed, a prefix of 'messages' (fewer if full)
+         */
+        size_t push_batch(const RawMessage* messages, size_t count);
 
         /**
          * @brief Reader method (Called by AI Worker)
@@ -46,14 +67,48 @@ namespace blackbox::ingest {
          */
         bool pop(LogEvent& out_event);
 
+        /**
+         * @brief Consumer: nothing popped, wait per 'strategy' (spin, yield,
+         * then park until the next push).
+         */
+        void wait_for_data(common::WaitStrategy& strategy) {
+            strategy.idle(parker_, [this] { return !empty(); });
+        }
+
+        /**
+         * @brief Wakes a parked consumer (shutdown).
+         */
+        void wake_consumer() { parker_.wake(); }
+
+        bool empty() const {
+            return tail_.load(std::memory_order_relaxed) == head_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Approximate occupancy (for metrics; safe from any thread).
+         */
+        size_t size() const {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            return (head + Capacity - tail) % Capacity;
+        }
+
+        static constexpr size_t capacity() { return Capacity; }
+
     private:
-        // Storage
-        std::vector<LogEvent> buffer_;
+        static void write_slot(LogEvent& slot, const char* data, size_t len,
+                               uint32_t sample_weight, uint64_t timestamp_ns);
+
+        // Storage (~256 MB at 65536 slots: huge pages cut the TLB misses)
+        common::MappedArray<LogEvent> buffer_;
 
         // Indices with Cache Padding to prevent False Sharing
         // We align to 64 bytes (common cache line size)
         alignas(64) std::atomic<size_t> head_;
         alignas(64) std::atomic<size_t> tail_;
+
+        // Consumer parking spot; push() wakes it only while parked
+        alignas(64) common::Parker parker_;
     };
 
 } // namespace blackbox::ingest
@@ -0,0 +1,72 @@
+/**
+ * @file stream_framer.h
+ * @brief Splits a TCP syslog stream into messages (RFC 6587).
+ *
+ * Two framings are in use on syslog/TCP and relays may mix them:
+ *
+ *  - Octet counting (3.4.1): "<MSG-LEN> <MSG>", e.g. "52 <34>1 ...".
+ *    rsyslog and syslog-ng use it so multi-line messages survive.
+ *  - Non-transparent framing (3.4.2): messages end with LF (a trailing
+ *    CR is dropped).
+ *
+ * The framing is detected per frame, as rsyslog does: a frame that
+ * starts with a non-zero digit run followed by a space is octet-counted,
+ * anything else runs to the next LF. Syslog messages start with '<', so
+ * the two cannot be confused on conforming input.
+ *
+ * Complete frames are returned as views into the read buffer; the only
+ * copy is for a frame split across reads, which goes through a fixed
+ * carry buffer of one event slot. Frames longer than a slot (4 KB) are
+ * truncated, like the ring would, instead of being dropped.
+ */
+
+#ifndef BLACKBOX_INGEST_STREAM_FRAMER_H
+#define BLACKBOX_INGEST_STREAM_FRAMER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "blackbox/ingest/ring_buffer.h"
+
+namespace blackbox::ingest {
+
+    class StreamFramer {
+    public:
+        // Longest frame kept (the rest is discarded): one event slot
+        static constexpr size_t MAX_FRAME = sizeof(LogEvent::raw_data);
+
+        /**
+         * @brief Takes frames from [cursor, end) into 'frames'.
+         *
+         * Call until cursor == end. Each call either consumes the rest of
+         * the read or returns at least one frame. Returned frames stay
+         * valid until the next call (one of them may point into the carry
+         * buffer) and have sample_weight 1.
+         *
+         * @return Number of frames written (<= max_frames)
+         */
+        size_t extract(const char*& cursor, const char* end, RawMessage* frames, size_t max_frames);
+
+    private:
+        enum class State : uint8_t {
+            FrameStart,   // Next byte begins a frame
+            Length,       // Reading the MSG-LEN digits
+            Counted,      // Inside an octet-counted frame
+            Line          // Inside an LF-terminated frame
+        };
+
+        void append_carry(const char* data, size_t len);
+
+        State state_ = State::FrameStart;
+        size_t length_ = 0;       // MSG-LEN being parsed
+        uint32_t digits_ = 0;
+        size_t remaining_ = 0;    // Bytes left in the counted frame
+
+        // Start of a frame split across reads
+        char carry_[MAX_FRAME];
+        size_t carry_len_ = 0;
+        bool carry_truncated_ = false;
+    };
+
+} // namespace blackbox::ingest
+
+#endif // BLACKBOX_INGEST_STREAM_FRAMER_H
@@ -3,7 +3,8 @@
  * @brief Reliable Log Ingestion (RFC 5424 / RFC 3164 via TCP).
  *
  * Handles multiple concurrent TCP connections.
- * buffers incoming streams and splits them by '\n' delimiters.
+ * Each read is split into frames (octet-counted or LF, see StreamFramer)
+ * and the frames of one read enter the ring in a single batch.
  */
 
 #ifndef BLACKBOX_INGEST_TCP_SERVER_H
@@ -11,8 +12,11 @@
 
 #include <boost/asio.hpp>
 #include <memory>
+#include <optional>
 #include <vector>
+#include "blackbox/common/ip_address.h"
 #include "blackbox/ingest/ring_buffer.h"
+#include "blackbox/ingest/stream_framer.h"
 
 namespace blackbox::ingest {
 
@@ -53,7 +57,12 @@ namespace blackbox::ingest {
      */
     class TcpSession : public std::enable_shared_from_this<TcpSession> {
     public:
-        TcpSession(tcp::socket socket, RingBuffer<65536>& buffer);
+        /**
+         * @param peer Binary source address, re-checked against the ban
+         *             filter on every read
+         */
+        TcpSession(tcp::socket socket, std::optional<common::IpKey> peer,
+                   RingBuffer<65536>& buffer);
 
         void start();
 
@@ -61,19 +70,29 @@ namespace blackbox::ingest {
         void do_read();
 
         /**
-         * @brief Scans buffer for newlines and pushes complete logs to RingBuffer.
+         * @brief Frames the read and pushes complete logs to RingBuffer.
          */
         void process_buffer(size_t bytes_transferred);
 
+        /**
+         * @brief Overload admission + one ring push for a batch of frames.
+         * Compacts 'frames' in place to the admitted ones.
+         */
+        void push_frames(RawMessage* frames, size_t count);
+
         tcp::socket socket_;
+        std::optional<common::IpKey> peer_;
         RingBuffer<65536>& ring_buffer_;
 
         // 64KB Read Buffer
         enum { max_length = 65536 };
         char data_[max_length];
 
+        // Frames per ring commit (a 64 KB read of short lines takes a few)
+        static constexpr size_t FRAME_BATCH = 64;
+
         // Handling split messages (half a log arriving in one packet, half in next)
-        std::string sticky_buffer_;
+        StreamFramer framer_;
     };
 
 } // namespace blackbox::ingest
@@ -4,6 +4,7 @@
  * 
  * Capabilities:
  * - Zero-Allocation Receive Loop
+ * - Early Drop of Banned Sources (BanFilter)
  * - Integrated DDoS Protection (Rate Limiting)
  * - Atomic Metrics Tracking
  */
@@ -31,6 +32,8 @@ namespace blackbox::ingest {
         UdpServer(boost::asio::io_context& io_context, 
                   RingBuffer<65536>& buffer);
 
+        ~UdpServer();
+
         // Disable copying
         UdpServer(const UdpServer&) = delete;
         UdpServer& operator=(const UdpServer&) = delete;
@@ -44,9 +47,10 @@ namespace blackbox::ingest {
         /**
          * @brief Callback when a packet arrives.
          * 
-         * 1. Checks Rate Limit.
-         * 2. Updates Metrics.
-         * 3. Pushes to RingBuffer.
+         * 1. Drops banned sources.
+         * 2. Checks Rate Limit.
+         * 3. Updates Metrics.
+         * 4. Pushes to RingBuffer.
          */
         void handle_receive(const boost::system::error_code& error,
                             std::size_t bytes_transferred);
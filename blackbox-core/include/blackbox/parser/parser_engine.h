@@ -9,18 +9,29 @@
 #define BLACKBOX_PARSER_ENGINE_H
 
 #include <vector>
+#include <string>
 #include <string_view>
 #include <array>
+#include "blackbox/common/id_generator.h"
 #include "blackbox/ingest/ring_buffer.h"
+#include "blackbox/parser/tokenizer.h"
+#include "blackbox/parser/feature_scaler.h"
 
 namespace blackbox::parser {
 
     // The structured output after parsing
     struct ParsedLog {
+        common::Uuid id;          // v4 or v7 (event correlation), 16 raw bytes
         uint64_t timestamp;
+        uint32_t sample_weight = 1; // > 1: kept 1 in N under overload
         std::string_view host;    // Points to raw buffer
         std::string_view service; // Points to raw buffer
         std::string_view message; // Points to raw buffer
+
+        // GeoIP Enrichment (filled by the Pipeline)
+        std::string country;
+        double lat = 0.0;
+        double lon = 0.0;
         
         // The numerical representation for xInfer
         // Fixed size array for stack allocation speed (e.g., 768 dim BERT or 128 dim Autoencoder)
@@ -6,12 +6,23 @@
 #ifndef BLACKBOX_STORAGE_CLICKHOUSE_CLIENT_H
 #define BLACKBOX_STORAGE_CLICKHOUSE_CLIENT_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
-#include "blackbox/storage/storage_engine.h" // For DBRow definition
+#include "blackbox/storage/row_batch.h" // For DBRow definition
 
 namespace blackbox::storage {
 
+    /**
+     * @brief Outcome of one INSERT, as far as retrying is concerned.
+     */
+    enum class WriteResult : uint8_t {
+        Ok,         // HTTP 200
+        Retry,      // Transport error, 5xx, 408 or 429: ClickHouse may take it later
+        Rejected    // Any other 4xx (bad query, missing column): it never will
+    };
+
     class ClickHouseClient {
     public:
         /**
@@ -23,22 +34,41 @@ namespace blackbox::storage {
 
         /**
          * @brief Executes a batch INSERT query.
-         * 
-         * Formats the C++ structs into a SQL INSERT statement 
+         *
+         * Formats the C++ structs into a SQL INSERT statement
          * and sends it via HTTP POST.
-         * 
+         *
          * @param rows The batch of data to write
          * @return true if HTTP 200 OK, false otherwise
          */
         bool insert_logs(const std::vector<DBRow>& rows);
 
+        /**
+         * @brief Sends a pre-built query via HTTP POST.
+         *
+         * Thread-safe: every calling thread reuses its own CURL handle,
+         * so several batches can be in flight at once.
+         *
+         * @param query The full SQL statement (see begin_insert/append_row)
+         * @return Ok on HTTP 200; Retry or Rejected depending on the failure
+         */
+        WriteResult execute(std::string_view query);
+
+        /**
+         * @brief Writes the "INSERT INTO sentry.logs (...) VALUES " prefix.
+         */
+        static void begin_insert(std::string& out);
+
+        /**
+         * @brief Appends one "(...)" tuple to an INSERT being built.
+         * @param first Set for the first row (controls the ',' separator)
+         */
+        static void append_row(std::string& out, const DBRow& row, bool first);
+
     private:
         std::string host_;
-
-        // Helper to escape strings for SQL (prevent injection/errors)
-        std::string escape_string(const std::string& input);
     };
 
 } // namespace blackbox::storage
 
-#endif // BLACKBOX_STORAGE_CLICKHOUSE_CLIENT_H
\ No newline at end of file
+#endif // BLACKBOX_STORAGE_CLICKHOUSE_CLIENT_H
@@ -0,0 +1,114 @@
+/**
+ * @file disk_spool.h
+ * @brief Durable Overflow Queue for ClickHouse Batches.
+ *
+ * When ClickHouse is slow or down, serialized INSERT batches are
+ * appended to segmented, append-only files on local disk instead of
+ * piling up in RAM. A replayer drains them (oldest first) once the
+ * server recovers, and a restart picks up whatever was left behind.
+ *
+ * On-disk layout (every block is 4 KB aligned for O_DIRECT):
+ *   [Segment Header][Record Header | INSERT payload | zero pad] ...
+ * Each record carries a CRC32C, so a torn write at the tail of a
+ * segment is detected and skipped during replay.
+ */
+
+#ifndef BLACKBOX_STORAGE_DISK_SPOOL_H
+#define BLACKBOX_STORAGE_DISK_SPOOL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace blackbox::storage {
+
+    class DiskSpool {
+    public:
+        /**
+         * @brief Open (or create) the spool directory and recover old segments.
+         *
+         * @param dir Directory holding the segment files
+         * @param max_bytes Total disk budget; appends beyond it are refused
+         * @param segment_bytes Size at which the active segment is sealed
+         */
+        DiskSpool(std::string dir, uint64_t max_bytes, uint64_t segment_bytes);
+        ~DiskSpool();
+
+        DiskSpool(const DiskSpool&) = delete;
+        DiskSpool& operator=(const DiskSpool&) = delete;
+
+        /**
+         * @brief False if the directory could not be used (spooling disabled).
+         */
+        bool is_ready() const { return ready_; }
+
+        /**
+         * @brief Durably append one serialized batch.
+         * @return false if the spool is disabled, full or the write failed
+         */
+        bool append(std::string_view payload, uint32_t rows);
+
+        /**
+         * @brief Read the oldest undelivered batch (does not remove it).
+         * @return false if nothing is waiting
+         */
+        bool peek(std::string& payload, uint32_t& rows);
+
+        /**
+         * @brief Drop the batch returned by the last peek() (it was delivered).
+         */
+        void commit();
+
+        bool empty() const;
+        uint64_t depth_bytes() const;
+        uint64_t depth_rows() const;
+
+        /**
+         * @brief Age of the oldest spooled batch in milliseconds (0 if empty).
+         */
+        uint64_t oldest_age_ms() const;
+
+    private:
+        struct Segment {
+            uint64_t seq = 0;
+            std::string path;
+            uint64_t size = 0;        // Bytes written (header included)
+            uint64_t created_ms = 0;
+            bool sealed = false;
+        };
+
+        void recover();
+        bool open_segment();
+        void seal_active();
+        void remove_front();
+        std::string segment_path(uint64_t seq) const;
+
+        std::string dir_;
+        uint64_t max_bytes_;
+        uint64_t segment_bytes_;
+        bool ready_ = false;
+
+        mutable std::mutex mutex_;
+        std::deque<Segment> segments_;  // Oldest first; back() may be active
+        int active_fd_ = -1;
+        uint64_t next_seq_ = 1;
+        uint64_t total_bytes_ = 0;
+        uint64_t total_rows_ = 0;
+
+        // Read cursor inside segments_.front()
+        uint64_t read_offset_ = 0;
+        uint64_t peeked_bytes_ = 0;   // Size of the record handed out by peek()
+        uint32_t peeked_rows_ = 0;
+        uint64_t oldest_record_ms_ = 0;
+
+        // 4 KB aligned scratch for O_DIRECT writes
+        char* write_buffer_ = nullptr;
+        size_t write_capacity_ = 0;
+    };
+
+} // namespace blackbox::storage
+
+#endif // BLACKBOX_STORAGE_DISK_SPOOL_H
@@ -0,0 +1,165 @@
+/**
+ * @file recent_store.h
+ * @brief In-Process Columnar Store of Recent Events.
+ *
+ * Keeps the last few minutes of scored events in RAM so operators can
+ * slice them through the admin API without waiting for the ClickHouse
+ * flush. Memory is fixed at construction: a ring of time-bucketed
+ * segments, each holding plain columns (timestamp, score, flags) plus
+ * dictionary-encoded host and service ids.
+ *
+ * Concurrency: exactly one writer (the processing thread) appends.
+ * Readers never lock; each segment carries a generation counter
+ * (seqlock) and a published row count, so a query only reads rows that
+ * were fully written and discards a segment that got recycled mid-scan.
+ */
+
+#ifndef BLACKBOX_STORAGE_RECENT_STORE_H
+#define BLACKBOX_STORAGE_RECENT_STORE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "blackbox/common/memory.h"
+#include "blackbox/parser/parser_engine.h" // For ParsedLog definition
+
+namespace blackbox::storage {
+
+    /**
+     * @brief Filter + aggregation over the recent window.
+     * Unset optionals match everything.
+     */
+    struct RecentQuery {
+        std::optional<std::string> host;
+        std::optional<std::string> service;
+        uint64_t from_ms = 0;                  // Inclusive
+        uint64_t to_ms = UINT64_MAX;           // Inclusive
+        float min_score = -1.0f;               // Inclusive
+        float max_score = 2.0f;                // Inclusive
+        bool alerts_only = false;
+
+        enum class GroupBy { None, Host, Service } group_by = GroupBy::None;
+        size_t limit = 10;                     // Top groups returned (by count)
+    };
+
+    struct RecentAggregate {
+        std::string key;         // Host or service; empty when not grouped
+        uint64_t count = 0;
+        uint64_t alerts = 0;
+        double score_sum = 0.0;
+        float score_max = 0.0f;
+        uint64_t first_ms = UINT64_MAX;
+        uint64_t last_ms = 0;
+    };
+
+    struct RecentResult {
+        RecentAggregate total;
+        std::vector<RecentAggregate> groups;   // Sorted by count, descending
+        uint64_t rows_scanned = 0;
+        uint32_t segments_scanned = 0;
+        uint32_t segments_skipped = 0;         // Pruned by time range or dictionary
+
+        // Rows a host/service filter could not be checked against: the value
+        // is not in a full dictionary, so it may hide among the overflow rows
+        // (only their id is stored). Non-zero means the totals are a lower bound.
+        uint64_t rows_unresolved = 0;
+        bool partial() const { return rows_unresolved > 0; }
+    };
+
+    class RecentEventStore {
+    public:
+        /**
+         * @param window_ms Span of history to keep
+         * @param memory_bytes Budget for all segments (allocated up front)
+         * @param memory Placement of the segments (huge pages, writer's NUMA node)
+         */
+        RecentEventStore(uint64_t window_ms, size_t memory_bytes,
+                         const common::MemoryPolicy& memory = common::MemoryPolicy{});
+        ~RecentEventStore();
+
+        RecentEventStore(const RecentEventStore&) = delete;
+        RecentEventStore& operator=(const RecentEventStore&) = delete;
+
+        /**
+         * @brief Records one scored event. Single writer only; never blocks.
+         */
+        void append(const parser::ParsedLog& log, float score, bool is_alert);
+
+        /**
+         * @brief Runs a lock-free scan. Safe from any thread, concurrently with append().
+         */
+        RecentResult query(const RecentQuery& q) const;
+
+        /**
+         * @brief Renders a RecentResult as JSON (admin API body).
+         */
+        static std::string to_json(const RecentResult& result);
+
+        /**
+         * @brief Builds a RecentQuery from a URL query string
+         * (host, service, since_sec, from_ms, to_ms, min_score, max_score,
+         * alerts, group_by, limit).
+         */
+        static RecentQuery parse_query_string(std::string_view qs);
+
+        size_t segment_count() const { return segments_.size(); }
+
+        // Layout (public so the .cpp helpers can use it)
+        static constexpr size_t SEGMENT_ROWS = 16384;
+        static constexpr size_t DICT_ENTRIES = 1024;  // Distinct values per segment and column
+        static constexpr size_t DICT_TEXT = 47;       // Longer values are truncated
+        static constexpr uint16_t DICT_OVERFLOW = DICT_ENTRIES; // Id used once a dictionary is full
+
+        struct DictEntry {
+            uint8_t len;
+            char text[DICT_TEXT];
+        };
+
+        struct Dictionary {
+            std::array<DictEntry, DICT_ENTRIES> entries;
+            std::array<uint16_t, DICT_ENTRIES * 2> slots; // Writer-only hash index (id + 1, 0 = empty)
+            std::atomic<uint32_t> size{0};                // Published entry count
+
+            void clear();
+            uint16_t encode(std::string_view value);                // Writer
+            std::optional<uint16_t> find(std::string_view value) const; // Reader
+        };
+
+        struct Segment {
+            std::atomic<uint64_t> generation{0}; // Odd while being recycled
+            std::atomic<uint32_t> rows{0};       // Published row count
+            std::atomic<uint64_t> min_ms{UINT64_MAX};
+            std::atomic<uint64_t> max_ms{0};
+            uint64_t bucket = 0;                 // Writer-only: time bucket index
+
+            alignas(64) std::array<uint64_t, SEGMENT_ROWS> ts_ms;
+            alignas(64) std::array<float, SEGMENT_ROWS> score;
+            alignas(64) std::array<uint16_t, SEGMENT_ROWS> host_id;
+            alignas(64) std::array<uint16_t, SEGMENT_ROWS> service_id;
+            alignas(64) std::array<uint8_t, SEGMENT_ROWS> alert;
+
+            Dictionary hosts;
+            Dictionary services;
+        };
+
+    private:
+        /**
+         * @brief Moves the writer to the next segment, recycling the oldest.
+         */
+        void rotate(uint64_t bucket);
+
+        uint64_t window_ms_;
+        uint64_t bucket_ms_;
+        common::MappedArray<Segment> segments_;   // One mapping for the whole budget
+        size_t active_ = 0;          // Writer-only
+        bool started_ = false;       // Writer-only
+    };
+
+} // namespace blackbox::storage
+
+#endif // BLACKBOX_STORAGE_RECENT_STORE_H
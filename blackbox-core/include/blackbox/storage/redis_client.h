@@ -4,13 +4,27 @@
  *
  * Used to broadcast "Critical Alerts" to the Go API (Tower)
  * for real-time dashboard visualization.
+ *
+ * publish() only copies the alert into a bounded SPSC queue; a
+ * dedicated publisher thread owns the hiredis connection, pipelines
+ * PUBLISH commands and reads the replies in bulk. When Redis is down
+ * or slow the queue fills and new alerts are dropped (and counted)
+ * rather than stalling the caller.
  */
 
 #ifndef BLACKBOX_STORAGE_REDIS_CLIENT_H
 #define BLACKBOX_STORAGE_REDIS_CLIENT_H
 
-#include <string>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "blackbox/common/spsc_queue.h"
+
 // Forward declaration of hiredis context to keep header clean
 struct redisContext;
 
@@ -19,12 +33,16 @@ namespace blackbox::storage {
     class RedisClient {
     public:
         /**
-         * @brief Initialize connection to Redis.
+         * @brief Starts the publisher thread (it connects in the background).
          *
          * @param host Redis Hostname (e.g., "localhost" or "redis")
          * @param port Redis Port (default 6379)
          */
         RedisClient(const std::string& host, int port);
+
+        /**
+         * @brief Flushes what is queued (best effort) and stops the publisher.
+         */
         ~RedisClient();
 
         /**
@@ -33,27 +51,69 @@ namespace blackbox::storage {
         bool is_connected() const;
 
         /**
-         * @brief Publish a message to a channel.
+         * @brief Queue a message for a channel. Never blocks.
+         *
+         * Single producer: call from one thread only (the alert dispatcher).
+         * Messages are dropped when the queue is full or the alert does not
+         * fit in a slot.
          *
          * @param channel The channel name (e.g., "sentry_alerts")
          * @param message The JSON payload
+         * @return false if the message was dropped
          */
-        void publish(const std::string& channel, const std::string& message);
+        bool publish(std::string_view channel, std::string_view message);
+
+        uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+        size_t queued() const { return queue_->size(); }
 
     private:
+        // One queued alert, stored inline so publish() never allocates
+        static constexpr size_t SLOT_BYTES = 4096;
+        static constexpr size_t QUEUE_DEPTH = 1024;   // ~4 MB of buffered alerts
+        static constexpr size_t MAX_PIPELINE = 256;   // Commands per write/read round
+
+        struct AlertSlot {
+            uint16_t channel_len;
+            uint16_t message_len;
+            char data[SLOT_BYTES - 4];
+        };
+
         /**
          * @brief Internal helper to reconnect if connection dropped.
          */
         bool connect();
+        void disconnect();
+
+        /**
+         * @brief Background loop: drain queue -> pipelined PUBLISH -> bulk replies.
+         */
+        void publisher_worker();
+
+        /**
+         * @brief Sends up to MAX_PIPELINE queued alerts in one round trip.
+         * @return Number of alerts taken from the queue
+         */
+        size_t publish_batch();
 
         std::string host_;
         int port_;
 
-        redisContext* context_ = nullptr;
-        std::mutex mutex_; // hiredis is not thread-safe by default
-        bool connected_ = false;
+        redisContext* context_ = nullptr;       // Owned by the publisher thread
+        std::atomic<bool> connected_{false};
+
+        // Producer -> Publisher
+        std::unique_ptr<common::SpscQueue<AlertSlot, QUEUE_DEPTH>> queue_;
+        std::atomic<bool> running_{true};
+        std::atomic<bool> idle_{false};        // Publisher is (about to be) waiting
+        std::mutex wake_mutex_;
+        std::condition_variable wake_cv_;
+        std::thread publisher_thread_;
+
+        std::atomic<uint64_t> published_{0};
+        std::atomic<uint64_t> dropped_{0};
     };
 
 } // namespace blackbox::storage
 
-#endif // BLACKBOX_STORAGE_REDIS_CLIENT_H
\ No newline at end of file
+#endif // BLACKBOX_STORAGE_REDIS_CLIENT_H
@@ -0,0 +1,77 @@
+/**
+ * @file row_batch.h
+ * @brief Arena-backed batch of rows staged for ClickHouse.
+ *
+ * Each producer thread fills its own RowBatch: the row strings are
+ * bump-allocated into a fixed arena, so staging a row costs a few
+ * memcpy calls and no heap allocation. Full batches are handed to the
+ * StorageEngine flusher as a whole and recycled afterwards.
+ */
+
+#ifndef BLACKBOX_STORAGE_ROW_BATCH_H
+#define BLACKBOX_STORAGE_ROW_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include "blackbox/parser/parser_engine.h" // For ParsedLog definition
+
+namespace blackbox::storage {
+
+    // Represents a row to be inserted into ClickHouse.
+    // The views point into the arena of the owning RowBatch.
+    struct DBRow {
+        uint64_t timestamp;
+        common::Uuid id;
+        std::string_view host;
+        std::string_view country;
+        std::string_view service;
+        std::string_view message;
+        float anomaly_score;
+        bool is_alert;
+        uint32_t sample_weight;
+    };
+
+    class RowBatch {
+    public:
+        static constexpr size_t MAX_ROWS = 512;
+        static constexpr size_t ARENA_BYTES = 128 * 1024;
+
+        RowBatch();
+        ~RowBatch() = default;
+
+        RowBatch(const RowBatch&) = delete;
+        RowBatch& operator=(const RowBatch&) = delete;
+
+        /**
+         * @brief Copies a parsed log into the batch.
+         * @return false if the batch has no room left (rows or arena bytes)
+         */
+        bool append(const parser::ParsedLog& log, float score, bool is_alert);
+
+        /**
+         * @brief Forget all rows. The arena is kept for reuse.
+         */
+        void reset();
+
+        size_t size() const { return count_; }
+        bool empty() const { return count_ == 0; }
+        bool full() const { return count_ == MAX_ROWS; }
+
+        const DBRow* begin() const { return rows_.get(); }
+        const DBRow* end() const { return rows_.get() + count_; }
+
+    private:
+        // Bump-allocate a copy of 'str' (caller checked capacity)
+        std::string_view copy(std::string_view str);
+
+        std::unique_ptr<char[]> arena_;
+        std::unique_ptr<DBRow[]> rows_;
+        size_t used_ = 0;
+        size_t count_ = 0;
+    };
+
+} // namespace blackbox::storage
+
+#endif // BLACKBOX_STORAGE_ROW_BATCH_H
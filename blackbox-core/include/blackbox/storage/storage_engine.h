@@ -1,77 +1,202 @@
 /**
  * @file storage_engine.h
- * @brief Thread-safe Batch Writer for ClickHouse.
- * 
- * Manages background threads to flush logs to the database 
+ * @brief Lock-free Batch Writer for ClickHouse.
+ *
+ * Manages background threads to flush logs to the database
  * without blocking the main AI pipeline.
+ *
+ * Every producer thread stages rows into its own arena-backed RowBatch
+ * and hands full batches to the flusher through an SPSC queue, so the
+ * hot path takes no lock and performs no per-row heap allocation.
+ *
+ * When ClickHouse falls behind (all in-flight slots busy) or a batch
+ * still fails after every retry, the serialized INSERT is diverted to a
+ * DiskSpool instead of being held in RAM or dropped. A replayer drains
+ * the spool at a bounded rate once the server answers again. Delivery
+ * from the spool is at-least-once: a crash between a successful replay
+ * and its commit re-sends that batch on restart.
+ *
+ * A batch the server answers with a 4xx (bad query, missing column) is
+ * never retried or spooled, and a spooled one is skipped: it would fail
+ * the same way forever and hold up everything behind it.
  */
 
 #ifndef BLACKBOX_STORAGE_STORAGE_ENGINE_H
 #define BLACKBOX_STORAGE_STORAGE_ENGINE_H
 
+#include <cstdint>
 #include <vector>
+#include <deque>
+#include <string>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <chrono>
 #include <condition_variable>
 #include <atomic>
+#include "blackbox/common/spsc_queue.h"
 #include "blackbox/parser/parser_engine.h" // For ParsedLog definition
+#include "blackbox/storage/row_batch.h"
 
 namespace blackbox::storage {
 
-    // Represents a row to be inserted into ClickHouse
-    struct DBRow {
-        uint64_t timestamp;
-        std::string service;
-        std::string message;
-        float anomaly_score;
-        bool is_alert;
+    class ClickHouseClient;
+    class DiskSpool;
+    enum class WriteResult : uint8_t;
+
+    // A serialized INSERT waiting for (or undergoing) delivery
+    struct PendingInsert {
+        std::string query;
+        size_t rows = 0;
     };
 
     class StorageEngine {
     public:
         StorageEngine();
+
+        /**
+         * @brief Flushes everything still staged.
+         * All producer threads must have stopped calling enqueue() by now.
+         */
         ~StorageEngine();
 
         /**
-         * @brief Adds a processed log to the write queue.
-         * 
-         * This method is called by the AI Thread. It must be very fast.
-         * It just locks a mutex and pushes to a vector.
-         * 
+         * @brief Adds a processed log to the calling thread's staging batch.
+         *
+         * This method is called by the AI Thread(s). It must be very fast.
+         * No locks, no heap allocation; it never waits on the database.
+         *
          * @param log The data extracted by the Parser
          * @param score The float output from xInfer
          */
         void enqueue(const parser::ParsedLog& log, float score);
 
+        /**
+         * @brief Hands the calling thread's partial batch to the flusher.
+         *
+         * Producers call this when they go idle, so a quiet thread does not
+         * sit on rows past the flush interval.
+         */
+        void flush_local();
+
+        /**
+         * @brief INSERTs queued for or on the wire to ClickHouse (for metrics).
+         */
+        size_t inflight() const { return inflight_count_.load(std::memory_order_relaxed); }
+
     private:
+        // Batches in flight between one producer and the flusher
+        static constexpr size_t HANDOFF_DEPTH = 32;
+
+        struct Producer {
+            common::SpscQueue<RowBatch*, HANDOFF_DEPTH> full;  // Producer -> Flusher
+            common::SpscQueue<RowBatch*, HANDOFF_DEPTH> spare; // Flusher -> Producer
+            RowBatch* current = nullptr;                       // Owned by the producer thread
+            std::atomic<bool> flush_requested{false};          // Set by the flusher on age
+        };
+
+        /**
+         * @brief Returns (registering on first use) the calling thread's Producer.
+         */
+        Producer& local_producer();
+
         /**
-         * @brief The background loop that sends HTTP requests to ClickHouse.
+         * @brief Producer side: push 'current' to the flusher.
+         */
+        void publish(Producer& producer);
+
+        /**
+         * @brief Producer side: take a recycled batch (or allocate during warm-up).
+         */
+        RowBatch* acquire_batch(Producer& producer);
+
+        /**
+         * @brief Polls producers, serializes their batches and cuts INSERTs.
          */
         void flush_worker();
 
         /**
-         * @brief Sends a batch of rows to the DB.
-         * (In a real app, this wraps libcurl or clickhouse-cpp)
+         * @brief Appends a staged batch to 'pending', dispatching full INSERTs.
+         */
+        void serialize(const RowBatch& batch, PendingInsert& pending,
+                       std::chrono::steady_clock::time_point& pending_started);
+
+        /**
+         * @brief Hands an INSERT to the senders.
+         * Spools it when ClickHouse is unhealthy or every slot is busy; without
+         * a usable spool it blocks (the flush thread only) for a free slot.
+         */
+        void dispatch(PendingInsert&& insert);
+
+        /**
+         * @brief Background loop that POSTs queued INSERTs to ClickHouse.
+         */
+        void sender_worker();
+
+        /**
+         * @brief Sends one batch, retrying transient failures with exponential backoff.
+         * @return Ok, Rejected (not retried), or Retry once the attempts run out
+         */
+        WriteResult send_to_clickhouse(const PendingInsert& insert);
+
+        /**
+         * @brief Accounts for a batch ClickHouse refused (dropped, never spooled).
          */
-        void send_to_clickhouse(const std::vector<DBRow>& batch);
+        void reject(size_t rows);
 
-        // CONFIGURATION
-        const size_t BATCH_SIZE_THRESHOLD = 1000;
-        const std::chrono::milliseconds FLUSH_INTERVAL_MS{1000};
+        /**
+         * @brief Writes a batch to the disk spool.
+         * @return false if there is no spool or it is full
+         */
+        bool spool(const PendingInsert& insert);
+
+        /**
+         * @brief Background loop that drains the spool into ClickHouse (rate limited).
+         */
+        void replay_worker();
+
+        // CONFIGURATION (from Settings::db())
+        size_t batch_size_;
+        std::chrono::milliseconds flush_interval_;
+        size_t max_inflight_;
+        int max_retries_;
+        std::chrono::milliseconds retry_backoff_;
+        int replay_rows_per_sec_;
 
         // STATE
+        const uint64_t engine_id_; // Distinguishes engines in thread-local caches
         std::atomic<bool> running_;
-        std::vector<DBRow> current_batch_;
-        
-        // CONCURRENCY
-        std::mutex batch_mutex_;
+        std::unique_ptr<ClickHouseClient> client_;
+
+        // PRODUCER REGISTRY (locked once per producer thread, never per row)
+        std::mutex registry_mutex_;
+        std::vector<std::unique_ptr<Producer>> producers_;
+
+        // FLUSHER
+        std::mutex flush_mutex_; // Only guards the shutdown wake-up
         std::condition_variable cv_;
         std::thread worker_thread_;
-        
+
+        // CONCURRENCY (Flusher -> Senders)
+        std::deque<PendingInsert> inflight_queue_;
+        std::atomic<size_t> inflight_count_{0}; // Queued + currently on the wire (written under inflight_mutex_)
+        bool senders_stopping_ = false;
+        std::mutex inflight_mutex_;
+        std::condition_variable work_cv_;  // Senders wait for batches
+        std::condition_variable space_cv_; // Flusher waits for a free slot
+        std::vector<std::thread> sender_threads_;
+
+        // DISK SPOOL (null when disabled or the directory is unusable)
+        std::unique_ptr<DiskSpool> spool_;
+        std::atomic<bool> clickhouse_healthy_{true}; // Cleared on a failed batch, set on success
+        std::mutex replay_mutex_;                    // Only guards the shutdown wake-up
+        std::condition_variable replay_cv_;
+        std::thread replay_thread_;
+
         // METRICS
-        uint64_t total_written_ = 0;
+        std::atomic<uint64_t> total_written_{0};
     };
 
 } // namespace blackbox::storage
 
-#endif // BLACKBOX_STORAGE_STORAGE_ENGINE_H
\ No newline at end of file
+#endif // BLACKBOX_STORAGE_STORAGE_ENGINE_H
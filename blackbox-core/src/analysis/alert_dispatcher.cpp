@@ -0,0 +1,255 @@
+/**
+ * @file alert_dispatcher.cpp
+ * @brief Implementation of the Alert Stage.
+ */
+
+#include "blackbox/analysis/alert_dispatcher.h"
+#include "blackbox/analysis/alert_manager.h"
+#include "blackbox/common/json_writer.h"
+#include "blackbox/common/logger.h"
+#include "blackbox/common/metrics.h"
+#include "blackbox/common/settings.h"
+#include "blackbox/common/thread_utils.h"
+#include <algorithm>
+#include <cstring>
+
+namespace blackbox::analysis {
+
+    namespace {
+
+        // Upper bound on how long a queued record waits for a missed wake-up,
+        // and on how late a window is emitted
+        constexpr std::chrono::milliseconds IDLE_POLL{5};
+
+        // Copies at most 'cap' bytes without splitting a UTF-8 sequence
+        template <typename Len>
+        void copy_field(char* dst, size_t cap, Len& len, std::string_view src) {
+            const std::string_view cut = common::JsonWriter::utf8_prefix(src, cap);
+            std::memcpy(dst, cut.data(), cut.size());
+            len = static_cast<Len>(cut.size());
+        }
+
+        ingest::TokenBucket make_bucket(int rate, int burst) {
+            ingest::TokenBucket bucket;
+            bucket.max_burst = std::max(1, burst);
+            bucket.tokens = bucket.max_burst; // Start full
+            bucket.refill_rate = std::max(0, rate);
+            bucket.last_refill = std::chrono::steady_clock::now();
+            return bucket;
+        }
+
+    } // namespace
+
+    // =========================================================
+    // Constructor / Destructor
+    // =========================================================
+    AlertDispatcher::AlertDispatcher(storage::RedisClient* redis, std::string channel)
+        : redis_(redis), channel_(std::move(channel)),
+          queue_(std::make_unique<common::SpscQueue<AlertRecord, QUEUE_DEPTH>>())
+    {
+        const auto& cfg = common::Settings::instance().alerts();
+        window_ = std::chrono::milliseconds(std::max(0, cfg.window_ms));
+        log_bucket_ = make_bucket(cfg.log_rate, cfg.log_burst);
+        redis_bucket_ = make_bucket(cfg.redis_rate, cfg.redis_burst);
+        json_buffer_.resize(common::JsonWriter::max_escaped_size(sizeof(AlertRecord)) + 1024);
+
+        dispatcher_thread_ = std::thread(&AlertDispatcher::dispatcher_worker, this);
+    }
+
+    AlertDispatcher::~AlertDispatcher() {
+        running_ = false;
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+        }
+        wake_cv_.notify_all();
+        if (dispatcher_thread_.joinable()) {
+            dispatcher_thread_.join();
+        }
+    }
+
+    // =========================================================
+    // Submit (The Hot Path: copy into the queue, nothing else)
+    // =========================================================
+    bool AlertDispatcher::submit(std::string_view source, std::string_view reason, float score,
+                                 uint64_t timestamp_ns, std::string_view country, std::string_view message) {
+        AlertRecord* record = queue_->try_claim();
+        if (!record) {
+            // Dispatcher is behind: shed, don't stall the processing thread
+            common::Metrics::instance().inc_alerts_dropped(1);
+            return false;
+        }
+
+        record->timestamp_ns = timestamp_ns;
+        record->score = score;
+        copy_field(record->source, sizeof(record->source), record->source_len, source);
+        copy_field(record->reason, sizeof(record->reason), record->reason_len, reason);
+        copy_field(record->message, sizeof(record->message), record->message_len, message);
+        const size_t country_len = std::min(country.size(), sizeof(record->country) - 1);
+        std::memcpy(record->country, country.data(), country_len);
+        record->country[country_len] = '\0';
+        queue_->commit_push();
+
+        // Only pay for a wake-up when the dispatcher is actually parked
+        if (idle_.load(std::memory_order_seq_cst)) {
+            wake_cv_.notify_one();
+        }
+        return true;
+    }
+
+    // =========================================================
+    // Dispatcher Worker (Background Thread)
+    // =========================================================
+    void AlertDispatcher::dispatcher_worker() {
+        common::ThreadUtils::set_current_thread_name("BB_Alerts");
+
+        while (running_) {
+            // 1. Fold everything queued into the open windows
+            const auto now = std::chrono::steady_clock::now();
+            size_t folded = 0;
+            while (const AlertRecord* record = queue_->front()) {
+                fold(*record, now);
+                queue_->pop_front();
+                folded++;
+            }
+
+            // 2. Emit the windows that closed
+            flush_due(now, false);
+            if (folded > 0) continue;
+
+            // 3. Idle: park until submit() wakes us
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            idle_.store(true, std::memory_order_seq_cst);
+            if (queue_->empty()) {
+                wake_cv_.wait_for(lock, IDLE_POLL, [this] { return !running_ || !queue_->empty(); });
+            }
+            idle_.store(false, std::memory_order_relaxed);
+        }
+
+        // Shutdown: fold the rest and emit every open window
+        const auto now = std::chrono::steady_clock::now();
+        while (const AlertRecord* record = queue_->front()) {
+            fold(*record, now);
+            queue_->pop_front();
+        }
+        flush_due(now, true);
+    }
+
+    void AlertDispatcher::fold(const AlertRecord& record, std::chrono::steady_clock::time_point now) {
+        const std::string_view source(record.source, record.source_len);
+        const std::string_view reason(record.reason, record.reason_len);
+
+        // Active defense + dedup: per record, never shaped or aggregated.
+        // The cooldown table makes repeats of an open window a cheap probe.
+        const AlertOutcome outcome = AlertManager::instance().trigger_alert(source, record.score, reason);
+
+        std::string key;
+        key.reserve(source.size() + 1 + reason.size());
+        key.append(source).push_back('\0');
+        key.append(reason);
+
+        auto it = open_.find(key);
+        if (it == open_.end()) {
+            // Spoofed-source floods: past the cap, new sources share one
+            // summary per reason instead of growing the table (they were
+            // already handed to active defense above)
+            if (open_.size() >= MAX_AGGREGATES) {
+                key.assign("*").push_back('\0');
+                key.append(reason);
+                it = open_.find(key);
+            }
+            if (it == open_.end()) {
+                Aggregate aggregate;
+                aggregate.source = key.substr(0, key.find('\0'));
+                aggregate.reason = std::string(reason);
+                aggregate.country = record.country;
+                aggregate.message = std::string(record.message, record.message_len);
+                aggregate.first_seen_ns = record.timestamp_ns;
+                it = open_.emplace(key, std::move(aggregate)).first;
+                deadlines_.push_back(Deadline{now + window_, key});
+            }
+        }
+
+        Aggregate& aggregate = it->second;
+        aggregate.count++;
+        aggregate.first_seen_ns = std::min(aggregate.first_seen_ns, record.timestamp_ns);
+        aggregate.last_seen_ns = std::max(aggregate.last_seen_ns, record.timestamp_ns);
+        aggregate.max_score = std::max(aggregate.max_score, record.score);
+        if (outcome != AlertOutcome::Suppressed) aggregate.alerted++;
+        if (outcome == AlertOutcome::Blocked) aggregate.blocked++;
+    }
+
+    void AlertDispatcher::flush_due(std::chrono::steady_clock::time_point now, bool everything) {
+        while (!deadlines_.empty() && (everything || deadlines_.front().at <= now)) {
+            auto it = open_.find(deadlines_.front().key);
+            if (it != open_.end()) {
+                emit(it->second, now);
+                open_.erase(it);
+            }
+            deadlines_.pop_front();
+        }
+    }
+
+    // =========================================================
+    // Sinks
+    // =========================================================
+    void AlertDispatcher::emit(const Aggregate& summary, std::chrono::steady_clock::time_point now) {
+        auto& metrics = common::Metrics::instance();
+        metrics.inc_alert_summaries(1);
+
+        // 1. Log, including what active defense did in fold() (shaped, never flushing)
+        if (take_token(log_bucket_, now)) {
+            std::string action;
+            if (summary.source == "*") {
+                if (summary.blocked > 0) action = ", " + std::to_string(summary.blocked) + " sources blocked";
+                else if (summary.alerted > 0) action = ", " + std::to_string(summary.alerted) + " new threats";
+            } else {
+                if (summary.blocked > 0) action = ", source blocked";
+                else if (summary.alerted > 0) action = ", new threat";
+            }
+            LOG_WARN("Alert summary: " + summary.source + " [" + summary.reason + "] x" +
+                     std::to_string(summary.count) + ", max score " + std::to_string(summary.max_score) + action);
+        } else {
+            metrics.inc_alerts_shaped(1);
+        }
+
+        // 2. Dashboard (Redis Pub/Sub)
+        if (!redis_) return;
+        if (!take_token(redis_bucket_, now)) {
+            metrics.inc_alerts_shaped(1);
+            return;
+        }
+
+        // Serialized into a reused buffer: no heap allocation per summary
+        common::JsonWriter json(json_buffer_.data(), json_buffer_.size());
+        json.begin_object()
+            .field("ts", summary.first_seen_ns)
+            .field("ip", std::string_view(summary.source))
+            .field("score", summary.max_score)
+            .field("reason", std::string_view(summary.reason))
+            .field("country", std::string_view(summary.country))
+            .field("msg", std::string_view(summary.message))
+            .field("count", summary.count)
+            .field("first_seen", summary.first_seen_ns)
+            .field("last_seen", summary.last_seen_ns)
+            .end_object();
+
+        if (json.ok()) {
+            redis_->publish(channel_, json.view());
+        } else {
+            LOG_ERROR("Alert JSON exceeded its buffer, not published.");
+        }
+    }
+
+    bool AlertDispatcher::take_token(ingest::TokenBucket& bucket, std::chrono::steady_clock::time_point now) {
+        // Same refill rule as RateLimiter
+        const double seconds = std::chrono::duration<double>(now - bucket.last_refill).count();
+        if (seconds > 0) {
+            bucket.tokens = std::min(bucket.max_burst, bucket.tokens + seconds * bucket.refill_rate);
+            bucket.last_refill = now;
+        }
+        if (bucket.tokens < 1.0) return false;
+        bucket.tokens -= 1.0;
+        return true;
+    }
+
+} // namespace blackbox::analysis
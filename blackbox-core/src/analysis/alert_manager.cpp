@@ -4,9 +4,12 @@
  */
 
 #include "blackbox/analysis/alert_manager.h"
+#include "blackbox/analysis/block_list_manager.h"
 #include "blackbox/common/logger.h" // Our logger
 #include "blackbox/common/settings.h" // To check if Active Defense is enabled
-#include <cstdlib> // For std::system
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 
 namespace blackbox::analysis {
@@ -19,32 +22,42 @@ namespace blackbox::analysis {
         return instance;
     }
 
+    AlertManager::AlertManager()
+        : cooldown_(static_cast<size_t>(std::max(common::Settings::instance().defense().alert_dedup_slots, 64)),
+                    static_cast<uint64_t>(COOLDOWN_SECONDS) * 1000) {}
+
+    namespace {
+
+        // FNV-1a; 'seed' lets two calls fill independent halves of a key
+        uint64_t hash_text(std::string_view text, uint64_t seed) {
+            uint64_t h = 0xCBF29CE484222325ull ^ seed;
+            for (unsigned char c : text) {
+                h ^= c;
+                h *= 0x100000001B3ull;
+            }
+            return h;
+        }
+
+    } // namespace
+
     // =========================================================
     // Helper: Deduplication Logic
     // =========================================================
-    bool AlertManager::should_trigger(const std::string& ip) {
-        std::lock_guard<std::mutex> lock(map_mutex_);
-        
-        auto now = std::chrono::steady_clock::now();
-        auto it = cooldown_map_.find(ip);
-
-        if (it == cooldown_map_.end()) {
-            // New IP, trigger away
-            cooldown_map_[ip] = now;
-            return true;
+    bool AlertManager::should_trigger(std::string_view source, std::string_view reason) {
+        // Sources are normally IP literals; hostnames are keyed by a hash of the text
+        common::IpKey key;
+        if (auto ip = common::IpKey::parse(source)) {
+            key = *ip;
+        } else {
+            const uint64_t halves[2] = {hash_text(source, 0), hash_text(source, 0x9E3779B97F4A7C15ull)};
+            std::memcpy(key.bytes.data(), halves, sizeof(halves));
         }
 
-        // Check time difference
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - it->second).count();
-        
-        if (elapsed > COOLDOWN_SECONDS) {
-            // Cooldown expired, trigger again
-            it->second = now;
-            return true;
-        }
+        const uint32_t rule_id = static_cast<uint32_t>(hash_text(reason, 0));
+        const uint64_t now_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
 
-        // Too soon
-        return false;
+        return cooldown_.try_trigger(key, rule_id, now_ms);
     }
 
     // =========================================================
@@ -53,53 +66,38 @@ namespace blackbox::analysis {
     void AlertManager::execute_block_action(const std::string& ip) {
         // SAFETY CHECK: Ensure Active Defense is enabled in Settings
         // In a real app, this would be: if (!Settings::instance().is_active_defense_enabled()) return;
-        
-        // Construct command
-        // Example: Add to iptables DROP list
-        // WARNING: This requires the container to have CAP_NET_ADMIN capabilities
-        std::string cmd = "iptables -A INPUT -s " + ip + " -j DROP";
 
-        LOG_CRITICAL("Executing Active Defense: " + cmd);
-        
-        // Call system (Blocking call)
-        // In production, use fork/exec or a library like 'boost::process' 
-        // to avoid stalling the thread.
-        int ret = std::system(cmd.c_str());
-        
-        if (ret != 0) {
-            LOG_ERROR("Failed to execute block command for IP: " + ip);
-        } else {
-            LOG_INFO("Successfully blocked IP: " + ip);
-        }
+        // The ban is queued and applied (batched) by the BlockListManager
+        // firewall thread; the kernel set element expires on its own.
+        // WARNING: The nftables backend requires CAP_NET_ADMIN
+        // Not logged here: a spoofed-source flood would turn every ban into
+        // a synchronous log flush. The caller logs the outcome, shaped.
+        BlockListManager::instance().block_ip(ip);
     }
 
     // =========================================================
     // Trigger Alert (The Hot Path)
     // =========================================================
-    void AlertManager::trigger_alert(std::string_view source_ip, float score, std::string_view message) {
+    AlertOutcome AlertManager::trigger_alert(std::string_view source_ip, float score, std::string_view message) {
         
         // 1. Check Threshold
         // Note: The caller usually checks this, but we double-check for safety
-        if (score < 0.8f) return;
+        if (score < 0.8f) return AlertOutcome::Suppressed;
 
-        std::string ip_str(source_ip);
-
-        // 2. Deduplicate
-        if (!should_trigger(ip_str)) {
+        // 2. Deduplicate (no allocation, no lock)
+        if (!should_trigger(source_ip, message)) {
             // We know about this threat, silently ignore to save resources
-            return;
+            return AlertOutcome::Suppressed;
         }
 
-        // 3. Log to Console (Red)
-        std::string msg = "THREAT DETECTED [Score: " + std::to_string(score) + "] IP: " + ip_str;
-        LOG_CRITICAL(msg);
-
-        // 4. Active Defense (If Critical)
+        // 3. Active Defense (If Critical)
         if (score > CRITICAL_THRESHOLD) {
             // Only block if it's practically 100% certain (0.95+)
             // We don't want to block users on false positives.
-            execute_block_action(ip_str);
+            execute_block_action(std::string(source_ip));
+            return AlertOutcome::Blocked;
         }
+        return AlertOutcome::Alerted;
     }
 
 } // namespace blackbox::analysis
\ No newline at end of file
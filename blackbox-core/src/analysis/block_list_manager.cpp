@@ -5,12 +5,36 @@
 
 #include "blackbox/analysis/block_list_manager.h"
 #include "blackbox/common/logger.h"
+#include "blackbox/common/metrics.h"
 #include "blackbox/common/settings.h"
-#include <cstdlib> // std::system
+#include "blackbox/common/thread_utils.h"
+#include "blackbox/ingest/ban_filter.h"
+#include <unordered_map>
 #include <vector>
 
 namespace blackbox::analysis {
 
+    namespace {
+
+        // The kernel element outlives our own deadline by this much: normally
+        // we remove it on time, the kernel timeout only cleans up after a crash
+        constexpr int KERNEL_TIMEOUT_GRACE_SECONDS = 60;
+
+        // Deadlines this close together expire in one wake-up / one batch
+        constexpr auto EXPIRY_COALESCE = std::chrono::milliseconds(50);
+
+        // Mirrors one batch into the ingest filter. The last op per address wins.
+        void update_ingest_filter(const std::vector<FirewallOp>& ops) {
+            std::unordered_map<common::IpKey, bool, common::IpKeyHash> final_state;
+            for (const auto& op : ops) final_state[op.ip] = op.type == FirewallOp::Type::Block;
+
+            std::vector<common::IpKey> added, removed;
+            for (const auto& [ip, banned] : final_state) (banned ? added : removed).push_back(ip);
+            ingest::BanFilter::instance().update(added, removed);
+        }
+
+    } // namespace
+
     // =========================================================
     // Singleton
     // =========================================================
@@ -23,138 +47,225 @@ namespace blackbox::analysis {
     // Constructor / Destructor
     // =========================================================
     BlockListManager::BlockListManager() : running_(true) {
-        // Start the janitor thread
+        const auto& cfg = common::Settings::instance().defense();
+        backend_ = FirewallBackend::create(cfg.firewall_backend, cfg.firewall_table);
+        batch_window_ = std::chrono::milliseconds(cfg.firewall_batch_ms);
+
+        // Start the janitor and firewall threads
         worker_thread_ = std::thread(&BlockListManager::expiration_worker, this);
-        LOG_INFO("Active Defense Manager started. Default ban time: 10m.");
+        firewall_thread_ = std::thread(&BlockListManager::firewall_worker, this);
+        LOG_INFO(std::string("Active Defense Manager started. Backend: ") + backend_->name() +
+                 ", default ban time: 10m.");
     }
 
     BlockListManager::~BlockListManager() {
-        running_ = false;
+        // 1. Stop expiry first: it may still queue removals
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        expiry_cv_.notify_all();
         if (worker_thread_.joinable()) {
             worker_thread_.join();
         }
 
-        // Optional: Clear all bans on shutdown?
-        // Usually safer to leave them or persist them to disk.
-        // For MVP, we leave them in iptables.
+        // 2. Flush what is still queued, then stop the firewall thread
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            firewall_stopping_ = true;
+        }
+        pending_cv_.notify_all();
+        if (firewall_thread_.joinable()) {
+            firewall_thread_.join();
+        }
+
+        // Bans still active are left in place: the kernel expires them.
     }
 
     // =========================================================
     // Block IP
     // =========================================================
     void BlockListManager::block_ip(const std::string& ip, int duration_seconds) {
-        std::lock_guard<std::mutex> lock(mutex_);
-
-        // Check if already blocked
-        if (active_blocks_.find(ip) != active_blocks_.end()) {
-            // Already blocked. Extend duration?
-            // For now, just ignore.
+        const auto key = common::IpKey::parse(ip);
+        if (!key) {
+            LOG_ERROR("Invalid IP format in block request: " + ip);
             return;
         }
+        block_ip(*key, duration_seconds);
+    }
+
+    void BlockListManager::block_ip(const common::IpKey& ip, int duration_seconds) {
+        bool earliest;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            // Check if already blocked
+            if (active_blocks_.find(ip) != active_blocks_.end()) {
+                // Already blocked. Extend duration?
+                // For now, just ignore.
+                return;
+            }
 
-        // 1. Update State
-        BlockEntry entry;
-        entry.ip = ip;
-        entry.duration_seconds = duration_seconds;
-        entry.start_time = std::chrono::steady_clock::now();
+            // 1. Update State + schedule the expiry
+            BlockEntry entry;
+            entry.start_time = std::chrono::steady_clock::now();
+            entry.expires_at = entry.start_time + std::chrono::seconds(duration_seconds);
+            entry.duration_seconds = duration_seconds;
+            entry.generation = ++next_generation_;
 
-        active_blocks_[ip] = entry;
+            active_blocks_[ip] = entry;
+            expiry_heap_.push(Expiry{entry.expires_at, ip, entry.generation});
+            earliest = expiry_heap_.top().generation == entry.generation;
 
-        // 2. Execute System Call
-        execute_firewall_command(ip, true);
+            // 2. Queue for the firewall thread (never blocks on the kernel here).
+            // Still under mutex_: ops for one address must queue in state order.
+            submit(FirewallOp{FirewallOp::Type::Block, ip, duration_seconds + KERNEL_TIMEOUT_GRACE_SECONDS});
+        }
+
+        // The expiry thread sleeps until the old earliest deadline: wake it
+        if (earliest) expiry_cv_.notify_one();
     }
 
     // =========================================================
     // Unblock IP
     // =========================================================
     void BlockListManager::unblock_ip(const std::string& ip) {
-        std::lock_guard<std::mutex> lock(mutex_);
+        if (const auto key = common::IpKey::parse(ip)) unblock_ip(*key);
+    }
 
-        auto it = active_blocks_.find(ip);
-        if (it == active_blocks_.end()) {
-            return; // Not found
-        }
+    void BlockListManager::unblock_ip(const common::IpKey& ip) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
 
-        // 1. Remove from State
-        active_blocks_.erase(it);
+            auto it = active_blocks_.find(ip);
+            if (it == active_blocks_.end()) {
+                return; // Not found
+            }
 
-        // 2. Execute System Call
-        execute_firewall_command(ip, false);
+            // 1. Remove from State (its heap entry goes stale and is skipped)
+            active_blocks_.erase(it);
+
+            // 2. Queue the removal before a new block_ip can queue its Block
+            submit(FirewallOp{FirewallOp::Type::Unblock, ip, 0});
+        }
     }
 
     // =========================================================
     // Check Status
     // =========================================================
     bool BlockListManager::is_blocked(const std::string& ip) {
+        const auto key = common::IpKey::parse(ip);
+        return key && is_blocked(*key);
+    }
+
+    bool BlockListManager::is_blocked(const common::IpKey& ip) {
         std::lock_guard<std::mutex> lock(mutex_);
         return active_blocks_.find(ip) != active_blocks_.end();
     }
 
+    size_t BlockListManager::active_count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return active_blocks_.size();
+    }
+
     // =========================================================
     // Expiration Worker (Background Thread)
     // =========================================================
     void BlockListManager::expiration_worker() {
-        while (running_) {
-            // Check every 5 seconds
-            std::this_thread::sleep_for(std::chrono::seconds(5));
-            if (!running_) break;
+        common::ThreadUtils::set_current_thread_name("BB_BanExpiry");
 
-            std::vector<std::string> expired_ips;
-            auto now = std::chrono::steady_clock::now();
+        std::vector<FirewallOp> expired;
+        std::unique_lock<std::mutex> lock(mutex_);
 
-            // 1. Find Expired
-            {
-                std::lock_guard<std::mutex> lock(mutex_);
-                for (const auto& [ip, entry] : active_blocks_) {
-                    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - entry.start_time).count();
-
-                    if (elapsed >= entry.duration_seconds) {
-                        expired_ips.push_back(ip);
-                    }
-                }
+        while (running_) {
+            // 1. Sleep until the earliest deadline (or a new, earlier one)
+            if (expiry_heap_.empty()) {
+                expiry_cv_.wait(lock);
+                continue;
+            }
+            const auto deadline = expiry_heap_.top().at + EXPIRY_COALESCE;
+            if (std::chrono::steady_clock::now() < deadline) {
+                expiry_cv_.wait_until(lock, deadline);
+                continue;
             }
 
-            // 2. Remove (Unblock)
-            // note: we call unblock_ip which re-locks the mutex.
-            // This is safe because we released the lock above.
-            for (const auto& ip : expired_ips) {
-                LOG_INFO("Ban expired for IP: " + ip + ". Unblocking.");
-                unblock_ip(ip);
+            // 2. Pop everything due. Entries for bans that were lifted or
+            // replaced since are stale: skip them.
+            const auto now = std::chrono::steady_clock::now();
+            while (!expiry_heap_.empty() && expiry_heap_.top().at <= now) {
+                const Expiry due = expiry_heap_.top();
+                expiry_heap_.pop();
+
+                auto it = active_blocks_.find(due.ip);
+                if (it == active_blocks_.end() || it->second.generation != due.generation) continue;
+                active_blocks_.erase(it);
+                expired.push_back(FirewallOp{FirewallOp::Type::Unblock, due.ip, 0});
             }
+
+            // 3. Hand them to the firewall as one batch. Queued under mutex_,
+            // so a re-block of the same address is queued after the Unblock.
+            if (expired.empty()) continue;
+            const size_t count = expired.size();
+            submit(expired);
+            lock.unlock();
+            LOG_INFO(std::to_string(count) + " ban(s) expired. Unblocking.");
+            lock.lock();
         }
     }
 
     // =========================================================
-    // System Call Helper
+    // Firewall Queue
     // =========================================================
-    void BlockListManager::execute_firewall_command(const std::string& ip, bool add) {
-        // Simple Input Validation to prevent Command Injection
-        // (Very basic check: assume valid IP has no spaces or semicolons)
-        if (ip.find(' ') != std::string::npos || ip.find(';') != std::string::npos) {
-            LOG_ERROR("Invalid IP format in firewall request: " + ip);
-            return;
+    void BlockListManager::submit(FirewallOp op) {
+        bool was_empty;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            was_empty = pending_.empty();
+            pending_.push_back(std::move(op));
         }
+        // Only the first op of a batch needs to wake the worker
+        if (was_empty) pending_cv_.notify_one();
+    }
 
-        std::string cmd;
-        if (add) {
-            // Append rule to DROP packets from this IP
-            cmd = "iptables -A INPUT -s " + ip + " -j DROP";
-            LOG_CRITICAL("Adding Firewall Rule: " + cmd);
-        } else {
-            // Delete the specific rule
-            cmd = "iptables -D INPUT -s " + ip + " -j DROP";
-            LOG_INFO("Removing Firewall Rule: " + cmd);
+    void BlockListManager::submit(std::vector<FirewallOp>& ops) {
+        bool was_empty;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            was_empty = pending_.empty();
+            pending_.insert(pending_.end(), ops.begin(), ops.end());
         }
+        ops.clear();
+        if (was_empty) pending_cv_.notify_one();
+    }
+
+    void BlockListManager::firewall_worker() {
+        common::ThreadUtils::set_current_thread_name("BB_Firewall");
+
+        std::vector<FirewallOp> batch;
+        for (;;) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(pending_mutex_);
+                pending_cv_.wait(lock, [this] { return !pending_.empty() || firewall_stopping_; });
+                if (pending_.empty()) break; // Stopped and drained
+                stopping = firewall_stopping_;
+            }
+
+            // Let the rest of a burst arrive, then ship it as one transaction
+            if (!stopping) std::this_thread::sleep_for(batch_window_);
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                batch.swap(pending_);
+            }
 
-        // Use std::system.
-        // In a container, ensure we are root or have NET_ADMIN capability.
-        int ret = std::system(cmd.c_str());
+            // Listeners drop the source right away, whatever the kernel says
+            update_ingest_filter(batch);
 
-        if (ret != 0) {
-            // This might happen if rule doesn't exist during unblock (harmless)
-            // or if we lack permissions (critical).
-            LOG_WARN("Firewall command returned non-zero exit code.");
+            const size_t failed = backend_->apply(batch);
+            common::Metrics::instance().inc_firewall_updates(batch.size() - failed);
+            if (failed > 0) common::Metrics::instance().inc_firewall_errors(failed);
+            batch.clear();
         }
     }
 
-} // namespace blackbox::analysis
\ No newline at end of file
+} // namespace blackbox::analysis
@@ -0,0 +1,104 @@
+/**
+ * @file cooldown_table.cpp
+ * @brief Implementation of the Lock-Free Alert Cooldown Table.
+ */
+
+#include "blackbox/analysis/cooldown_table.h"
+#include "blackbox/common/metrics.h"
+#include <algorithm>
+
+namespace blackbox::analysis {
+
+    // =========================================================
+    // Constructor
+    // =========================================================
+    CooldownTable::CooldownTable(size_t capacity, uint64_t cooldown_ms)
+        : cooldown_ms_(cooldown_ms)
+    {
+        size_t groups = 8;
+        while (groups * GROUP < capacity) groups <<= 1;
+        groups_ = std::make_unique<Group[]>(groups);
+        group_mask_ = groups - 1;
+    }
+
+    // =========================================================
+    // Helpers
+    // =========================================================
+    uint64_t CooldownTable::fingerprint(const common::IpKey& ip, uint32_t rule_id) {
+        uint64_t h = common::IpKeyHash{}(ip) ^ (uint64_t(rule_id) * 0x9E3779B97F4A7C15ull);
+        h = (h ^ (h >> 32)) * 0xD6E8FEB86659FD93ull;
+        h ^= h >> 32;
+        return h ? h : 1; // 0 marks an empty slot
+    }
+
+    void CooldownTable::fill(Slot& slot, uint64_t key, uint64_t now_ms) {
+        // Key before stamp: a reader that sees the new key sees stamp 0
+        // ("being written") or the new stamp, never the victim's.
+        slot.key.store(key, std::memory_order_release);
+        slot.stamp.store((now_ms << 1) | 1, std::memory_order_release);
+    }
+
+    // =========================================================
+    // Try Trigger (Hot Path)
+    // =========================================================
+    bool CooldownTable::try_trigger(const common::IpKey& ip, uint32_t rule_id, uint64_t now_ms) {
+        const uint64_t key = fingerprint(ip, rule_id);
+        now_ms = std::max<uint64_t>(now_ms, 1); // Stamp 0 is reserved
+        Slot* group = groups_[key & group_mask_].slots;
+
+        // 1. Existing entry, or the first free slot (slots never become free
+        // again, so reaching one means the key is absent)
+        for (size_t i = 0; i < GROUP; ++i) {
+            Slot& slot = group[i];
+            uint64_t k = slot.key.load(std::memory_order_acquire);
+            if (k == 0) {
+                if (slot.key.compare_exchange_strong(k, key, std::memory_order_acq_rel)) {
+                    slot.stamp.store((now_ms << 1) | 1, std::memory_order_release);
+                    return true;
+                }
+                // Lost the slot; 'k' now holds the winner's key
+            }
+            if (k != key) continue;
+
+            uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+            for (;;) {
+                if (stamp == 0) return false; // Same pair being recorded right now
+                if (now_ms < (stamp >> 1) + cooldown_ms_) {
+                    // In cooldown: mark as referenced for CLOCK, suppress
+                    if (!(stamp & 1)) slot.stamp.compare_exchange_strong(stamp, stamp | 1, std::memory_order_relaxed);
+                    return false;
+                }
+                if (slot.stamp.compare_exchange_weak(stamp, (now_ms << 1) | 1, std::memory_order_acq_rel)) {
+                    return true;
+                }
+            }
+        }
+
+        // 2. Group full: CLOCK. The hand starts at a key-dependent slot so
+        // colliding keys do not all fight over slot 0.
+        const size_t hand = (key >> 32) % GROUP;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (size_t j = 0; j < GROUP; ++j) {
+                Slot& slot = group[(hand + j) % GROUP];
+                uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+                if (stamp == 0) continue; // Being replaced by someone else
+
+                const bool expired = now_ms >= (stamp >> 1) + cooldown_ms_;
+                if (!expired && (stamp & 1)) {
+                    // Second chance: clear the reference bit and move on
+                    slot.stamp.compare_exchange_strong(stamp, stamp & ~uint64_t(1), std::memory_order_relaxed);
+                    continue;
+                }
+                if (slot.stamp.compare_exchange_strong(stamp, 0, std::memory_order_acq_rel)) {
+                    if (!expired) common::Metrics::instance().inc_alert_dedup_evictions(1);
+                    fill(slot, key, now_ms);
+                    return true;
+                }
+            }
+        }
+
+        // Every slot contended: alert rather than drop a pair we cannot track
+        return true;
+    }
+
+} // namespace blackbox::analysis
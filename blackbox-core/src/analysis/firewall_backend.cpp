@@ -0,0 +1,426 @@
+/**
+ * @file firewall_backend.cpp
+ * @brief nftables (nfnetlink) and Dry-Run Firewall Backends.
+ */
+
+#include "blackbox/analysis/firewall_backend.h"
+#include "blackbox/common/logger.h"
+#include <arpa/inet.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter/nf_tables.h>
+#include <linux/netfilter/nfnetlink.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace blackbox::analysis {
+
+    namespace {
+
+        constexpr const char* CHAIN_NAME = "input";
+        constexpr const char* SET_V4 = "ban4";
+        constexpr const char* SET_V6 = "ban6";
+        constexpr uint32_t SET_ID_V4 = 1;
+        constexpr uint32_t SET_ID_V6 = 2;
+
+        // nft's userspace datatype ids, so 'nft list' prints addresses
+        constexpr uint32_t NFT_TYPE_IPADDR = 7;
+        constexpr uint32_t NFT_TYPE_IP6ADDR = 8;
+
+        // Ahead of distro filter chains (priority 0)
+        constexpr int32_t CHAIN_PRIORITY = -10;
+
+        // Elements per NEWSETELEM/DELSETELEM message
+        constexpr size_t MAX_ELEMENTS_PER_MSG = 512;
+
+        constexpr int SOCKET_BUFFER_BYTES = 1 << 20;
+
+        uint16_t nft_msg(int type) {
+            return static_cast<uint16_t>((NFNL_SUBSYS_NFTABLES << 8) | type);
+        }
+
+        /**
+         * @brief Appends netlink messages and attributes to one send buffer.
+         */
+        class NlBuilder {
+        public:
+            size_t begin_msg(uint16_t type, uint16_t flags, uint8_t family, uint16_t res_id, uint32_t seq) {
+                const size_t at = buf_.size();
+                buf_.resize(at + NLMSG_HDRLEN + NLMSG_ALIGN(sizeof(nfgenmsg)));
+
+                auto* nlh = reinterpret_cast<nlmsghdr*>(buf_.data() + at);
+                nlh->nlmsg_type = type;
+                nlh->nlmsg_flags = static_cast<uint16_t>(NLM_F_REQUEST | flags);
+                nlh->nlmsg_seq = seq;
+
+                auto* nfg = reinterpret_cast<nfgenmsg*>(buf_.data() + at + NLMSG_HDRLEN);
+                nfg->nfgen_family = family;
+                nfg->version = NFNETLINK_V0;
+                nfg->res_id = htons(res_id);
+                return at;
+            }
+
+            void end_msg(size_t at) {
+                reinterpret_cast<nlmsghdr*>(buf_.data() + at)->nlmsg_len = static_cast<uint32_t>(buf_.size() - at);
+            }
+
+            void put(uint16_t type, const void* data, size_t len) {
+                const size_t at = buf_.size();
+                buf_.resize(at + NLA_ALIGN(NLA_HDRLEN + len));
+                auto* attr = reinterpret_cast<nlattr*>(buf_.data() + at);
+                attr->nla_type = type;
+                attr->nla_len = static_cast<uint16_t>(NLA_HDRLEN + len);
+                std::memcpy(buf_.data() + at + NLA_HDRLEN, data, len);
+            }
+
+            void put_str(uint16_t type, const char* str) { put(type, str, std::strlen(str) + 1); }
+            void put_str(uint16_t type, const std::string& str) { put(type, str.c_str(), str.size() + 1); }
+
+            void put_be32(uint16_t type, uint32_t v) {
+                v = htonl(v);
+                put(type, &v, sizeof(v));
+            }
+
+            void put_be64(uint16_t type, uint64_t v) {
+                v = __builtin_bswap64(v);
+                put(type, &v, sizeof(v));
+            }
+
+            size_t begin_nest(uint16_t type) {
+                const size_t at = buf_.size();
+                buf_.resize(at + NLA_HDRLEN);
+                reinterpret_cast<nlattr*>(buf_.data() + at)->nla_type = static_cast<uint16_t>(type | NLA_F_NESTED);
+                return at;
+            }
+
+            void end_nest(size_t at) {
+                reinterpret_cast<nlattr*>(buf_.data() + at)->nla_len = static_cast<uint16_t>(buf_.size() - at);
+            }
+
+            void batch_begin(uint32_t seq) {
+                end_msg(begin_msg(NFNL_MSG_BATCH_BEGIN, 0, AF_UNSPEC, NFNL_SUBSYS_NFTABLES, seq));
+            }
+
+            void batch_end(uint32_t seq) {
+                end_msg(begin_msg(NFNL_MSG_BATCH_END, 0, AF_UNSPEC, NFNL_SUBSYS_NFTABLES, seq));
+            }
+
+            const std::vector<char>& data() const { return buf_; }
+
+        private:
+            std::vector<char> buf_;
+        };
+
+        // One entry of NFTA_RULE_EXPRESSIONS: name + attributes written by 'body'
+        template <typename Body>
+        void put_expr(NlBuilder& b, const char* name, Body&& body) {
+            const size_t elem = b.begin_nest(NFTA_LIST_ELEM);
+            b.put_str(NFTA_EXPR_NAME, name);
+            const size_t data = b.begin_nest(NFTA_EXPR_DATA);
+            body();
+            b.end_nest(data);
+            b.end_nest(elem);
+        }
+
+        void add_set(NlBuilder& b, uint32_t seq, const std::string& table, bool v6) {
+            const size_t msg = b.begin_msg(nft_msg(NFT_MSG_NEWSET), NLM_F_CREATE | NLM_F_ACK, NFPROTO_INET, 0, seq);
+            b.put_str(NFTA_SET_TABLE, table);
+            b.put_str(NFTA_SET_NAME, v6 ? SET_V6 : SET_V4);
+            b.put_be32(NFTA_SET_FLAGS, NFT_SET_TIMEOUT);
+            b.put_be32(NFTA_SET_KEY_TYPE, v6 ? NFT_TYPE_IP6ADDR : NFT_TYPE_IPADDR);
+            b.put_be32(NFTA_SET_KEY_LEN, v6 ? 16 : 4);
+            b.put_be32(NFTA_SET_ID, v6 ? SET_ID_V6 : SET_ID_V4);
+            b.end_msg(msg);
+        }
+
+        // meta nfproto == ipv4|ipv6  &&  saddr @ban4|@ban6  ->  counter drop
+        void add_ban_rule(NlBuilder& b, uint32_t seq, const std::string& table, bool v6) {
+            const size_t msg = b.begin_msg(nft_msg(NFT_MSG_NEWRULE), NLM_F_CREATE | NLM_F_APPEND | NLM_F_ACK,
+                                           NFPROTO_INET, 0, seq);
+            b.put_str(NFTA_RULE_TABLE, table);
+            b.put_str(NFTA_RULE_CHAIN, CHAIN_NAME);
+
+            const size_t exprs = b.begin_nest(NFTA_RULE_EXPRESSIONS);
+            put_expr(b, "meta", [&] {
+                b.put_be32(NFTA_META_DREG, NFT_REG_1);
+                b.put_be32(NFTA_META_KEY, NFT_META_NFPROTO);
+            });
+            put_expr(b, "cmp", [&] {
+                b.put_be32(NFTA_CMP_SREG, NFT_REG_1);
+                b.put_be32(NFTA_CMP_OP, NFT_CMP_EQ);
+                const uint8_t proto = v6 ? NFPROTO_IPV6 : NFPROTO_IPV4;
+                const size_t data = b.begin_nest(NFTA_CMP_DATA);
+                b.put(NFTA_DATA_VALUE, &proto, sizeof(proto));
+                b.end_nest(data);
+            });
+            put_expr(b, "payload", [&] {
+                // Source address: offset 12 (IPv4) / 8 (IPv6) in the network header
+                b.put_be32(NFTA_PAYLOAD_DREG, NFT_REG_1);
+                b.put_be32(NFTA_PAYLOAD_BASE, NFT_PAYLOAD_NETWORK_HEADER);
+                b.put_be32(NFTA_PAYLOAD_OFFSET, v6 ? 8 : 12);
+                b.put_be32(NFTA_PAYLOAD_LEN, v6 ? 16 : 4);
+            });
+            put_expr(b, "lookup", [&] {
+                b.put_str(NFTA_LOOKUP_SET, v6 ? SET_V6 : SET_V4);
+                b.put_be32(NFTA_LOOKUP_SET_ID, v6 ? SET_ID_V6 : SET_ID_V4);
+                b.put_be32(NFTA_LOOKUP_SREG, NFT_REG_1);
+            });
+            put_expr(b, "counter", [] {});
+            put_expr(b, "immediate", [&] {
+                b.put_be32(NFTA_IMMEDIATE_DREG, NFT_REG_VERDICT);
+                const size_t data = b.begin_nest(NFTA_IMMEDIATE_DATA);
+                const size_t verdict = b.begin_nest(NFTA_DATA_VERDICT);
+                b.put_be32(NFTA_VERDICT_CODE, NF_DROP);
+                b.end_nest(verdict);
+                b.end_nest(data);
+            });
+            b.end_nest(exprs);
+            b.end_msg(msg);
+        }
+
+        struct Element {
+            FirewallOp::Type type;
+            bool v6;
+            const uint8_t* addr; // 4 or 16 bytes inside the op's IpKey
+            uint64_t timeout_ms;
+        };
+
+        /**
+         * @brief One transaction for elems[begin, end).
+         * Consecutive elements for the same set and operation share a
+         * message, so a burst of bans is a single NEWSETELEM.
+         */
+        std::vector<char> build_element_batch(const std::vector<Element>& elems, size_t begin, size_t end,
+                                              const std::string& table, uint32_t& seq) {
+            NlBuilder b;
+            b.batch_begin(seq++);
+
+            size_t i = begin;
+            while (i < end) {
+                const bool add = elems[i].type == FirewallOp::Type::Block;
+                const bool v6 = elems[i].v6;
+
+                const size_t msg = b.begin_msg(nft_msg(add ? NFT_MSG_NEWSETELEM : NFT_MSG_DELSETELEM),
+                                               (add ? NLM_F_CREATE : 0) | NLM_F_ACK, NFPROTO_INET, 0, seq++);
+                b.put_str(NFTA_SET_ELEM_LIST_TABLE, table);
+                b.put_str(NFTA_SET_ELEM_LIST_SET, v6 ? SET_V6 : SET_V4);
+                const size_t list = b.begin_nest(NFTA_SET_ELEM_LIST_ELEMENTS);
+
+                size_t in_msg = 0;
+                for (; i < end && in_msg < MAX_ELEMENTS_PER_MSG; ++i, ++in_msg) {
+                    const Element& e = elems[i];
+                    if ((e.type == FirewallOp::Type::Block) != add || e.v6 != v6) break;
+
+                    const size_t elem = b.begin_nest(NFTA_LIST_ELEM);
+                    const size_t key = b.begin_nest(NFTA_SET_ELEM_KEY);
+                    b.put(NFTA_DATA_VALUE, e.addr, v6 ? 16 : 4);
+                    b.end_nest(key);
+                    if (add && e.timeout_ms > 0) b.put_be64(NFTA_SET_ELEM_TIMEOUT, e.timeout_ms);
+                    b.end_nest(elem);
+                }
+
+                b.end_nest(list);
+                b.end_msg(msg);
+            }
+
+            b.batch_end(seq++);
+            return b.data();
+        }
+
+        const char* op_name(FirewallOp::Type type) {
+            return type == FirewallOp::Type::Block ? "block" : "unblock";
+        }
+
+    } // namespace
+
+    // =========================================================
+    // Factory
+    // =========================================================
+    std::unique_ptr<FirewallBackend> FirewallBackend::create(const std::string& kind, const std::string& table) {
+        if (kind == "nftables") {
+            auto backend = std::make_unique<NftablesBackend>(table);
+            if (backend->init()) return backend;
+            LOG_ERROR("Firewall: nftables backend unavailable, falling back to dry-run (bans are NOT enforced)");
+        } else if (kind != "dryrun") {
+            LOG_ERROR("Firewall: unknown backend '" + kind + "', using dry-run");
+        }
+        return std::make_unique<DryRunBackend>();
+    }
+
+    // =========================================================
+    // nftables: Constructor / Destructor
+    // =========================================================
+    NftablesBackend::NftablesBackend(std::string table) : table_(std::move(table)) {}
+
+    NftablesBackend::~NftablesBackend() {
+        // The table stays loaded: remaining bans expire in the kernel
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    // =========================================================
+    // nftables: Bootstrap
+    // =========================================================
+    bool NftablesBackend::init() {
+        fd_ = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_NETFILTER);
+        if (fd_ < 0) {
+            LOG_ERROR(std::string("Firewall: netlink socket failed: ") + std::strerror(errno));
+            return false;
+        }
+
+        // Acks without the echoed request; room for large batches
+        int one = 1;
+        ::setsockopt(fd_, SOL_NETLINK, NETLINK_CAP_ACK, &one, sizeof(one));
+        ::setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &SOCKET_BUFFER_BYTES, sizeof(SOCKET_BUFFER_BYTES));
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &SOCKET_BUFFER_BYTES, sizeof(SOCKET_BUFFER_BYTES));
+
+        // Recreate the table atomically (create-if-missing, delete, create):
+        // bans from a previous run are dropped along with our in-memory state
+        NlBuilder b;
+        b.batch_begin(seq_++);
+
+        size_t msg = b.begin_msg(nft_msg(NFT_MSG_NEWTABLE), NLM_F_CREATE | NLM_F_ACK, NFPROTO_INET, 0, seq_++);
+        b.put_str(NFTA_TABLE_NAME, table_);
+        b.end_msg(msg);
+
+        msg = b.begin_msg(nft_msg(NFT_MSG_DELTABLE), NLM_F_ACK, NFPROTO_INET, 0, seq_++);
+        b.put_str(NFTA_TABLE_NAME, table_);
+        b.end_msg(msg);
+
+        msg = b.begin_msg(nft_msg(NFT_MSG_NEWTABLE), NLM_F_CREATE | NLM_F_ACK, NFPROTO_INET, 0, seq_++);
+        b.put_str(NFTA_TABLE_NAME, table_);
+        b.end_msg(msg);
+
+        add_set(b, seq_++, table_, false);
+        add_set(b, seq_++, table_, true);
+
+        msg = b.begin_msg(nft_msg(NFT_MSG_NEWCHAIN), NLM_F_CREATE | NLM_F_ACK, NFPROTO_INET, 0, seq_++);
+        b.put_str(NFTA_CHAIN_TABLE, table_);
+        b.put_str(NFTA_CHAIN_NAME, CHAIN_NAME);
+        const size_t hook = b.begin_nest(NFTA_CHAIN_HOOK);
+        b.put_be32(NFTA_HOOK_HOOKNUM, NF_INET_LOCAL_IN);
+        b.put_be32(NFTA_HOOK_PRIORITY, static_cast<uint32_t>(CHAIN_PRIORITY));
+        b.end_nest(hook);
+        b.put_be32(NFTA_CHAIN_POLICY, NF_ACCEPT);
+        b.put_str(NFTA_CHAIN_TYPE, "filter");
+        b.end_msg(msg);
+
+        add_ban_rule(b, seq_++, table_, false);
+        add_ban_rule(b, seq_++, table_, true);
+
+        b.batch_end(seq_++);
+
+        const int err = transact(b.data());
+        if (err != 0) {
+            LOG_ERROR("Firewall: creating nftables table inet " + table_ + " failed: " + std::strerror(err));
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+
+        LOG_INFO("Firewall: nftables table inet " + table_ + " ready (sets " + SET_V4 + ", " + SET_V6 + ")");
+        return true;
+    }
+
+    // =========================================================
+    // nftables: Apply (one transaction)
+    // =========================================================
+    size_t NftablesBackend::apply(const std::vector<FirewallOp>& ops) {
+        if (ops.empty()) return 0;
+
+        std::vector<Element> elems;
+        elems.reserve(ops.size());
+        for (const auto& op : ops) {
+            const bool v4 = op.ip.is_v4();
+            elems.push_back(Element{op.type, !v4, v4 ? op.ip.v4_bytes() : op.ip.bytes.data(),
+                                    static_cast<uint64_t>(op.timeout_seconds > 0 ? op.timeout_seconds : 0) * 1000});
+        }
+
+        if (transact(build_element_batch(elems, 0, elems.size(), table_, seq_)) == 0) return 0;
+
+        // One bad element aborts the whole transaction: replay one by one
+        size_t failed = 0;
+        for (size_t i = 0; i < elems.size(); ++i) {
+            const int err = transact(build_element_batch(elems, i, i + 1, table_, seq_));
+            // Unblocking an element the kernel already expired is fine
+            if (err == 0 || (err == ENOENT && elems[i].type == FirewallOp::Type::Unblock)) continue;
+
+            LOG_WARN(std::string("Firewall: ") + op_name(elems[i].type) + " " + ops[i].ip.to_string() +
+                     " failed: " + std::strerror(err));
+            ++failed;
+        }
+        return failed;
+    }
+
+    // =========================================================
+    // nftables: Send + Collect Acks
+    // =========================================================
+    int NftablesBackend::transact(const std::vector<char>& batch) {
+        if (fd_ < 0) return EBADF;
+
+        sockaddr_nl kernel{};
+        kernel.nl_family = AF_NETLINK;
+        if (::sendto(fd_, batch.data(), batch.size(), 0, reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+            return errno;
+        }
+
+        // The kernel runs the batch inside sendto(): every ack is queued by now
+        int first_error = 0;
+        alignas(nlmsghdr) char buf[16384];
+        for (;;) {
+            const ssize_t n = ::recv(fd_, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK && first_error == 0) first_error = errno;
+                break;
+            }
+
+            int len = static_cast<int>(n);
+            for (auto* nlh = reinterpret_cast<nlmsghdr*>(buf); NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+                if (nlh->nlmsg_type != NLMSG_ERROR) continue;
+                const auto* err = static_cast<const nlmsgerr*>(NLMSG_DATA(nlh));
+                if (err->error != 0 && first_error == 0) first_error = -err->error;
+            }
+        }
+        return first_error;
+    }
+
+    // =========================================================
+    // Dry Run
+    // =========================================================
+    size_t DryRunBackend::apply(const std::vector<FirewallOp>& ops) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t blocks = 0;
+        for (const auto& op : ops) {
+            LOG_DEBUG(std::string("Firewall (dry-run): ") + op_name(op.type) + " " + op.ip.to_string() +
+                      (op.type == FirewallOp::Type::Block ? " for " + std::to_string(op.timeout_seconds) + "s" : ""));
+            if (op.type == FirewallOp::Type::Block) ++blocks;
+            if (history_.size() < HISTORY_LIMIT) {
+                history_.push_back(op);
+            } else {
+                history_[history_next_] = op;
+                history_next_ = (history_next_ + 1) % HISTORY_LIMIT;
+            }
+        }
+        ++transactions_;
+        LOG_INFO("Firewall (dry-run): transaction with " + std::to_string(blocks) + " block(s), " +
+                 std::to_string(ops.size() - blocks) + " unblock(s)");
+        return 0;
+    }
+
+    std::vector<FirewallOp> DryRunBackend::history() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<FirewallOp> ordered;
+        ordered.reserve(history_.size());
+        ordered.insert(ordered.end(), history_.begin() + history_next_, history_.end());
+        ordered.insert(ordered.end(), history_.begin(), history_.begin() + history_next_);
+        return ordered;
+    }
+
+    size_t DryRunBackend::transactions() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return transactions_;
+    }
+
+} // namespace blackbox::analysis
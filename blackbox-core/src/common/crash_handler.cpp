@@ -4,6 +4,7 @@
  */
 
 #include "blackbox/common/crash_handler.h"
+#include "blackbox/common/logger.h"
 #include <iostream>
 #include <csignal>
 #include <cstdlib>
@@ -27,6 +28,9 @@ namespace blackbox::common {
     // Crash Callback
     // =========================================================
     void CrashHandler::handle_crash(int signal) {
+        // Write out what was logged before the crash, ahead of the banner
+        Logger::instance().flush();
+
         // Use std::cerr because it is unbuffered. std::cout might not flush in a crash.
         std::cerr << "\n\n" 
                   << "########################################################\n"
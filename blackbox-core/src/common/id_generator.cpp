@@ -1,79 +1,163 @@
-
 /**
  * @file id_generator.cpp
  * @brief Implementation of Lock-Free UUID Generation.
  */
 
 #include "blackbox/common/id_generator.h"
+#include <cstring>
 #include <random>
-#include <sstream>
-#include <iomanip>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
 
 namespace blackbox::common {
 
+    namespace {
+
+        inline uint64_t rotl(uint64_t x, int k) {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        inline uint64_t splitmix64(uint64_t& state) {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        /**
+         * @brief xoshiro256** (Blackman & Vigna): ~1 ns per 64 bits, 32 bytes of state.
+         */
+        class Xoshiro256 {
+        public:
+            Xoshiro256() {
+                // std::random_device only once per thread, expanded by splitmix64
+                std::random_device rd;
+                uint64_t seed = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+                for (auto& word : s_) word = splitmix64(seed);
+            }
+
+            uint64_t next() {
+                const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+                const uint64_t t = s_[1] << 17;
+                s_[2] ^= s_[0];
+                s_[3] ^= s_[1];
+                s_[1] ^= s_[2];
+                s_[0] ^= s_[3];
+                s_[2] ^= t;
+                s_[3] = rotl(s_[3], 45);
+                return result;
+            }
+
+        private:
+            uint64_t s_[4];
+        };
+
+        Xoshiro256& rng() {
+            static thread_local Xoshiro256 engine;
+            return engine;
+        }
+
+        // Per-thread v7 state: last timestamp used and the 12-bit counter under it
+        struct V7State {
+            uint64_t last_ms = 0;
+            uint32_t counter = 0;
+        };
+
+        inline void store_be64(uint8_t* dst, uint64_t v) {
+            v = __builtin_bswap64(v);
+            std::memcpy(dst, &v, sizeof(v));
+        }
+
+        // Variant 10xx in the top bits of byte 8
+        inline void set_variant(Uuid& id) {
+            id.bytes[8] = static_cast<uint8_t>((id.bytes[8] & 0x3F) | 0x80);
+        }
+
+    } // namespace
+
     // =========================================================
     // Generate UUID v4
     // =========================================================
-    std::string IdGenerator::generate_uuid_v4() {
-        // 1. Thread-Local Random Engine
-        // Initialization happens only once per thread.
-        // This avoids the expensive std::random_device() call on every log.
-        static thread_local std::mt19937_64 engine{std::random_device{}()};
-        static thread_local std::uniform_int_distribution<uint64_t> dist;
-
-        // 2. Generate 128 bits of random data (2 x 64-bit integers)
-        uint64_t part1 = dist(engine);
-        uint64_t part2 = dist(engine);
-
-        // 3. Apply UUID v4 Variant/Version bits
-        // Part 1: ...-4xxx-... (Version 4)
-        // We need to set the 4 bits at the 13th nibble (index 12 in hex)
-        // In uint64 logic, this depends on byte ordering, but here we manipulate bytes conceptually.
-
-        // A simpler way with string formatting:
-        // We format the random numbers as hex and patch the specific characters.
-
-        std::stringstream ss;
-        ss << std::hex << std::setfill('0')
-           << std::setw(16) << part1
-           << std::setw(16) << part2;
-
-        std::string hex = ss.str(); // 32 chars
-
-        // UUID Format: 8-4-4-4-12
-        // Indices:     01234567-8901-2345-6789-012345678901
-
-        // Set Version 4 (at index 12 of the 32-char string, which corresponds to the 3rd group)
-        // Actually, let's construct it manually to be precise with bits.
-
-        // Alternative Approach: Byte manipulation
-        union {
-            uint64_t ints[2];
-            uint8_t bytes[16];
-        } uuid;
-
-        uuid.ints[0] = part1;
-        uuid.ints[1] = part2;
-
-        // Set Version: 4
-        uuid.bytes[6] = (uuid.bytes[6] & 0x0F) | 0x40;
-
-        // Set Variant: 10xxxxxx (RFC 4122)
-        uuid.bytes[8] = (uuid.bytes[8] & 0x3F) | 0x80;
-
-        // 4. Format to String
-        // We use a small buffer to avoid stream overhead
-        char buffer[37];
-        snprintf(buffer, sizeof(buffer),
-            "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-            uuid.bytes[0], uuid.bytes[1], uuid.bytes[2], uuid.bytes[3],
-            uuid.bytes[4], uuid.bytes[5],
-            uuid.bytes[6], uuid.bytes[7],
-            uuid.bytes[8], uuid.bytes[9],
-            uuid.bytes[10], uuid.bytes[11], uuid.bytes[12], uuid.bytes[13], uuid.bytes[14], uuid.bytes[15]
-        );
-
-        return std::string(buffer);
+    Uuid IdGenerator::uuid_v4() {
+        Uuid id;
+        auto& engine = rng();
+        const uint64_t hi = engine.next();
+        const uint64_t lo = engine.next();
+        std::memcpy(id.bytes.data(), &hi, 8);
+        std::memcpy(id.bytes.data() + 8, &lo, 8);
+
+        id.bytes[6] = static_cast<uint8_t>((id.bytes[6] & 0x0F) | 0x40);
+        set_variant(id);
+        return id;
+    }
+
+    // =========================================================
+    // Generate UUID v7
+    // =========================================================
+    Uuid IdGenerator::uuid_v7(uint64_t unix_ms) {
+        static thread_local V7State state;
+        auto& engine = rng();
+
+        if (unix_ms > state.last_ms) {
+            // New millisecond: random counter start, top bit clear for headroom
+            state.last_ms = unix_ms;
+            state.counter = static_cast<uint32_t>(engine.next() & 0x7FF);
+        } else if (++state.counter > 0xFFF) {
+            // 4096 ids in one ms (or the clock went back): borrow the next ms
+            ++state.last_ms;
+            state.counter = static_cast<uint32_t>(engine.next() & 0x7FF);
+        }
+
+        Uuid id;
+        // unix_ts_ms (48 bits) | ver (4) | counter (12), big-endian
+        store_be64(id.bytes.data(), (state.last_ms << 16) | 0x7000 | state.counter);
+        store_be64(id.bytes.data() + 8, engine.next());
+        set_variant(id);
+        return id;
+    }
+
+    // =========================================================
+    // Text Form
+    // =========================================================
+    void IdGenerator::format(const Uuid& id, char* out) {
+        char hex[32];
+
+#if defined(__SSSE3__)
+        // Nibble -> ASCII via one table lookup per 16 nibbles
+        const __m128i table = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                            '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+        const __m128i mask = _mm_set1_epi8(0x0F);
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(id.bytes.data()));
+        const __m128i hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        const __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(v, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex + 16), _mm_unpackhi_epi8(hi, lo));
+#else
+        constexpr char HEX[] = "0123456789abcdef";
+        for (size_t i = 0; i < 16; ++i) {
+            hex[2 * i] = HEX[id.bytes[i] >> 4];
+            hex[2 * i + 1] = HEX[id.bytes[i] & 0x0F];
+        }
+#endif
+
+        // 8-4-4-4-12
+        std::memcpy(out, hex, 8);
+        out[8] = '-';
+        std::memcpy(out + 9, hex + 8, 4);
+        out[13] = '-';
+        std::memcpy(out + 14, hex + 12, 4);
+        out[18] = '-';
+        std::memcpy(out + 19, hex + 16, 4);
+        out[23] = '-';
+        std::memcpy(out + 24, hex + 20, 12);
+    }
+
+    std::string IdGenerator::to_string(const Uuid& id) {
+        std::string text(Uuid::TEXT_LENGTH, '\0');
+        format(id, text.data());
+        return text;
     }
 
-} // namespace blackbox::common
\ No newline at end of file
+} // namespace blackbox::common
@@ -0,0 +1,39 @@
+/**
+ * @file ip_address.cpp
+ * @brief IpKey Parsing and Formatting.
+ */
+
+#include "blackbox/common/ip_address.h"
+#include <arpa/inet.h>
+
+namespace blackbox::common {
+
+    // =========================================================
+    // Parse
+    // =========================================================
+    std::optional<IpKey> IpKey::parse(std::string_view text) {
+        // inet_pton needs a NUL-terminated copy (longest IPv6 text is 45 chars)
+        char buf[INET6_ADDRSTRLEN];
+        if (text.empty() || text.size() >= sizeof(buf)) return std::nullopt;
+        std::memcpy(buf, text.data(), text.size());
+        buf[text.size()] = '\0';
+
+        uint32_t v4;
+        if (inet_pton(AF_INET, buf, &v4) == 1) return from_v4(v4);
+
+        IpKey key;
+        if (inet_pton(AF_INET6, buf, key.bytes.data()) == 1) return key;
+        return std::nullopt;
+    }
+
+    // =========================================================
+    // Format
+    // =========================================================
+    std::string IpKey::to_string() const {
+        char buf[INET6_ADDRSTRLEN];
+        const char* text = is_v4() ? inet_ntop(AF_INET, v4_bytes(), buf, sizeof(buf))
+                                   : inet_ntop(AF_INET6, bytes.data(), buf, sizeof(buf));
+        return text ? std::string(text) : std::string();
+    }
+
+} // namespace blackbox::common
@@ -0,0 +1,272 @@
+/**
+ * @file json_writer.cpp
+ * @brief Implementation of the JSON Serializer.
+ */
+
+#include "blackbox/common/json_writer.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace blackbox::common {
+
+    namespace {
+
+        constexpr char HEX[] = "0123456789abcdef";
+
+        // Escape sequence for bytes that need one (0 = copy as is)
+        constexpr char short_escape(unsigned char c) {
+            switch (c) {
+                case '"':  return '"';
+                case '\\': return '\\';
+                case '\b': return 'b';
+                case '\f': return 'f';
+                case '\n': return 'n';
+                case '\r': return 'r';
+                case '\t': return 't';
+                default:   return 0;
+            }
+        }
+
+        // Bytes the fast path stops at: escapes, and non-ASCII (validated)
+        inline bool needs_escape(unsigned char c) {
+            return c < 0x20 || c == '"' || c == '\\' || c >= 0x80;
+        }
+
+        // U+FFFD REPLACEMENT CHARACTER, written for ill-formed UTF-8
+        constexpr char REPLACEMENT[] = "\xEF\xBF\xBD";
+
+        /**
+         * @brief Length of the UTF-8 sequence at p if it is well-formed
+         * (Unicode Table 3-7: no overlongs, surrogates or values past
+         * U+10FFFF); otherwise 0, with 'bad' set to the length of the
+         * maximal ill-formed subpart to replace (at least 1).
+         */
+        size_t utf8_sequence(const unsigned char* p, const unsigned char* end, size_t& bad) {
+            const unsigned char lead = p[0];
+            size_t len = 0;
+            unsigned char lo = 0x80, hi = 0xBF;   // Range of the second byte
+            if (lead >= 0xC2 && lead <= 0xDF) len = 2;
+            else if (lead == 0xE0) { len = 3; lo = 0xA0; }
+            else if (lead == 0xED) { len = 3; hi = 0x9F; }
+            else if (lead >= 0xE1 && lead <= 0xEF) len = 3;
+            else if (lead == 0xF0) { len = 4; lo = 0x90; }
+            else if (lead == 0xF4) { len = 4; hi = 0x8F; }
+            else if (lead >= 0xF1 && lead <= 0xF3) len = 4;
+            else { bad = 1; return 0; }            // Stray continuation, C0/C1, F5..FF
+
+            for (size_t i = 1; i < len; ++i) {
+                const bool in_range = p + i < end &&
+                                      p[i] >= (i == 1 ? lo : 0x80) && p[i] <= (i == 1 ? hi : 0xBF);
+                if (!in_range) { bad = i; return 0; }
+            }
+            return len;
+        }
+
+        /**
+         * @brief First byte in [p, end) that must be escaped or validated
+         * (end if none). Checks 32 bytes per step with AVX2.
+         */
+        const char* find_special(const char* p, const char* end) {
+#if defined(__AVX2__)
+            const __m256i quote = _mm256_set1_epi8('"');
+            const __m256i backslash = _mm256_set1_epi8('\\');
+            const __m256i ctrl_max = _mm256_set1_epi8(0x1F);
+
+            while (end - p >= 32) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                // Unsigned v <= 0x1F  <=>  max(v, 0x1F) == 0x1F
+                __m256i ctrl = _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl_max), ctrl_max);
+                __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                                                  _mm256_cmpeq_epi8(v, backslash)), ctrl);
+                // High bit set: non-ASCII
+                uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(special, v)));
+                if (mask) return p + __builtin_ctz(mask);
+                p += 32;
+            }
+#endif
+            while (p < end && !needs_escape(static_cast<unsigned char>(*p))) ++p;
+            return p;
+        }
+
+    } // namespace
+
+    // =========================================================
+    // Low-level Output
+    // =========================================================
+    void JsonWriter::put(char c) {
+        if (len_ >= cap_) { overflow_ = true; return; }
+        buf_[len_++] = c;
+    }
+
+    void JsonWriter::put(const char* data, size_t n) {
+        if (n > cap_ - len_) { overflow_ = true; return; }
+        std::memcpy(buf_ + len_, data, n);
+        len_ += n;
+    }
+
+    void JsonWriter::separator() {
+        if (after_key_) {
+            after_key_ = false;
+            return;
+        }
+        if (depth_ == 0) return;
+
+        const uint64_t bit = 1ull << ((depth_ - 1) & 63);
+        if (has_items_ & bit) put(',');
+        has_items_ |= bit;
+    }
+
+    // =========================================================
+    // Structure
+    // =========================================================
+    JsonWriter& JsonWriter::begin_object() {
+        separator();
+        put('{');
+        depth_++;
+        has_items_ &= ~(1ull << ((depth_ - 1) & 63));
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::end_object() {
+        if (depth_ > 0) depth_--;
+        put('}');
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::begin_array() {
+        separator();
+        put('[');
+        depth_++;
+        has_items_ &= ~(1ull << ((depth_ - 1) & 63));
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::end_array() {
+        if (depth_ > 0) depth_--;
+        put(']');
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::key(std::string_view name) {
+        separator();
+        put('"');
+        escape(name);
+        put('"');
+        put(':');
+        after_key_ = true;
+        return *this;
+    }
+
+    // =========================================================
+    // Strings (SIMD Escaping)
+    // =========================================================
+    JsonWriter& JsonWriter::value(std::string_view str) {
+        separator();
+        put('"');
+        escape(str);
+        put('"');
+        return *this;
+    }
+
+    void JsonWriter::escape(std::string_view str) {
+        const char* p = str.data();
+        const char* end = p + str.size();
+
+        while (p < end) {
+            // 1. Copy the run of bytes that need no escaping
+            const char* run = find_special(p, end);
+            put(p, static_cast<size_t>(run - p));
+            if (run == end || overflow_) return;
+
+            // 2. Escape the special byte
+            const auto c = static_cast<unsigned char>(*run);
+            if (c >= 0x80) {
+                // Raw syslog bytes are not necessarily UTF-8: keep well-formed
+                // sequences, replace anything else so the JSON stays valid
+                size_t bad = 0;
+                const auto* u = reinterpret_cast<const unsigned char*>(run);
+                if (size_t len = utf8_sequence(u, reinterpret_cast<const unsigned char*>(end), bad)) {
+                    put(run, len);
+                    p = run + len;
+                } else {
+                    put(REPLACEMENT, 3);
+                    p = run + bad;
+                }
+                continue;
+            }
+            if (char e = short_escape(c)) {
+                const char seq[2] = {'\\', e};
+                put(seq, 2);
+            } else {
+                const char seq[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF]};
+                put(seq, 6);
+            }
+            p = run + 1;
+        }
+    }
+
+    std::string_view JsonWriter::utf8_prefix(std::string_view str, size_t max_bytes) {
+        if (str.size() <= max_bytes) return str;
+
+        // Step back over continuation bytes (10xxxxxx) to a sequence start
+        size_t n = max_bytes;
+        while (n > 0 && (static_cast<unsigned char>(str[n]) & 0xC0) == 0x80) --n;
+        return str.substr(0, n);
+    }
+
+    // =========================================================
+    // Numbers (std::to_chars, no locale, no allocation)
+    // =========================================================
+    JsonWriter& JsonWriter::value(int64_t v) {
+        separator();
+        char tmp[24];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        put(tmp, static_cast<size_t>(res.ptr - tmp));
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::value(uint64_t v) {
+        separator();
+        char tmp[24];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        put(tmp, static_cast<size_t>(res.ptr - tmp));
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::value(float v) {
+        if (!std::isfinite(v)) return null();
+        separator();
+        char tmp[32];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), v); // Shortest round-trip
+        put(tmp, static_cast<size_t>(res.ptr - tmp));
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::value(double v) {
+        if (!std::isfinite(v)) return null();
+        separator();
+        char tmp[32];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        put(tmp, static_cast<size_t>(res.ptr - tmp));
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::value(bool v) {
+        separator();
+        if (v) put("true", 4);
+        else put("false", 5);
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::null() {
+        separator();
+        put("null", 4);
+        return *this;
+    }
+
+} // namespace blackbox::common
@@ -0,0 +1,152 @@
+/**
+ * @file latency_histogram.cpp
+ * @brief Registry, Merge and Prometheus Export for Stage Histograms.
+ */
+
+#include "blackbox/common/latency_histogram.h"
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace blackbox::common {
+
+    namespace {
+
+        // Blocks outlive their threads so a scrape never reads freed memory.
+        // Threads that record are long-lived pipeline workers, so this stays small.
+        std::mutex& registry_mutex() {
+            static std::mutex m;
+            return m;
+        }
+
+        template <typename Block>
+        std::vector<std::unique_ptr<Block>>& registry() {
+            static std::vector<std::unique_ptr<Block>> blocks;
+            return blocks;
+        }
+
+        // Prometheus bucket bounds (seconds): 1 us .. 10 s
+        constexpr double EXPORT_BOUNDS[] = {
+            1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4,
+            1e-3, 2.5e-3, 5e-3, 1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1.0, 2.5, 10.0
+        };
+
+    } // namespace
+
+    // =========================================================
+    // Registration (Once per Recording Thread)
+    // =========================================================
+    LatencyHistograms::Block* LatencyHistograms::register_thread() {
+        auto block = std::make_unique<Block>();
+        Block* raw = block.get();
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            registry<Block>().push_back(std::move(block));
+        }
+        tls_block_ = raw;
+        return raw;
+    }
+
+    // =========================================================
+    // Merge (Scrape Path)
+    // =========================================================
+    LatencyHistograms::Snapshot LatencyHistograms::snapshot(Stage stage) {
+        Snapshot snap;
+        const auto s = static_cast<size_t>(stage);
+
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        for (const auto& block : registry<Block>()) {
+            for (size_t b = 0; b < BUCKETS; ++b) {
+                const uint64_t c = block->counts[s][b].load(std::memory_order_relaxed);
+                snap.counts[b] += c;
+                snap.count += c;
+            }
+            snap.sum_ns += block->sum_ns[s].load(std::memory_order_relaxed);
+        }
+        return snap;
+    }
+
+    uint64_t LatencyHistograms::Snapshot::quantile(double q) const {
+        if (count == 0) return 0;
+        const auto target = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < BUCKETS; ++b) {
+            seen += counts[b];
+            if (seen >= target) return bucket_upper(b);
+        }
+        return bucket_upper(BUCKETS - 1);
+    }
+
+    const char* LatencyHistograms::stage_name(Stage stage) {
+        switch (stage) {
+            case Stage::RingDwell:      return "ring_dwell";
+            case Stage::Parse:          return "parse";
+            case Stage::Enrich:         return "enrich";
+            case Stage::Rules:          return "rules";
+            case Stage::Inference:      return "inference";
+            case Stage::StorageEnqueue: return "storage_enqueue";
+            case Stage::EndToEnd:       return "end_to_end";
+            case Stage::COUNT:          break;
+        }
+        return "unknown";
+    }
+
+    // =========================================================
+    // Prometheus Export
+    // =========================================================
+    void LatencyHistograms::render_prometheus(std::string& out) {
+        char line[160];
+
+        // Merge once per stage; both sections below read the same snapshots
+        std::array<Snapshot, STAGES> snaps;
+        for (size_t s = 0; s < STAGES; ++s) snaps[s] = snapshot(static_cast<Stage>(s));
+
+        out += "# HELP blackbox_stage_latency_seconds Per-stage processing latency\n"
+               "# TYPE blackbox_stage_latency_seconds histogram\n";
+
+        for (size_t s = 0; s < STAGES; ++s) {
+            const auto stage = static_cast<Stage>(s);
+            const char* name = stage_name(stage);
+            const Snapshot& snap = snaps[s];
+
+            // Fine buckets fold into the coarse export bounds (cumulative).
+            // A fine bucket counts toward 'le' once its upper bound fits under it.
+            uint64_t cumulative = 0;
+            size_t b = 0;
+            for (double bound : EXPORT_BOUNDS) {
+                const auto bound_ns = static_cast<uint64_t>(bound * 1e9);
+                while (b < BUCKETS && bucket_upper(b) <= bound_ns) cumulative += snap.counts[b++];
+                std::snprintf(line, sizeof(line), "blackbox_stage_latency_seconds_bucket{stage=\"%s\",le=\"%g\"} %llu\n",
+                              name, bound, static_cast<unsigned long long>(cumulative));
+                out += line;
+            }
+
+            std::snprintf(line, sizeof(line), "blackbox_stage_latency_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n",
+                          name, static_cast<unsigned long long>(snap.count));
+            out += line;
+            std::snprintf(line, sizeof(line), "blackbox_stage_latency_seconds_sum{stage=\"%s\"} %.9f\n",
+                          name, static_cast<double>(snap.sum_ns) / 1e9);
+            out += line;
+            std::snprintf(line, sizeof(line), "blackbox_stage_latency_seconds_count{stage=\"%s\"} %llu\n",
+                          name, static_cast<unsigned long long>(snap.count));
+            out += line;
+        }
+        out += "\n";
+
+        // Precomputed quantiles for dashboards that don't run histogram_quantile()
+        out += "# HELP blackbox_stage_latency_quantile_seconds Per-stage latency quantiles (bucket upper bound)\n"
+               "# TYPE blackbox_stage_latency_quantile_seconds gauge\n";
+        for (size_t s = 0; s < STAGES; ++s) {
+            const auto stage = static_cast<Stage>(s);
+            const Snapshot& snap = snaps[s];
+            for (double q : {0.5, 0.9, 0.99, 0.999}) {
+                std::snprintf(line, sizeof(line), "blackbox_stage_latency_quantile_seconds{stage=\"%s\",quantile=\"%g\"} %.9f\n",
+                              stage_name(stage), q, static_cast<double>(snap.quantile(q)) / 1e9);
+                out += line;
+            }
+        }
+        out += "\n";
+    }
+
+} // namespace blackbox::common
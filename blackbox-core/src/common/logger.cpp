@@ -1,13 +1,19 @@
 /**
  * @file logger.cpp
- * @brief Implementation of Thread-Safe Logging.
+ * @brief Implementation of Asynchronous Logging.
  */
 
 #include "blackbox/common/logger.h"
-#include <iostream>
-#include <iomanip>
+#include "blackbox/common/spsc_queue.h"
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 namespace blackbox::common {
 
@@ -16,58 +22,381 @@ namespace blackbox::common {
     constexpr const char* RED     = "\033[31m";
     constexpr const char* GREEN   = "\033[32m";
     constexpr const char* YELLOW  = "\033[33m";
-    constexpr const char* BLUE    = "\033[34m";
     constexpr const char* MAGENTA = "\033[35m";
     constexpr const char* CYAN    = "\033[36m";
 
+    // Records buffered per producer thread (~128 KB each)
+    constexpr size_t RING_DEPTH = 256;
+
+    // Sink batching
+    constexpr size_t BATCH_BYTES = 64 * 1024;
+    constexpr int BATCH_IOV = 256;
+    constexpr auto SINK_POLL = std::chrono::milliseconds(2);
+
+    struct Logger::ThreadRing {
+        SpscQueue<Record, RING_DEPTH> queue;
+        std::atomic<bool> closed{false};   // Owning thread has exited
+    };
+
+    namespace {
+
+        void level_style(LogLevel level, const char*& color, const char*& label) {
+            switch (level) {
+                case LogLevel::DEBUG:    color = CYAN;    label = "[DEBUG]"; break;
+                case LogLevel::INFO:     color = GREEN;   label = "[INFO] "; break; // Space for alignment
+                case LogLevel::WARN:     color = YELLOW;  label = "[WARN] "; break;
+                case LogLevel::ERROR:    color = RED;     label = "[ERROR]"; break;
+                case LogLevel::CRITICAL: color = MAGENTA; label = "[CRIT] "; break;
+            }
+        }
+
+        // Local wall-clock "HH:MM:SS", recomputed only when the second changes
+        struct ClockCache {
+            int64_t second = -1;
+            char text[9] = {};
+
+            const char* format(uint64_t timestamp_ns) {
+                const auto sec = static_cast<int64_t>(timestamp_ns / 1000000000ull);
+                if (sec != second) {
+                    second = sec;
+                    std::time_t t = static_cast<std::time_t>(sec);
+                    std::tm tm{};
+                    localtime_r(&t, &tm);
+                    std::snprintf(text, sizeof(text), "%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
+                }
+                return text;
+            }
+        };
+
+        uint64_t wall_clock_ns() {
+            timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts); // vDSO, no syscall
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+        }
+
+        /**
+         * @brief Renders one record: [TIME] [LEVEL] Message (File:Line)
+         * @return Bytes written into out (at most cap)
+         */
+        size_t format_record(char* out, size_t cap, ClockCache& clock, bool color,
+                             LogLevel level, uint64_t timestamp_ns, std::string_view message,
+                             bool truncated, const char* file, int line) {
+            const char* col = RESET;
+            const char* label = "[INFO] ";
+            level_style(level, col, label);
+
+            const unsigned ms = static_cast<unsigned>((timestamp_ns / 1000000ull) % 1000);
+            int n = std::snprintf(out, cap, "%s[%s.%03u] %s %.*s%s%s",
+                                  color ? col : "", clock.format(timestamp_ns), ms, label,
+                                  static_cast<int>(message.size()), message.data(),
+                                  truncated ? "..." : "", color ? RESET : "");
+            size_t len = std::min(static_cast<size_t>(std::max(n, 0)), cap - 1);
+
+            // Add file info only for errors/debug to keep logs clean
+            if (level == LogLevel::ERROR || level == LogLevel::DEBUG || level == LogLevel::CRITICAL) {
+                n = std::snprintf(out + len, cap - len, " (%s:%d)", file, line);
+                len = std::min(len + static_cast<size_t>(std::max(n, 0)), cap - 1);
+            }
+
+            out[len++] = '\n';
+            return len;
+        }
+
+        // Longest formatted line: colors + prefix + message + "..." + file:line
+        constexpr size_t MAX_LINE = Logger::MAX_MESSAGE + 512;
+
+    } // namespace
+
+    // =========================================================
+    // Singleton Instance
+    // =========================================================
     Logger& Logger::instance() {
-        static Logger instance;
-        return instance;
+        // Leaked on purpose: other singletons may log from their destructors.
+        // The sink is drained and stopped from an atexit hook instead.
+        static Logger* instance = [] {
+            auto* logger = new Logger();
+            std::atexit([] { Logger::instance().shutdown(); });
+            return logger;
+        }();
+        return *instance;
+    }
+
+    Logger::Logger() {
+        color_ = ::isatty(1) == 1;
+        sink_thread_ = std::thread(&Logger::sink_worker, this);
+    }
+
+    void Logger::shutdown() {
+        if (!running_.exchange(false)) return;
+        wake_cv_.notify_all();
+        if (sink_thread_.joinable()) sink_thread_.join();
+
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        if (fd_ > 2) {
+            ::close(fd_);
+            fd_ = 1;
+        }
     }
 
     void Logger::set_level(LogLevel level) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        min_level_ = level;
+        min_level_.store(level, std::memory_order_relaxed);
+    }
+
+    // =========================================================
+    // File Sink (Rotating)
+    // =========================================================
+    bool Logger::set_file_sink(const std::string& path, uint64_t max_bytes, int max_files) {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            LOG_ERROR("Cannot open log file " + path + ": " + std::strerror(errno));
+            return false;
+        }
+
+        flush(); // Everything queued so far still goes to the old sink
+
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        if (fd_ > 2) ::close(fd_);
+        fd_ = fd;
+        color_ = false;
+        file_path_ = path;
+        file_max_bytes_ = max_bytes;
+        file_max_count_ = std::max(1, max_files);
+        file_bytes_ = static_cast<uint64_t>(std::max<off_t>(0, ::lseek(fd, 0, SEEK_END)));
+        return true;
+    }
+
+    void Logger::rotate_file() {
+        ::close(fd_);
+
+        // path.N-1 -> path.N, ..., path -> path.1
+        for (int i = file_max_count_ - 1; i >= 1; --i) {
+            std::string from = file_path_ + "." + std::to_string(i);
+            std::string to = file_path_ + "." + std::to_string(i + 1);
+            ::rename(from.c_str(), to.c_str());
+        }
+        std::string first = file_path_ + ".1";
+        ::rename(file_path_.c_str(), first.c_str());
+
+        fd_ = ::open(file_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0) fd_ = 1; // Keep logging somewhere
+        file_bytes_ = 0;
+    }
+
+    // =========================================================
+    // Producer Side (Any Thread, Lock-Free)
+    // =========================================================
+    Logger::ThreadRing& Logger::local_ring() {
+        // Marks the ring closed when its thread exits; the sink frees it once drained
+        struct Handle {
+            std::shared_ptr<ThreadRing> ring;
+            ~Handle() {
+                if (ring) ring->closed.store(true, std::memory_order_release);
+            }
+        };
+        static thread_local Handle handle;
+
+        if (!handle.ring) {
+            handle.ring = std::make_shared<ThreadRing>();
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            rings_.push_back(handle.ring);
+        }
+        return *handle.ring;
     }
 
     void Logger::log(LogLevel level, std::string_view message, const char* file, int line) {
-        // Double-check locking (optimization)
-        if (level < min_level_) return;
-
-        std::lock_guard<std::mutex> lock(mutex_);
-
-        // 1. Get Current Time
-        auto now = std::chrono::system_clock::now();
-        auto time_t_now = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-
-        // 2. Select Color & Label
-        const char* color = RESET;
-        const char* label = "[INFO]";
-        
-        switch (level) {
-            case LogLevel::DEBUG:    color = CYAN;    label = "[DEBUG]"; break;
-            case LogLevel::INFO:     color = GREEN;   label = "[INFO] "; break; // Space for alignment
-            case LogLevel::WARN:     color = YELLOW;  label = "[WARN] "; break;
-            case LogLevel::ERROR:    color = RED;     label = "[ERROR]"; break;
-            case LogLevel::CRITICAL: color = MAGENTA; label = "[CRIT] "; break;
-        }
-
-        // 3. Format Output
-        // [TIME] [LEVEL] Message (File:Line)
-        std::cout << color << "[" 
-                  << std::put_time(std::localtime(&time_t_now), "%H:%M:%S") 
-                  << "." << std::setfill('0') << std::setw(3) << ms.count() 
-                  << "] " << label << " " 
-                  << message 
-                  << RESET;
-
-        // Add file info only for errors/debug to keep logs clean
-        if (level == LogLevel::ERROR || level == LogLevel::DEBUG || level == LogLevel::CRITICAL) {
-             std::cout << " (" << file << ":" << line << ")";
-        }
-
-        std::cout << std::endl;
+        if (level < min_level_.load(std::memory_order_relaxed)) return;
+
+        const uint64_t now = wall_clock_ns();
+        const size_t length = std::min(message.size(), MAX_MESSAGE);
+
+        // Sink already stopped (exit in progress): write synchronously
+        if (!running_.load(std::memory_order_acquire)) {
+            char out[MAX_LINE];
+            ClockCache clock;
+            std::lock_guard<std::mutex> lock(output_mutex_);
+            size_t n = format_record(out, sizeof(out), clock, color_, level, now,
+                                     message.substr(0, length), length < message.size(), file, line);
+            write_line({out, n});
+            return;
+        }
+
+        ThreadRing& ring = local_ring();
+        Record* rec = ring.queue.try_claim();
+        if (!rec) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        rec->timestamp_ns = now;
+        rec->file = file;
+        rec->line = line;
+        rec->level = static_cast<uint8_t>(level);
+        rec->truncated = length < message.size();
+        rec->length = static_cast<uint16_t>(length);
+        std::memcpy(rec->message, message.data(), length);
+        ring.queue.commit_push();
+
+        // Wake the sink now instead of at its next poll, but don't wait for
+        // the write: CRITICAL is logged on failure paths that must stay fast.
+        // Nothing queued is lost on exit (atexit drain, crash handler flush).
+        // Only the first record after the sink parks pays for the notify.
+        if (level == LogLevel::CRITICAL) {
+            flush_requests_.fetch_add(1, std::memory_order_seq_cst);
+            if (sink_idle_.exchange(false, std::memory_order_seq_cst)) wake_cv_.notify_one();
+        }
+    }
+
+    void Logger::flush() {
+        if (!running_.load(std::memory_order_acquire)) return;
+        if (std::this_thread::get_id() == sink_thread_.get_id()) return;
+
+        const uint64_t ticket = flush_requests_.fetch_add(1, std::memory_order_acq_rel) + 1;
+        wake_cv_.notify_all();
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        flushed_cv_.wait_for(lock, std::chrono::seconds(1), [this, ticket] {
+            return flush_done_.load(std::memory_order_acquire) >= ticket || !running_;
+        });
+    }
+
+    // =========================================================
+    // Sink Thread (Formatting + Batched writev)
+    // =========================================================
+    void Logger::sink_worker() {
+        while (running_.load(std::memory_order_acquire)) {
+            const uint64_t requested = flush_requests_.load(std::memory_order_acquire);
+            const size_t written = drain(false);
+
+            if (requested != flush_done_.load(std::memory_order_relaxed)) {
+                {
+                    std::lock_guard<std::mutex> lock(wake_mutex_);
+                    flush_done_.store(requested, std::memory_order_release);
+                }
+                flushed_cv_.notify_all();
+            }
+
+            if (written == 0) {
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                sink_idle_.store(true, std::memory_order_seq_cst);
+                wake_cv_.wait_for(lock, SINK_POLL, [this, requested] {
+                    return !running_ || flush_requests_.load(std::memory_order_seq_cst) != requested;
+                });
+                sink_idle_.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        // Exit: write whatever is left
+        drain(true);
+        flush_done_.store(flush_requests_.load());
+        flushed_cv_.notify_all();
+    }
+
+    size_t Logger::drain(bool final_pass) {
+        static thread_local std::vector<std::shared_ptr<ThreadRing>> snapshot;
+        static thread_local std::vector<char> batch(BATCH_BYTES + MAX_LINE);
+        static thread_local ClockCache clock;
+
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            // Forget rings whose thread is gone and which are fully drained
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const auto& r) {
+                return r->closed.load(std::memory_order_acquire) && r->queue.empty();
+            }), rings_.end());
+            snapshot.assign(rings_.begin(), rings_.end());
+        }
+
+        std::lock_guard<std::mutex> lock(output_mutex_);
+
+        iovec iov[BATCH_IOV];
+        int count = 0;
+        size_t used = 0;
+        size_t records = 0;
+
+        auto emit = [&] {
+            if (count > 0) write_batch(iov, count, used);
+            count = 0;
+            used = 0;
+        };
+
+        // Report losses in-band so they are visible next to the gap
+        const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != dropped_reported_) {
+            char msg[96];
+            int m = std::snprintf(msg, sizeof(msg), "Logger dropped %llu message(s): producer ring full",
+                                  static_cast<unsigned long long>(dropped - dropped_reported_));
+            size_t n = format_record(batch.data(), MAX_LINE, clock, color_, LogLevel::WARN,
+                                     wall_clock_ns(), {msg, static_cast<size_t>(m)}, false, __FILE__, __LINE__);
+            iov[count++] = {batch.data(), n};
+            used = n;
+            dropped_reported_ = dropped;
+        }
+
+        for (const auto& ring : snapshot) {
+            // Bound the per-ring work so one chatty thread can't starve the others
+            for (size_t taken = 0; taken < RING_DEPTH; ++taken) {
+                const Record* rec = ring->queue.front();
+                if (!rec) break;
+
+                char* out = batch.data() + used;
+                size_t n = format_record(out, MAX_LINE, clock, color_, static_cast<LogLevel>(rec->level),
+                                         rec->timestamp_ns, {rec->message, rec->length},
+                                         rec->truncated != 0, rec->file, rec->line);
+                ring->queue.pop_front();
+
+                iov[count++] = {out, n};
+                used += n;
+                records++;
+
+                if (count == BATCH_IOV || used >= BATCH_BYTES) emit();
+            }
+        }
+        emit();
+
+        if (final_pass) {
+            // One more sweep for records logged while we were writing
+            for (const auto& ring : snapshot) {
+                while (const Record* rec = ring->queue.front()) {
+                    size_t n = format_record(batch.data(), MAX_LINE, clock, color_, static_cast<LogLevel>(rec->level),
+                                             rec->timestamp_ns, {rec->message, rec->length},
+                                             rec->truncated != 0, rec->file, rec->line);
+                    ring->queue.pop_front();
+                    write_line({batch.data(), n});
+                    records++;
+                }
+            }
+        }
+        return records;
+    }
+
+    void Logger::write_batch(const iovec* iov, int count, size_t bytes) {
+        // writev may be partial on pipes; finish with plain writes
+        ssize_t n = ::writev(fd_, iov, count);
+        size_t done = n > 0 ? static_cast<size_t>(n) : 0;
+
+        if (done < bytes) {
+            for (int i = 0; i < count; ++i) {
+                if (done >= iov[i].iov_len) {
+                    done -= iov[i].iov_len;
+                    continue;
+                }
+                write_line({static_cast<const char*>(iov[i].iov_base) + done, iov[i].iov_len - done});
+                done = 0;
+            }
+        }
+
+        if (!file_path_.empty()) {
+            file_bytes_ += bytes;
+            if (file_bytes_ >= file_max_bytes_) rotate_file();
+        }
+    }
+
+    void Logger::write_line(std::string_view line) {
+        while (!line.empty()) {
+            ssize_t n = ::write(fd_, line.data(), line.size());
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return; // Sink broken: nothing sensible left to do
+            line.remove_prefix(static_cast<size_t>(n));
+        }
     }
 
-} // namespace blackbox::common
\ No newline at end of file
+} // namespace blackbox::common
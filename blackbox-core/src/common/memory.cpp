@@ -0,0 +1,163 @@
+/**
+ * @file memory.cpp
+ * @brief Implementation of Huge-Page / NUMA-Aware Mappings.
+ */
+
+#include "blackbox/common/memory.h"
+#include "blackbox/common/logger.h"
+#include "blackbox/common/settings.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace blackbox::common {
+
+    namespace {
+
+        constexpr size_t HUGE_PAGE = 2 * 1024 * 1024;
+        constexpr int MAX_NUMA_NODES = 64;   // One word of node mask
+
+        size_t round_up(size_t value, size_t to) {
+            return (value + to - 1) / to * to;
+        }
+
+        // Plain mapping of 'bytes' whose start is 2 MB aligned (THP can
+        // only back aligned 2 MB extents)
+        void* map_aligned(size_t bytes) {
+            const size_t padded = bytes + HUGE_PAGE;
+            void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) return nullptr;
+
+            const auto start = reinterpret_cast<uintptr_t>(raw);
+            const uintptr_t aligned = round_up(start, HUGE_PAGE);
+            if (aligned > start) munmap(raw, aligned - start);
+            const uintptr_t end = start + padded;
+            if (end > aligned + bytes) munmap(reinterpret_cast<void*>(aligned + bytes), end - (aligned + bytes));
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // Preferred (not strict) policy: falls back to other nodes when full
+        bool bind_to_node(void* addr, size_t bytes, int node) {
+            if (node < 0 || node >= MAX_NUMA_NODES) return false;
+            unsigned long mask = 1ul << node;
+            return syscall(SYS_mbind, addr, bytes, MPOL_PREFERRED, &mask, MAX_NUMA_NODES + 1, 0) == 0;
+        }
+
+        void prefault(void* addr, size_t bytes, size_t page) {
+#ifdef MADV_POPULATE_WRITE
+            if (madvise(addr, bytes, MADV_POPULATE_WRITE) == 0) return;
+#endif
+            // Older kernels: touch one byte per page
+            auto* p = static_cast<volatile char*>(addr);
+            for (size_t off = 0; off < bytes; off += page) p[off] = 0;
+        }
+
+    } // namespace
+
+    // =========================================================
+    // Policy
+    // =========================================================
+    MemoryPolicy MemoryPolicy::for_cpu(int cpu) {
+        const auto& config = Settings::instance().memory();
+        MemoryPolicy policy;
+        policy.huge_pages = config.huge_pages;
+        policy.prefault = config.prefault;
+        policy.numa_node = config.numa_bind && cpu >= 0 ? MappedRegion::numa_node_of_cpu(cpu) : -1;
+        return policy;
+    }
+
+    // =========================================================
+    // Mapping
+    // =========================================================
+    MappedRegion MappedRegion::allocate(size_t bytes, const MemoryPolicy& policy, const char* label) {
+        MappedRegion region;
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        bytes = std::max<size_t>(bytes, 1);
+
+        // 1. Explicit huge pages (only if the administrator reserved a pool)
+        if (policy.huge_pages) {
+            const size_t len = round_up(bytes, HUGE_PAGE);
+            void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                region.data_ = p;
+                region.size_ = len;
+                region.backing_ = Backing::HugeTlb;
+            }
+        }
+
+        // 2. THP hint on an aligned mapping
+        if (!region.data_ && policy.huge_pages && bytes >= HUGE_PAGE) {
+            const size_t len = round_up(bytes, HUGE_PAGE);
+            if (void* p = map_aligned(len)) {
+                region.data_ = p;
+                region.size_ = len;
+                region.backing_ = madvise(p, len, MADV_HUGEPAGE) == 0 ? Backing::TransparentHuge : Backing::Normal;
+            }
+        }
+
+        // 3. Plain pages
+        if (!region.data_) {
+            const size_t len = round_up(bytes, page);
+            void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) {
+                LOG_CRITICAL(std::string("Cannot map ") + label + ": " + std::strerror(errno));
+                throw std::bad_alloc();
+            }
+            region.data_ = p;
+            region.size_ = len;
+            region.backing_ = Backing::Normal;
+        }
+
+        // Bind before the first touch, so prefaulting places the pages
+        region.numa_bound_ = bind_to_node(region.data_, region.size_, policy.numa_node);
+
+        if (policy.prefault) {
+            prefault(region.data_, region.size_, region.backing_ == Backing::HugeTlb ? HUGE_PAGE : page);
+        }
+
+        LOG_INFO(std::string(label) + ": " + std::to_string(region.size_ / (1024 * 1024)) + " MB, " +
+                 backing_name(region.backing_) + " pages" +
+                 (region.numa_bound_ ? ", node " + std::to_string(policy.numa_node) : std::string()) +
+                 (policy.prefault ? ", prefaulted" : ""));
+        return region;
+    }
+
+    MappedRegion::~MappedRegion() {
+        if (data_) munmap(data_, size_);
+    }
+
+    const char* MappedRegion::backing_name(Backing backing) {
+        switch (backing) {
+            case Backing::HugeTlb:         return "hugetlb";
+            case Backing::TransparentHuge: return "THP";
+            case Backing::Normal:          return "4K";
+            default:                       return "none";
+        }
+    }
+
+    int MappedRegion::numa_node_of_cpu(int cpu) {
+        // /sys/devices/system/cpu/cpuN/ holds a "nodeK" link
+        const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return -1;
+
+        int node = -1;
+        while (dirent* entry = readdir(dir)) {
+            if (std::strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+                node = std::atoi(entry->d_name + 4);
+                break;
+            }
+        }
+        closedir(dir);
+        return node;
+    }
+
+} // namespace blackbox::common
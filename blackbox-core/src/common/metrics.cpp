@@ -6,9 +6,14 @@
 #include "blackbox/common/metrics.h"
 #include "blackbox/common/logger.h"
 #include "blackbox/common/system_stats.h"
+#include "blackbox/common/latency_histogram.h"
+#include "blackbox/common/profiler.h"
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <string_view>
 #include <chrono>
 
 namespace blackbox::common {
@@ -42,6 +47,14 @@ namespace blackbox::common {
         packets_dropped_.fetch_add(count, std::memory_order_relaxed);
     }
 
+    void Metrics::inc_ingest_backpressure(size_t count) {
+        ingest_backpressure_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_tcp_frames_truncated(size_t count) {
+        tcp_truncated_.fetch_add(count, std::memory_order_relaxed);
+    }
+
     void Metrics::inc_inferences_run(size_t count) {
         inferences_.fetch_add(count, std::memory_order_relaxed);
     }
@@ -50,6 +63,14 @@ namespace blackbox::common {
         threats_.fetch_add(count, std::memory_order_relaxed);
     }
 
+    void Metrics::inc_alerts_published(size_t count) {
+        alerts_published_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_alerts_dropped(size_t count) {
+        alerts_dropped_.fetch_add(count, std::memory_order_relaxed);
+    }
+
     void Metrics::inc_db_rows_written(size_t count) {
         db_written_.fetch_add(count, std::memory_order_relaxed);
     }
@@ -58,6 +79,52 @@ namespace blackbox::common {
         db_errors_.fetch_add(count, std::memory_order_relaxed);
     }
 
+    void Metrics::inc_db_rows_dropped(size_t count) {
+        db_dropped_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_db_batches_rejected(size_t count) {
+        db_rejected_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_spool_rows_written(size_t count) {
+        spool_written_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_spool_rows_replayed(size_t count) {
+        spool_replayed_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_firewall_updates(size_t count) {
+        firewall_updates_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_firewall_errors(size_t count) {
+        firewall_errors_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_packets_banned(size_t count) {
+        packets_banned_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_alert_dedup_evictions(size_t count) {
+        alert_dedup_evictions_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_alert_summaries(size_t count) {
+        alert_summaries_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::inc_alerts_shaped(size_t count) {
+        alerts_shaped_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Metrics::set_spool_depth(uint64_t bytes, uint64_t rows, uint64_t oldest_age_ms) {
+        spool_bytes_.store(bytes, std::memory_order_relaxed);
+        spool_rows_.store(rows, std::memory_order_relaxed);
+        spool_age_ms_.store(oldest_age_ms, std::memory_order_relaxed);
+    }
+
     // =========================================================
     // Lifecycle Management
     // =========================================================
@@ -120,63 +187,149 @@ namespace blackbox::common {
         }
     }
 
+    // =========================================================
+    // Gauge Registry
+    // =========================================================
+    void Metrics::register_gauge(const std::string& name, const std::string& help, std::function<double()> sample) {
+        register_sampled(name, help, std::move(sample), "gauge");
+    }
+
+    void Metrics::register_counter(const std::string& name, const std::string& help, std::function<double()> sample) {
+        register_sampled(name, help, std::move(sample), "counter");
+    }
+
+    void Metrics::register_sampled(const std::string& name, const std::string& help,
+                                   std::function<double()> sample, const char* type) {
+        std::lock_guard<std::mutex> lock(scrape_mutex_);
+        for (auto& gauge : gauges_) {
+            if (gauge.name == name) {
+                gauge.help = help;
+                gauge.sample = std::move(sample);
+                gauge.type = type;
+                return;
+            }
+        }
+        gauges_.push_back(Gauge{name, help, std::move(sample), type});
+    }
+
+    void Metrics::unregister_gauge(const std::string& name) {
+        std::lock_guard<std::mutex> lock(scrape_mutex_);
+        gauges_.erase(std::remove_if(gauges_.begin(), gauges_.end(),
+                                     [&](const Gauge& g) { return g.name == name; }),
+                      gauges_.end());
+    }
+
     // =========================================================
     // Prometheus Exporter (For Admin Server)
     // =========================================================
+    namespace {
+
+        void append_value(std::string& out, uint64_t value) {
+            char buf[24];
+            auto res = std::to_chars(buf, buf + sizeof(buf), value);
+            out.append(buf, res.ptr);
+        }
+
+        void append_value(std::string& out, double value) {
+            char buf[32];
+            auto res = std::to_chars(buf, buf + sizeof(buf), value);
+            out.append(buf, res.ptr);
+        }
+
+        void append_header(std::string& out, std::string_view name, std::string_view help, std::string_view type) {
+            out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+            out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+        }
+
+        template <typename T>
+        void append_metric(std::string& out, std::string_view name, std::string_view help,
+                           std::string_view type, T value) {
+            append_header(out, name, help, type);
+            out.append(name).append(" ");
+            append_value(out, value);
+            out.append("\n\n");
+        }
+
+        void append_counter(std::string& out, std::string_view name, std::string_view help,
+                            const std::atomic<uint64_t>& counter) {
+            append_metric(out, name, help, "counter", counter.load(std::memory_order_relaxed));
+        }
+
+    } // namespace
+
     std::string Metrics::get_prometheus_metrics() {
-        std::stringstream ss;
-        
-        // Snapshot atomic values
-        uint64_t rx = packets_rx_.load(std::memory_order_relaxed);
-        uint64_t drops = packets_dropped_.load(std::memory_order_relaxed);
-        uint64_t inf = inferences_.load(std::memory_order_relaxed);
-        uint64_t thr = threats_.load(std::memory_order_relaxed);
-        uint64_t db = db_written_.load(std::memory_order_relaxed);
-        uint64_t err = db_errors_.load(std::memory_order_relaxed);
-
-        // Snapshot System Stats
-        double cpu = SystemStats::instance().get_cpu_usage_percent();
-        size_t ram = SystemStats::instance().get_memory_usage_bytes();
+        std::lock_guard<std::mutex> lock(scrape_mutex_);
+
+        // Reused across scrapes: after warm-up, rendering doesn't grow it
+        std::string& out = scrape_buffer_;
+        out.clear();
 
         // ---------------------------------------------------------
         // Format: Prometheus Text Protocol
         // ---------------------------------------------------------
 
         // App Metrics
-        ss << "# HELP blackbox_packets_total Total UDP packets received\n"
-           << "# TYPE blackbox_packets_total counter\n"
-           << "blackbox_packets_total " << rx << "\n\n";
-
-        ss << "# HELP blackbox_packets_dropped_total Total packets dropped (buffer full/ratelimit)\n"
-           << "# TYPE blackbox_packets_dropped_total counter\n"
-           << "blackbox_packets_dropped_total " << drops << "\n\n";
-
-        ss << "# HELP blackbox_inferences_total Total AI inferences run\n"
-           << "# TYPE blackbox_inferences_total counter\n"
-           << "blackbox_inferences_total " << inf << "\n\n";
-
-        ss << "# HELP blackbox_threats_detected_total Total critical threats found\n"
-           << "# TYPE blackbox_threats_detected_total counter\n"
-           << "blackbox_threats_detected_total " << thr << "\n\n";
-
-        ss << "# HELP blackbox_db_written_total Total rows flushed to ClickHouse\n"
-           << "# TYPE blackbox_db_written_total counter\n"
-           << "blackbox_db_written_total " << db << "\n\n";
+        append_counter(out, "blackbox_packets_total", "Total UDP packets received", packets_rx_);
+        append_counter(out, "blackbox_packets_dropped_total", "Total packets dropped (buffer full/ratelimit)", packets_dropped_);
+        append_counter(out, "blackbox_ingest_backpressure_drops_total", "Events dropped at ingest because the ring buffer was full", ingest_backpressure_);
+        append_counter(out, "blackbox_tcp_frames_truncated_total", "TCP frames cut to the 4 KB event size", tcp_truncated_);
+        append_counter(out, "blackbox_inferences_total", "Total AI inferences run", inferences_);
+        append_counter(out, "blackbox_threats_detected_total", "Total critical threats found", threats_);
+        append_counter(out, "blackbox_alerts_published_total", "Alerts acknowledged by Redis PUBLISH", alerts_published_);
+        append_counter(out, "blackbox_alerts_dropped_total", "Alerts shed (queue full, oversized, Redis down or refused)", alerts_dropped_);
+        append_counter(out, "blackbox_db_written_total", "Total rows flushed to ClickHouse", db_written_);
+        append_counter(out, "blackbox_db_errors_total", "Total DB write failures", db_errors_);
+        append_counter(out, "blackbox_db_rows_dropped_total", "Rows discarded before reaching ClickHouse", db_dropped_);
+        append_counter(out, "blackbox_db_batches_rejected_total", "Batches ClickHouse refused with a 4xx (dropped, not retried)", db_rejected_);
+        append_counter(out, "blackbox_spool_rows_written_total", "Rows diverted to the disk spool", spool_written_);
+        append_counter(out, "blackbox_spool_rows_replayed_total", "Rows replayed from the disk spool into ClickHouse", spool_replayed_);
+        append_counter(out, "blackbox_firewall_updates_total", "Ban set additions/removals applied", firewall_updates_);
+        append_counter(out, "blackbox_firewall_errors_total", "Ban set operations rejected by the firewall", firewall_errors_);
+        append_counter(out, "blackbox_packets_banned_total", "Datagrams/connections from banned sources dropped at ingest", packets_banned_);
+        append_counter(out, "blackbox_alert_dedup_evictions_total", "Alert cooldown entries displaced before expiry", alert_dedup_evictions_);
+        append_counter(out, "blackbox_alert_summaries_total", "Aggregated alert summaries emitted", alert_summaries_);
+        append_counter(out, "blackbox_alerts_shaped_total", "Alert summaries held back by a sink's rate limit", alerts_shaped_);
+
+        append_metric(out, "blackbox_spool_depth_bytes", "Bytes waiting in the disk spool", "gauge",
+                      spool_bytes_.load(std::memory_order_relaxed));
+        append_metric(out, "blackbox_spool_depth_rows", "Rows waiting in the disk spool", "gauge",
+                      spool_rows_.load(std::memory_order_relaxed));
+        append_metric(out, "blackbox_spool_oldest_age_seconds", "Age of the oldest spooled batch", "gauge",
+                      spool_age_ms_.load(std::memory_order_relaxed) / 1000.0);
+
+        append_metric(out, "blackbox_log_records_dropped_total", "Log records dropped (logger ring full)", "counter",
+                      Logger::instance().dropped());
+
+        // Component gauges and counters (queue depths, ring occupancy...)
+        for (const auto& gauge : gauges_) {
+            append_metric(out, gauge.name, gauge.help, gauge.type, gauge.sample());
+        }
 
-        ss << "# HELP blackbox_db_errors_total Total DB write failures\n"
-           << "# TYPE blackbox_db_errors_total counter\n"
-           << "blackbox_db_errors_total " << err << "\n\n";
+        // System Metrics (cached, at most one /proc refresh per second)
+        SystemStats::instance().snapshot(system_snapshot_);
+
+        append_metric(out, "blackbox_process_cpu_percent", "CPU usage percentage (normalized)", "gauge",
+                      system_snapshot_.cpu_percent);
+        append_metric(out, "blackbox_process_memory_bytes", "Resident memory size in bytes", "gauge",
+                      static_cast<uint64_t>(system_snapshot_.memory_bytes));
+
+        append_header(out, "blackbox_thread_cpu_percent", "CPU usage per named thread (100 = one core)", "gauge");
+        for (const auto& thread : system_snapshot_.threads) {
+            out.append("blackbox_thread_cpu_percent{thread=\"").append(thread.name).append("\",tid=\"");
+            append_value(out, static_cast<uint64_t>(thread.tid));
+            out.append("\"} ");
+            append_value(out, thread.cpu_percent);
+            out.append("\n");
+        }
+        out.append("\n");
 
-        // System Metrics
-        ss << "# HELP blackbox_process_cpu_percent CPU usage percentage (normalized)\n"
-           << "# TYPE blackbox_process_cpu_percent gauge\n"
-           << "blackbox_process_cpu_percent " << cpu << "\n\n";
+        // Per-stage latency (merged across threads)
+        LatencyHistograms::render_prometheus(out);
 
-        ss << "# HELP blackbox_process_memory_bytes Resident memory size in bytes\n"
-           << "# TYPE blackbox_process_memory_bytes gauge\n"
-           << "blackbox_process_memory_bytes " << ram << "\n\n";
+        // Profiling zones (empty when compiled out)
+        Profiler::render_prometheus(out);
 
-        return ss.str();
+        return out;
     }
 
 } // namespace blackbox::common
\ No newline at end of file
@@ -0,0 +1,156 @@
+/**
+ * @file profiler.cpp
+ * @brief Zone Registry, Merge and Export.
+ */
+
+#include "blackbox/common/profiler.h"
+#include "blackbox/common/json_writer.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+namespace blackbox::common {
+
+    namespace {
+
+        struct ZoneInfo {
+            const char* name;
+            const char* file;
+            int line;
+        };
+
+        // Zone 0 catches call sites beyond MAX_ZONES
+        constexpr uint32_t OVERFLOW_ZONE = 0;
+
+        std::mutex& registry_mutex() {
+            static std::mutex m;
+            return m;
+        }
+
+        std::vector<ZoneInfo>& zones() {
+            static std::vector<ZoneInfo> list{{"(overflow)", "", 0}};
+            return list;
+        }
+
+        // Blocks outlive their threads so a merge never reads freed memory
+        template <typename Block>
+        std::vector<std::unique_ptr<Block>>& blocks() {
+            static std::vector<std::unique_ptr<Block>> list;
+            return list;
+        }
+
+        void append_seconds(std::string& out, uint64_t ns) {
+            char buf[32];
+            const int n = std::snprintf(buf, sizeof(buf), "%.9f", static_cast<double>(ns) / 1e9);
+            out.append(buf, static_cast<size_t>(n));
+        }
+
+    } // namespace
+
+    // =========================================================
+    // Registration
+    // =========================================================
+    uint32_t Profiler::register_zone(const char* name, const char* file, int line) {
+        // Ticks are only meaningful once the TSC rate is known
+        TscClock::calibrate();
+
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        auto& list = zones();
+        if (list.size() >= MAX_ZONES) return OVERFLOW_ZONE;
+        list.push_back(ZoneInfo{name, file, line});
+        return static_cast<uint32_t>(list.size() - 1);
+    }
+
+    Profiler::Block* Profiler::register_thread() {
+        auto block = std::make_unique<Block>();
+        Block* raw = block.get();
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            blocks<Block>().push_back(std::move(block));
+        }
+        tls_block_ = raw;
+        return raw;
+    }
+
+    // =========================================================
+    // Merge
+    // =========================================================
+    std::vector<Profiler::ZoneStats> Profiler::snapshot() {
+        std::vector<ZoneStats> result;
+
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        const auto& list = zones();
+        for (size_t z = 0; z < list.size(); ++z) {
+            uint64_t count = 0, total = 0, max = 0;
+            for (const auto& block : blocks<Block>()) {
+                const Slot& slot = block->slots[z];
+                count += slot.count.load(std::memory_order_relaxed);
+                total += slot.total_ticks.load(std::memory_order_relaxed);
+                max = std::max(max, slot.max_ticks.load(std::memory_order_relaxed));
+            }
+            if (count == 0) continue;
+            result.push_back(ZoneStats{list[z].name, list[z].file, list[z].line,
+                                       count, TscClock::to_ns(total), TscClock::to_ns(max)});
+        }
+
+        // Most expensive first
+        std::sort(result.begin(), result.end(),
+                  [](const ZoneStats& a, const ZoneStats& b) { return a.total_ns > b.total_ns; });
+        return result;
+    }
+
+    // =========================================================
+    // Export
+    // =========================================================
+    std::string Profiler::to_json() {
+        const auto stats = snapshot();
+
+        std::string out(64 + stats.size() * 512, '\0');
+        JsonWriter json(out.data(), out.size());
+        json.begin_array();
+        for (const auto& z : stats) {
+            json.begin_object()
+                .field("zone", z.name)
+                .field("file", z.file)
+                .field("line", z.line)
+                .field("count", z.count)
+                .field("total_ns", z.total_ns)
+                .field("mean_ns", z.total_ns / z.count)
+                .field("max_ns", z.max_ns)
+                .end_object();
+        }
+        json.end_array();
+
+        out.resize(json.ok() ? json.size() : 0);
+        return out;
+    }
+
+    void Profiler::render_prometheus(std::string& out) {
+        const auto stats = snapshot();
+        if (stats.empty()) return;
+
+        out += "# HELP blackbox_zone_calls_total Profiling zone entries\n"
+               "# TYPE blackbox_zone_calls_total counter\n";
+        for (const auto& z : stats) {
+            out.append("blackbox_zone_calls_total{zone=\"").append(z.name).append("\"} ")
+               .append(std::to_string(z.count)).append("\n");
+        }
+        out += "\n# HELP blackbox_zone_seconds_total Time spent inside profiling zones\n"
+               "# TYPE blackbox_zone_seconds_total counter\n";
+        for (const auto& z : stats) {
+            out.append("blackbox_zone_seconds_total{zone=\"").append(z.name).append("\"} ");
+            append_seconds(out, z.total_ns);
+            out.append("\n");
+        }
+        out += "\n# HELP blackbox_zone_max_seconds Longest single pass through a profiling zone\n"
+               "# TYPE blackbox_zone_max_seconds gauge\n";
+        for (const auto& z : stats) {
+            out.append("blackbox_zone_max_seconds{zone=\"").append(z.name).append("\"} ");
+            append_seconds(out, z.max_ns);
+            out.append("\n");
+        }
+        out += "\n";
+    }
+
+} // namespace blackbox::common
@@ -59,16 +59,86 @@ namespace blackbox::common {
         // Network
         network_.udp_port = static_cast<uint16_t>(get_env_int("BLACKBOX_UDP_PORT", 514));
         network_.ring_buffer_size = get_env_int("BLACKBOX_RING_BUFFER_SIZE", 65536);
+        network_.admin_max_connections = get_env_int("BLACKBOX_ADMIN_MAX_CONNECTIONS", 32);
+        network_.admin_timeout_ms = get_env_int("BLACKBOX_ADMIN_TIMEOUT_MS", 10000);
+        network_.consumer_wait = get_env_string("BLACKBOX_CONSUMER_WAIT", "balanced");
 
         // AI
         ai_.model_path = get_env_string("BLACKBOX_MODEL_PATH", "/app/models/autoencoder.plan");
         ai_.anomaly_threshold = get_env_float("BLACKBOX_ANOMALY_THRESHOLD", 0.8f);
         ai_.batch_size = get_env_int("BLACKBOX_AI_BATCH_SIZE", 32);
+        ai_.adaptive_batching = get_env_int("BLACKBOX_AI_BATCH_ADAPTIVE", 1) != 0;
+        ai_.batch_min = get_env_int("BLACKBOX_AI_BATCH_MIN", 8);
+        ai_.batch_max = get_env_int("BLACKBOX_AI_BATCH_MAX", 512);
+        ai_.batch_max_wait_us = get_env_int("BLACKBOX_AI_BATCH_WAIT_US", 200);
+        ai_.latency_budget_ms = get_env_int("BLACKBOX_LATENCY_BUDGET_MS", 50);
 
         // Database
         db_.clickhouse_url = get_env_string("BLACKBOX_CLICKHOUSE_URL", "http://clickhouse:8123");
         db_.flush_batch_size = get_env_int("BLACKBOX_DB_BATCH_SIZE", 1000);
         db_.flush_interval_ms = get_env_int("BLACKBOX_DB_FLUSH_MS", 1000);
+        db_.max_inflight_batches = get_env_int("BLACKBOX_DB_MAX_INFLIGHT", 4);
+        db_.max_retries = get_env_int("BLACKBOX_DB_MAX_RETRIES", 5);
+        db_.retry_backoff_ms = get_env_int("BLACKBOX_DB_RETRY_BACKOFF_MS", 100);
+        db_.spool_dir = get_env_string("BLACKBOX_SPOOL_DIR", "/var/lib/blackbox/spool");
+        db_.spool_max_bytes = static_cast<uint64_t>(get_env_int("BLACKBOX_SPOOL_MAX_MB", 2048)) << 20;
+        db_.spool_segment_bytes = static_cast<uint64_t>(get_env_int("BLACKBOX_SPOOL_SEGMENT_MB", 64)) << 20;
+        db_.spool_replay_rows_per_sec = get_env_int("BLACKBOX_SPOOL_REPLAY_RPS", 50000);
+        db_.time_ordered_ids = get_env_int("BLACKBOX_EVENT_ID_V7", 0) != 0;
+
+        // Recent Event Store (Admin Queries)
+        recent_.window_sec = get_env_int("BLACKBOX_RECENT_WINDOW_SEC", 300);
+        recent_.memory_mb = get_env_int("BLACKBOX_RECENT_MEMORY_MB", 64);
+
+        // Logging
+        log_.file_path = get_env_string("BLACKBOX_LOG_FILE", "");
+        log_.max_file_mb = get_env_int("BLACKBOX_LOG_MAX_MB", 100);
+        log_.max_files = get_env_int("BLACKBOX_LOG_MAX_FILES", 5);
+
+        // Pipeline Tracing (/debug/trace)
+        trace_.sample_every = get_env_int("BLACKBOX_TRACE_SAMPLE_N", 0);
+        trace_.source_ip = get_env_string("BLACKBOX_TRACE_SOURCE_IP", "");
+        trace_.buffer_events = get_env_int("BLACKBOX_TRACE_BUFFER", 4096);
+
+        // Active Defense (Firewall)
+        defense_.firewall_backend = get_env_string("BLACKBOX_FIREWALL_BACKEND", "nftables");
+        defense_.firewall_table = get_env_string("BLACKBOX_FIREWALL_TABLE", "blackbox");
+        defense_.firewall_batch_ms = get_env_int("BLACKBOX_FIREWALL_BATCH_MS", 5);
+        defense_.ingest_bpf_filter = get_env_int("BLACKBOX_BAN_BPF", 0) != 0;
+        defense_.alert_dedup_slots = get_env_int("BLACKBOX_ALERT_DEDUP_SLOTS", 65536);
+
+        // Alert Dispatch (aggregation + per-sink rate limits)
+        alerts_.window_ms = get_env_int("BLACKBOX_ALERT_WINDOW_MS", 1000);
+        alerts_.log_rate = get_env_int("BLACKBOX_ALERT_LOG_RATE", 10);
+        alerts_.log_burst = get_env_int("BLACKBOX_ALERT_LOG_BURST", 50);
+        alerts_.redis_rate = get_env_int("BLACKBOX_ALERT_REDIS_RATE", 50);
+        alerts_.redis_burst = get_env_int("BLACKBOX_ALERT_REDIS_BURST", 200);
+
+        // Stage Graph (threads, pinning, queue depth)
+        stages_.queue_depth = get_env_int("BLACKBOX_STAGE_QUEUE_DEPTH", 1024);
+        stages_.enrich_threads = get_env_int("BLACKBOX_STAGE_ENRICH_THREADS", 1);
+        stages_.detect_threads = get_env_int("BLACKBOX_STAGE_DETECT_THREADS", 1);
+        stages_.parse_core = get_env_int("BLACKBOX_STAGE_PARSE_CORE", 1);
+        stages_.enrich_core = get_env_int("BLACKBOX_STAGE_ENRICH_CORE", -1);
+        stages_.detect_core = get_env_int("BLACKBOX_STAGE_DETECT_CORE", -1);
+        stages_.persist_core = get_env_int("BLACKBOX_STAGE_PERSIST_CORE", -1);
+
+        // Overload Shedding (priority-aware sampling at ingest)
+        overload_.enabled = get_env_int("BLACKBOX_OVERLOAD_SHEDDING", 1) != 0;
+        overload_.engage_pct = get_env_int("BLACKBOX_OVERLOAD_ENGAGE_PCT", 50);
+        overload_.severe_pct = get_env_int("BLACKBOX_OVERLOAD_SEVERE_PCT", 85);
+        overload_.release_pct = get_env_int("BLACKBOX_OVERLOAD_RELEASE_PCT", 25);
+        overload_.keep_high = get_env_int("BLACKBOX_SHED_KEEP_HIGH", 1);
+        overload_.keep_normal = get_env_int("BLACKBOX_SHED_KEEP_NORMAL", 4);
+        overload_.keep_low = get_env_int("BLACKBOX_SHED_KEEP_LOW", 16);
+        overload_.severe_factor = get_env_int("BLACKBOX_SHED_SEVERE_FACTOR", 8);
+        overload_.hot_source_sec = get_env_int("BLACKBOX_SHED_HOT_SOURCE_SEC", 300);
+        overload_.priority_sources = get_env_string("BLACKBOX_SHED_PRIORITY_SOURCES", "");
+
+        // Memory Placement (huge pages, NUMA, prefault)
+        memory_.huge_pages = get_env_int("BLACKBOX_HUGE_PAGES", 1) != 0;
+        memory_.numa_bind = get_env_int("BLACKBOX_NUMA_BIND", 1) != 0;
+        memory_.prefault = get_env_int("BLACKBOX_PREFAULT", 1) != 0;
 
         std::cout << "[INIT] Config Loaded. Listening on Port: " << network_.udp_port << std::endl;
         std::cout << "[INIT] DB Target: " << db_.clickhouse_url << std::endl;
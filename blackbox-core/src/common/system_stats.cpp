@@ -4,15 +4,53 @@
  */
 
 #include "blackbox/common/system_stats.h"
+#include "blackbox/common/thread_utils.h"
 #include "blackbox/common/logger.h"
-#include <fstream>
-#include <sstream>
-#include <string>
-#include <unistd.h> // sysconf
-#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h> // sysconf, pread
 
 namespace blackbox::common {
 
+    namespace {
+
+        // Reads a whole /proc file from offset 0 into buf (NUL-terminated)
+        ssize_t read_proc(int fd, char* buf, size_t size) {
+            if (fd < 0) return -1;
+            ssize_t n = ::pread(fd, buf, size - 1, 0);
+            if (n < 0) return -1;
+            buf[n] = '\0';
+            return n;
+        }
+
+        // utime + stime (fields 14, 15) of a /proc/.../stat line.
+        // The comm field may contain spaces, so parsing starts after its closing ')'.
+        bool parse_stat_cpu(const char* line, unsigned long long& out) {
+            const char* p = std::strrchr(line, ')');
+            if (!p) return false;
+            ++p;
+            // Fields after comm: state(3) ... utime(14) stime(15)
+            for (int field = 3; field < 14; ++field) {
+                while (*p == ' ') ++p;
+                while (*p && *p != ' ') ++p;
+                if (!*p) return false;
+            }
+            char* end = nullptr;
+            const unsigned long long utime = std::strtoull(p, &end, 10);
+            const unsigned long long stime = std::strtoull(end, &end, 10);
+            out = utime + stime;
+            return true;
+        }
+
+        int open_proc(const char* path) {
+            return ::open(path, O_RDONLY | O_CLOEXEC);
+        }
+
+    } // namespace
+
     // =========================================================
     // Constructor
     // =========================================================
@@ -27,80 +65,134 @@ namespace blackbox::common {
         if (page_size > 0) {
             page_size_kb_ = page_size / 1024;
         }
+
+        num_cores_ = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+
+        stat_fd_ = open_proc("/proc/stat");
+        self_stat_fd_ = open_proc("/proc/self/stat");
+        statm_fd_ = open_proc("/proc/self/statm");
+        if (stat_fd_ < 0 || self_stat_fd_ < 0 || statm_fd_ < 0) {
+            LOG_WARN("SystemStats: /proc is not readable, CPU/RSS will report 0.");
+        }
+    }
+
+    SystemStats::~SystemStats() {
+        for (int fd : {stat_fd_, self_stat_fd_, statm_fd_}) {
+            if (fd >= 0) ::close(fd);
+        }
+        for (auto& t : thread_states_) {
+            if (t.fd >= 0) ::close(t.fd);
+        }
     }
 
     // =========================================================
-    // Get Memory Usage (RSS)
+    // Cached Snapshot
     // =========================================================
+    void SystemStats::snapshot(Snapshot& out, std::chrono::milliseconds max_age) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refresh_locked(max_age);
+
+        out.cpu_percent = cached_.cpu_percent;
+        out.memory_bytes = cached_.memory_bytes;
+        out.threads.resize(cached_.threads.size());
+        for (size_t i = 0; i < cached_.threads.size(); ++i) {
+            out.threads[i].tid = cached_.threads[i].tid;
+            out.threads[i].name.assign(cached_.threads[i].name);
+            out.threads[i].cpu_percent = cached_.threads[i].cpu_percent;
+        }
+    }
+
     size_t SystemStats::get_memory_usage_bytes() {
-        // Read /proc/self/statm
-        // Format: size resident shared text lib data dt
-        std::ifstream file("/proc/self/statm");
-        if (!file.is_open()) return 0;
-
-        unsigned long size, resident, share, text, lib, data, dt;
-        file >> size >> resident >> share >> text >> lib >> data >> dt;
-        
-        // 'resident' is in pages. Convert to bytes.
-        // We use sysconf value * 1024 because page_size_kb_ is in KB.
-        return resident * (size_t)sysconf(_SC_PAGESIZE);
+        std::lock_guard<std::mutex> lock(mutex_);
+        refresh_locked(DEFAULT_MAX_AGE);
+        return cached_.memory_bytes;
+    }
+
+    double SystemStats::get_cpu_usage_percent() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refresh_locked(DEFAULT_MAX_AGE);
+        return cached_.cpu_percent;
     }
 
     // =========================================================
-    // Get CPU Usage
+    // Refresh (/proc reads)
     // =========================================================
-    double SystemStats::get_cpu_usage_percent() {
-        // 1. Read System-wide CPU times from /proc/stat
-        std::ifstream stat_file("/proc/stat");
-        if (!stat_file.is_open()) return 0.0;
-
-        std::string line;
-        std::getline(stat_file, line); // First line is "cpu  ..."
-        std::stringstream ss(line);
-        std::string label;
-        unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
-        ss >> label >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
-
-        unsigned long long current_total_time = user + nice + system + idle + iowait + irq + softirq + steal;
-
-        // 2. Read Process CPU times from /proc/self/stat
-        std::ifstream self_file("/proc/self/stat");
-        if (!self_file.is_open()) return 0.0;
-
-        // The fields we want are #14 (utime) and #15 (stime)
-        // We have to skip the first 13 fields.
-        // Warning: The filename field #2 might contain spaces "(blackbox core)", so strictly parsing by space is risky 
-        // if the binary name has spaces. Assuming standard name here.
-        
-        std::string dummy;
-        unsigned long long utime = 0, stime = 0;
-        
-        // Skip 13 fields
-        for (int i = 0; i < 13; ++i) self_file >> dummy;
-        self_file >> utime >> stime;
-
-        unsigned long long current_proc_time = utime + stime;
-
-        // 3. Calculate Delta
-        double percent = 0.0;
-        if (last_total_time_ > 0 && last_proc_time_ > 0) {
-            unsigned long long total_delta = current_total_time - last_total_time_;
-            unsigned long long proc_delta = current_proc_time - last_proc_time_;
-
-            if (total_delta > 0) {
-                // Determine number of cores to normalize? 
-                // Usually top shows % * cores.
-                long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
-                
-                percent = (double)proc_delta / (double)total_delta * 100.0 * num_cores;
+    void SystemStats::refresh_locked(std::chrono::milliseconds max_age) {
+        const auto now = std::chrono::steady_clock::now();
+        if (refreshed_at_.time_since_epoch().count() != 0 && now - refreshed_at_ < max_age) return;
+        refreshed_at_ = now;
+
+        char buf[1024];
+
+        // 1. Memory (RSS): /proc/self/statm
+        // Format: size resident shared text lib data dt ('resident' is in pages)
+        if (read_proc(statm_fd_, buf, sizeof(buf)) > 0) {
+            unsigned long size = 0, resident = 0;
+            if (std::sscanf(buf, "%lu %lu", &size, &resident) == 2) {
+                cached_.memory_bytes = resident * static_cast<size_t>(page_size_kb_) * 1024;
+            }
+        }
+
+        // 2. System-wide CPU times: first line of /proc/stat ("cpu  ...")
+        unsigned long long current_total_time = 0;
+        if (read_proc(stat_fd_, buf, sizeof(buf)) > 0) {
+            unsigned long long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+            std::sscanf(buf, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+                        &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
+            current_total_time = user + nice + system + idle + iowait + irq + softirq + steal;
+        }
+        if (current_total_time == 0) return;
+
+        const unsigned long long total_delta =
+            last_total_time_ > 0 ? current_total_time - last_total_time_ : 0;
+
+        // Percentage of one core: share of all-CPU jiffies, times core count
+        auto percent_of = [&](unsigned long long delta) {
+            if (total_delta == 0) return 0.0;
+            return static_cast<double>(delta) / static_cast<double>(total_delta) * 100.0 * num_cores_;
+        };
+
+        // 3. Process CPU times: /proc/self/stat
+        unsigned long long current_proc_time = 0;
+        if (read_proc(self_stat_fd_, buf, sizeof(buf)) > 0 && parse_stat_cpu(buf, current_proc_time)) {
+            if (last_total_time_ > 0) cached_.cpu_percent = percent_of(current_proc_time - last_proc_time_);
+            last_proc_time_ = current_proc_time;
+        }
+
+        // 4. Per-thread CPU for every thread named through ThreadUtils
+        const auto named = ThreadUtils::named_threads();
+        cached_.threads.clear();
+        for (const auto& info : named) {
+            auto state = std::find_if(thread_states_.begin(), thread_states_.end(),
+                                      [&](const ThreadState& s) { return s.tid == info.tid; });
+            if (state == thread_states_.end()) {
+                char path[64];
+                std::snprintf(path, sizeof(path), "/proc/self/task/%d/stat", info.tid);
+                const int fd = open_proc(path);
+                if (fd < 0) continue; // Thread already exited
+                thread_states_.push_back(ThreadState{info.tid, fd, 0, false});
+                state = thread_states_.end() - 1;
             }
+
+            unsigned long long thread_time = 0;
+            if (read_proc(state->fd, buf, sizeof(buf)) <= 0 || !parse_stat_cpu(buf, thread_time)) {
+                // Exited: drop the handle
+                ::close(state->fd);
+                thread_states_.erase(state);
+                continue;
+            }
+
+            ThreadCpu cpu;
+            cpu.tid = info.tid;
+            cpu.name = info.name;
+            cpu.cpu_percent = state->primed ? percent_of(thread_time - state->last_time) : 0.0;
+            state->last_time = thread_time;
+            state->primed = true;
+            cached_.threads.push_back(std::move(cpu));
         }
 
         // Update State
         last_total_time_ = current_total_time;
-        last_proc_time_ = current_proc_time;
-
-        return percent;
     }
 
     // =========================================================
@@ -114,4 +206,4 @@ namespace blackbox::common {
         return 0; // Simplified
     }
 
-} // namespace blackbox::common
\ No newline at end of file
+} // namespace blackbox::common
@@ -7,11 +7,26 @@
 #include "blackbox/common/logger.h"
 #include <pthread.h>
 #include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <cstring> // for strerror
 #include <iostream>
+#include <mutex>
 
 namespace blackbox::common {
 
+    namespace {
+        std::mutex& registry_mutex() {
+            static std::mutex m;
+            return m;
+        }
+
+        std::vector<ThreadUtils::ThreadInfo>& registry() {
+            static std::vector<ThreadUtils::ThreadInfo> threads;
+            return threads;
+        }
+    }
+
     // =========================================================
     // Set Name
     // =========================================================
@@ -23,6 +38,22 @@ namespace blackbox::common {
         if (rc != 0) {
             LOG_WARN("Failed to set thread name: " + name);
         }
+
+        // Register for per-thread CPU accounting (renames update in place)
+        const int tid = static_cast<int>(::syscall(SYS_gettid));
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        for (auto& info : registry()) {
+            if (info.tid == tid) {
+                info.name = short_name;
+                return;
+            }
+        }
+        registry().push_back(ThreadInfo{tid, short_name});
+    }
+
+    std::vector<ThreadUtils::ThreadInfo> ThreadUtils::named_threads() {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        return registry();
     }
 
     // =========================================================
@@ -4,15 +4,134 @@
  */
 
 #include "blackbox/common/time_utils.h"
-#include <ctime>
-#include <cstdio>
-#include <vector>
-#include <unordered_map>
-#include <iomanip>
-#include <sstream>
+#include <cstring>
 
 namespace blackbox::common {
 
+    namespace {
+
+        constexpr uint64_t NS_PER_SEC = 1000000000ull;
+        constexpr uint64_t SECONDS_PER_DAY = 86400;
+
+        // "00" "01" ... "99": one 2-byte copy per field instead of a div/mod pair per digit
+        constexpr char DIGIT_PAIRS[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        inline void write_2(char* out, unsigned v) {
+            std::memcpy(out, DIGIT_PAIRS + 2 * v, 2);
+        }
+
+        struct CivilDate {
+            int64_t year;
+            unsigned month; // 1..12
+            unsigned day;   // 1..31
+        };
+
+        // Inverse of days_from_civil (H. Hinnant's algorithm, exact for the proleptic Gregorian calendar)
+        CivilDate civil_from_days(int64_t z) {
+            z += 719468;
+            const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+            const auto doe = static_cast<unsigned>(z - era * 146097);
+            const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            const unsigned mp = (5 * doy + 2) / 153;
+            const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+            const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+            return CivilDate{static_cast<int64_t>(yoe) + era * 400 + (month <= 2), month, day};
+        }
+
+        /**
+         * @brief Per-thread "YYYY-MM-DD" of the last day formatted.
+         * Log timestamps arrive roughly in order, so the calendar
+         * conversion runs about once per day per thread.
+         */
+        struct DateCache {
+            uint64_t day = UINT64_MAX;
+            char text[10];
+
+            const char* get(uint64_t d) {
+                if (d != day) {
+                    const CivilDate c = civil_from_days(static_cast<int64_t>(d));
+                    const auto year = static_cast<unsigned>(c.year % 10000);
+                    write_2(text, year / 100);
+                    write_2(text + 2, year % 100);
+                    text[4] = '-';
+                    write_2(text + 5, c.month);
+                    text[7] = '-';
+                    write_2(text + 8, c.day);
+                    day = d;
+                }
+                return text;
+            }
+        };
+
+        // "YYYY-MM-DD?HH:MM:SS.mmm" (23 chars), '?' = date_sep
+        void write_datetime_ms(uint64_t timestamp_ms, char date_sep, char* out) {
+            static thread_local DateCache cache;
+
+            const uint64_t secs = timestamp_ms / 1000;
+            const auto sod = static_cast<unsigned>(secs % SECONDS_PER_DAY);
+            const auto millis = static_cast<unsigned>(timestamp_ms % 1000);
+
+            std::memcpy(out, cache.get(secs / SECONDS_PER_DAY), 10);
+            out[10] = date_sep;
+            write_2(out + 11, sod / 3600);
+            out[13] = ':';
+            write_2(out + 14, (sod / 60) % 60);
+            out[16] = ':';
+            write_2(out + 17, sod % 60);
+            out[19] = '.';
+            out[20] = static_cast<char>('0' + millis / 100);
+            write_2(out + 21, millis % 100);
+        }
+
+        // One ASCII digit -> value, or -1
+        inline int parse_1(const char* p) {
+            const unsigned d = static_cast<unsigned char>(p[0]) - '0';
+            return d > 9 ? -1 : static_cast<int>(d);
+        }
+
+        // Two ASCII digits -> value, or -1
+        inline int parse_2(const char* p) {
+            const unsigned hi = static_cast<unsigned char>(p[0]) - '0';
+            const unsigned lo = static_cast<unsigned char>(p[1]) - '0';
+            return (hi > 9 || lo > 9) ? -1 : static_cast<int>(hi * 10 + lo);
+        }
+
+        // "Jan".."Dec" -> 1..12, or 0
+        inline unsigned parse_month(const char* p) {
+            const uint32_t key = (static_cast<uint32_t>(static_cast<unsigned char>(p[0])) << 16) |
+                                 (static_cast<uint32_t>(static_cast<unsigned char>(p[1])) << 8) |
+                                 static_cast<unsigned char>(p[2]);
+            switch (key) {
+                case ('J' << 16) | ('a' << 8) | 'n': return 1;
+                case ('F' << 16) | ('e' << 8) | 'b': return 2;
+                case ('M' << 16) | ('a' << 8) | 'r': return 3;
+                case ('A' << 16) | ('p' << 8) | 'r': return 4;
+                case ('M' << 16) | ('a' << 8) | 'y': return 5;
+                case ('J' << 16) | ('u' << 8) | 'n': return 6;
+                case ('J' << 16) | ('u' << 8) | 'l': return 7;
+                case ('A' << 16) | ('u' << 8) | 'g': return 8;
+                case ('S' << 16) | ('e' << 8) | 'p': return 9;
+                case ('O' << 16) | ('c' << 8) | 't': return 10;
+                case ('N' << 16) | ('o' << 8) | 'v': return 11;
+                case ('D' << 16) | ('e' << 8) | 'c': return 12;
+                default: return 0;
+            }
+        }
+
+        // "hh:mm:ss" -> seconds of day, or -1
+        inline int64_t parse_hms(const char* p) {
+            if (p[2] != ':' || p[5] != ':') return -1;
+            const int h = parse_2(p), m = parse_2(p + 3), s = parse_2(p + 6);
+            if (h < 0 || h > 23 || m < 0 || m > 59 || s < 0 || s > 60) return -1;
+            return h * 3600 + m * 60 + s;
+        }
+
+    } // namespace
+
     // =========================================================
     // Get Current Time (Nano)
     // =========================================================
@@ -33,120 +152,142 @@ namespace blackbox::common {
         ).count();
     }
 
+    // =========================================================
+    // Calendar
+    // =========================================================
+    int64_t TimeUtils::days_from_civil(int64_t year, unsigned month, unsigned day) {
+        year -= month <= 2;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const auto yoe = static_cast<unsigned>(year - era * 400);
+        const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
     // =========================================================
     // To ClickHouse SQL Format
     // =========================================================
-    std::string TimeUtils::to_clickhouse_format(uint64_t timestamp_ms) {
-        // Timestamp is usually ms, but time_t needs seconds
-        std::time_t seconds = static_cast<std::time_t>(timestamp_ms / 1000);
-
-        // Thread-safe version of localtime
-        struct std::tm tm_buf;
-        // gmtime_r is thread-safe on Linux. On Windows use gmtime_s.
-        #ifdef _WIN32
-            gmtime_s(&tm_buf, &seconds);
-        #else
-            gmtime_r(&seconds, &tm_buf);
-        #endif
-
-        // Pre-allocate buffer to avoid string resizing
-        // Format: "YYYY-MM-DD HH:MM:SS" is 19 chars + null terminator
-        char buffer[24];
+    void TimeUtils::format_clickhouse_ms(uint64_t timestamp_ms, char* out) {
+        write_datetime_ms(timestamp_ms, ' ', out);
+    }
 
-        // Using snprintf is generally faster than std::stringstream
-        std::snprintf(buffer, sizeof(buffer),
-                      "%04d-%02d-%02d %02d:%02d:%02d",
-                      tm_buf.tm_year + 1900,
-                      tm_buf.tm_mon + 1,
-                      tm_buf.tm_mday,
-                      tm_buf.tm_hour,
-                      tm_buf.tm_min,
-                      tm_buf.tm_sec);
-
-        return std::string(buffer);
+    std::string TimeUtils::to_clickhouse_format(uint64_t timestamp_ms) {
+        // Format: "YYYY-MM-DD HH:MM:SS" (the millisecond tail is dropped)
+        char buffer[CLICKHOUSE_MS_LENGTH];
+        write_datetime_ms(timestamp_ms, ' ', buffer);
+        return std::string(buffer, 19);
     }
 
     // =========================================================
     // To ISO 8601
     // =========================================================
     std::string TimeUtils::to_iso_8601(uint64_t timestamp_ms) {
-        std::time_t seconds = static_cast<std::time_t>(timestamp_ms / 1000);
-        int millis = timestamp_ms % 1000;
-
-        struct std::tm tm_buf;
-        #ifdef _WIN32
-            gmtime_s(&tm_buf, &seconds);
-        #else
-            gmtime_r(&seconds, &tm_buf);
-        #endif
-
-        char buffer[32];
         // "YYYY-MM-DDTHH:MM:SS.mmmZ"
-        std::snprintf(buffer, sizeof(buffer),
-                      "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
-                      tm_buf.tm_year + 1900,
-                      tm_buf.tm_mon + 1,
-                      tm_buf.tm_mday,
-                      tm_buf.tm_hour,
-                      tm_buf.tm_min,
-                      tm_buf.tm_sec,
-                      millis);
-
-        return std::string(buffer);
+        char buffer[24];
+        write_datetime_ms(timestamp_ms, 'T', buffer);
+        buffer[23] = 'Z';
+        return std::string(buffer, sizeof(buffer));
     }
 
     // =========================================================
-    // Parse Syslog
+    // Parse Syslog (RFC 3164)
     // =========================================================
+    uint64_t TimeUtils::parse_rfc3164(std::string_view text, uint64_t now) {
+        // "Mmm dd hh:mm:ss"; also tolerate the unpadded "Mmm d hh:mm:ss"
+        if (text.size() < 14 || text[3] != ' ') return 0;
+        const char* p = text.data();
+
+        const unsigned month = parse_month(p);
+        if (month == 0) return 0;
+
+        int day;
+        const char* hms;
+        if (p[5] == ' ') {
+            day = parse_1(p + 4);
+            hms = p + 6;
+        } else {
+            if (text.size() < 15 || p[6] != ' ') return 0;
+            day = p[4] == ' ' ? parse_1(p + 5) : parse_2(p + 4); // " 2" is space-padded
+            hms = p + 7;
+        }
+        if (day < 1 || day > 31) return 0;
+
+        const int64_t sod = parse_hms(hms);
+        if (sod < 0) return 0;
+
+        // Syslog has no year: use the current one, unless that lands in the future
+        const uint64_t now_sec = now / NS_PER_SEC;
+        int64_t year = civil_from_days(static_cast<int64_t>(now_sec / SECONDS_PER_DAY)).year;
+        int64_t secs = days_from_civil(year, month, static_cast<unsigned>(day)) * 86400 + sod;
+        if (secs > static_cast<int64_t>(now_sec + 2 * SECONDS_PER_DAY)) {
+            --year;
+            secs = days_from_civil(year, month, static_cast<unsigned>(day)) * 86400 + sod;
+        }
+        return secs < 0 ? 0 : static_cast<uint64_t>(secs) * NS_PER_SEC;
+    }
+
     uint64_t TimeUtils::parse_syslog_time(const std::string& date_str) {
-        // Input: "Dec 12 10:00:00"
-        // Need to guess the year. We assume current year.
-
-        std::tm tm_buf = {};
-
-        // Get current time to find current year
-        auto t = std::time(nullptr);
-        struct std::tm now_tm;
-        #ifdef _WIN32
-            localtime_s(&now_tm, &t);
-        #else
-            localtime_r(&t, &now_tm);
-        #endif
-
-        // Parse using stringstream (Simpler than strptime for portability)
-        std::stringstream ss(date_str);
-
-        // Map Month Name to Index
-        static const std::unordered_map<std::string, int> months = {
-            {"Jan", 0}, {"Feb", 1}, {"Mar", 2}, {"Apr", 3}, {"May", 4}, {"Jun", 5},
-            {"Jul", 6}, {"Aug", 7}, {"Sep", 8}, {"Oct", 9}, {"Nov", 10}, {"Dec", 11}
-        };
+        return parse_rfc3164(date_str, now_ns()) / 1000000; // Return MS
+    }
+
+    // =========================================================
+    // Parse RFC 3339
+    // =========================================================
+    uint64_t TimeUtils::parse_rfc3339(std::string_view text, size_t* consumed) {
+        // "YYYY-MM-DDThh:mm:ss" + at least the 'Z'
+        if (text.size() < 20) return 0;
+        const char* p = text.data();
 
-        std::string mon_str;
-        int day, hour, min, sec;
-        char sep; // to eat ':'
+        const int y_hi = parse_2(p), y_lo = parse_2(p + 2);
+        const int month = parse_2(p + 5), day = parse_2(p + 8);
+        if (y_hi < 0 || y_lo < 0 || p[4] != '-' || p[7] != '-') return 0;
+        if (month < 1 || month > 12 || day < 1 || day > 31) return 0;
+        if (p[10] != 'T' && p[10] != 't' && p[10] != ' ') return 0;
 
-        ss >> mon_str >> day >> hour >> sep >> min >> sep >> sec;
+        const int64_t sod = parse_hms(p + 11);
+        if (sod < 0) return 0;
 
-        if (months.find(mon_str) != months.end()) {
-            tm_buf.tm_mon = months.at(mon_str);
+        // Fraction: keep up to ns precision, skip extra digits
+        size_t pos = 19;
+        uint64_t frac_ns = 0;
+        if (text[pos] == '.') {
+            ++pos;
+            const size_t start = pos;
+            uint64_t scale = NS_PER_SEC;
+            while (pos < text.size()) {
+                const unsigned d = static_cast<unsigned char>(text[pos]) - '0';
+                if (d > 9) break;
+                if (scale > 1) {
+                    scale /= 10;
+                    frac_ns += d * scale;
+                }
+                ++pos;
+            }
+            if (pos == start) return 0;
         }
 
-        tm_buf.tm_mday = day;
-        tm_buf.tm_hour = hour;
-        tm_buf.tm_min = min;
-        tm_buf.tm_sec = sec;
-        tm_buf.tm_year = now_tm.tm_year; // Assume current year
-        tm_buf.tm_isdst = -1; // Let system determine DST
-
-        // Handle edge case: If today is Jan 1st and log is Dec 31st, it was last year.
-        time_t result = std::mktime(&tm_buf);
-        if (result > t + (86400 * 2)) { // If result is in the future (allow 2 days drift)
-            tm_buf.tm_year -= 1;
-            result = std::mktime(&tm_buf);
+        // Zone: Z or +hh:mm / -hh:mm
+        if (pos >= text.size()) return 0;
+        int64_t offset = 0;
+        const char zone = text[pos];
+        if (zone == 'Z' || zone == 'z') {
+            ++pos;
+        } else if (zone == '+' || zone == '-') {
+            if (text.size() - pos < 6 || text[pos + 3] != ':') return 0;
+            const int oh = parse_2(p + pos + 1), om = parse_2(p + pos + 4);
+            if (oh < 0 || oh > 23 || om < 0 || om > 59) return 0;
+            offset = (oh * 3600 + om * 60) * (zone == '+' ? 1 : -1);
+            pos += 6;
+        } else {
+            return 0;
         }
 
-        return static_cast<uint64_t>(result) * 1000; // Return MS
+        const int64_t secs = days_from_civil(y_hi * 100 + y_lo, static_cast<unsigned>(month),
+                                             static_cast<unsigned>(day)) * 86400 + sod - offset;
+        if (secs < 0) return 0;
+
+        if (consumed) *consumed = pos;
+        return static_cast<uint64_t>(secs) * NS_PER_SEC + frac_ns;
     }
 
-} // namespace blackbox::common
\ No newline at end of file
+} // namespace blackbox::common
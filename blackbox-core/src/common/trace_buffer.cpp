@@ -0,0 +1,163 @@
+/**
+ * @file trace_buffer.cpp
+ * @brief Trace Ring and Chrome Trace-Event Export.
+ */
+
+#include "blackbox/common/trace_buffer.h"
+#include "blackbox/common/json_writer.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <vector>
+
+namespace blackbox::common {
+
+    // =========================================================
+    // TraceEvent
+    // =========================================================
+    void TraceEvent::set_source(std::string_view host) {
+        const size_t n = std::min(host.size(), SOURCE_MAX);
+        std::memcpy(source, host.data(), n);
+        source[n] = '\0';
+    }
+
+    // =========================================================
+    // Constructor
+    // =========================================================
+    TraceBuffer::TraceBuffer(size_t capacity, uint32_t sample_every, std::string source_filter)
+        : sample_every_(sample_every),
+          source_filter_(std::move(source_filter))
+    {
+        const size_t slots = std::bit_ceil(std::max<size_t>(capacity, 16));
+        slots_ = std::make_unique<Slot[]>(slots);
+        mask_ = slots - 1;
+
+        // Stamps are converted to wall time on export
+        TscClock::calibrate();
+    }
+
+    // =========================================================
+    // Publish (Processing Threads)
+    // =========================================================
+    void TraceBuffer::publish(const TraceEvent& event) {
+        const uint64_t pos = write_pos_.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots_[pos & mask_];
+
+        // Seqlock: odd while the copy is in progress
+        slot.seq.store(2 * pos + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = event;
+        slot.seq.store(2 * pos + 2, std::memory_order_release);
+    }
+
+    const char* TraceBuffer::span_name(TracePoint end_point) {
+        switch (end_point) {
+            case TracePoint::Pop:       return "ring_dwell";
+            case TracePoint::Parse:     return "parse";
+            case TracePoint::GeoIP:     return "geoip";
+            case TracePoint::Rules:     return "rules";
+            case TracePoint::Inference: return "inference";
+            case TracePoint::Alert:     return "alert";
+            case TracePoint::Enqueue:   return "storage_enqueue";
+            default:                    return "unknown";
+        }
+    }
+
+    // =========================================================
+    // Chrome Trace-Event Export (Admin Thread)
+    // =========================================================
+    std::string TraceBuffer::to_chrome_json(size_t limit) const {
+        // 1. Copy out consistent events, oldest first
+        const uint64_t end = write_pos_.load(std::memory_order_acquire);
+        size_t count = std::min<uint64_t>(end, mask_ + 1);
+        if (limit > 0) count = std::min(count, limit);
+
+        struct Copied {
+            uint64_t id;
+            TraceEvent event;
+        };
+        std::vector<Copied> events;
+        events.reserve(count);
+
+        for (uint64_t pos = end - count; pos < end; ++pos) {
+            const Slot& slot = slots_[pos & mask_];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != 2 * pos + 2) continue; // Still being written, or already overwritten
+
+            Copied copy{pos, slot.event};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) continue; // Torn
+            events.push_back(copy);
+        }
+
+        // 2. Timestamps relative to the oldest stamp (double us keeps ns precision)
+        uint64_t base_ticks = UINT64_MAX;
+        for (const auto& c : events) {
+            for (uint64_t t : c.event.stamps) {
+                if (t != 0) base_ticks = std::min(base_ticks, t);
+            }
+        }
+        if (base_ticks == UINT64_MAX) base_ticks = 0;
+        auto to_us = [](uint64_t ticks) { return static_cast<double>(TscClock::to_ns(ticks)) / 1000.0; };
+
+        // 3. Serialize: one enclosing span per event plus one span per stage
+        constexpr size_t PER_EVENT = (TraceEvent::POINTS + 1) * 192 + JsonWriter::max_escaped_size(TraceEvent::SOURCE_MAX);
+        std::string out(256 + PER_EVENT * events.size(), '\0');
+        JsonWriter json(out.data(), out.size());
+
+        json.begin_object().key("traceEvents").begin_array();
+        for (const auto& c : events) {
+            const auto& ev = c.event;
+
+            size_t first = TraceEvent::POINTS, last = 0;
+            for (size_t p = 0; p < TraceEvent::POINTS; ++p) {
+                if (ev.stamps[p] == 0) continue;
+                first = std::min(first, p);
+                last = p;
+            }
+            if (first >= last) continue;
+
+            json.begin_object()
+                .field("name", std::string_view(ev.source))
+                .field("cat", "event")
+                .field("ph", "X")
+                .field("pid", 1)
+                .field("tid", c.id)
+                .field("ts", to_us(ev.stamps[first] - base_ticks))
+                .field("dur", to_us(ev.stamps[last] - ev.stamps[first]))
+                .key("args").begin_object()
+                    .field("score", ev.score)
+                    .field("critical", ev.critical)
+                .end_object()
+            .end_object();
+
+            // Each span ends at a stamped point and starts at the previous stamped one
+            size_t prev = first;
+            for (size_t p = first + 1; p < TraceEvent::POINTS; ++p) {
+                if (ev.stamps[p] == 0) continue;
+                json.begin_object()
+                    .field("name", span_name(static_cast<TracePoint>(p)))
+                    .field("cat", "stage")
+                    .field("ph", "X")
+                    .field("pid", 1)
+                    .field("tid", c.id)
+                    .field("ts", to_us(ev.stamps[prev] - base_ticks))
+                    .field("dur", to_us(ev.stamps[p] >= ev.stamps[prev] ? ev.stamps[p] - ev.stamps[prev] : 0))
+                .end_object();
+                prev = p;
+            }
+        }
+        json.end_array()
+            .field("displayTimeUnit", "ns")
+            .key("otherData").begin_object()
+                .field("base_wall_ns", base_ticks ? TscClock::to_wall_ns(base_ticks) : uint64_t{0})
+                .field("events", static_cast<uint64_t>(events.size()))
+                .field("published", end)
+            .end_object()
+            .end_object();
+
+        out.resize(json.ok() ? json.size() : 0);
+        return out;
+    }
+
+} // namespace blackbox::common
@@ -0,0 +1,101 @@
+/**
+ * @file tsc_clock.cpp
+ * @brief TSC Detection and Calibration.
+ */
+
+#include "blackbox/common/tsc_clock.h"
+#include "blackbox/common/logger.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#ifdef BLACKBOX_HAS_RDTSC
+#include <cpuid.h>
+#endif
+
+namespace blackbox::common {
+
+    namespace {
+
+        uint64_t wall_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        // Constant-rate TSC that keeps ticking in deep C-states (CPUID 0x80000007, EDX bit 8)
+        bool has_invariant_tsc() {
+#ifdef BLACKBOX_HAS_RDTSC
+            unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+            if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) return false;
+            __cpuid(0x80000007, eax, ebx, ecx, edx);
+            return (edx & (1u << 8)) != 0;
+#else
+            return false;
+#endif
+        }
+
+    } // namespace
+
+    // =========================================================
+    // Calibration
+    // =========================================================
+    void TscClock::calibrate() {
+        static std::once_flag once;
+        std::call_once(once, [] {
+            use_tsc_ = has_invariant_tsc();
+
+            // Ticks and wall time at the same instant: bracket the wall read with
+            // two tick reads and keep the tightest of a few tries (preemption,
+            // vDSO slow path)
+            auto paired_reading = [](uint64_t& ticks, uint64_t& wall) {
+                uint64_t best = UINT64_MAX;
+                for (int i = 0; i < 8; ++i) {
+                    const uint64_t before = now();
+                    const uint64_t w = wall_ns();
+                    const uint64_t after = now();
+                    if (after - before < best) {
+                        best = after - before;
+                        ticks = before + (after - before) / 2;
+                        wall = w;
+                    }
+                }
+            };
+
+            // Two pairs ~10 ms apart keep the rate error well under 0.1%
+            uint64_t t0 = 0, w0 = 0, t1 = 0, w1 = 0;
+            paired_reading(t0, w0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            paired_reading(t1, w1);
+
+            if (w1 > w0 && t1 > t0) {
+                ticks_per_ns_ = static_cast<double>(t1 - t0) / static_cast<double>(w1 - w0);
+            }
+            anchor_ticks_ = t1;
+            anchor_wall_ns_ = w1;
+
+            LOG_INFO(std::string("TscClock: ") + (use_tsc_ ? "invariant TSC" : "CLOCK_MONOTONIC fallback") +
+                     ", " + std::to_string(ticks_per_ns_) + " ticks/ns");
+        });
+    }
+
+    // =========================================================
+    // Conversions
+    // =========================================================
+    uint64_t TscClock::to_ns(uint64_t ticks) {
+        return static_cast<uint64_t>(static_cast<double>(ticks) / ticks_per_ns_);
+    }
+
+    uint64_t TscClock::to_wall_ns(uint64_t ticks) {
+        if (ticks >= anchor_ticks_) return anchor_wall_ns_ + to_ns(ticks - anchor_ticks_);
+        return anchor_wall_ns_ - to_ns(anchor_ticks_ - ticks);
+    }
+
+    uint64_t TscClock::from_wall_ns(uint64_t wall) {
+        if (wall >= anchor_wall_ns_) {
+            return anchor_ticks_ + static_cast<uint64_t>(static_cast<double>(wall - anchor_wall_ns_) * ticks_per_ns_);
+        }
+        const auto back = static_cast<uint64_t>(static_cast<double>(anchor_wall_ns_ - wall) * ticks_per_ns_);
+        return back < anchor_ticks_ ? anchor_ticks_ - back : 0;
+    }
+
+} // namespace blackbox::common
@@ -0,0 +1,51 @@
+/**
+ * @file wait_strategy.cpp
+ * @brief Futex Parking and Wait Policy Presets.
+ */
+
+#include "blackbox/common/wait_strategy.h"
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace blackbox::common {
+
+    // =========================================================
+    // Parker (futex)
+    // =========================================================
+    void Parker::wait(std::chrono::microseconds timeout) {
+        parks_.fetch_add(1, std::memory_order_relaxed);
+
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000);
+        ts.tv_nsec = static_cast<long>((timeout.count() % 1000000) * 1000);
+
+        // Returns at once if notify() already cleared the word (EAGAIN);
+        // EINTR / ETIMEDOUT just mean "re-check the queue".
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&parked_), FUTEX_WAIT_PRIVATE, 1, &ts, nullptr, 0);
+    }
+
+    void Parker::wake() {
+        // Clearing the word first makes a FUTEX_WAIT that has not started
+        // yet return at once, so this wake-up cannot be lost
+        parked_.store(0, std::memory_order_relaxed);
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&parked_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+
+    // =========================================================
+    // Presets
+    // =========================================================
+    WaitPolicy WaitPolicy::from_name(const std::string& name) {
+        using std::chrono::microseconds;
+
+        // A pause is ~10-50 ns depending on the CPU generation, so
+        // 2000 rounds cover roughly the first 20-100 us of an idle gap.
+        if (name == "spin")    return {1000,  UINT32_MAX, false, microseconds(0)};
+        if (name == "latency") return {50000, 100,        true,  microseconds(1000)};
+        if (name == "power")   return {64,    0,          true,  microseconds(50000)};
+        return {2000, 50, true, microseconds(10000)}; // "balanced"
+    }
+
+} // namespace blackbox::common
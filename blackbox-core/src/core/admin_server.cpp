@@ -6,29 +6,95 @@
 #include "blackbox/core/admin_server.h"
 #include "blackbox/common/logger.h"
 #include "blackbox/common/metrics.h" // To fetch stats
-#include <iostream>
-#include <sstream>
+#include "blackbox/common/profiler.h"
+#include "blackbox/common/settings.h"
+#include "blackbox/common/thread_utils.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
 
 namespace blackbox::core {
 
+    namespace {
+
+        // Sent (best effort, non-blocking) to connections over the limit
+        constexpr std::string_view BUSY_RESPONSE =
+            "HTTP/1.1 503 Service Unavailable\r\n"
+            "Content-Length: 0\r\n"
+            "Connection: close\r\n\r\n";
+
+        /**
+         * @brief Index just past the blank line ending a request head, or npos.
+         * Accepts "\r\n\r\n" and bare "\n\n".
+         */
+        size_t find_head_end(const std::string& buf, size_t from) {
+            const char* data = buf.data();
+            const size_t size = buf.size();
+            size_t pos = from;
+            while (pos < size) {
+                const void* nl = std::memchr(data + pos, '\n', size - pos);
+                if (!nl) return std::string::npos;
+                const size_t i = static_cast<const char*>(nl) - data;
+                if (i + 1 < size && data[i + 1] == '\n') return i + 2;
+                if (i + 2 < size && data[i + 1] == '\r' && data[i + 2] == '\n') return i + 3;
+                pos = i + 1;
+            }
+            return std::string::npos;
+        }
+
+        bool iequals(std::string_view a, std::string_view b) {
+            return a.size() == b.size() &&
+                   std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                       return std::tolower(static_cast<unsigned char>(x)) ==
+                              std::tolower(static_cast<unsigned char>(y));
+                   });
+        }
+
+        bool icontains(std::string_view haystack, std::string_view needle) {
+            if (needle.size() > haystack.size()) return false;
+            for (size_t i = 0; i + needle.size() <= haystack.size(); ++i) {
+                if (iequals(haystack.substr(i, needle.size()), needle)) return true;
+            }
+            return false;
+        }
+
+        std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+            return s;
+        }
+
+    } // namespace
+
     // =========================================================
     // Constructor
     // =========================================================
     AdminServer::AdminServer(short port) : port_(port) {
+        const auto& network = common::Settings::instance().network();
+        max_connections_ = static_cast<size_t>(std::max(1, network.admin_max_connections));
+        timeout_ = std::chrono::milliseconds(std::max(100, network.admin_timeout_ms));
+
         // Prepare context
         io_context_ = std::make_shared<boost::asio::io_context>();
-        
+
         // Prepare acceptor (Listener)
         acceptor_ = std::make_unique<tcp::acceptor>(
-            *io_context_, 
+            *io_context_,
             tcp::endpoint(tcp::v4(), port)
         );
-        
-        LOG_INFO("Admin Server configured on port " + std::to_string(port));
+
+        LOG_INFO("Admin Server configured on port " + std::to_string(port) +
+                 " (max " + std::to_string(max_connections_) + " connections)");
     }
 
     AdminServer::~AdminServer() {
         stop();
+
+        // Destroy pending handlers (and with them the sessions) while the
+        // server they point back to is still alive
+        acceptor_.reset();
+        io_context_.reset();
     }
 
     // =========================================================
@@ -49,14 +115,23 @@ namespace blackbox::core {
     void AdminServer::stop() {
         if (!running_) return;
         running_ = false;
-        
+
         io_context_->stop();
         if (worker_thread_.joinable()) {
             worker_thread_.join();
         }
     }
 
+    void AdminServer::add_route(const std::string& path, RouteHandler handler, std::string content_type) {
+        if (running_) {
+            LOG_ERROR("Admin Server: route " + path + " registered after start, ignored.");
+            return;
+        }
+        routes_[path] = Route{std::move(handler), std::move(content_type)};
+    }
+
     void AdminServer::run_worker() {
+        common::ThreadUtils::set_current_thread_name("BB_Admin");
         try {
             io_context_->run();
         } catch (const std::exception& e) {
@@ -68,94 +143,303 @@ namespace blackbox::core {
     // Async Accept
     // =========================================================
     void AdminServer::start_accept() {
-        auto socket = std::make_shared<tcp::socket>(*io_context_);
-        
-        acceptor_->async_accept(*socket, [this, socket](const boost::system::error_code& error) {
+        acceptor_->async_accept([this](const boost::system::error_code& error, tcp::socket socket) {
+            if (error == boost::asio::error::operation_aborted) return;
+
             if (!error) {
-                // Handle the connection
-                // For simplicity in this Admin module, we spawn a transient thread 
-                // or just handle it. Since ops traffic is low volume, std::thread is fine.
-                std::thread(&AdminServer::handle_session, this, socket).detach();
+                if (active_sessions_ >= max_connections_) {
+                    // Refuse without blocking the admin thread
+                    boost::system::error_code ignored;
+                    socket.non_blocking(true, ignored);
+                    socket.write_some(boost::asio::buffer(BUSY_RESPONSE.data(), BUSY_RESPONSE.size()), ignored);
+                    socket.close(ignored);
+                    LOG_DEBUG("Admin Server: connection limit reached, refused.");
+                } else {
+                    std::make_shared<AdminSession>(std::move(socket), *this)->start();
+                }
+            } else {
+                LOG_WARN("Admin Accept Error: " + error.message());
             }
+
             // Continue listening
             if (running_) start_accept();
         });
     }
 
     // =========================================================
-    // Request Handler
+    // Logic (The "Controller")
     // =========================================================
-    void AdminServer::handle_session(std::shared_ptr<tcp::socket> socket) {
-        try {
-            char data[1024];
-            boost::system::error_code error;
-            size_t length = socket->read_some(boost::asio::buffer(data), error);
-
-            if (error == boost::asio::error::eof) return; // Connection closed
-            else if (error) return; // Other error
-
-            // 1. Parse Request Line (Very basic)
-            // Expect: "GET /health HTTP/1.1"
-            std::string request(data, length);
-            std::string path;
-            
-            std::istringstream iss(request);
-            std::string method;
-            iss >> method >> path;
-
-            // 2. Route
-            std::string body;
-            std::string status = "200 OK";
-
-            if (method == "GET") {
-                body = generate_response(path);
-                if (body.empty()) {
-                    status = "404 Not Found";
-                    body = "404 Page Not Found";
-                }
-            } else {
-                status = "405 Method Not Allowed";
-            }
-
-            // 3. Construct HTTP Response
-            std::ostringstream response;
-            response << "HTTP/1.1 " << status << "\r\n";
-            response << "Content-Length: " << body.size() << "\r\n";
-            response << "Content-Type: text/plain\r\n";
-            response << "Connection: close\r\n";
-            response << "\r\n";
-            response << body;
+    std::string AdminServer::generate_response(const std::string& request_path, std::string& content_type) {
+        // Split "/path?query"
+        size_t q = request_path.find('?');
+        std::string path = request_path.substr(0, q);
+        std::string query = (q == std::string::npos) ? "" : request_path.substr(q + 1);
 
-            // 4. Send
-            boost::asio::write(*socket, boost::asio::buffer(response.str()));
-
-        } catch (const std::exception& e) {
-            LOG_ERROR("Admin Session Error: " + std::string(e.what()));
+        auto route = routes_.find(path);
+        if (route != routes_.end()) {
+            try {
+                content_type = route->second.content_type;
+                return route->second.handler(query);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Admin route " + path + " failed: " + std::string(e.what()));
+                content_type = "text/plain";
+                return "";
+            }
         }
-    }
 
-    // =========================================================
-    // Logic (The "Controller")
-    // =========================================================
-    std::string AdminServer::generate_response(const std::string& path) {
         if (path == "/health") {
             // Liveness probe
             // In a real app, check if RingBuffer is full or DB is down
             return "OK";
-        } 
+        }
         else if (path == "/metrics") {
-            // Dump atomic stats in Prometheus format
-            // We can't access Metrics privates directly, so we assume Metrics class 
-            // has a dump() method or we access the counters via getters.
-            // For MVP, we'll just return a simple text summary.
-            
-            // NOTE: Ideally, Metrics.h should have a 'get_snapshot()' method.
-            // Here we return a static string for demonstration.
-            return "# HELP blackbox_status Status of the engine\n"
-                   "# TYPE blackbox_status gauge\n"
-                   "blackbox_status 1\n";
+            // Prometheus text exposition (counters, gauges, stage latency histograms)
+            content_type = "text/plain; version=0.0.4";
+            return common::Metrics::instance().get_prometheus_metrics();
+        }
+        else if (path == "/debug/zones") {
+            // BB_PROFILE_ZONE aggregates, most expensive first
+            content_type = "application/json";
+            return common::Profiler::to_json();
         }
         return "";
     }
 
-} // namespace blackbox::core
\ No newline at end of file
+    // =========================================================
+    // ADMIN SESSION Implementation
+    // =========================================================
+
+    AdminSession::AdminSession(tcp::socket socket, AdminServer& server)
+        : socket_(std::move(socket)),
+          timer_(socket_.get_executor()),
+          server_(server)
+    {
+        server_.active_sessions_++;
+        request_.reserve(1024);
+        head_.reserve(256);
+    }
+
+    AdminSession::~AdminSession() {
+        server_.active_sessions_--;
+    }
+
+    void AdminSession::start() {
+        do_read();
+    }
+
+    void AdminSession::do_read() {
+        auto self(shared_from_this()); // Keep session alive
+
+        // Deadline covers the whole request, so a slow drip of bytes can't hold the slot
+        if (request_.empty()) arm_timer();
+
+        socket_.async_read_some(boost::asio::buffer(read_buffer_),
+            [this, self](boost::system::error_code ec, std::size_t length) {
+                if (ec) {
+                    // EOF is a normal keep-alive disconnect
+                    close();
+                    return;
+                }
+                request_.append(read_buffer_.data(), length);
+                process_buffer();
+            }
+        );
+    }
+
+    void AdminSession::process_buffer() {
+        if (closed_) return;
+
+        const size_t head_end = find_head_end(request_, scan_from_);
+        if (head_end == std::string::npos) {
+            if (request_.size() > MAX_HEAD_BYTES) {
+                keep_alive_ = false;
+                body_ = "Request header too large";
+                prepare_response("431 Request Header Fields Too Large", "text/plain", true);
+                do_write();
+                return;
+            }
+            // Resume just before the end: the terminator may straddle two reads
+            scan_from_ = request_.size() > 2 ? request_.size() - 2 : 0;
+            do_read();
+            return;
+        }
+
+        handle_request(std::string_view(request_).substr(0, head_end));
+
+        // Keep anything after this request (pipelining)
+        request_.erase(0, head_end);
+        scan_from_ = 0;
+
+        do_write();
+    }
+
+    void AdminSession::handle_request(std::string_view head) {
+        // 1. Request line: "GET /metrics HTTP/1.1"
+        const size_t line_end = head.find('\n');
+        const std::string_view request_line = trim(head.substr(0, line_end));
+
+        const size_t sp1 = request_line.find(' ');
+        const size_t sp2 = (sp1 == std::string_view::npos) ? sp1 : request_line.find(' ', sp1 + 1);
+        if (sp2 == std::string_view::npos) {
+            keep_alive_ = false;
+            body_ = "Bad Request";
+            prepare_response("400 Bad Request", "text/plain", true);
+            return;
+        }
+
+        const std::string_view method = request_line.substr(0, sp1);
+        const std::string_view target = request_line.substr(sp1 + 1, sp2 - sp1 - 1);
+        const std::string_view version = request_line.substr(sp2 + 1);
+
+        // HTTP/1.1 defaults to keep-alive, HTTP/1.0 to close
+        http11_ = (version == "HTTP/1.1");
+        keep_alive_ = http11_;
+        bool has_body = false;
+
+        // 2. Headers (only the ones that affect framing)
+        size_t pos = (line_end == std::string_view::npos) ? head.size() : line_end + 1;
+        while (pos < head.size()) {
+            size_t eol = head.find('\n', pos);
+            if (eol == std::string_view::npos) eol = head.size();
+            const std::string_view line = head.substr(pos, eol - pos);
+            pos = eol + 1;
+
+            const size_t colon = line.find(':');
+            if (colon == std::string_view::npos) continue;
+            const std::string_view name = trim(line.substr(0, colon));
+            const std::string_view value = trim(line.substr(colon + 1));
+
+            if (iequals(name, "Connection")) {
+                if (icontains(value, "close")) keep_alive_ = false;
+                else if (icontains(value, "keep-alive")) keep_alive_ = true;
+            } else if (iequals(name, "Content-Length")) {
+                has_body = has_body || (value != "0");
+            } else if (iequals(name, "Transfer-Encoding")) {
+                has_body = true;
+            }
+        }
+
+        // 3. Route
+        if (has_body) {
+            // GET-only server: a body would desync the stream, so refuse and close
+            keep_alive_ = false;
+            body_ = "Request bodies are not accepted";
+            prepare_response("400 Bad Request", "text/plain", true);
+            return;
+        }
+
+        if (method != "GET" && method != "HEAD") {
+            body_ = "Method Not Allowed";
+            prepare_response("405 Method Not Allowed", "text/plain", true, "Allow: GET, HEAD\r\n");
+            return;
+        }
+
+        std::string content_type = "text/plain";
+        body_ = server_.generate_response(std::string(target), content_type);
+        if (body_.empty()) {
+            body_ = "404 Page Not Found";
+            prepare_response("404 Not Found", "text/plain", method == "GET");
+            return;
+        }
+        prepare_response("200 OK", content_type, method == "GET");
+    }
+
+    void AdminSession::prepare_response(std::string_view status, std::string_view content_type,
+                                        bool send_body, std::string_view extra_headers) {
+        // Large GET bodies are streamed; HTTP/1.0 cannot take chunks
+        chunked_ = send_body && http11_ && body_.size() > STREAM_THRESHOLD;
+        body_sent_ = 0;
+
+        head_.clear();
+        head_.append("HTTP/1.1 ").append(status).append("\r\n");
+        if (chunked_) {
+            head_.append("Transfer-Encoding: chunked\r\n");
+        } else {
+            head_.append("Content-Length: ").append(std::to_string(body_.size())).append("\r\n");
+        }
+        head_.append("Content-Type: ").append(content_type).append("\r\n");
+        head_.append(keep_alive_ ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+        head_.append(extra_headers);
+        head_.append("\r\n");
+
+        // HEAD: same headers, no payload
+        if (!send_body) body_.clear();
+    }
+
+    void AdminSession::do_write() {
+        auto self(shared_from_this());
+        arm_timer();
+
+        // Head and body are written straight from their buffers (no
+        // concatenation); the head is empty after the first chunk
+        std::array<boost::asio::const_buffer, 4> buffers = {boost::asio::buffer(head_)};
+        if (!chunked_) {
+            buffers[1] = boost::asio::buffer(body_);
+            body_sent_ = body_.size();
+        } else {
+            const size_t len = std::min(STREAM_CHUNK, body_.size() - body_sent_);
+            auto res = std::to_chars(chunk_size_.data(), chunk_size_.data() + chunk_size_.size() - 2, len, 16);
+            *res.ptr++ = '\r';
+            *res.ptr++ = '\n';
+            chunk_size_len_ = static_cast<size_t>(res.ptr - chunk_size_.data());
+
+            buffers[1] = boost::asio::buffer(chunk_size_.data(), chunk_size_len_);
+            buffers[2] = boost::asio::buffer(body_.data() + body_sent_, len);
+            body_sent_ += len;
+
+            // Chunk trailer; the last one also carries the terminating empty chunk
+            static constexpr std::string_view CHUNK_END = "\r\n";
+            static constexpr std::string_view LAST_CHUNK_END = "\r\n0\r\n\r\n";
+            const std::string_view end = body_sent_ == body_.size() ? LAST_CHUNK_END : CHUNK_END;
+            buffers[3] = boost::asio::buffer(end.data(), end.size());
+        }
+
+        boost::asio::async_write(socket_, buffers,
+            [this, self](boost::system::error_code ec, std::size_t /*length*/) {
+                if (ec) {
+                    close();
+                    return;
+                }
+
+                // Rest of a streamed body (fresh deadline per chunk)
+                head_.clear();
+                if (body_sent_ < body_.size()) {
+                    do_write();
+                    return;
+                }
+
+                if (!keep_alive_) {
+                    close();
+                    return;
+                }
+                body_.clear();
+                chunked_ = false;
+
+                // Next request (possibly already buffered)
+                process_buffer();
+            }
+        );
+    }
+
+    void AdminSession::arm_timer() {
+        auto self(shared_from_this());
+        timer_.expires_after(server_.timeout_);
+        timer_.async_wait([this, self](const boost::system::error_code& ec) {
+            // Re-arming cancels the previous wait; only a real expiry closes
+            if (ec == boost::asio::error::operation_aborted) return;
+            if (timer_.expiry() > std::chrono::steady_clock::now()) return;
+            close();
+        });
+    }
+
+    void AdminSession::close() {
+        if (closed_) return;
+        closed_ = true;
+
+        boost::system::error_code ignored;
+        socket_.shutdown(tcp::socket::shutdown_both, ignored);
+        socket_.close(ignored);
+        timer_.cancel();
+    }
+
+} // namespace blackbox::core
@@ -9,6 +9,8 @@
 #include "blackbox/common/signal_handler.h"
 #include "blackbox/common/crash_handler.h"
 #include "blackbox/common/metrics.h"
+#include "blackbox/common/id_generator.h"
+#include "blackbox/common/tsc_clock.h"
 #include <iostream>
 #include <stdexcept>
 
@@ -27,6 +29,22 @@ namespace blackbox::core {
         // 3. Load Configuration
         // (In the future, parse argc/argv for config file path)
         common::Settings::instance().load_from_env();
+
+        // 4. Optional file logging (stdout otherwise)
+        const auto& log_cfg = common::Settings::instance().log();
+        if (!log_cfg.file_path.empty()) {
+            common::Logger::instance().set_file_sink(
+                log_cfg.file_path,
+                static_cast<uint64_t>(log_cfg.max_file_mb) * 1024 * 1024,
+                log_cfg.max_files
+            );
+        }
+
+        // 5. Event id layout (v7 keeps ids from one moment together on insert)
+        common::IdGenerator::set_time_ordered(common::Settings::instance().db().time_ordered_ids);
+
+        // 6. TSC rate for profiling zones and traces (~10 ms, before any worker starts)
+        common::TscClock::calibrate();
     }
 
     // =========================================================
@@ -0,0 +1,116 @@
+/**
+ * @file batch_controller.cpp
+ * @brief Implementation of the AIMD Batch Controller.
+ */
+
+#include "blackbox/core/batch_controller.h"
+#include <algorithm>
+
+namespace blackbox::core {
+
+    namespace {
+
+        // Fewer end-to-end samples than this in an interval: no latency signal
+        constexpr uint64_t MIN_LATENCY_SAMPLES = 32;
+
+        // Fill deadline grows in these steps (then halves on pressure)
+        constexpr uint64_t WAIT_STEP_US = 20;
+
+    } // namespace
+
+    // =========================================================
+    // Constructor
+    // =========================================================
+    BatchController::BatchController(const BatchLimits& limits, size_t queue_capacity)
+        : limits_(limits), queue_capacity_(queue_capacity)
+    {
+        // A batch never takes more than half the queue. Bound min_batch first:
+        // a shallow queue (e.g. depth 8 with the default min of 8) would
+        // otherwise leave min > max.
+        const size_t ceiling = std::max<size_t>(1, queue_capacity_ / 2);
+        limits_.min_batch = std::clamp<size_t>(limits_.min_batch, 1, ceiling);
+        limits_.max_batch = std::clamp(limits_.max_batch, limits_.min_batch, ceiling);
+        batch_ = std::clamp(limits_.initial_batch, limits_.min_batch, limits_.max_batch);
+        if (!limits_.adaptive) batch_ = std::clamp<size_t>(limits_.initial_batch, 1, ceiling);
+
+        pub_batch_.store(batch_, std::memory_order_relaxed);
+        previous_ = common::LatencyHistograms::snapshot(common::Stage::EndToEnd);
+    }
+
+    // =========================================================
+    // Per-Batch Feedback (Detect Thread)
+    // =========================================================
+    void BatchController::on_batch(size_t occupancy, size_t collected, uint64_t now_ns) {
+        if (!limits_.adaptive) return;
+
+        if (interval_start_ns_ == 0) interval_start_ns_ = now_ns;
+        batches_++;
+        occupancy_sum_ += occupancy;
+        fill_sum_ += collected;
+
+        if (now_ns - interval_start_ns_ < limits_.interval_ms * 1000000) return;
+
+        bool known = false;
+        const uint64_t p99 = window_p99(known);
+        adjust(p99, known,
+               static_cast<double>(occupancy_sum_) / static_cast<double>(batches_),
+               static_cast<double>(fill_sum_) / static_cast<double>(batches_));
+
+        interval_start_ns_ = now_ns;
+        batches_ = occupancy_sum_ = fill_sum_ = 0;
+    }
+
+    uint64_t BatchController::window_p99(bool& known) {
+        auto current = common::LatencyHistograms::snapshot(common::Stage::EndToEnd);
+
+        // Only what was recorded since the last control step
+        common::LatencyHistograms::Snapshot window;
+        for (size_t b = 0; b < common::LatencyHistograms::BUCKETS; ++b) {
+            window.counts[b] = current.counts[b] - previous_.counts[b];
+        }
+        window.count = current.count - previous_.count;
+        window.sum_ns = current.sum_ns - previous_.sum_ns;
+        previous_ = current;
+
+        known = window.count >= MIN_LATENCY_SAMPLES;
+        const uint64_t p99 = known ? window.quantile(0.99) : 0;
+        if (known) pub_p99_ns_.store(p99, std::memory_order_relaxed);
+        return p99;
+    }
+
+    // =========================================================
+    // Control Law (AIMD)
+    // =========================================================
+    void BatchController::adjust(uint64_t p99_ns, bool latency_known, double avg_occupancy, double avg_fill) {
+        const uint64_t budget_ns = limits_.p99_budget_us * 1000;
+        const bool over_budget = latency_known && p99_ns > budget_ns;
+        const bool headroom = !latency_known || p99_ns < budget_ns / 2;
+
+        if (over_budget) {
+            // Multiplicative decrease: latency first
+            batch_ = std::max(limits_.min_batch, batch_ / 2);
+            wait_us_ /= 2;
+        } else {
+            // 1. Size: follow the backlog (additive, in steps of min_batch)
+            const size_t step = limits_.min_batch;
+            if (avg_occupancy > static_cast<double>(batch_)) {
+                batch_ = std::min(limits_.max_batch, batch_ + step);
+            } else if (avg_occupancy < static_cast<double>(batch_) / 4) {
+                batch_ = std::max(limits_.min_batch, batch_ - std::min(step, batch_));
+            }
+
+            // 2. Deadline: only worth waiting while traffic is steady enough to
+            // fill batches further and the budget has room for it
+            const bool partial = avg_fill >= 2.0 && avg_fill < static_cast<double>(batch_);
+            if (headroom && partial) {
+                wait_us_ = std::min(limits_.max_wait_us, wait_us_ + WAIT_STEP_US);
+            } else {
+                wait_us_ /= 2;
+            }
+        }
+
+        pub_batch_.store(batch_, std::memory_order_relaxed);
+        pub_wait_us_.store(wait_us_, std::memory_order_relaxed);
+    }
+
+} // namespace blackbox::core
@@ -8,17 +8,43 @@
 #include "blackbox/common/logger.h"
 #include "blackbox/common/metrics.h"
 #include "blackbox/common/thread_utils.h"
-#include "blackbox/common/string_utils.h"
-#include "blackbox/analysis/alert_manager.h"
+#include "blackbox/common/latency_histogram.h"
+#include "blackbox/common/time_utils.h"
+#include "blackbox/common/tsc_clock.h"
+#include "blackbox/common/wait_strategy.h"
+#include "blackbox/ingest/overload_controller.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
 #include <iostream>
 #include <chrono>
 
 namespace blackbox::core {
 
+    namespace {
+        // Stage clock deltas; a wall-clock step backwards records 0, not 2^64
+        inline uint64_t elapsed_ns(uint64_t from, uint64_t to) {
+            return to > from ? to - from : 0;
+        }
+
+        // Names, pinning and priority for one stage thread
+        void setup_stage_thread(const std::string& name, int core, size_t index) {
+            common::ThreadUtils::set_current_thread_name(name);
+            if (core >= 0) common::ThreadUtils::pin_current_thread_to_core(core + static_cast<int>(index));
+        }
+
+        size_t stage_threads(int configured) {
+            return static_cast<size_t>(std::max(1, configured));
+        }
+    }
+
     // =========================================================
     // Constructor
     // =========================================================
-    Pipeline::Pipeline() {
+    Pipeline::Pipeline()
+        // Slots on the parse stage's node (it is the ring's only consumer)
+        : ring_buffer_(common::MemoryPolicy::for_cpu(common::Settings::instance().stages().parse_core))
+    {
         LOG_INFO("Initializing Blackbox Pipeline components...");
 
         const auto& settings = common::Settings::instance();
@@ -26,6 +52,9 @@ namespace blackbox::core {
         // 1. Setup Network Context
         io_context_ = std::make_shared<boost::asio::io_context>();
         
+        // Overload shedding must be configured before the listeners run
+        ingest::OverloadController::instance().configure(settings.overload());
+
         // 2. Setup UDP Server
         udp_server_ = std::make_unique<ingest::UdpServer>(
             *io_context_, 
@@ -39,8 +68,11 @@ namespace blackbox::core {
         );
         // 3. Setup Logic Engines
         try {
-            // A. AI Brain (xInfer)
-            brain_ = std::make_unique<analysis::InferenceEngine>(settings.ai().model_path);
+            // A. AI Brain (xInfer): one context per detect thread
+            const size_t detect_threads = stage_threads(settings.stages().detect_threads);
+            for (size_t i = 0; i < detect_threads; ++i) {
+                brains_.push_back(std::make_unique<analysis::InferenceEngine>(settings.ai().model_path));
+            }
             
             // B. Rule Engine (Signatures)
             rule_engine_ = std::make_unique<analysis::RuleEngine>();
@@ -58,10 +90,128 @@ namespace blackbox::core {
                 settings.db().redis_port
             );
 
+            // Alert stage: aggregation + shaped dispatch off the processing thread
+            alerts_ = std::make_unique<analysis::AlertDispatcher>(redis_.get(), settings.db().redis_channel);
+
+            // F. Recent Event Store (queried through the Admin Server)
+            if (settings.recent().memory_mb > 0) {
+                recent_ = std::make_unique<storage::RecentEventStore>(
+                    static_cast<uint64_t>(settings.recent().window_sec) * 1000,
+                    settings.recent().memory_mb * 1024 * 1024,
+                    common::MemoryPolicy::for_cpu(settings.stages().persist_core)
+                );
+                admin_server_->add_route("/query/recent", [this](const std::string& query) {
+                    auto q = storage::RecentEventStore::parse_query_string(query);
+                    return storage::RecentEventStore::to_json(recent_->query(q));
+                });
+            }
+
+            // G. Adaptive micro-batching (sized from ring depth and the p99 budget)
+            const auto& ai = settings.ai();
+            BatchLimits limits;
+            limits.initial_batch = static_cast<size_t>(std::max(1, ai.batch_size));
+            limits.min_batch = static_cast<size_t>(std::max(1, ai.batch_min));
+            limits.max_batch = static_cast<size_t>(std::max(1, ai.batch_max));
+            limits.max_wait_us = static_cast<uint64_t>(std::max(0, ai.batch_max_wait_us));
+            limits.p99_budget_us = static_cast<uint64_t>(std::max(1, ai.latency_budget_ms)) * 1000;
+            limits.adaptive = ai.adaptive_batching;
+
+            // H. Stage graph. The pool covers every queue slot plus what
+            // the stage threads hold, so acquire() only fails when all
+            // queues are full (and then parsing must wait anyway).
+            const auto& stages = settings.stages();
+            const size_t depth = std::bit_ceil(static_cast<size_t>(std::max(2, stages.queue_depth)));
+            const size_t enrich_threads = stage_threads(stages.enrich_threads);
+            limits.max_batch = std::min(limits.max_batch, depth);
+
+            to_enrich_ = std::make_unique<StageQueue>("enrich", depth, enrich_threads);
+            to_detect_ = std::make_unique<StageQueue>("detect", depth, detect_threads);
+            to_persist_ = std::make_unique<StageQueue>("persist", depth, 1);
+            pool_ = std::make_unique<EventPool>(3 * depth + detect_threads * limits.max_batch + enrich_threads + 2,
+                                                common::MemoryPolicy::for_cpu(stages.parse_core));
+
+            for (size_t i = 0; i < detect_threads; ++i) {
+                batchers_.push_back(std::make_unique<BatchController>(limits, depth));
+            }
+            LOG_INFO("Stage graph: parse x1, enrich x" + std::to_string(enrich_threads) +
+                     ", detect x" + std::to_string(detect_threads) + ", persist x1, queue depth " +
+                     std::to_string(depth) + ", " + std::to_string(pool_->size()) + " pooled events");
+
+            // I. Sampled Tracing (Chrome trace JSON through the Admin Server)
+            const auto& trace = settings.trace();
+            if (trace.sample_every > 0 || !trace.source_ip.empty()) {
+                trace_ = std::make_unique<common::TraceBuffer>(
+                    static_cast<size_t>(std::max(1, trace.buffer_events)),
+                    static_cast<uint32_t>(std::max(0, trace.sample_every)),
+                    trace.source_ip
+                );
+                admin_server_->add_route("/debug/trace", [this](const std::string& query) {
+                    // Optional "?limit=N": newest N events only
+                    size_t limit = 0;
+                    if (query.rfind("limit=", 0) == 0) {
+                        std::from_chars(query.data() + 6, query.data() + query.size(), limit);
+                    }
+                    return trace_->to_chrome_json(limit);
+                });
+                LOG_INFO("Pipeline tracing enabled (1 in " + std::to_string(trace.sample_every) +
+                         (trace.source_ip.empty() ? "" : ", source " + trace.source_ip) + ")");
+            }
+
         } catch (const std::exception& e) {
             LOG_CRITICAL("Failed to initialize pipeline components: " + std::string(e.what()));
             throw; // Fatal error, crash the app
         }
+
+        // 4. Queue gauges for /metrics (sampled on scrape, atomic loads only)
+        auto& metrics = common::Metrics::instance();
+        metrics.register_gauge("blackbox_ring_buffer_events", "Events waiting in the ingest ring buffer",
+                               [this] { return static_cast<double>(ring_buffer_.size()); });
+        metrics.register_gauge("blackbox_ring_buffer_capacity", "Ingest ring buffer capacity",
+                               [] { return static_cast<double>(decltype(ring_buffer_)::capacity()); });
+        metrics.register_gauge("blackbox_db_inflight_batches", "INSERT batches queued or on the wire to ClickHouse",
+                               [this] { return static_cast<double>(storage_.inflight()); });
+        metrics.register_gauge("blackbox_alerts_queued", "Alerts waiting for the Redis publisher",
+                               [this] { return static_cast<double>(redis_->queued()); });
+        metrics.register_gauge("blackbox_alert_records_queued", "Alert records waiting for aggregation",
+                               [this] { return static_cast<double>(alerts_->queued()); });
+        // Batch gauges follow the first detect thread (all see the same signals)
+        metrics.register_gauge("blackbox_ai_batch_size", "Current micro-batch size target",
+                               [this] { return static_cast<double>(batchers_[0]->published_batch_size()); });
+        metrics.register_gauge("blackbox_ai_batch_wait_us", "Current micro-batch fill deadline in microseconds",
+                               [this] { return static_cast<double>(batchers_[0]->published_wait_us()); });
+        metrics.register_gauge("blackbox_batch_latency_p99_seconds",
+                               "End-to-end p99 seen by the batch controller (last control interval)",
+                               [this] { return static_cast<double>(batchers_[0]->published_p99_ns()) / 1e9; });
+
+        // Stage queues: occupancy and how often a producer found them full.
+        // Stage service times are the blackbox_stage_latency histograms.
+        metrics.register_gauge("blackbox_stage_queue_capacity", "Events each inter-stage queue can hold",
+                               [this] { return static_cast<double>(to_enrich_->capacity()); });
+        metrics.register_gauge("blackbox_stage_events_in_flight", "Pooled events between parse and persist",
+                               [this] { return static_cast<double>(pool_->in_flight()); });
+        // Overload shedding: level and per-class shed/drop counts
+        auto& overload = ingest::OverloadController::instance();
+        metrics.register_gauge("blackbox_overload_level", "Ingest shedding level (0 off, 1 sampling, 2 severe)",
+                               [&overload] { return static_cast<double>(overload.level()); });
+        for (size_t c = 0; c < ingest::OverloadController::CLASSES; ++c) {
+            const auto cls = static_cast<ingest::TrafficClass>(c);
+            const std::string name = ingest::OverloadController::class_name(cls);
+            metrics.register_counter("blackbox_shed_" + name + "_total",
+                                     "Events of class " + name + " sampled out at ingest under overload",
+                                     [&overload, cls] { return static_cast<double>(overload.shed(cls)); });
+            metrics.register_counter("blackbox_overload_dropped_" + name + "_total",
+                                     "Events of class " + name + " admitted but dropped on a full ring",
+                                     [&overload, cls] { return static_cast<double>(overload.dropped(cls)); });
+        }
+
+        for (StageQueue* queue : {to_enrich_.get(), to_detect_.get(), to_persist_.get()}) {
+            metrics.register_gauge("blackbox_stage_" + queue->name() + "_queue_events",
+                                   "Events waiting for the " + queue->name() + " stage",
+                                   [queue] { return static_cast<double>(queue->size()); });
+            metrics.register_counter("blackbox_stage_" + queue->name() + "_backpressure_total",
+                                     "Pushes that waited on a full " + queue->name() + " queue",
+                                     [queue] { return static_cast<double>(queue->full_waits()); });
+        }
     }
 
     // =========================================================
@@ -69,6 +219,25 @@ namespace blackbox::core {
     // =========================================================
     Pipeline::~Pipeline() {
         stop();
+
+        auto& metrics = common::Metrics::instance();
+        for (const char* gauge : {"blackbox_ring_buffer_events", "blackbox_ring_buffer_capacity",
+                                  "blackbox_db_inflight_batches", "blackbox_alerts_queued",
+                                  "blackbox_alert_records_queued", "blackbox_ai_batch_size",
+                                  "blackbox_ai_batch_wait_us", "blackbox_batch_latency_p99_seconds",
+                                  "blackbox_stage_queue_capacity", "blackbox_stage_events_in_flight",
+                                  "blackbox_overload_level"}) {
+            metrics.unregister_gauge(gauge);
+        }
+        for (const char* stage : {"enrich", "detect", "persist"}) {
+            metrics.unregister_gauge(std::string("blackbox_stage_") + stage + "_queue_events");
+            metrics.unregister_gauge(std::string("blackbox_stage_") + stage + "_backpressure_total");
+        }
+        for (size_t c = 0; c < ingest::OverloadController::CLASSES; ++c) {
+            const std::string name = ingest::OverloadController::class_name(static_cast<ingest::TrafficClass>(c));
+            metrics.unregister_gauge("blackbox_shed_" + name + "_total");
+            metrics.unregister_gauge("blackbox_overload_dropped_" + name + "_total");
+        }
     }
 
     // =========================================================
@@ -86,8 +255,16 @@ namespace blackbox::core {
         // 2. Start Network Thread
         ingest_thread_ = std::thread(&Pipeline::ingest_worker, this);
 
-        // 3. Start Processing Thread
-        processing_thread_ = std::thread(&Pipeline::processing_worker, this);
+        // 3. Start Stage Threads (persist first: consumers before producers)
+        const auto& stages = common::Settings::instance().stages();
+        stage_threads_.emplace_back(&Pipeline::persist_worker, this);
+        for (size_t i = 0; i < brains_.size(); ++i) {
+            stage_threads_.emplace_back(&Pipeline::detect_worker, this, i);
+        }
+        for (size_t i = 0; i < stage_threads(stages.enrich_threads); ++i) {
+            stage_threads_.emplace_back(&Pipeline::enrich_worker, this, i);
+        }
+        stage_threads_.emplace_back(&Pipeline::parse_worker, this);
 
         LOG_INFO("Pipeline Active. Kinetic Defense Online.");
     }
@@ -101,11 +278,20 @@ namespace blackbox::core {
         
         running_ = false;
 
+        // Stage threads may be parked on empty queues
+        ring_buffer_.wake_consumer();
+        to_enrich_->wake_all();
+        to_detect_->wake_all();
+        to_persist_->wake_all();
+
         if (io_context_) io_context_->stop();
         if (admin_server_) admin_server_->stop();
 
         if (ingest_thread_.joinable()) ingest_thread_.join();
-        if (processing_thread_.joinable()) processing_thread_.join();
+        for (auto& thread : stage_threads_) {
+            if (thread.joinable()) thread.join();
+        }
+        stage_threads_.clear();
 
         LOG_INFO("Pipeline Stopped.");
     }
@@ -130,105 +316,261 @@ namespace blackbox::core {
     }
 
     // =========================================================
-    // Processing Worker (Core 1)
+    // Parse Stage (ring consumer, single thread)
     // =========================================================
-    void Pipeline::processing_worker() {
-        common::ThreadUtils::set_current_thread_name("BB_Brain");
-        common::ThreadUtils::pin_current_thread_to_core(1);
+    void Pipeline::parse_worker() {
+        const auto& settings = common::Settings::instance();
+        setup_stage_thread("BB_Parse", settings.stages().parse_core, 0);
         common::ThreadUtils::set_realtime_priority(80);
 
+        // Idle behaviour: spin, yield, then park until the next push
+        common::WaitStrategy waiter(common::WaitPolicy::from_name(settings.network().consumer_wait));
+
+        auto& overload = ingest::OverloadController::instance();
+        uint32_t since_pressure = 0;
+
+        StageEvent* event = nullptr;
+        while (running_) {
+            // Fullest stage queue feeds the ingest shedding decision
+            if ((++since_pressure & 63) == 0) {
+                size_t fullest = std::max({to_enrich_->size(), to_detect_->size(), to_persist_->size()});
+                overload.set_stage_pressure(static_cast<double>(fullest) / static_cast<double>(to_enrich_->capacity()));
+            }
+
+            // Every event in flight: downstream is full, leave the ring to fill
+            if (!event && !(event = pool_->acquire())) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (!ring_buffer_.pop(event->raw)) {
+                since_pressure = 63; // Refresh on the next round, the queues may have drained
+                ring_buffer_.wait_for_data(waiter);
+                continue;
+            }
+            waiter.reset();
+
+            const uint64_t t_pop = common::TimeUtils::now_ns();
+            common::LatencyHistograms::record(common::Stage::RingDwell, elapsed_ns(event->raw.timestamp_ns, t_pop));
+
+            // Parse (Zero Copy: views into event->raw)
+            event->log = parser_.process(event->raw);
+            common::LatencyHistograms::record(common::Stage::Parse, elapsed_ns(t_pop, common::TimeUtils::now_ns()));
+
+            // Sampling is decided after parsing, so source filters can match.
+            // Push/pop reuse the wall-clock stamps already taken above.
+            if (trace_ && trace_->should_sample(event->log.host)) {
+                auto& trace = event->trace;
+                trace = common::TraceEvent{};
+                trace.stamps[static_cast<size_t>(common::TracePoint::IngestPush)] =
+                    common::TscClock::from_wall_ns(event->raw.timestamp_ns);
+                trace.stamps[static_cast<size_t>(common::TracePoint::Pop)] = common::TscClock::from_wall_ns(t_pop);
+                trace.mark(common::TracePoint::Parse);
+                trace.set_source(event->log.host);
+                event->traced = true;
+            }
+
+            if (!to_enrich_->push(event, running_)) break;
+            event = nullptr;
+        }
+
+        if (event) pool_->release(event);
+    }
+
+    // =========================================================
+    // Enrich Stage (GeoIP)
+    // =========================================================
+    void Pipeline::enrich_worker(size_t index) {
+        const auto& settings = common::Settings::instance();
+        setup_stage_thread("BB_Enrich" + std::to_string(index), settings.stages().enrich_core, index);
+
+        common::WaitStrategy waiter(common::WaitPolicy::from_name(settings.network().consumer_wait));
+
+        while (running_) {
+            StageEvent* event = to_enrich_->try_pop();
+            if (!event) {
+                to_enrich_->wait(index, waiter);
+                continue;
+            }
+            waiter.reset();
+
+            const uint64_t t_stage = common::TimeUtils::now_ns();
+            auto& log = event->log;
+
+            auto loc = geoip_->lookup(log.host);
+            if (loc) {
+                log.country = loc->country_iso;
+                log.lat = loc->latitude;
+                log.lon = loc->longitude;
+            }
+
+            if (event->traced) event->trace.mark(common::TracePoint::GeoIP);
+            common::LatencyHistograms::record(common::Stage::Enrich, elapsed_ns(t_stage, common::TimeUtils::now_ns()));
+
+            if (!to_detect_->push(event, running_)) {
+                pool_->release(event);
+                break;
+            }
+        }
+    }
+
+    // =========================================================
+    // Detect Stage (Rules + Inference, micro-batched)
+    // =========================================================
+    void Pipeline::detect_worker(size_t index) {
         const auto& settings = common::Settings::instance();
-        const int BATCH_SIZE = settings.ai().batch_size;
+        setup_stage_thread("BB_Detect" + std::to_string(index), settings.stages().detect_core, index);
+
         const float AI_THRESHOLD = settings.ai().anomaly_threshold;
+        BatchController& batcher = *batchers_[index];
+        analysis::InferenceEngine& brain = *brains_[index];
 
-        // Micro-batch buffer
-        std::vector<parser::ParsedLog> batch_logs;
-        batch_logs.reserve(BATCH_SIZE);
+        common::WaitStrategy waiter(common::WaitPolicy::from_name(settings.network().consumer_wait));
 
-        ingest::LogEvent raw_event;
+        // Micro-batch, sized for the largest batch the controller may pick
+        std::vector<StageEvent*> batch;
+        batch.reserve(std::max<size_t>(batcher.batch_size(), static_cast<size_t>(std::max(1, settings.ai().batch_max))));
 
         while (running_) {
-            
             // -------------------------------------------------
-            // 1. Fetch Batch from RingBuffer
+            // 1. Fetch Batch from the detect queue
             // -------------------------------------------------
-            int collected = 0;
-            while (collected < BATCH_SIZE && ring_buffer_.pop(raw_event)) {
-                // Parse (Zero Copy)
-                batch_logs.push_back(parser_.process(raw_event));
-                collected++;
+            const size_t target = batcher.batch_size();
+            const uint64_t fill_wait_ns = batcher.wait_ns();
+            const size_t occupancy = to_detect_->size();
+            uint64_t fill_deadline = 0;
+            uint32_t fill_spins = 0;
+
+            while (batch.size() < target) {
+                StageEvent* event = to_detect_->try_pop();
+                if (!event) {
+                    // Queue drained: a started batch may wait briefly for more,
+                    // checking the clock every 64 pauses only
+                    if (batch.empty() || fill_wait_ns == 0) break;
+                    if ((++fill_spins & 63) == 0 && common::TimeUtils::now_ns() >= fill_deadline) break;
+                    common::cpu_relax();
+                    continue;
+                }
+                if (batch.empty()) fill_deadline = common::TimeUtils::now_ns() + fill_wait_ns;
+                batch.push_back(event);
             }
 
-            if (collected == 0) {
-                std::this_thread::yield();
+            if (batch.empty()) {
+                to_detect_->wait(index, waiter);
                 continue;
             }
+            waiter.reset();
 
             // -------------------------------------------------
-            // 2. Process Logic
+            // 2. Verdicts
             // -------------------------------------------------
-            for (auto& log : batch_logs) {
-                float final_score = 0.0f;
-                bool is_critical = false;
-                std::string alert_reason = "";
-
-                // A. GeoIP Enrichment
-                // We use std::string(log.host) because lookup expects null-terminated string/view
-                auto loc = geoip_->lookup(log.host);
-                if (loc) {
-                    log.country = loc->country_iso;
-                    log.lat = loc->latitude;
-                    log.lon = loc->longitude;
-                }
+            for (StageEvent* event : batch) {
+                uint64_t t_stage = common::TimeUtils::now_ns();
+                uint64_t t_next = 0;
+
+                // A. Rule Engine (Static)
+                auto rule_hit = rule_engine_->evaluate(event->log);
+                if (event->traced) event->trace.mark(common::TracePoint::Rules);
+
+                t_next = common::TimeUtils::now_ns();
+                common::LatencyHistograms::record(common::Stage::Rules, elapsed_ns(t_stage, t_next));
+                t_stage = t_next;
 
-                // B. Rule Engine (Static)
-                auto rule_hit = rule_engine_->evaluate(log);
                 if (rule_hit) {
-                    final_score = 1.0f;
-                    is_critical = true;
-                    alert_reason = "Rule: " + *rule_hit;
-                } 
+                    event->score = 1.0f;
+                    event->critical = true;
+                    event->reason.append("Rule: ").append(*rule_hit);
+                }
                 else {
-                    // C. AI Engine (Dynamic)
-                    final_score = brain_->evaluate(log.embedding_vector);
-                    if (final_score > AI_THRESHOLD) {
-                        is_critical = true;
-                        alert_reason = "AI Anomaly Detection";
+                    // B. AI Engine (Dynamic)
+                    event->score = brain.evaluate(event->log.embedding_vector);
+                    if (event->score > AI_THRESHOLD) {
+                        event->critical = true;
+                        event->reason = "AI Anomaly Detection";
                     }
                     common::Metrics::instance().inc_inferences_run(1);
-                }
+                    if (event->traced) event->trace.mark(common::TracePoint::Inference);
 
-                // D. Action (If Critical)
-                if (is_critical) {
-                    common::Metrics::instance().inc_threats_detected(1);
-                    
-                    // 1. Active Defense (Block IP)
-                    analysis::AlertManager::instance().trigger_alert(
-                        log.host, final_score, alert_reason
-                    );
-
-                    // 2. Notify Dashboard (Redis Pub/Sub)
-                    // Construct JSON manually for speed
-                    std::string json = "{";
-                    json += "\"ts\": " + std::to_string(log.timestamp) + ",";
-                    json += "\"ip\": \"" + std::string(log.host) + "\",";
-                    json += "\"score\": " + std::to_string(final_score) + ",";
-                    json += "\"reason\": \"" + alert_reason + "\",";
-                    json += "\"country\": \"" + log.country + "\",";
-                    json += "\"msg\": \"" + common::StringUtils::escape_sql(std::string(log.message)) + "\"";
-                    json += "}";
-
-                    redis_->publish(settings.db().redis_channel, json);
+                    common::LatencyHistograms::record(common::Stage::Inference,
+                                                      elapsed_ns(t_stage, common::TimeUtils::now_ns()));
                 }
-
-                // E. Persistence (ClickHouse)
-                storage_.enqueue(log, final_score);
             }
 
             // -------------------------------------------------
-            // 3. Reset
+            // 3. Hand-off + Feedback
             // -------------------------------------------------
-            batch_logs.clear();
+            size_t handed = 0;
+            for (; handed < batch.size(); ++handed) {
+                if (!to_persist_->push(batch[handed], running_)) break;
+            }
+            for (size_t i = handed; i < batch.size(); ++i) pool_->release(batch[i]);
+
+            batcher.on_batch(occupancy, batch.size(), common::TimeUtils::now_ns());
+            batch.clear();
+        }
+
+        for (StageEvent* event : batch) pool_->release(event);
+    }
+
+    // =========================================================
+    // Persist Stage (Alerts, Storage, Recent history)
+    // =========================================================
+    void Pipeline::persist_worker() {
+        const auto& settings = common::Settings::instance();
+        setup_stage_thread("BB_Persist", settings.stages().persist_core, 0);
+
+        common::WaitStrategy waiter(common::WaitPolicy::from_name(settings.network().consumer_wait));
+
+        // Single thread on purpose: the alert queue and the recent store
+        // take exactly one producer
+        while (running_) {
+            StageEvent* event = to_persist_->try_pop();
+            if (!event) {
+                // Idle: ship any partially staged rows before they go stale
+                storage_.flush_local();
+                to_persist_->wait(0, waiter);
+                continue;
+            }
+            waiter.reset();
+
+            const auto& log = event->log;
+
+            // A. Action (If Critical)
+            if (event->critical) {
+                common::Metrics::instance().inc_threats_detected(1);
+
+                // Active defense, log and dashboard run on the alert
+                // stage: here it is one copy into its queue
+                alerts_->submit(log.host, event->reason, event->score,
+                                log.timestamp, log.country, log.message);
+
+                // Keep this source at full fidelity if ingest starts shedding
+                if (auto source = common::IpKey::parse(log.host)) {
+                    ingest::OverloadController::instance().note_alert(*source);
+                }
+                if (event->traced) event->trace.mark(common::TracePoint::Alert);
+            }
+
+            // B. Persistence (ClickHouse)
+            const uint64_t t_stage = common::TimeUtils::now_ns();
+            storage_.enqueue(log, event->score);
+
+            const uint64_t t_next = common::TimeUtils::now_ns();
+            common::LatencyHistograms::record(common::Stage::StorageEnqueue, elapsed_ns(t_stage, t_next));
+            common::LatencyHistograms::record(common::Stage::EndToEnd, elapsed_ns(log.timestamp, t_next));
+
+            // C. Recent history (lock-free for admin readers)
+            if (recent_) recent_->append(log, event->score, event->critical);
+
+            if (event->traced) {
+                auto& trace = event->trace;
+                trace.mark(common::TracePoint::Enqueue);
+                trace.score = event->score;
+                trace.critical = event->critical;
+                trace_->publish(trace);
+            }
+
+            pool_->release(event);
         }
     }
 
@@ -0,0 +1,78 @@
+/**
+ * @file stage_queue.cpp
+ * @brief Implementation of the Event Pool and Stage Queues.
+ */
+
+#include "blackbox/core/stage_queue.h"
+#include <thread>
+
+namespace blackbox::core {
+
+    namespace {
+        // Pause-loop re-checks of a full queue before yielding
+        constexpr uint32_t FULL_SPIN_ROUNDS = 256;
+    }
+
+    // =========================================================
+    // Event Pool
+    // =========================================================
+    EventPool::EventPool(size_t events, const common::MemoryPolicy& memory)
+        : size_(events), events_(events, memory, "Stage event pool"), free_(events)
+    {
+        for (size_t i = 0; i < size_; ++i) {
+            events_[i].reason.reserve(256);
+            StageEvent* event = &events_[i];
+            free_.try_push(event);
+        }
+    }
+
+    StageEvent* EventPool::acquire() {
+        StageEvent* event = nullptr;
+        if (!free_.try_pop(event)) return nullptr;
+        event->reset();
+        return event;
+    }
+
+    void EventPool::release(StageEvent* event) {
+        // Cannot fail: the free list has room for every event
+        free_.try_push(event);
+    }
+
+    // =========================================================
+    // Stage Queue
+    // =========================================================
+    StageQueue::StageQueue(std::string name, size_t capacity, size_t consumers)
+        : name_(std::move(name)),
+          queue_(capacity),
+          consumers_(consumers == 0 ? 1 : consumers),
+          parkers_(new common::Parker[consumers_])
+    {
+    }
+
+    bool StageQueue::push(StageEvent* event, const std::atomic<bool>& running) {
+        if (queue_.try_push(event)) {
+            notify();
+            return true;
+        }
+
+        // Full: the consumer stage is behind. Wait here, so the stall
+        // travels upstream instead of dropping the event.
+        full_waits_.fetch_add(1, std::memory_order_relaxed);
+        uint32_t rounds = 0;
+        while (!queue_.try_push(event)) {
+            if (!running.load(std::memory_order_relaxed)) return false;
+            if (++rounds < FULL_SPIN_ROUNDS) {
+                common::cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        notify();
+        return true;
+    }
+
+    void StageQueue::wake_all() {
+        for (size_t i = 0; i < consumers_; ++i) parkers_[i].wake();
+    }
+
+} // namespace blackbox::core
@@ -0,0 +1,210 @@
+/**
+ * @file ban_filter.cpp
+ * @brief Implementation of the Ingest Ban Filter.
+ */
+
+#include "blackbox/ingest/ban_filter.h"
+#include "blackbox/common/logger.h"
+#include "blackbox/common/settings.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <linux/filter.h>
+#include <sys/socket.h>
+
+namespace blackbox::ingest {
+
+    namespace {
+
+        // ~10 bits per key with 3 probes: ~2% of clean traffic reaches the
+        // binary search
+        constexpr size_t BLOOM_BITS_PER_KEY = 10;
+        constexpr size_t BLOOM_MIN_BITS = 512;
+
+        // The socket filter is a linear compare chain (cBPF jump offsets are
+        // 8 bits), so only short lists are worth loading into the kernel.
+        constexpr size_t BPF_MAX_ADDRESSES = 64;
+
+    } // namespace
+
+    // =========================================================
+    // Singleton
+    // =========================================================
+    BanFilter& BanFilter::instance() {
+        static BanFilter instance;
+        return instance;
+    }
+
+    BanFilter::BanFilter() {
+        auto empty = std::make_unique<Snapshot>();
+        empty->bloom.assign(BLOOM_MIN_BITS / 64, 0);
+        empty->bloom_mask = BLOOM_MIN_BITS - 1;
+        current_.store(empty.get(), std::memory_order_release);
+        live_ = std::move(empty);
+    }
+
+    BanFilter::~BanFilter() = default;
+
+    // =========================================================
+    // Readers
+    // =========================================================
+    BanFilter::ReaderSlot* BanFilter::reader_slot() const {
+        // Gives the slot back when the thread exits
+        struct Owner {
+            ReaderSlot* slot = nullptr;
+            bool claimed = false;
+            ~Owner() { if (slot) slot->owned.store(false, std::memory_order_release); }
+        };
+        static thread_local Owner owner;
+
+        if (!owner.claimed) {
+            owner.claimed = true;
+            for (auto& candidate : readers_) {
+                bool expected = false;
+                if (candidate.owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    owner.slot = &candidate;
+                    break;
+                }
+            }
+            static std::atomic<bool> warned{false};
+            if (!owner.slot && !warned.exchange(true, std::memory_order_relaxed)) {
+                LOG_WARN("Ban filter: more than " + std::to_string(READER_SLOTS) +
+                         " reader threads, the rest look up under the writer lock");
+            }
+        }
+        return owner.slot;
+    }
+
+    bool BanFilter::contains_locked(const common::IpKey& ip) const {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        return std::binary_search(live_->keys.begin(), live_->keys.end(), ip);
+    }
+
+    // =========================================================
+    // Update (Writer Side)
+    // =========================================================
+    void BanFilter::update(const std::vector<common::IpKey>& added,
+                           const std::vector<common::IpKey>& removed) {
+        if (added.empty() && removed.empty()) return;
+
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+
+        std::vector<common::IpKey> adds(added);
+        std::vector<common::IpKey> removes(removed);
+        std::sort(adds.begin(), adds.end());
+        adds.erase(std::unique(adds.begin(), adds.end()), adds.end());
+        std::sort(removes.begin(), removes.end());
+        removes.erase(std::unique(removes.begin(), removes.end()), removes.end());
+
+        // 1. master - removed
+        std::vector<common::IpKey> kept;
+        kept.reserve(master_.size());
+        std::set_difference(master_.begin(), master_.end(), removes.begin(), removes.end(),
+                            std::back_inserter(kept));
+
+        // 2. + added (sorted merge, no duplicates)
+        std::vector<common::IpKey> next;
+        next.reserve(kept.size() + adds.size());
+        std::set_union(kept.begin(), kept.end(), adds.begin(), adds.end(), std::back_inserter(next));
+
+        master_ = next;
+        publish(std::move(next));
+    }
+
+    void BanFilter::publish(std::vector<common::IpKey> keys) {
+        // 1. Build the new snapshot
+        auto snapshot = std::make_unique<Snapshot>();
+        size_t bits = BLOOM_MIN_BITS;
+        while (bits < keys.size() * BLOOM_BITS_PER_KEY) bits <<= 1;
+        snapshot->bloom.assign(bits / 64, 0);
+        snapshot->bloom_mask = bits - 1;
+        for (const auto& key : keys) snapshot->add(common::IpKeyHash{}(key));
+        snapshot->keys = std::move(keys);
+
+        // 2. Swap it in; the old one is retired, not freed. Readers that
+        // announce the new epoch are guaranteed to load the new snapshot.
+        banned_.store(snapshot->keys.size(), std::memory_order_relaxed);
+        current_.store(snapshot.get(), std::memory_order_seq_cst);
+        const uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+        retired_.emplace_back(epoch, std::move(live_));
+        live_ = std::move(snapshot);
+
+        // 3. Free what no reader can still hold
+        reclaim();
+
+        if (!sockets_.empty()) refresh_socket_filters(live_->keys);
+    }
+
+    void BanFilter::reclaim() {
+        // Oldest epoch a reader is still inside (0 = idle slot)
+        uint64_t oldest = UINT64_MAX;
+        for (const auto& reader : readers_) {
+            const uint64_t epoch = reader.epoch.load(std::memory_order_seq_cst);
+            if (epoch != 0) oldest = std::min(oldest, epoch);
+        }
+
+        // A reader that entered before a snapshot's replacement may hold it
+        while (!retired_.empty() && retired_.front().first <= oldest) {
+            retired_.pop_front();
+        }
+    }
+
+    // =========================================================
+    // Kernel Socket Filter (Optional)
+    // =========================================================
+    void BanFilter::attach_socket(int fd) {
+        if (!common::Settings::instance().defense().ingest_bpf_filter) return;
+
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        sockets_.push_back(fd);
+        refresh_socket_filters(live_->keys);
+    }
+
+    void BanFilter::detach_socket(int fd) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        const auto it = std::find(sockets_.begin(), sockets_.end(), fd);
+        if (it == sockets_.end()) return;
+        sockets_.erase(it);
+        setsockopt(fd, SOL_SOCKET, SO_DETACH_FILTER, nullptr, 0);
+    }
+
+    void BanFilter::refresh_socket_filters(const std::vector<common::IpKey>& keys) {
+        // The UDP listener is IPv4 only: IPv6 bans are irrelevant to it
+        std::vector<uint32_t> v4;
+        for (const auto& key : keys) {
+            if (!key.is_v4()) continue;
+            uint32_t addr_be;
+            std::memcpy(&addr_be, key.v4_bytes(), 4);
+            v4.push_back(ntohl(addr_be)); // BPF loads are big-endian
+        }
+
+        if (v4.empty() || v4.size() > BPF_MAX_ADDRESSES) {
+            // Nothing to drop, or too many for a compare chain: user space
+            // (contains()) handles it. ENOENT just means no filter was attached.
+            for (int fd : sockets_) setsockopt(fd, SOL_SOCKET, SO_DETACH_FILTER, nullptr, 0);
+            return;
+        }
+
+        // ld [saddr]; jeq #a1 -> drop; ... jeq #aN -> drop; ret accept; ret drop
+        const size_t n = v4.size();
+        std::vector<sock_filter> program;
+        program.reserve(n + 3);
+        program.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_NET_OFF + 12)));
+        for (size_t i = 0; i < n; ++i) {
+            // From instruction i+1, the drop is n-i instructions ahead
+            program.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, v4[i], static_cast<uint8_t>(n - i), 0));
+        }
+        program.push_back(BPF_STMT(BPF_RET | BPF_K, 0xFFFFFFFF)); // Accept whole datagram
+        program.push_back(BPF_STMT(BPF_RET | BPF_K, 0));          // Drop
+
+        sock_fprog fprog{};
+        fprog.len = static_cast<unsigned short>(program.size());
+        fprog.filter = program.data();
+        for (int fd : sockets_) {
+            if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) != 0) {
+                LOG_ERROR(std::string("Failed to attach ban socket filter: ") + std::strerror(errno));
+            }
+        }
+    }
+
+} // namespace blackbox::ingest
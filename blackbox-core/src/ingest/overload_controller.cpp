@@ -0,0 +1,208 @@
+/**
+ * @file overload_controller.cpp
+ * @brief Implementation of Priority-Aware Load Shedding.
+ */
+
+#include "blackbox/ingest/overload_controller.h"
+#include "blackbox/common/logger.h"
+#include "blackbox/common/string_utils.h"
+#include <chrono>
+#include <string>
+
+namespace blackbox::ingest {
+
+    namespace {
+
+        // Syslog facilities that carry security events (RFC 5424 6.2.1)
+        constexpr int FACILITY_AUTH = 4;
+        constexpr int FACILITY_AUTHPRIV = 10;
+        constexpr int FACILITY_AUDIT = 13;
+        constexpr int FACILITY_ALERT = 14;
+
+        constexpr int SEVERITY_ERR = 3;
+        constexpr int SEVERITY_WARNING = 4;
+        constexpr int SEVERITY_DEBUG = 7;
+
+        // Coarse monotonic clock for hot-source expiry
+        uint32_t now_sec() {
+            return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        uint32_t keep_every(int configured) {
+            return static_cast<uint32_t>(std::max(1, configured));
+        }
+
+        uint32_t permille(int pct) {
+            return static_cast<uint32_t>(std::clamp(pct, 0, 100)) * 10;
+        }
+
+    } // namespace
+
+    // =========================================================
+    // Singleton
+    // =========================================================
+    OverloadController& OverloadController::instance() {
+        static OverloadController instance;
+        return instance;
+    }
+
+    OverloadController::OverloadController()
+        : hot_(new std::atomic<uint64_t>[HOT_SLOTS])
+    {
+        for (size_t i = 0; i < HOT_SLOTS; ++i) hot_[i].store(0, std::memory_order_relaxed);
+    }
+
+    void OverloadController::configure(const common::OverloadConfig& config) {
+        enabled_ = config.enabled;
+        engage_permille_ = permille(config.engage_pct);
+        severe_permille_ = std::max(engage_permille_, permille(config.severe_pct));
+        release_permille_ = std::min(engage_permille_, permille(config.release_pct));
+        keep_every_ = {1, keep_every(config.keep_high), keep_every(config.keep_normal), keep_every(config.keep_low)};
+        severe_factor_ = keep_every(config.severe_factor);
+        hot_ttl_sec_ = static_cast<uint32_t>(std::max(0, config.hot_source_sec));
+
+        priority_sources_.clear();
+        for (auto token : common::StringUtils::split(config.priority_sources, ',')) {
+            token = common::StringUtils::trim(token);
+            if (token.empty()) continue;
+            if (auto key = common::IpKey::parse(token)) {
+                priority_sources_.push_back(*key);
+            } else {
+                LOG_WARN("Ignoring invalid priority source: " + std::string(token));
+            }
+        }
+        std::sort(priority_sources_.begin(), priority_sources_.end());
+
+        if (enabled_) {
+            LOG_INFO("Overload shedding: engage at " + std::to_string(engage_permille_ / 10) +
+                     "%, severe at " + std::to_string(severe_permille_ / 10) +
+                     "%, release at " + std::to_string(release_permille_ / 10) + "%, " +
+                     std::to_string(priority_sources_.size()) + " priority sources");
+        }
+    }
+
+    // =========================================================
+    // Level (Hysteresis)
+    // =========================================================
+    uint8_t OverloadController::update_level(uint32_t fill) {
+        const uint8_t level = level_.load(std::memory_order_relaxed);
+        if (!enabled_) return 0;
+
+        uint8_t next;
+        if (fill >= severe_permille_) {
+            next = 2;
+        } else if (fill >= engage_permille_) {
+            next = level == 2 ? 2 : 1;        // Severe holds until below engage
+        } else if (fill >= release_permille_) {
+            next = level == 0 ? 0 : 1;        // Engaged holds until below release
+        } else {
+            next = 0;
+        }
+
+        if (next != level) {
+            level_.store(next, std::memory_order_relaxed);
+            const std::string at = " (queue fill " + std::to_string(fill / 10) + "%)";
+            if (next == 0) {
+                LOG_INFO("Overload cleared, sampling off" + at);
+            } else {
+                LOG_WARN("Overload level " + std::to_string(next) + ", sampling low-priority events" + at);
+            }
+        }
+        return next;
+    }
+
+    // =========================================================
+    // Classification
+    // =========================================================
+    int OverloadController::parse_pri(const char* data, size_t len) {
+        if (len < 3 || data[0] != '<') return -1;
+
+        int pri = 0;
+        size_t i = 1;
+        for (; i < len && i <= 3; ++i) {
+            const char c = data[i];
+            if (c < '0' || c > '9') break;
+            pri = pri * 10 + (c - '0');
+        }
+        if (i == 1 || i >= len || data[i] != '>' || pri > 191) return -1;
+        return pri;
+    }
+
+    TrafficClass OverloadController::classify(const char* data, size_t len, const common::IpKey* source) const {
+        TrafficClass cls = TrafficClass::Normal;
+
+        const int pri = parse_pri(data, len);
+        if (pri >= 0) {
+            const int severity = pri & 7;
+            const int facility = pri >> 3;
+            if (severity <= SEVERITY_ERR) return TrafficClass::Critical;
+
+            if (severity == SEVERITY_DEBUG) {
+                cls = TrafficClass::Low;
+            } else if (severity == SEVERITY_WARNING || facility == FACILITY_AUTH ||
+                       facility == FACILITY_AUTHPRIV || facility == FACILITY_AUDIT ||
+                       facility == FACILITY_ALERT) {
+                cls = TrafficClass::High;
+            }
+        }
+
+        if (source) {
+            if (recently_alerted(*source)) return TrafficClass::Critical;
+            if (cls != TrafficClass::High && !priority_sources_.empty() &&
+                std::binary_search(priority_sources_.begin(), priority_sources_.end(), *source)) {
+                cls = TrafficClass::High;
+            }
+        }
+        return cls;
+    }
+
+    const char* OverloadController::class_name(TrafficClass cls) {
+        switch (cls) {
+            case TrafficClass::Critical: return "critical";
+            case TrafficClass::High:     return "high";
+            case TrafficClass::Normal:   return "normal";
+            case TrafficClass::Low:      return "low";
+            default:                     return "unknown";
+        }
+    }
+
+    // =========================================================
+    // Sampling
+    // =========================================================
+    OverloadController::Admission OverloadController::sample(TrafficClass cls, uint8_t level) {
+        auto& counters = counters_[index(cls)];
+
+        uint32_t every = keep_every_[index(cls)];
+        if (level >= 2 && cls != TrafficClass::Critical) every *= severe_factor_;
+        if (every <= 1) return {true, 1};
+
+        // Deterministic 1-in-N: the kept event stands for the N-1 shed ones
+        if (counters.seen.fetch_add(1, std::memory_order_relaxed) % every == 0) return {true, every};
+
+        counters.shed.fetch_add(1, std::memory_order_relaxed);
+        return {false, 0};
+    }
+
+    void OverloadController::count_dropped(const char* data, size_t len, const common::IpKey* source) {
+        counters_[index(classify(data, len, source))].dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // =========================================================
+    // Recent Alert History
+    // =========================================================
+    void OverloadController::note_alert(const common::IpKey& source) {
+        const uint64_t h = common::IpKeyHash{}(source);
+        const uint64_t tag = h & 0xFFFFFFFF00000000ull;
+        // Newest alert wins the slot; a displaced source only loses its boost
+        hot_[h & (HOT_SLOTS - 1)].store(tag | (now_sec() + hot_ttl_sec_), std::memory_order_relaxed);
+    }
+
+    bool OverloadController::recently_alerted(const common::IpKey& source) const {
+        const uint64_t h = common::IpKeyHash{}(source);
+        const uint64_t entry = hot_[h & (HOT_SLOTS - 1)].load(std::memory_order_relaxed);
+        if (entry == 0 || (entry & 0xFFFFFFFF00000000ull) != (h & 0xFFFFFFFF00000000ull)) return false;
+        return static_cast<uint32_t>(entry) > now_sec();
+    }
+
+} // namespace blackbox::ingest
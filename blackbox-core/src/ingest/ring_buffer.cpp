@@ -13,17 +13,18 @@ namespace blackbox::ingest {
     // Constructor
     // =========================================================
     template <size_t Capacity>
-    RingBuffer<Capacity>::RingBuffer() : head_(0), tail_(0) {
-        // Pre-allocate memory on startup. 
+    RingBuffer<Capacity>::RingBuffer(const common::MemoryPolicy& memory)
+        : buffer_(Capacity, memory, "Ingest ring"), head_(0), tail_(0)
+    {
+        // Mapped (and by default pre-faulted) on startup.
         // This prevents lag spikes during runtime.
-        buffer_.resize(Capacity);
     }
 
     // =========================================================
     // Push (Producer)
     // =========================================================
     template <size_t Capacity>
-    bool RingBuffer<Capacity>::push(const char* data, size_t len) {
+    bool RingBuffer<Capacity>::push(const char* data, size_t len, uint32_t sample_weight) {
         const size_t current_head = head_.load(std::memory_order_relaxed);
         const size_t next_head = (current_head + 1) % Capacity;
 
@@ -34,21 +35,54 @@ namespace blackbox::ingest {
         }
 
         // Write Data
-        LogEvent& slot = buffer_[current_head];
-        slot.timestamp_ns = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-        
-        // Safety cap on size
-        slot.length = (len > 4096) ? 4096 : len;
-        
-        // Fast memory copy
-        std::memcpy(slot.raw_data, data, slot.length);
+        write_slot(buffer_[current_head], data, len, sample_weight,
+                   std::chrono::high_resolution_clock::now().time_since_epoch().count());
 
         // Commit the write
         // release: ensures the data write (memcpy) is visible before we update 'head'
         head_.store(next_head, std::memory_order_release);
+
+        // Syscall only if the consumer went to sleep
+        parker_.notify();
         return true;
     }
 
+    template <size_t Capacity>
+    size_t RingBuffer<Capacity>::push_batch(const RawMessage* messages, size_t count) {
+        const size_t current_head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+
+        // One slot stays empty to tell full from empty
+        const size_t free_slots = (tail + Capacity - current_head - 1) % Capacity;
+        const size_t n = count < free_slots ? count : free_slots;
+        if (n == 0) return 0;
+
+        // Same arrival time for the whole read
+        const uint64_t now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        for (size_t i = 0; i < n; ++i) {
+            const RawMessage& msg = messages[i];
+            write_slot(buffer_[(current_head + i) % Capacity], msg.data, msg.length, msg.sample_weight, now);
+        }
+
+        // Publish all of them with a single release store
+        head_.store((current_head + n) % Capacity, std::memory_order_release);
+        parker_.notify();
+        return n;
+    }
+
+    template <size_t Capacity>
+    void RingBuffer<Capacity>::write_slot(LogEvent& slot, const char* data, size_t len,
+                                          uint32_t sample_weight, uint64_t timestamp_ns) {
+        slot.timestamp_ns = timestamp_ns;
+
+        // Safety cap on size
+        slot.length = (len > sizeof(slot.raw_data)) ? sizeof(slot.raw_data) : len;
+        slot.sample_weight = sample_weight;
+
+        // Fast memory copy
+        std::memcpy(slot.raw_data, data, slot.length);
+    }
+
     // =========================================================
     // Pop (Consumer)
     // =========================================================
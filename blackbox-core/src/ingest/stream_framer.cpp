@@ -0,0 +1,136 @@
+/**
+ * @file stream_framer.cpp
+ * @brief Implementation of RFC 6587 Stream Framing.
+ */
+
+#include "blackbox/ingest/stream_framer.h"
+#include "blackbox/common/metrics.h"
+#include <algorithm>
+#include <cstring>
+
+namespace blackbox::ingest {
+
+    namespace {
+        // MSG-LEN above 999,999,999 is not a length but text
+        constexpr uint32_t MAX_LENGTH_DIGITS = 9;
+
+        inline bool is_digit(char c) {
+            return c >= '0' && c <= '9';
+        }
+    }
+
+    void StreamFramer::append_carry(const char* data, size_t len) {
+        const size_t room = MAX_FRAME - carry_len_;
+        if (len > room) {
+            carry_truncated_ = true;
+            len = room;
+        }
+        std::memcpy(carry_ + carry_len_, data, len);
+        carry_len_ += len;
+    }
+
+    size_t StreamFramer::extract(const char*& cursor, const char* end, RawMessage* frames, size_t max_frames) {
+        const char* p = cursor;
+        size_t n = 0;
+        bool carry_out = false;   // A returned frame points into carry_: no appends until the next call
+
+        auto emit = [&](const char* data, size_t len, bool line) {
+            if (line && len > 0 && data[len - 1] == '\r') --len;
+            if (len == 0) return;                   // Blank lines, trailers after counted frames
+            if (len > MAX_FRAME) {
+                common::Metrics::instance().inc_tcp_frames_truncated(1);
+                len = MAX_FRAME;
+            }
+            frames[n++] = {data, len, 1};
+        };
+
+        auto emit_carry = [&](bool line) {
+            if (carry_truncated_) common::Metrics::instance().inc_tcp_frames_truncated(1);
+            const size_t before = n;
+            emit(carry_, carry_len_, line);
+            carry_out = n > before;
+            carry_len_ = 0;
+            carry_truncated_ = false;
+        };
+
+        while (p < end && n < max_frames) {
+            if (state_ == State::FrameStart) {
+                if (*p >= '1' && *p <= '9') {
+                    state_ = State::Length;
+                    length_ = 0;
+                    digits_ = 0;
+                } else {
+                    state_ = State::Line;
+                }
+            }
+
+            if (state_ == State::Length) {
+                // The digits go to the carry too, in case they turn out to be text
+                if (carry_out) break;
+                const char* digits = p;
+                while (p < end && digits_ < MAX_LENGTH_DIGITS && is_digit(*p)) {
+                    length_ = length_ * 10 + static_cast<size_t>(*p - '0');
+                    ++digits_;
+                    ++p;
+                }
+                append_carry(digits, static_cast<size_t>(p - digits));
+                if (p == end) break;                // Header continues in the next read
+
+                if (*p == ' ') {
+                    ++p;
+                    carry_len_ = 0;
+                    remaining_ = length_;
+                    state_ = remaining_ > 0 ? State::Counted : State::FrameStart;
+                } else {
+                    state_ = State::Line;           // Not a length: a line that starts with digits
+                }
+                continue;
+            }
+
+            if (state_ == State::Counted) {
+                const size_t avail = static_cast<size_t>(end - p);
+                if (carry_len_ == 0 && remaining_ <= avail) {
+                    // Whole frame in this read: no copy
+                    emit(p, remaining_, false);
+                    p += remaining_;
+                    remaining_ = 0;
+                    state_ = State::FrameStart;
+                    continue;
+                }
+
+                if (carry_out) break;
+                const size_t take = std::min(remaining_, avail);
+                append_carry(p, take);
+                p += take;
+                remaining_ -= take;
+                if (remaining_ == 0) {
+                    emit_carry(false);
+                    state_ = State::FrameStart;
+                }
+                continue;
+            }
+
+            // State::Line: glibc memchr scans 32/64 bytes per step (AVX2/EVEX)
+            const auto* newline = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!newline) {
+                if (carry_out) break;
+                append_carry(p, static_cast<size_t>(end - p));
+                p = end;
+                break;
+            }
+
+            if (carry_len_ == 0) {
+                emit(p, static_cast<size_t>(newline - p), true);
+            } else {
+                append_carry(p, static_cast<size_t>(newline - p));
+                emit_carry(true);
+            }
+            p = newline + 1;
+            state_ = State::FrameStart;
+        }
+
+        cursor = p;
+        return n;
+    }
+
+} // namespace blackbox::ingest
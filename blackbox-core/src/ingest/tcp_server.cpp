@@ -6,9 +6,10 @@
 #include "blackbox/ingest/tcp_server.h"
 #include "blackbox/common/logger.h"
 #include "blackbox/common/metrics.h"
+#include "blackbox/ingest/ban_filter.h"
+#include "blackbox/ingest/overload_controller.h"
 #include "blackbox/ingest/rate_limiter.h"
 #include <iostream>
-#include <string_view>
 
 namespace blackbox::ingest {
 
@@ -35,14 +36,25 @@ namespace blackbox::ingest {
         acceptor_.async_accept(
             [this](boost::system::error_code ec, tcp::socket socket) {
                 if (!ec) {
+                    const auto endpoint = socket.remote_endpoint();
+                    const auto source = common::IpKey::from_sockaddr(endpoint.data());
+
+                    // Banned sources are closed before anything else
+                    if (source && BanFilter::instance().contains(*source)) {
+                        common::Metrics::instance().inc_packets_banned(1);
+                        socket.close();
+                        start_accept();
+                        return;
+                    }
+
                     // Check Rate Limit (Connection Throttling)
-                    std::string ip = socket.remote_endpoint().address().to_string();
+                    std::string ip = endpoint.address().to_string();
                     if (!RateLimiter::instance().should_allow(ip)) {
                         LOG_WARN("TCP Connection rejected (Rate Limit): " + ip);
                         socket.close();
                     } else {
                         // Create Session and Start
-                        std::make_shared<TcpSession>(std::move(socket), ring_buffer_)->start();
+                        std::make_shared<TcpSession>(std::move(socket), source, ring_buffer_)->start();
                     }
                 } else {
                     LOG_ERROR("TCP Accept Error: " + ec.message());
@@ -58,11 +70,10 @@ namespace blackbox::ingest {
     // TCP SESSION Implementation
     // =========================================================
 
-    TcpSession::TcpSession(tcp::socket socket, RingBuffer<65536>& buffer)
-        : socket_(std::move(socket)), ring_buffer_(buffer)
+    TcpSession::TcpSession(tcp::socket socket, std::optional<common::IpKey> peer,
+                           RingBuffer<65536>& buffer)
+        : socket_(std::move(socket)), peer_(peer), ring_buffer_(buffer)
     {
-        // Reserve memory for sticky buffer to prevent reallocs
-        sticky_buffer_.reserve(4096);
     }
 
     void TcpSession::start() {
@@ -75,6 +86,14 @@ namespace blackbox::ingest {
         socket_.async_read_some(boost::asio::buffer(data_, max_length),
             [this, self](boost::system::error_code ec, std::size_t length) {
                 if (!ec) {
+                    // Source banned while connected: hang up, drop the chunk
+                    if (peer_ && BanFilter::instance().contains(*peer_)) {
+                        common::Metrics::instance().inc_packets_banned(1);
+                        boost::system::error_code ignored;
+                        socket_.close(ignored);
+                        return;
+                    }
+
                     // Process Data
                     common::Metrics::instance().inc_packets_received(1); // Count chunks
                     process_buffer(length);
@@ -89,53 +108,40 @@ namespace blackbox::ingest {
     }
 
     void TcpSession::process_buffer(size_t bytes_transferred) {
-        // Create a view over the new data
-        std::string_view chunk(data_, bytes_transferred);
-
-        size_t start_pos = 0;
-
-        // Find newlines
-        while (true) {
-            size_t newline_pos = chunk.find('\n', start_pos);
-
-            if (newline_pos == std::string_view::npos) {
-                // No more newlines.
-                // Append remaining data to sticky buffer for next packet.
-                sticky_buffer_.append(chunk.substr(start_pos));
-
-                // Safety: Prevent memory exhaustion if client never sends \n
-                if (sticky_buffer_.size() > 8192) {
-                    LOG_WARN("TCP message too large without newline. Dropping buffer.");
-                    sticky_buffer_.clear();
-                }
-                break;
-            }
-
-            // We found a complete message
-            size_t msg_len = newline_pos - start_pos;
-
-            // 1. Combine sticky buffer + current chunk part
-            // Optimization: If sticky_buffer is empty, we can zero-copy push directly from 'data_'
-            if (sticky_buffer_.empty()) {
-                // Direct Push
-                const char* log_ptr = data_ + start_pos;
-                if (!ring_buffer_.push(log_ptr, msg_len)) {
-                    common::Metrics::instance().inc_packets_dropped(1);
-                }
-            } else {
-                // Stitch together
-                sticky_buffer_.append(chunk.substr(start_pos, msg_len));
+        const char* cursor = data_;
+        const char* const end = data_ + bytes_transferred;
+
+        // Frames of a whole read, pushed together
+        RawMessage frames[FRAME_BATCH];
+        while (cursor < end) {
+            const size_t count = framer_.extract(cursor, end, frames, FRAME_BATCH);
+            if (count > 0) push_frames(frames, count);
+        }
+    }
 
-                if (!ring_buffer_.push(sticky_buffer_.data(), sticky_buffer_.size())) {
-                    common::Metrics::instance().inc_packets_dropped(1);
-                }
+    void TcpSession::push_frames(RawMessage* frames, size_t count) {
+        // Near capacity: sample by priority (see OverloadController)
+        const common::IpKey* source = peer_ ? &*peer_ : nullptr;
+        auto& overload = OverloadController::instance();
+        const double fill = static_cast<double>(ring_buffer_.size()) / static_cast<double>(ring_buffer_.capacity());
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const auto admission = overload.admit(frames[i].data, frames[i].length, source, fill);
+            if (!admission.keep) continue;
+            frames[kept] = frames[i];
+            frames[kept].sample_weight = admission.weight;
+            ++kept;
+        }
 
-                sticky_buffer_.clear();
+        const size_t pushed = ring_buffer_.push_batch(frames, kept);
+        if (pushed < kept) {
+            common::Metrics::instance().inc_packets_dropped(kept - pushed);
+            common::Metrics::instance().inc_ingest_backpressure(kept - pushed);
+            for (size_t i = pushed; i < kept; ++i) {
+                overload.count_dropped(frames[i].data, frames[i].length, source);
             }
-
-            // Move cursor past the newline
-            start_pos = newline_pos + 1;
         }
     }
 
-} // namespace blackbox::ingest
\ No newline at end of file
+} // namespace blackbox::ingest
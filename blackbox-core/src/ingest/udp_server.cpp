@@ -7,6 +7,8 @@
 #include "blackbox/common/settings.h"
 #include "blackbox/common/logger.h"
 #include "blackbox/common/metrics.h"
+#include "blackbox/ingest/ban_filter.h"
+#include "blackbox/ingest/overload_controller.h"
 #include "blackbox/ingest/rate_limiter.h"
 #include <iostream>
 
@@ -25,10 +27,17 @@ namespace blackbox::ingest {
         LOG_INFO("UDP Server listening on port: " + 
                  std::to_string(common::Settings::instance().network().udp_port));
         
+        // Kernel-side drop of short IPv4 ban lists (if enabled)
+        BanFilter::instance().attach_socket(socket_.native_handle());
+
         // Start the infinite loop
         start_receive();
     }
 
+    UdpServer::~UdpServer() {
+        BanFilter::instance().detach_socket(socket_.native_handle());
+    }
+
     // =========================================================
     // Start Receive
     // =========================================================
@@ -53,7 +62,16 @@ namespace blackbox::ingest {
             // 1. METRICS: Count raw packet
             common::Metrics::instance().inc_packets_received(1);
 
-            // 2. SECURITY: Rate Limit Check
+            // 2. SECURITY: Banned source? Checked on the binary address,
+            // before any string conversion or copy.
+            const auto source = common::IpKey::from_sockaddr(remote_endpoint_.data());
+            if (source && BanFilter::instance().contains(*source)) {
+                common::Metrics::instance().inc_packets_banned(1);
+                start_receive();
+                return;
+            }
+
+            // 3. SECURITY: Rate Limit Check
             // We must convert address to string (allocating memory), 
             // but RateLimiter requires the IP key.
             // Optimization Note: In v2.0, use a raw uint32_t IP for RateLimiter to avoid string alloc.
@@ -68,13 +86,27 @@ namespace blackbox::ingest {
                 return; 
             }
 
-            // 3. STORAGE: Push to Lock-Free Buffer
+            // 4. OVERLOAD: Near capacity, sample by priority instead of
+            // letting the ring drop whatever comes next
+            const common::IpKey* source_key = source ? &*source : nullptr;
+            auto& overload = OverloadController::instance();
+            const auto admission = overload.admit(
+                recv_buffer_.data(), bytes_transferred, source_key,
+                static_cast<double>(ring_buffer_.size()) / static_cast<double>(ring_buffer_.capacity()));
+            if (!admission.keep) {
+                start_receive();
+                return;
+            }
+
+            // 5. STORAGE: Push to Lock-Free Buffer
             // We pass the raw pointer and length. formatting happens in the Parser thread.
-            bool success = ring_buffer_.push(recv_buffer_.data(), bytes_transferred);
+            bool success = ring_buffer_.push(recv_buffer_.data(), bytes_transferred, admission.weight);
 
             if (!success) {
-                // Buffer Full -> Drop Packet
+                // Buffer Full -> Drop Packet (the pipeline is pushing back)
                 common::Metrics::instance().inc_packets_dropped(1);
+                common::Metrics::instance().inc_ingest_backpressure(1);
+                overload.count_dropped(recv_buffer_.data(), bytes_transferred, source_key);
                 
                 // Optional: Warn if this happens too often (handled by Metrics Reporter)
             }
@@ -83,7 +115,7 @@ namespace blackbox::ingest {
             LOG_ERROR("UDP Receive Error: " + error.message());
         }
 
-        // 4. LOOP: Re-arm listener
+        // 6. LOOP: Re-arm listener
         start_receive();
     }
 
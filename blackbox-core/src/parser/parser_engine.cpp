@@ -8,6 +8,7 @@
 #include "blackbox/common/string_utils.h"
 #include "blackbox/common/settings.h"
 #include "blackbox/common/logger.h"
+#include "blackbox/common/profiler.h"
 #include <cstring>
 
 namespace blackbox::parser {
@@ -55,11 +56,13 @@ namespace blackbox::parser {
     // Process (The Hot Path)
     // =========================================================
     ParsedLog ParserEngine::process(const ingest::LogEvent& raw_event) {
+        BB_PROFILE_ZONE("parser.process");
         ParsedLog output;
 
         // 1. Assign Metadata
-        output.id = common::IdGenerator::generate_uuid_v4();
+        output.id = common::IdGenerator::generate(raw_event.timestamp_ns);
         output.timestamp = raw_event.timestamp_ns;
+        output.sample_weight = raw_event.sample_weight;
 
         // 2. Create View over raw buffer
         std::string_view cursor(raw_event.raw_data, raw_event.length);
@@ -4,21 +4,68 @@
  */
 
 #include "blackbox/storage/clickhouse_client.h"
+#include "blackbox/common/id_generator.h"
 #include "blackbox/common/logger.h"
-#include "blackbox/common/string_utils.h"
 #include "blackbox/common/time_utils.h"
-#include "blackbox/common/metrics.h"
-#include <iostream>
-#include <sstream>
+#include <algorithm>
+#include <charconv>
 #include <curl/curl.h>
 
 namespace blackbox::storage {
 
+    // =========================================================
+    // Helper: Per-Thread CURL Handle
+    // =========================================================
+    // Every sender thread keeps its own easy handle so the TCP
+    // connection to ClickHouse stays alive between batches.
+    namespace {
+        struct CurlHandle {
+            CURL* curl = curl_easy_init();
+            ~CurlHandle() { if (curl) curl_easy_cleanup(curl); }
+        };
+
+        // INSERT responses carry no payload on success; on error the body is
+        // ClickHouse's exception text, of which the start is kept for the log
+        constexpr size_t ERROR_HEAD = 256;
+
+        size_t keep_response_head(char* data, size_t size, size_t nmemb, void* userdata) {
+            auto* head = static_cast<std::string*>(userdata);
+            const size_t len = size * nmemb;
+            if (head->size() < ERROR_HEAD) head->append(data, std::min(len, ERROR_HEAD - head->size()));
+            return len;
+        }
+
+        // Transport errors, 5xx, 408 and 429 clear up on their own; any other
+        // 4xx is about the query itself and fails the same way every time
+        bool is_transient(long response_code) {
+            return response_code < 400 || response_code >= 500 ||
+                   response_code == 408 || response_code == 429;
+        }
+
+        // Escape Strings (same rules as StringUtils::escape_sql, but
+        // appends in place instead of allocating a temporary)
+        void append_escaped(std::string& out, std::string_view str) {
+            for (char c : str) {
+                switch (c) {
+                    case '\'': out += "\\'"; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\b': out += "\\b"; break;
+                    case '\f': out += "\\f"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\t': out += "\\t"; break;
+                    case '\0': out += "\\0"; break;
+                    default:   out += c; break;
+                }
+            }
+        }
+    }
+
     // =========================================================
     // Constructor
     // =========================================================
-    ClickHouseClient::ClickHouseClient(std::string host) 
-        : host_(std::move(host)) 
+    ClickHouseClient::ClickHouseClient(std::string host)
+        : host_(std::move(host))
     {
         // Global init should theoretically happen once in main,
         // but it's safe to call multiple times if handled carefully.
@@ -29,88 +76,112 @@ namespace blackbox::storage {
         curl_global_cleanup();
     }
 
+    // =========================================================
+    // SQL Construction
+    // =========================================================
+    void ClickHouseClient::begin_insert(std::string& out) {
+        // Table: sentry.logs
+        out += "INSERT INTO sentry.logs (id, timestamp, host, country, service, message, anomaly_score, is_threat, sample_weight) VALUES ";
+    }
+
+    void ClickHouseClient::append_row(std::string& out, const DBRow& row, bool first) {
+        if (!first) out += ',';
+
+        out += "('";
+        const size_t id_pos = out.size();                           // UUID
+        out.resize(id_pos + common::Uuid::TEXT_LENGTH);
+        common::IdGenerator::format(row.id, out.data() + id_pos);
+        out += "', '";
+        const size_t ts_pos = out.size();                           // DateTime64(3)
+        out.resize(ts_pos + common::TimeUtils::CLICKHOUSE_MS_LENGTH);
+        common::TimeUtils::format_clickhouse_ms(row.timestamp / 1000000, out.data() + ts_pos);
+        out += "', '";
+        append_escaped(out, row.host);                              // Host/IP
+        out += "', '";
+        append_escaped(out, row.country);                           // Country Code
+        out += "', '";
+        append_escaped(out, row.service);                           // Service
+        out += "', '";
+        append_escaped(out, row.message);                           // Message
+        out += "', ";
+
+        char num[32];
+        auto res = std::to_chars(num, num + sizeof(num), row.anomaly_score); // Float32
+        out.append(num, res.ptr);
+
+        out += row.is_alert ? ", 1, " : ", 0, ";                    // UInt8
+
+        res = std::to_chars(num, num + sizeof(num), row.sample_weight); // UInt32
+        out.append(num, res.ptr);
+        out += ')';
+    }
+
     // =========================================================
     // Insert Logs
     // =========================================================
     bool ClickHouseClient::insert_logs(const std::vector<DBRow>& rows) {
         if (rows.empty()) return true;
 
-        // 1. Construct SQL
-        // Table: sentry.logs
-        std::stringstream sql;
-        sql << "INSERT INTO sentry.logs (id, timestamp, host, country, service, message, anomaly_score, is_threat) VALUES ";
+        std::string query_data;
+        query_data.reserve(rows.size() * 256);
 
+        begin_insert(query_data);
         bool first = true;
         for (const auto& row : rows) {
-            if (!first) sql << ",";
+            append_row(query_data, row, first);
             first = false;
-
-            // Format Timestamp (ns -> YYYY-MM-DD HH:MM:SS)
-            // Note: DBRow timestamp is uint64 ns. TimeUtils expects ms.
-            std::string time_str = common::TimeUtils::to_clickhouse_format(row.timestamp / 1000000);
-
-            // Escape Strings
-            std::string safe_host = common::StringUtils::escape_sql(row.host);
-            std::string safe_country = common::StringUtils::escape_sql(row.country);
-            std::string safe_service = common::StringUtils::escape_sql(row.service);
-            std::string safe_msg = common::StringUtils::escape_sql(row.message);
-
-            sql << "("
-                << "'" << row.id << "', "                 // UUID
-                << "'" << time_str << "', "               // DateTime
-                << "'" << safe_host << "', "              // Host/IP
-                << "'" << safe_country << "', "           // Country Code
-                << "'" << safe_service << "', "           // Service
-                << "'" << safe_msg << "', "               // Message
-                << row.anomaly_score << ", "              // Float
-                << (row.is_alert ? 1 : 0)                 // UInt8
-                << ")";
         }
 
-        std::string query_data = sql.str();
+        return execute(query_data) == WriteResult::Ok;
+    }
 
-        // 2. Setup CURL
-        CURL* curl = curl_easy_init();
+    // =========================================================
+    // Execute (HTTP POST)
+    // =========================================================
+    WriteResult ClickHouseClient::execute(std::string_view query) {
+        static thread_local CurlHandle handle;
+        static thread_local std::string response_head;
+        CURL* curl = handle.curl;
         if (!curl) {
-            common::Metrics::instance().inc_db_errors(1);
-            return false;
+            LOG_ERROR("DB Write Failed: could not allocate CURL handle.");
+            return WriteResult::Retry;
         }
 
-        struct curl_slist* headers = nullptr;
-        // Optional: headers = curl_slist_append(headers, "Content-Type: text/plain");
-
+        response_head.clear();
+        curl_easy_reset(curl);
         curl_easy_setopt(curl, CURLOPT_URL, host_.c_str());
         curl_easy_setopt(curl, CURLOPT_POST, 1L);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, query_data.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, query_data.size());
-
-        // Fast Timeout (Prevent pipeline stall)
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, query.data());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(query.size()));
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L); // Required for multi-threaded use
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, keep_response_head);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_head);
+
+        // Fast Timeout (Prevent sender stall; retries are handled by StorageEngine)
         curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, 2000L);
 
-        // 3. Execute
+        // Execute
         CURLcode res = curl_easy_perform(curl);
         long response_code = 0;
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
 
-        bool success = true;
+        if (res == CURLE_OK && response_code == 200) {
+            return WriteResult::Ok;
+        }
 
-        if (res != CURLE_OK || response_code != 200) {
+        if (res != CURLE_OK || is_transient(response_code)) {
             LOG_ERROR("DB Write Failed. CURL Code: " + std::to_string(res) +
                       " HTTP: " + std::to_string(response_code));
 
             // Log the beginning of the query for debugging (truncated)
-            LOG_DEBUG("Failed Query Start: " + query_data.substr(0, 100));
-
-            common::Metrics::instance().inc_db_errors(1);
-            success = false;
-        } else {
-            // Success
-            // common::Metrics::instance().inc_db_rows_written(rows.size());
-            // ^ handled in StorageEngine usually, but can be here too.
+            LOG_DEBUG("Failed Query Start: " + std::string(query.substr(0, 100)));
+            return WriteResult::Retry;
         }
 
-        curl_easy_cleanup(curl);
-        return success;
+        LOG_ERROR("DB Write Rejected. HTTP: " + std::to_string(response_code) + " " + response_head);
+        LOG_DEBUG("Rejected Query Start: " + std::string(query.substr(0, 100)));
+        return WriteResult::Rejected;
     }
 
-} // namespace blackbox::storage
\ No newline at end of file
+} // namespace blackbox::storage
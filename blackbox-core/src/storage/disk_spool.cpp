@@ -0,0 +1,461 @@
+/**
+ * @file disk_spool.cpp
+ * @brief Implementation of the Segmented On-Disk Spool.
+ */
+
+#include "blackbox/storage/disk_spool.h"
+#include "blackbox/common/logger.h"
+#include "blackbox/common/time_utils.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace blackbox::storage {
+
+    namespace {
+
+        constexpr size_t BLOCK = 4096;                       // O_DIRECT alignment
+        constexpr uint64_t SEGMENT_MAGIC = 0x314C4F4F50534242ull; // "BBSPOOL1"
+        constexpr uint32_t RECORD_MAGIC = 0x44524342u;       // "BCRD"
+        constexpr uint32_t FORMAT_VERSION = 1;
+
+        struct SegmentHeader {
+            uint64_t magic;
+            uint32_t version;
+            uint32_t header_crc;   // CRC32C of the fields below
+            uint64_t seq;
+            uint64_t created_ms;
+        };
+
+        struct RecordHeader {
+            uint32_t magic;
+            uint32_t payload_crc;  // CRC32C of the payload bytes
+            uint32_t payload_bytes;
+            uint32_t rows;
+            uint64_t created_ms;
+            uint64_t reserved;
+        };
+        static_assert(sizeof(RecordHeader) == 32);
+
+        size_t round_up(size_t n) { return (n + BLOCK - 1) & ~(BLOCK - 1); }
+
+        // =========================================================
+        // CRC32C (Castagnoli)
+        // =========================================================
+        // Uses the SSE4.2 instruction when -march=native provides it.
+        uint32_t crc32c(const void* data, size_t len) {
+            const auto* p = static_cast<const unsigned char*>(data);
+            uint32_t crc = 0xFFFFFFFFu;
+#if defined(__SSE4_2__)
+            uint64_t crc64 = crc;
+            while (len >= 8) {
+                uint64_t v;
+                std::memcpy(&v, p, 8);
+                crc64 = _mm_crc32_u64(crc64, v);
+                p += 8;
+                len -= 8;
+            }
+            crc = static_cast<uint32_t>(crc64);
+            while (len--) crc = _mm_crc32_u8(crc, *p++);
+#else
+            static const auto table = [] {
+                std::array<uint32_t, 256> t{};
+                for (uint32_t i = 0; i < 256; ++i) {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; ++k) c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+                    t[i] = c;
+                }
+                return t;
+            }();
+            while (len--) crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+#endif
+            return crc ^ 0xFFFFFFFFu;
+        }
+
+        uint32_t segment_header_crc(const SegmentHeader& h) {
+            return crc32c(&h.seq, sizeof(h.seq) + sizeof(h.created_ms));
+        }
+
+        bool read_exact(int fd, void* buf, size_t len, uint64_t offset) {
+            auto* out = static_cast<char*>(buf);
+            while (len > 0) {
+                ssize_t n = ::pread(fd, out, len, static_cast<off_t>(offset));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                out += n;
+                len -= static_cast<size_t>(n);
+                offset += static_cast<uint64_t>(n);
+            }
+            return true;
+        }
+
+        bool write_exact(int fd, const char* buf, size_t len, uint64_t offset) {
+            while (len > 0) {
+                ssize_t n = ::pwrite(fd, buf, len, static_cast<off_t>(offset));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                buf += n;
+                len -= static_cast<size_t>(n);
+                offset += static_cast<uint64_t>(n);
+            }
+            return true;
+        }
+
+        // Prefer O_DIRECT (no page-cache pollution); tmpfs and some
+        // overlay filesystems reject it, so fall back to buffered I/O.
+        int open_for_append(const std::string& path) {
+            int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | O_DIRECT, 0640);
+            if (fd < 0 && errno == EINVAL) {
+                fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0640);
+            }
+            return fd;
+        }
+
+        bool read_record_header(const std::string& path, uint64_t offset, RecordHeader& out) {
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return false;
+            bool ok = read_exact(fd, &out, sizeof(out), offset) && out.magic == RECORD_MAGIC;
+            ::close(fd);
+            return ok;
+        }
+
+    } // namespace
+
+    // =========================================================
+    // Constructor
+    // =========================================================
+    DiskSpool::DiskSpool(std::string dir, uint64_t max_bytes, uint64_t segment_bytes)
+        : dir_(std::move(dir)),
+          max_bytes_(max_bytes),
+          segment_bytes_(std::max<uint64_t>(segment_bytes, 2 * BLOCK))
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(dir_, ec);
+        if (ec) {
+            // Graceful degradation: run without a spool (old drop behaviour)
+            LOG_ERROR("Disk spool disabled, cannot create " + dir_ + ": " + ec.message());
+            return;
+        }
+
+        recover();
+        ready_ = true;
+
+        if (!segments_.empty()) {
+            LOG_WARN("Disk spool recovered " + std::to_string(segments_.size()) + " segment(s), " +
+                     std::to_string(total_rows_) + " rows pending replay.");
+        }
+    }
+
+    DiskSpool::~DiskSpool() {
+        if (active_fd_ >= 0) {
+            ::fdatasync(active_fd_);
+            ::close(active_fd_);
+        }
+        std::free(write_buffer_);
+    }
+
+    std::string DiskSpool::segment_path(uint64_t seq) const {
+        char name[48];
+        std::snprintf(name, sizeof(name), "segment-%020llu.spool",
+                      static_cast<unsigned long long>(seq));
+        return dir_ + "/" + name;
+    }
+
+    // =========================================================
+    // Recovery (Startup)
+    // =========================================================
+    void DiskSpool::recover() {
+        std::vector<Segment> found;
+
+        for (const auto& entry : std::filesystem::directory_iterator(dir_)) {
+            const std::string name = entry.path().filename().string();
+            unsigned long long seq = 0;
+            if (std::sscanf(name.c_str(), "segment-%llu.spool", &seq) != 1) continue;
+
+            int fd = ::open(entry.path().c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) continue;
+
+            SegmentHeader header{};
+            bool valid = read_exact(fd, &header, sizeof(header), 0) &&
+                         header.magic == SEGMENT_MAGIC &&
+                         header.version == FORMAT_VERSION &&
+                         header.header_crc == segment_header_crc(header);
+
+            Segment seg;
+            seg.seq = seq;
+            seg.path = entry.path().string();
+            seg.created_ms = header.created_ms;
+            seg.sealed = true;
+
+            // Walk the record headers to find the valid end and the row count
+            uint64_t offset = BLOCK;
+            const uint64_t file_size = valid ? std::filesystem::file_size(entry.path()) : 0;
+            RecordHeader rec{};
+            while (valid && offset + sizeof(rec) <= file_size &&
+                   read_exact(fd, &rec, sizeof(rec), offset) && rec.magic == RECORD_MAGIC) {
+                uint64_t len = round_up(sizeof(rec) + rec.payload_bytes);
+                if (offset + len > file_size) break; // Torn tail
+                total_rows_ += rec.rows;
+                offset += len;
+            }
+            ::close(fd);
+
+            if (!valid || offset == BLOCK) {
+                // Empty or unreadable segment: nothing to replay
+                std::filesystem::remove(entry.path());
+                continue;
+            }
+
+            seg.size = offset;
+            total_bytes_ += offset;
+            next_seq_ = std::max<uint64_t>(next_seq_, seq + 1);
+            found.push_back(std::move(seg));
+        }
+
+        std::sort(found.begin(), found.end(),
+                  [](const Segment& a, const Segment& b) { return a.seq < b.seq; });
+        for (auto& seg : found) segments_.push_back(std::move(seg));
+
+        read_offset_ = BLOCK;
+        if (!segments_.empty()) oldest_record_ms_ = segments_.front().created_ms;
+    }
+
+    // =========================================================
+    // Segment Lifecycle
+    // =========================================================
+    bool DiskSpool::open_segment() {
+        Segment seg;
+        seg.seq = next_seq_++;
+        seg.path = segment_path(seg.seq);
+        seg.created_ms = common::TimeUtils::now_ms();
+
+        int fd = open_for_append(seg.path);
+        if (fd < 0) {
+            LOG_ERROR("Disk spool: cannot open " + seg.path + ": " + std::strerror(errno));
+            return false;
+        }
+
+        // Header occupies the whole first block
+        std::memset(write_buffer_, 0, BLOCK);
+        SegmentHeader header{};
+        header.magic = SEGMENT_MAGIC;
+        header.version = FORMAT_VERSION;
+        header.seq = seg.seq;
+        header.created_ms = seg.created_ms;
+        header.header_crc = segment_header_crc(header);
+        std::memcpy(write_buffer_, &header, sizeof(header));
+
+        if (!write_exact(fd, write_buffer_, BLOCK, 0)) {
+            LOG_ERROR("Disk spool: failed to write segment header " + seg.path);
+            ::close(fd);
+            std::filesystem::remove(seg.path);
+            return false;
+        }
+
+        seg.size = BLOCK;
+        total_bytes_ += BLOCK;
+        active_fd_ = fd;
+        if (segments_.empty()) read_offset_ = BLOCK;
+        segments_.push_back(std::move(seg));
+        return true;
+    }
+
+    void DiskSpool::seal_active() {
+        if (active_fd_ < 0) return;
+        ::fdatasync(active_fd_);
+        ::close(active_fd_);
+        active_fd_ = -1;
+        segments_.back().sealed = true;
+    }
+
+    void DiskSpool::remove_front() {
+        Segment& seg = segments_.front();
+        if (!seg.sealed) seal_active();
+
+        total_bytes_ -= std::min(total_bytes_, seg.size);
+        std::error_code ec;
+        std::filesystem::remove(seg.path, ec);
+        segments_.pop_front();
+        read_offset_ = BLOCK;
+    }
+
+    // =========================================================
+    // Append (Flush / Sender Threads)
+    // =========================================================
+    bool DiskSpool::append(std::string_view payload, uint32_t rows) {
+        if (!ready_) return false;
+
+        const size_t record_bytes = round_up(sizeof(RecordHeader) + payload.size());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (total_bytes_ + record_bytes > max_bytes_) {
+            return false; // Disk budget exhausted
+        }
+
+        // Grow the aligned scratch buffer if needed
+        if (record_bytes > write_capacity_) {
+            std::free(write_buffer_);
+            write_buffer_ = nullptr;
+            write_capacity_ = 0;
+            void* mem = nullptr;
+            if (posix_memalign(&mem, BLOCK, std::max(record_bytes, BLOCK)) != 0) {
+                LOG_ERROR("Disk spool: out of memory for a " + std::to_string(record_bytes) + " byte record");
+                return false;
+            }
+            write_buffer_ = static_cast<char*>(mem);
+            write_capacity_ = std::max(record_bytes, BLOCK);
+        }
+
+        // Rotate when the active segment would overflow
+        if (active_fd_ >= 0 && segments_.back().size + record_bytes > segment_bytes_) {
+            seal_active();
+        }
+        if (active_fd_ < 0 && !open_segment()) {
+            return false;
+        }
+
+        // Build [header | payload | zero pad]
+        RecordHeader header{};
+        header.magic = RECORD_MAGIC;
+        header.payload_crc = crc32c(payload.data(), payload.size());
+        header.payload_bytes = static_cast<uint32_t>(payload.size());
+        header.rows = rows;
+        header.created_ms = common::TimeUtils::now_ms();
+
+        std::memcpy(write_buffer_, &header, sizeof(header));
+        std::memcpy(write_buffer_ + sizeof(header), payload.data(), payload.size());
+        std::memset(write_buffer_ + sizeof(header) + payload.size(), 0,
+                    record_bytes - sizeof(header) - payload.size());
+
+        Segment& seg = segments_.back();
+        if (!write_exact(active_fd_, write_buffer_, record_bytes, seg.size) ||
+            ::fdatasync(active_fd_) != 0) {
+            LOG_ERROR("Disk spool: write failed on " + seg.path + ": " + std::strerror(errno));
+            // Do not append after a possibly torn record
+            seal_active();
+            return false;
+        }
+
+        if (total_rows_ == 0) oldest_record_ms_ = header.created_ms;
+        seg.size += record_bytes;
+        total_bytes_ += record_bytes;
+        total_rows_ += rows;
+        return true;
+    }
+
+    // =========================================================
+    // Peek / Commit (Replayer Thread)
+    // =========================================================
+    bool DiskSpool::peek(std::string& payload, uint32_t& rows) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        while (!segments_.empty()) {
+            Segment& seg = segments_.front();
+
+            if (read_offset_ >= seg.size) {
+                if (!seg.sealed) return false; // Caught up with the writer
+                remove_front();
+                continue;
+            }
+
+            int fd = ::open(seg.path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                LOG_ERROR("Disk spool: cannot reopen " + seg.path + ", skipping segment.");
+                remove_front();
+                continue;
+            }
+
+            RecordHeader header{};
+            bool ok = read_exact(fd, &header, sizeof(header), read_offset_) &&
+                      header.magic == RECORD_MAGIC;
+            if (ok) {
+                payload.resize(header.payload_bytes);
+                ok = read_exact(fd, payload.data(), header.payload_bytes, read_offset_ + sizeof(header)) &&
+                     crc32c(payload.data(), payload.size()) == header.payload_crc;
+            }
+            ::close(fd);
+
+            if (!ok) {
+                // Torn or corrupt tail: nothing after it can be trusted
+                LOG_ERROR("Disk spool: corrupt record in " + seg.path + " at offset " +
+                          std::to_string(read_offset_) + ", discarding rest of segment.");
+                if (!seg.sealed) seal_active();
+                remove_front();
+                continue;
+            }
+
+            rows = header.rows;
+            peeked_bytes_ = round_up(sizeof(header) + header.payload_bytes);
+            peeked_rows_ = header.rows;
+            oldest_record_ms_ = header.created_ms;
+            return true;
+        }
+        return false;
+    }
+
+    void DiskSpool::commit() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (peeked_bytes_ == 0 || segments_.empty()) return;
+
+        read_offset_ += peeked_bytes_;
+        total_rows_ -= std::min<uint64_t>(total_rows_, peeked_rows_);
+        peeked_bytes_ = 0;
+        peeked_rows_ = 0;
+
+        Segment& seg = segments_.front();
+        if (read_offset_ >= seg.size && seg.sealed) {
+            remove_front();
+        }
+
+        // Keep the age gauge pointing at the next undelivered record
+        if (segments_.empty() || total_rows_ == 0) {
+            oldest_record_ms_ = 0;
+        } else {
+            RecordHeader next{};
+            const Segment& front = segments_.front();
+            if (read_offset_ < front.size && read_record_header(front.path, read_offset_, next)) {
+                oldest_record_ms_ = next.created_ms;
+            } else {
+                oldest_record_ms_ = front.created_ms;
+            }
+        }
+    }
+
+    // =========================================================
+    // Gauges
+    // =========================================================
+    bool DiskSpool::empty() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_rows_ == 0;
+    }
+
+    uint64_t DiskSpool::depth_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_bytes_;
+    }
+
+    uint64_t DiskSpool::depth_rows() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_rows_;
+    }
+
+    uint64_t DiskSpool::oldest_age_ms() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (total_rows_ == 0 || oldest_record_ms_ == 0) return 0;
+        uint64_t now = common::TimeUtils::now_ms();
+        return now > oldest_record_ms_ ? now - oldest_record_ms_ : 0;
+    }
+
+} // namespace blackbox::storage
@@ -0,0 +1,506 @@
+/**
+ * @file recent_store.cpp
+ * @brief Implementation of the Recent Event Store (Columnar, Lock-Free Reads).
+ */
+
+#include "blackbox/storage/recent_store.h"
+#include "blackbox/common/json_writer.h"
+#include "blackbox/common/logger.h"
+#include "blackbox/common/profiler.h"
+#include "blackbox/common/time_utils.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace blackbox::storage {
+
+    namespace {
+
+        // FNV-1a, good enough for a few hundred hosts per segment
+        uint32_t hash_value(std::string_view value) {
+            uint32_t h = 2166136261u;
+            for (unsigned char c : value) {
+                h ^= c;
+                h *= 16777619u;
+            }
+            return h;
+        }
+
+        std::string_view truncate(std::string_view value) {
+            return value.substr(0, RecentEventStore::DICT_TEXT);
+        }
+
+        // Per-dictionary-id accumulator used while scanning one segment
+        struct SlotAgg {
+            uint64_t count = 0;
+            uint64_t alerts = 0;
+            double score_sum = 0.0;
+            float score_max = 0.0f;
+            uint64_t first_ms = UINT64_MAX;
+            uint64_t last_ms = 0;
+        };
+
+        void accumulate(RecentAggregate& agg, uint64_t ts, float score, bool alert) {
+            agg.count++;
+            agg.alerts += alert;
+            agg.score_sum += score;
+            agg.score_max = std::max(agg.score_max, score);
+            agg.first_ms = std::min(agg.first_ms, ts);
+            agg.last_ms = std::max(agg.last_ms, ts);
+        }
+
+        void merge(RecentAggregate& into, const SlotAgg& from) {
+            into.count += from.count;
+            into.alerts += from.alerts;
+            into.score_sum += from.score_sum;
+            into.score_max = std::max(into.score_max, from.score_max);
+            into.first_ms = std::min(into.first_ms, from.first_ms);
+            into.last_ms = std::max(into.last_ms, from.last_ms);
+        }
+
+        // Resolved, segment-local form of a RecentQuery
+        struct Predicate {
+            int64_t from_ms;
+            int64_t to_ms;
+            float min_score;
+            float max_score;
+            bool alerts_only;
+            int32_t host_id;     // -1 = any
+            int32_t service_id;  // -1 = any
+        };
+
+        bool match_row(const RecentEventStore::Segment& seg, size_t i, const Predicate& p) {
+            const auto ts = static_cast<int64_t>(seg.ts_ms[i]);
+            const float s = seg.score[i];
+            return ts >= p.from_ms && ts <= p.to_ms &&
+                   s >= p.min_score && s <= p.max_score &&
+                   (!p.alerts_only || seg.alert[i]) &&
+                   (p.host_id < 0 || seg.host_id[i] == p.host_id) &&
+                   (p.service_id < 0 || seg.service_id[i] == p.service_id);
+        }
+
+        /**
+         * @brief Evaluates the predicate over rows [0, n) and calls emit(i) per match.
+         * Eight rows per step with AVX2; the tail (and non-AVX2 builds) go scalar.
+         */
+        template <typename Emit>
+        void scan(const RecentEventStore::Segment& seg, size_t n, const Predicate& p, Emit&& emit) {
+            size_t i = 0;
+
+#if defined(__AVX2__)
+            const __m256i from = _mm256_set1_epi64x(p.from_ms - 1);
+            const __m256i to = _mm256_set1_epi64x(p.to_ms + 1);
+            const __m256 lo = _mm256_set1_ps(p.min_score);
+            const __m256 hi = _mm256_set1_ps(p.max_score);
+            const __m128i host = _mm_set1_epi16(static_cast<int16_t>(p.host_id));
+            const __m128i service = _mm_set1_epi16(static_cast<int16_t>(p.service_id));
+            const __m128i zero = _mm_setzero_si128();
+
+            for (; i + 8 <= n; i += 8) {
+                // Timestamps: two lanes of 4 x int64
+                const auto* ts = reinterpret_cast<const __m256i*>(&seg.ts_ms[i]);
+                __m256i t0 = _mm256_loadu_si256(ts);
+                __m256i t1 = _mm256_loadu_si256(ts + 1);
+                __m256i in0 = _mm256_and_si256(_mm256_cmpgt_epi64(t0, from), _mm256_cmpgt_epi64(to, t0));
+                __m256i in1 = _mm256_and_si256(_mm256_cmpgt_epi64(t1, from), _mm256_cmpgt_epi64(to, t1));
+                uint32_t mask = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(in0))) |
+                                (static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(in1))) << 4);
+
+                // Score range
+                __m256 s = _mm256_loadu_ps(&seg.score[i]);
+                __m256 in_range = _mm256_and_ps(_mm256_cmp_ps(s, lo, _CMP_GE_OQ), _mm256_cmp_ps(s, hi, _CMP_LE_OQ));
+                mask &= static_cast<uint32_t>(_mm256_movemask_ps(in_range));
+
+                // Dictionary ids: 8 x uint16
+                if (p.host_id >= 0) {
+                    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&seg.host_id[i]));
+                    mask &= static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(h, host), zero))) & 0xFF;
+                }
+                if (p.service_id >= 0) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&seg.service_id[i]));
+                    mask &= static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(v, service), zero))) & 0xFF;
+                }
+                if (p.alerts_only) {
+                    __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&seg.alert[i]));
+                    mask &= static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(a, zero))) & 0xFF;
+                }
+
+                while (mask) {
+                    emit(i + static_cast<size_t>(std::countr_zero(mask)));
+                    mask &= mask - 1;
+                }
+            }
+#endif
+
+            for (; i < n; ++i) {
+                if (match_row(seg, i, p)) emit(i);
+            }
+        }
+
+        void write_aggregate(common::JsonWriter& json, const RecentAggregate& agg, bool with_key) {
+            const double avg = agg.count ? agg.score_sum / static_cast<double>(agg.count) : 0.0;
+            json.begin_object();
+            if (with_key) json.field("key", std::string_view(agg.key));
+            json.field("count", agg.count)
+                .field("alerts", agg.alerts)
+                .field("avg_score", avg)
+                .field("max_score", agg.score_max)
+                .field("first_ms", agg.count ? agg.first_ms : 0)
+                .field("last_ms", agg.last_ms)
+                .end_object();
+        }
+
+        std::string url_decode(std::string_view in) {
+            std::string out;
+            out.reserve(in.size());
+            for (size_t i = 0; i < in.size(); ++i) {
+                if (in[i] == '+') {
+                    out += ' ';
+                } else if (in[i] == '%' && i + 2 < in.size()) {
+                    unsigned value = 0;
+                    auto [p, ec] = std::from_chars(in.data() + i + 1, in.data() + i + 3, value, 16);
+                    if (ec == std::errc() && p == in.data() + i + 3) {
+                        out += static_cast<char>(value);
+                        i += 2;
+                    } else {
+                        out += in[i];
+                    }
+                } else {
+                    out += in[i];
+                }
+            }
+            return out;
+        }
+
+        template <typename T>
+        void parse_number(std::string_view text, T& out) {
+            T value{};
+            auto [p, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (ec == std::errc() && p == text.data() + text.size()) out = value;
+        }
+
+    } // namespace
+
+    // =========================================================
+    // Dictionary
+    // =========================================================
+    void RecentEventStore::Dictionary::clear() {
+        size.store(0, std::memory_order_relaxed);
+        slots.fill(0);
+    }
+
+    uint16_t RecentEventStore::Dictionary::encode(std::string_view value) {
+        value = truncate(value);
+        const uint32_t n = size.load(std::memory_order_relaxed);
+        const size_t mask = slots.size() - 1;
+
+        for (size_t slot = hash_value(value) & mask;; slot = (slot + 1) & mask) {
+            const uint16_t stored = slots[slot];
+            if (stored == 0) {
+                if (n >= DICT_ENTRIES) return DICT_OVERFLOW;
+
+                DictEntry& e = entries[n];
+                e.len = static_cast<uint8_t>(value.size());
+                std::memcpy(e.text, value.data(), value.size());
+                slots[slot] = static_cast<uint16_t>(n + 1);
+                size.store(n + 1, std::memory_order_release); // Publish the entry
+                return static_cast<uint16_t>(n);
+            }
+            const DictEntry& e = entries[stored - 1];
+            if (std::string_view(e.text, e.len) == value) return static_cast<uint16_t>(stored - 1);
+        }
+    }
+
+    std::optional<uint16_t> RecentEventStore::Dictionary::find(std::string_view value) const {
+        value = truncate(value);
+        const uint32_t n = size.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (std::string_view(entries[i].text, entries[i].len) == value) {
+                return static_cast<uint16_t>(i);
+            }
+        }
+        return std::nullopt;
+    }
+
+    // =========================================================
+    // Constructor
+    // =========================================================
+    RecentEventStore::RecentEventStore(uint64_t window_ms, size_t memory_bytes, const common::MemoryPolicy& memory)
+        : window_ms_(std::max<uint64_t>(window_ms, 1000))
+    {
+        // Fixed budget: allocate every segment now, never again
+        const size_t count = std::max<size_t>(2, memory_bytes / sizeof(Segment));
+        segments_ = common::MappedArray<Segment>(count, memory, "Recent event store");
+        for (size_t i = 0; i < count; ++i) {
+            segments_[i].hosts.clear();
+            segments_[i].services.clear();
+        }
+
+        // Ring covers the window, plus one segment being filled
+        bucket_ms_ = std::max<uint64_t>(1, window_ms_ / (count - 1));
+
+        LOG_INFO("Recent Event Store: " + std::to_string(count) + " segments (" +
+                 std::to_string(count * sizeof(Segment) / (1024 * 1024)) + " MB), window " +
+                 std::to_string(window_ms_ / 1000) + "s, bucket " + std::to_string(bucket_ms_) + "ms");
+    }
+
+    RecentEventStore::~RecentEventStore() = default;
+
+    // =========================================================
+    // Writer (Processing Thread)
+    // =========================================================
+    void RecentEventStore::rotate(uint64_t bucket) {
+        active_ = started_ ? (active_ + 1) % segments_.size() : 0;
+        started_ = true;
+
+        Segment& seg = segments_[active_];
+
+        // Seqlock: odd generation tells readers the segment is being recycled
+        seg.generation.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        seg.rows.store(0, std::memory_order_relaxed);
+        seg.min_ms.store(UINT64_MAX, std::memory_order_relaxed);
+        seg.max_ms.store(0, std::memory_order_relaxed);
+        seg.hosts.clear();
+        seg.services.clear();
+        seg.bucket = bucket;
+
+        seg.generation.fetch_add(1, std::memory_order_release);
+    }
+
+    void RecentEventStore::append(const parser::ParsedLog& log, float score, bool is_alert) {
+        BB_PROFILE_ZONE("recent.append");
+        const uint64_t ts_ms = log.timestamp / 1000000;
+        const uint64_t bucket = ts_ms / bucket_ms_;
+
+        if (!started_) rotate(bucket);
+
+        Segment* seg = &segments_[active_];
+        uint32_t row = seg->rows.load(std::memory_order_relaxed);
+
+        // New time bucket, or this one filled up early (budget beats window)
+        if (bucket != seg->bucket || row >= SEGMENT_ROWS) {
+            rotate(bucket);
+            seg = &segments_[active_];
+            row = 0;
+        }
+
+        seg->ts_ms[row] = ts_ms;
+        seg->score[row] = score;
+        seg->alert[row] = is_alert ? 1 : 0;
+        seg->host_id[row] = seg->hosts.encode(log.host);
+        seg->service_id[row] = seg->services.encode(log.service);
+
+        if (ts_ms < seg->min_ms.load(std::memory_order_relaxed)) seg->min_ms.store(ts_ms, std::memory_order_relaxed);
+        if (ts_ms > seg->max_ms.load(std::memory_order_relaxed)) seg->max_ms.store(ts_ms, std::memory_order_relaxed);
+
+        // Publish: readers see the row only after its columns are written
+        seg->rows.store(row + 1, std::memory_order_release);
+    }
+
+    // =========================================================
+    // Query (Any Thread, Lock-Free)
+    // =========================================================
+    RecentResult RecentEventStore::query(const RecentQuery& q) const {
+        RecentResult result;
+
+        // Never look further back than the configured window
+        const uint64_t now_ms = common::TimeUtils::now_ms();
+        const uint64_t floor_ms = now_ms > window_ms_ ? now_ms - window_ms_ : 0;
+        const uint64_t from_ms = std::max(q.from_ms, floor_ms);
+        const uint64_t to_ms = std::min<uint64_t>(q.to_ms, INT64_MAX - 1);
+        if (from_ms > to_ms) return result;
+
+        std::vector<SlotAgg> slots(q.group_by == RecentQuery::GroupBy::None ? 0 : DICT_ENTRIES + 1);
+        std::unordered_map<std::string, RecentAggregate> groups;
+
+        for (size_t s = 0; s < segments_.size(); ++s) {
+            const Segment& seg = segments_[s];
+
+            const uint64_t gen = seg.generation.load(std::memory_order_acquire);
+            if (gen & 1) { result.segments_skipped++; continue; }
+
+            const uint32_t n = seg.rows.load(std::memory_order_acquire);
+            if (n == 0) continue;
+
+            // Zone map: skip segments outside the time range
+            if (seg.max_ms.load(std::memory_order_relaxed) < from_ms ||
+                seg.min_ms.load(std::memory_order_relaxed) > to_ms) {
+                result.segments_skipped++;
+                continue;
+            }
+
+            Predicate p{static_cast<int64_t>(from_ms), static_cast<int64_t>(to_ms),
+                        q.min_score, q.max_score, q.alerts_only, -1, -1};
+
+            // Resolve string filters to this segment's ids. Absent from a
+            // dictionary with room => no match here; absent from a full one =>
+            // the value may be among the overflow rows, which are counted as
+            // unresolved instead of matched.
+            bool unresolved = false;
+            auto resolve = [&](const Dictionary& dict, const std::string& value, int32_t& id) {
+                if (auto found = dict.find(value)) {
+                    id = *found;
+                    return true;
+                }
+                if (dict.size.load(std::memory_order_acquire) < DICT_ENTRIES) return false;
+                id = DICT_OVERFLOW;
+                unresolved = true;
+                return true;
+            };
+            if ((q.host && !resolve(seg.hosts, *q.host, p.host_id)) ||
+                (q.service && !resolve(seg.services, *q.service, p.service_id))) {
+                result.segments_skipped++;
+                continue;
+            }
+
+            RecentAggregate local;
+            uint64_t candidates = 0;
+            std::fill(slots.begin(), slots.end(), SlotAgg{});
+            const uint16_t* group_ids = unresolved ? nullptr
+                                      : q.group_by == RecentQuery::GroupBy::Host ? seg.host_id.data()
+                                      : q.group_by == RecentQuery::GroupBy::Service ? seg.service_id.data()
+                                      : nullptr;
+
+            scan(seg, n, p, [&](size_t i) {
+                if (unresolved) {
+                    candidates++;
+                    return;
+                }
+                const uint64_t ts = seg.ts_ms[i];
+                const float s = seg.score[i];
+                const bool alert = seg.alert[i] != 0;
+                accumulate(local, ts, s, alert);
+                if (group_ids) {
+                    SlotAgg& g = slots[group_ids[i]];
+                    g.count++;
+                    g.alerts += alert;
+                    g.score_sum += s;
+                    g.score_max = std::max(g.score_max, s);
+                    g.first_ms = std::min(g.first_ms, ts);
+                    g.last_ms = std::max(g.last_ms, ts);
+                }
+            });
+
+            // Copy group keys out before validating the segment
+            std::vector<std::pair<std::string, const SlotAgg*>> keyed;
+            if (group_ids) {
+                const Dictionary& dict = q.group_by == RecentQuery::GroupBy::Host ? seg.hosts : seg.services;
+                const uint32_t entries = std::min<uint32_t>(dict.size.load(std::memory_order_acquire), DICT_ENTRIES);
+                for (uint32_t id = 0; id < entries; ++id) {
+                    if (slots[id].count == 0) continue;
+                    keyed.emplace_back(std::string(dict.entries[id].text, dict.entries[id].len), &slots[id]);
+                }
+                if (slots[DICT_OVERFLOW].count) keyed.emplace_back("(other)", &slots[DICT_OVERFLOW]);
+            }
+
+            // Recycled while we were reading: those rows left the window anyway
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seg.generation.load(std::memory_order_relaxed) != gen) {
+                result.segments_skipped++;
+                continue;
+            }
+
+            result.segments_scanned++;
+            result.rows_scanned += n;
+            result.rows_unresolved += candidates;
+
+            if (local.count == 0) continue;
+            result.total.count += local.count;
+            result.total.alerts += local.alerts;
+            result.total.score_sum += local.score_sum;
+            result.total.score_max = std::max(result.total.score_max, local.score_max);
+            result.total.first_ms = std::min(result.total.first_ms, local.first_ms);
+            result.total.last_ms = std::max(result.total.last_ms, local.last_ms);
+
+            for (auto& [key, agg] : keyed) {
+                RecentAggregate& g = groups[key];
+                merge(g, *agg);
+            }
+        }
+
+        // Top-N groups by count
+        result.groups.reserve(groups.size());
+        for (auto& [key, agg] : groups) {
+            agg.key = key;
+            result.groups.push_back(std::move(agg));
+        }
+        const size_t keep = std::min(result.groups.size(), q.limit);
+        std::partial_sort(result.groups.begin(), result.groups.begin() + keep, result.groups.end(),
+                          [](const RecentAggregate& a, const RecentAggregate& b) { return a.count > b.count; });
+        result.groups.resize(keep);
+
+        return result;
+    }
+
+    // =========================================================
+    // Admin API Helpers
+    // =========================================================
+    std::string RecentEventStore::to_json(const RecentResult& result) {
+        // Exact upper bound: fixed fields plus worst-case escaped keys
+        constexpr size_t PER_AGGREGATE = 256 + common::JsonWriter::max_escaped_size(DICT_TEXT);
+        std::string out(128 + PER_AGGREGATE * (result.groups.size() + 1), '\0');
+
+        common::JsonWriter json(out.data(), out.size());
+        json.begin_object().key("total");
+        write_aggregate(json, result.total, false);
+        json.key("groups").begin_array();
+        for (const auto& group : result.groups) {
+            write_aggregate(json, group, true);
+        }
+        json.end_array()
+            .field("rows_scanned", result.rows_scanned)
+            .field("segments_scanned", result.segments_scanned)
+            .field("segments_skipped", result.segments_skipped)
+            .field("rows_unresolved", result.rows_unresolved)
+            .field("partial", result.partial())
+            .end_object();
+
+        out.resize(json.size());
+        return out;
+    }
+
+    RecentQuery RecentEventStore::parse_query_string(std::string_view qs) {
+        RecentQuery q;
+
+        while (!qs.empty()) {
+            size_t amp = qs.find('&');
+            std::string_view pair = qs.substr(0, amp);
+            qs = (amp == std::string_view::npos) ? std::string_view{} : qs.substr(amp + 1);
+
+            size_t eq = pair.find('=');
+            if (eq == std::string_view::npos) continue;
+            std::string_view key = pair.substr(0, eq);
+            std::string value = url_decode(pair.substr(eq + 1));
+
+            if (key == "host") q.host = value;
+            else if (key == "service") q.service = value;
+            else if (key == "from_ms") parse_number(value, q.from_ms);
+            else if (key == "to_ms") parse_number(value, q.to_ms);
+            else if (key == "min_score") parse_number(value, q.min_score);
+            else if (key == "max_score") parse_number(value, q.max_score);
+            else if (key == "limit") parse_number(value, q.limit);
+            else if (key == "alerts") q.alerts_only = (value == "1" || value == "true");
+            else if (key == "since_sec") {
+                uint64_t since = 0;
+                parse_number(value, since);
+                uint64_t now = common::TimeUtils::now_ms();
+                q.from_ms = now > since * 1000 ? now - since * 1000 : 0;
+            }
+            else if (key == "group_by") {
+                if (value == "host") q.group_by = RecentQuery::GroupBy::Host;
+                else if (value == "service") q.group_by = RecentQuery::GroupBy::Service;
+            }
+        }
+        return q;
+    }
+
+} // namespace blackbox::storage
@@ -5,39 +5,53 @@
 
 #include "blackbox/storage/redis_client.h"
 #include "blackbox/common/logger.h"
+#include "blackbox/common/metrics.h"
+#include "blackbox/common/profiler.h"
+#include "blackbox/common/thread_utils.h"
 #include <hiredis/hiredis.h> // Requires libhiredis-dev
-#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 namespace blackbox::storage {
 
+    // Reconnect backoff bounds
+    constexpr std::chrono::milliseconds MIN_BACKOFF{100};
+    constexpr std::chrono::milliseconds MAX_BACKOFF{5000};
+
+    // Upper bound on how long a queued alert waits for a missed wake-up
+    constexpr std::chrono::milliseconds IDLE_POLL{5};
+
     // =========================================================
     // Constructor
     // =========================================================
     RedisClient::RedisClient(const std::string& host, int port)
-        : host_(host), port_(port)
+        : host_(host), port_(port),
+          queue_(std::make_unique<common::SpscQueue<AlertSlot, QUEUE_DEPTH>>())
     {
-        connect();
+        publisher_thread_ = std::thread(&RedisClient::publisher_worker, this);
     }
 
     // =========================================================
     // Destructor
     // =========================================================
     RedisClient::~RedisClient() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (context_) {
-            redisFree(context_);
-            context_ = nullptr;
+        running_ = false;
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+        }
+        wake_cv_.notify_all();
+        if (publisher_thread_.joinable()) {
+            publisher_thread_.join();
         }
+        disconnect();
     }
 
     // =========================================================
-    // Connect Logic
+    // Connect Logic (Publisher Thread)
     // =========================================================
     bool RedisClient::connect() {
-        if (context_) {
-            redisFree(context_);
-            context_ = nullptr;
-        }
+        disconnect();
 
         // Set timeout to 1.5 seconds (Fail fast)
         struct timeval timeout = { 1, 500000 };
@@ -51,48 +65,158 @@ namespace blackbox::storage {
             } else {
                 LOG_ERROR("Redis Connection Error: Can't allocate context");
             }
-            connected_ = false;
             return false;
         }
 
+        // Bound reply reads too, so a hung server can't wedge the publisher
+        redisSetTimeout(context_, timeout);
+
         LOG_INFO("Connected to Redis at " + host_ + ":" + std::to_string(port_));
         connected_ = true;
         return true;
     }
 
+    void RedisClient::disconnect() {
+        if (context_) {
+            redisFree(context_);
+            context_ = nullptr;
+        }
+        connected_ = false;
+    }
+
     bool RedisClient::is_connected() const {
         return connected_;
     }
 
     // =========================================================
-    // Publish (The Hot Path)
+    // Publish (The Hot Path: copy into the queue, nothing else)
+    // =========================================================
+    bool RedisClient::publish(std::string_view channel, std::string_view message) {
+        if (channel.size() + message.size() > sizeof(AlertSlot::data)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            common::Metrics::instance().inc_alerts_dropped(1);
+            return false;
+        }
+
+        AlertSlot* slot = queue_->try_claim();
+        if (!slot) {
+            // Redis is down or slower than the attack: shed, don't stall
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            common::Metrics::instance().inc_alerts_dropped(1);
+            return false;
+        }
+
+        slot->channel_len = static_cast<uint16_t>(channel.size());
+        slot->message_len = static_cast<uint16_t>(message.size());
+        std::memcpy(slot->data, channel.data(), channel.size());
+        std::memcpy(slot->data + channel.size(), message.data(), message.size());
+        queue_->commit_push();
+
+        // Only pay for a wake-up when the publisher is actually parked
+        if (idle_.load(std::memory_order_seq_cst)) {
+            wake_cv_.notify_one();
+        }
+        return true;
+    }
+
+    // =========================================================
+    // Publisher Worker (Background Thread)
     // =========================================================
-    void RedisClient::publish(const std::string& channel, const std::string& message) {
-        std::lock_guard<std::mutex> lock(mutex_);
-
-        // 1. Auto-reconnect if needed
-        if (!connected_ || !context_) {
-            if (!connect()) {
-                // Still failed, drop message
-                return;
+    void RedisClient::publisher_worker() {
+        common::ThreadUtils::set_current_thread_name("BB_Redis");
+
+        auto backoff = MIN_BACKOFF;
+
+        while (running_) {
+            // 1. (Re)connect with exponential backoff; the queue absorbs the gap
+            if (!context_) {
+                if (!connect()) {
+                    std::unique_lock<std::mutex> lock(wake_mutex_);
+                    wake_cv_.wait_for(lock, backoff, [this] { return !running_; });
+                    backoff = std::min(backoff * 2, MAX_BACKOFF);
+                    continue;
+                }
+                backoff = MIN_BACKOFF;
             }
+
+            // 2. Ship whatever is queued
+            if (publish_batch() > 0) continue;
+
+            // 3. Idle: park until publish() wakes us
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            idle_.store(true, std::memory_order_seq_cst);
+            if (queue_->empty()) {
+                wake_cv_.wait_for(lock, IDLE_POLL, [this] { return !running_ || !queue_->empty(); });
+            }
+            idle_.store(false, std::memory_order_relaxed);
         }
 
-        // 2. Execute PUBLISH command
-        // hiredis command format: "PUBLISH %s %s"
-        auto reply = (redisReply*)redisCommand(context_, "PUBLISH %s %s", channel.c_str(), message.c_str());
+        // Shutdown: best-effort flush of what is still queued
+        while (context_ && publish_batch() > 0) {}
+    }
 
-        // 3. Check result
-        if (reply == nullptr) {
-            LOG_ERROR("Redis PUBLISH failed (Server disconnected?)");
-            redisFree(context_);
-            context_ = nullptr;
-            connected_ = false;
-            return;
+    size_t RedisClient::publish_batch() {
+        BB_PROFILE_ZONE("redis.publish_batch");
+        // 1. Append up to MAX_PIPELINE commands to hiredis' output buffer
+        size_t appended = 0;
+        while (appended < MAX_PIPELINE) {
+            const AlertSlot* slot = queue_->front();
+            if (!slot) break;
+
+            int rc = redisAppendCommand(context_, "PUBLISH %b %b",
+                                        slot->data, static_cast<size_t>(slot->channel_len),
+                                        slot->data + slot->channel_len, static_cast<size_t>(slot->message_len));
+            if (rc != REDIS_OK) break; // Out of memory in hiredis; leave it queued
+
+            queue_->pop_front(); // hiredis copied the bytes; free the slot
+            appended++;
+        }
+        if (appended == 0) return 0;
+
+        // 2. One write for the whole pipeline
+        bool ok = true;
+        int done = 0;
+        while (ok && !done) {
+            ok = (redisBufferWrite(context_, &done) == REDIS_OK);
+        }
+
+        // 3. Read all replies back-to-back. An error reply (NOAUTH, OOM, a
+        // READONLY replica) means that PUBLISH was refused: not delivered.
+        size_t replied = 0;
+        size_t rejected = 0;
+        std::string first_error;
+        while (ok && replied < appended) {
+            void* raw = nullptr;
+            if (redisGetReply(context_, &raw) != REDIS_OK || raw == nullptr) {
+                ok = false;
+                break;
+            }
+            const auto* reply = static_cast<const redisReply*>(raw);
+            if (reply->type == REDIS_REPLY_ERROR) {
+                if (rejected++ == 0) first_error.assign(reply->str, reply->len);
+            }
+            freeReplyObject(raw);
+            replied++;
+        }
+
+        const size_t confirmed = replied - rejected;
+        published_.fetch_add(confirmed, std::memory_order_relaxed);
+        common::Metrics::instance().inc_alerts_published(confirmed);
+
+        if (rejected > 0) {
+            LOG_ERROR("Redis refused " + std::to_string(rejected) + " PUBLISH(es): " + first_error);
+            dropped_.fetch_add(rejected, std::memory_order_relaxed);
+            common::Metrics::instance().inc_alerts_dropped(rejected);
         }
 
-        // 4. Cleanup
-        freeReplyObject(reply);
+        if (!ok) {
+            LOG_ERROR("Redis PUBLISH pipeline failed (" + std::string(context_->errstr) + "), " +
+                      std::to_string(appended - replied) + " alerts lost. Reconnecting.");
+            dropped_.fetch_add(appended - replied, std::memory_order_relaxed);
+            common::Metrics::instance().inc_alerts_dropped(appended - replied);
+            disconnect();
+        }
+        return appended;
     }
 
-} // namespace blackbox::storage
\ No newline at end of file
+} // namespace blackbox::storage
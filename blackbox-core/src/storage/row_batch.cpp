@@ -0,0 +1,57 @@
+/**
+ * @file row_batch.cpp
+ * @brief Implementation of Arena-backed Row Staging.
+ */
+
+#include "blackbox/storage/row_batch.h"
+#include <cstring> // For std::memcpy
+
+namespace blackbox::storage {
+
+    // =========================================================
+    // Constructor
+    // =========================================================
+    RowBatch::RowBatch()
+        : arena_(new char[ARENA_BYTES]),
+          rows_(new DBRow[MAX_ROWS])
+    {
+    }
+
+    // =========================================================
+    // Append (The Hot Path)
+    // =========================================================
+    bool RowBatch::append(const parser::ParsedLog& log, float score, bool is_alert) {
+        if (count_ == MAX_ROWS) return false;
+
+        const size_t needed = log.host.size() + log.country.size() +
+                              log.service.size() + log.message.size();
+        if (used_ + needed > ARENA_BYTES) return false;
+
+        // We need to copy the views because the raw ringbuffer
+        // memory might be overwritten before the DB write happens.
+        DBRow& row = rows_[count_++];
+        row.timestamp = log.timestamp;
+        row.id = log.id;
+        row.host = copy(log.host);
+        row.country = copy(log.country);
+        row.service = copy(log.service);
+        row.message = copy(log.message);
+        row.anomaly_score = score;
+        row.is_alert = is_alert;
+        row.sample_weight = log.sample_weight;
+        return true;
+    }
+
+    void RowBatch::reset() {
+        used_ = 0;
+        count_ = 0;
+    }
+
+    std::string_view RowBatch::copy(std::string_view str) {
+        char* dst = arena_.get() + used_;
+        std::memcpy(dst, str.data(), str.size());
+        used_ += str.size();
+        return std::string_view(dst, str.size());
+    }
+
+} // namespace blackbox::storage
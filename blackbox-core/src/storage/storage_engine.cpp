@@ -4,64 +4,207 @@
  */
 
 #include "blackbox/storage/storage_engine.h"
-#include <iostream>
+#include "blackbox/storage/clickhouse_client.h"
+#include "blackbox/storage/disk_spool.h"
+#include "blackbox/common/settings.h"
+#include "blackbox/common/logger.h"
+#include "blackbox/common/metrics.h"
+#include "blackbox/common/profiler.h"
+#include "blackbox/common/thread_utils.h"
+#include <algorithm>
 #include <chrono>
 
 namespace blackbox::storage {
 
+    // Upper bound for a single backoff sleep
+    constexpr std::chrono::milliseconds MAX_BACKOFF{5000};
+
+    // Batches handed to a new producer up front, so it never allocates in steady state
+    constexpr size_t PREALLOCATED_BATCHES = 4;
+
+    // Unique per engine instance (thread-local caches compare against it)
+    static std::atomic<uint64_t> next_engine_id{1};
+
     // =========================================================
     // Constructor
     // =========================================================
-    StorageEngine::StorageEngine() : running_(true) {
+    StorageEngine::StorageEngine()
+        : engine_id_(next_engine_id.fetch_add(1, std::memory_order_relaxed)),
+          running_(true)
+    {
+        const auto& db = common::Settings::instance().db();
+
+        batch_size_ = std::max<size_t>(1, db.flush_batch_size);
+        flush_interval_ = std::chrono::milliseconds(std::max(1, db.flush_interval_ms));
+        max_inflight_ = std::max<size_t>(1, db.max_inflight_batches);
+        max_retries_ = std::max(1, db.max_retries);
+        retry_backoff_ = std::chrono::milliseconds(std::max(1, db.retry_backoff_ms));
+        replay_rows_per_sec_ = std::max(1, db.spool_replay_rows_per_sec);
+
+        client_ = std::make_unique<ClickHouseClient>(db.clickhouse_url);
+
+        // Optional: overflow to disk instead of RAM while ClickHouse is down
+        if (!db.spool_dir.empty()) {
+            spool_ = std::make_unique<DiskSpool>(db.spool_dir, db.spool_max_bytes, db.spool_segment_bytes);
+            if (spool_->is_ready()) {
+                replay_thread_ = std::thread(&StorageEngine::replay_worker, this);
+            } else {
+                spool_.reset();
+            }
+        }
+
+        // One sender per in-flight slot, so a slow INSERT never delays the next one
+        for (size_t i = 0; i < max_inflight_; ++i) {
+            sender_threads_.emplace_back(&StorageEngine::sender_worker, this);
+        }
+
         // Start the background flusher immediately
         worker_thread_ = std::thread(&StorageEngine::flush_worker, this);
-        std::cout << "[CORE] Storage Engine started. Batch size: " << BATCH_SIZE_THRESHOLD << std::endl;
+        LOG_INFO("Storage Engine started. Batch size: " + std::to_string(batch_size_) +
+                 " | Flush interval: " + std::to_string(flush_interval_.count()) + "ms" +
+                 " | In-flight: " + std::to_string(max_inflight_) +
+                 " | Spool: " + (spool_ ? db.spool_dir : std::string("disabled")));
     }
 
     // =========================================================
     // Destructor
     // =========================================================
     StorageEngine::~StorageEngine() {
+        // 1. Stop the flusher (it collects every staged batch on exit)
         running_ = false;
         cv_.notify_all(); // Wake up worker to finish
         if (worker_thread_.joinable()) {
             worker_thread_.join();
         }
+
+        // Whatever the replayer has not sent stays on disk for the next start
+        replay_cv_.notify_all();
+        if (replay_thread_.joinable()) {
+            replay_thread_.join();
+        }
+
+        // 2. Let the senders drain the queue, then stop them
+        {
+            std::lock_guard<std::mutex> lock(inflight_mutex_);
+            senders_stopping_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& t : sender_threads_) {
+            if (t.joinable()) t.join();
+        }
+
+        // 3. Release the recycled arenas
+        for (auto& producer : producers_) {
+            RowBatch* batch = nullptr;
+            while (producer->spare.try_pop(batch)) delete batch;
+            delete producer->current;
+        }
+
+        LOG_INFO("Storage Engine stopped. Rows written: " + std::to_string(total_written_.load()));
+    }
+
+    // =========================================================
+    // Producer Registration (Once per Thread)
+    // =========================================================
+    StorageEngine::Producer& StorageEngine::local_producer() {
+        struct Cache {
+            uint64_t engine_id = 0;
+            Producer* producer = nullptr;
+        };
+        static thread_local Cache cache;
+
+        if (cache.engine_id == engine_id_) {
+            return *cache.producer;
+        }
+
+        auto producer = std::make_unique<Producer>();
+
+        // Pre-fill the spare queue before the flusher can see this producer
+        for (size_t i = 0; i < PREALLOCATED_BATCHES; ++i) {
+            producer->spare.try_push(new RowBatch());
+        }
+
+        Producer* raw = producer.get();
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            producers_.push_back(std::move(producer));
+        }
+
+        cache.engine_id = engine_id_;
+        cache.producer = raw;
+        return *raw;
+    }
+
+    RowBatch* StorageEngine::acquire_batch(Producer& producer) {
+        RowBatch* batch = nullptr;
+        if (producer.spare.try_pop(batch)) {
+            batch->reset();
+            return batch;
+        }
+        // Warm-up (or the flusher is behind): grow the pool by one batch
+        return new RowBatch();
+    }
+
+    void StorageEngine::publish(Producer& producer) {
+        RowBatch* batch = producer.current;
+        if (!batch || batch->empty()) return;
+
+        if (producer.full.try_push(std::move(batch))) {
+            producer.current = nullptr;
+            return;
+        }
+
+        // Flusher is not keeping up: drop this batch and keep its arena
+        common::Metrics::instance().inc_db_rows_dropped(batch->size());
+        batch->reset();
     }
 
     // =========================================================
     // Enqueue (Called by AI Thread)
     // =========================================================
     void StorageEngine::enqueue(const parser::ParsedLog& log, float score) {
-        
+
         // 1. BUSINESS LOGIC: FILTERING
         // If score is very low (Safe), we might drop it to save money.
         // For MVP, we save everything > 0.1, drop the rest.
         bool is_alert = (score > 0.8f);
-        
+
         if (score < 0.1f) {
             return; // Drop "Green" noise
         }
 
-        // 2. CONVERT TO DB ROW
-        // We need to copy string_views to strings because the raw ringbuffer 
-        // memory might be overwritten before the DB write happens.
-        DBRow row;
-        row.timestamp = log.timestamp;
-        row.service = std::string(log.service);
-        row.message = std::string(log.message);
-        row.anomaly_score = score;
-        row.is_alert = is_alert;
+        Producer& producer = local_producer();
 
-        // 3. THREAD-SAFE PUSH
-        {
-            std::unique_lock<std::mutex> lock(batch_mutex_);
-            current_batch_.push_back(std::move(row));
-            
-            // Optimization: Only notify if we hit the limit
-            if (current_batch_.size() >= BATCH_SIZE_THRESHOLD) {
-                cv_.notify_one();
+        // 2. AGE: the flusher asks us to ship what we have
+        if (producer.flush_requested.load(std::memory_order_relaxed)) {
+            producer.flush_requested.store(false, std::memory_order_relaxed);
+            publish(producer);
+        }
+
+        if (!producer.current) {
+            producer.current = acquire_batch(producer);
+        }
+
+        // 3. STAGE ROW (bump-allocated copy, no lock)
+        if (!producer.current->append(log, score, is_alert)) {
+            publish(producer);
+            if (!producer.current) {
+                producer.current = acquire_batch(producer);
             }
+            producer.current->append(log, score, is_alert);
+        }
+
+        // 4. SIZE: ship full batches right away
+        if (producer.current->full()) {
+            publish(producer);
+        }
+    }
+
+    void StorageEngine::flush_local() {
+        Producer& producer = local_producer();
+        if (producer.flush_requested.load(std::memory_order_relaxed)) {
+            producer.flush_requested.store(false, std::memory_order_relaxed);
+            publish(producer);
         }
     }
 
@@ -69,50 +212,268 @@ namespace blackbox::storage {
     // Flush Worker (Background Thread)
     // =========================================================
     void StorageEngine::flush_worker() {
-        std::vector<DBRow> outgoing_buffer;
-        
-        // Reserve memory to avoid reallocations
-        outgoing_buffer.reserve(BATCH_SIZE_THRESHOLD);
+        common::ThreadUtils::set_current_thread_name("BB_DbFlush");
+        using clock = std::chrono::steady_clock;
 
-        while (running_) {
+        // Poll often enough to honour the flush interval without spinning
+        const auto poll_interval = std::clamp<std::chrono::milliseconds>(
+            flush_interval_ / 4, std::chrono::milliseconds(1), std::chrono::milliseconds(50));
+
+        std::vector<Producer*> snapshot;
+        PendingInsert pending;
+        auto pending_started = clock::now();
+        auto last_age_request = clock::now();
+
+        while (true) {
+            const bool stopping = !running_;
+
+            // 1. Refresh the producer list (new threads register rarely)
+            {
+                std::lock_guard<std::mutex> lock(registry_mutex_);
+                snapshot.clear();
+                for (auto& p : producers_) snapshot.push_back(p.get());
+            }
+
+            // 2. Ask producers to ship partial batches once per interval
+            auto now = clock::now();
+            if (now - last_age_request >= flush_interval_ / 2) {
+                for (Producer* p : snapshot) {
+                    p->flush_requested.store(true, std::memory_order_relaxed);
+                }
+                last_age_request = now;
+            }
+
+            // 3. Collect handed-off batches, serialize, recycle the arenas
+            for (Producer* p : snapshot) {
+                RowBatch* batch = nullptr;
+                while (p->full.try_pop(batch)) {
+                    serialize(*batch, pending, pending_started);
+                    if (!p->spare.try_push(std::move(batch))) delete batch;
+                }
+
+                // On shutdown the producer threads are gone; take their partial batch
+                if (stopping && p->current) {
+                    serialize(*p->current, pending, pending_started);
+                    p->current->reset();
+                }
+            }
+
+            // 4. Ship an aged partial INSERT
+            if (pending.rows > 0 &&
+                (stopping || clock::now() - pending_started >= flush_interval_)) {
+                dispatch(std::move(pending));
+                pending = PendingInsert{};
+            }
+
+            if (stopping) break;
+
+            std::unique_lock<std::mutex> lock(flush_mutex_);
+            cv_.wait_for(lock, poll_interval, [this] { return !running_; });
+        }
+    }
+
+    // =========================================================
+    // Serialize (Staged Rows -> INSERT)
+    // =========================================================
+    void StorageEngine::serialize(const RowBatch& batch, PendingInsert& pending,
+                                  std::chrono::steady_clock::time_point& pending_started) {
+        BB_PROFILE_ZONE("storage.serialize");
+        for (const DBRow& row : batch) {
+            if (pending.rows == 0) {
+                pending.query.reserve(batch_size_ * 256);
+                ClickHouseClient::begin_insert(pending.query);
+                pending_started = std::chrono::steady_clock::now();
+            }
+
+            ClickHouseClient::append_row(pending.query, row, pending.rows == 0);
+            pending.rows++;
+
+            if (pending.rows >= batch_size_) {
+                dispatch(std::move(pending));
+                pending = PendingInsert{};
+            }
+        }
+    }
+
+    // =========================================================
+    // Dispatch (Queue for Senders)
+    // =========================================================
+    void StorageEngine::dispatch(PendingInsert&& insert) {
+        std::unique_lock<std::mutex> lock(inflight_mutex_);
+
+        // ClickHouse is down or saturated: park the batch on disk, don't wait
+        if (spool_ && (!clickhouse_healthy_.load(std::memory_order_relaxed) ||
+                       inflight_count_ >= max_inflight_)) {
+            lock.unlock();
+            if (spool(insert)) return;
+            lock.lock();
+        }
+
+        // Bounded in-flight: wait for a sender to free a slot.
+        // Only the flush thread waits here; producers keep staging.
+        space_cv_.wait(lock, [this] { return inflight_count_ < max_inflight_; });
+
+        inflight_queue_.push_back(std::move(insert));
+        inflight_count_++;
+        work_cv_.notify_one();
+    }
+
+    // =========================================================
+    // Sender Worker (Background Threads)
+    // =========================================================
+    void StorageEngine::sender_worker() {
+        common::ThreadUtils::set_current_thread_name("BB_DbSend");
+        while (true) {
+            PendingInsert insert;
             {
-                // Wait for Data OR Timeout
-                std::unique_lock<std::mutex> lock(batch_mutex_);
-                cv_.wait_for(lock, FLUSH_INTERVAL_MS, [this] { 
-                    return !running_ || current_batch_.size() >= BATCH_SIZE_THRESHOLD; 
+                std::unique_lock<std::mutex> lock(inflight_mutex_);
+                work_cv_.wait(lock, [this] {
+                    return senders_stopping_ || !inflight_queue_.empty();
                 });
 
-                // SWAP buffers (Double Buffering)
-                // We swap the full 'current_batch' into our local 'outgoing_buffer'
-                // and give 'current_batch' an empty vector.
-                // This minimizes the time we hold the lock to nanoseconds.
-                outgoing_buffer.swap(current_batch_);
+                if (inflight_queue_.empty()) return; // Stopping and drained
+
+                insert = std::move(inflight_queue_.front());
+                inflight_queue_.pop_front();
             }
 
-            // Lock is released here. AI thread can continue filling 'current_batch'.
+            // NETWORK IO (No locks held)
+            const WriteResult result = send_to_clickhouse(insert);
+            if (result == WriteResult::Ok) {
+                clickhouse_healthy_.store(true, std::memory_order_relaxed);
+                total_written_.fetch_add(insert.rows, std::memory_order_relaxed);
+                common::Metrics::instance().inc_db_rows_written(insert.rows);
+            } else if (result == WriteResult::Rejected) {
+                // The server is up but will never take this batch: spooling it
+                // would only block the replayer behind it
+                reject(insert.rows);
+            } else if (spool(insert)) {
+                // Newer batches go straight to disk until the replayer gets through
+                clickhouse_healthy_.store(false, std::memory_order_relaxed);
+                LOG_WARN("ClickHouse unavailable, spooled batch of " + std::to_string(insert.rows) + " rows.");
+            } else {
+                common::Metrics::instance().inc_db_rows_dropped(insert.rows);
+                LOG_ERROR("Dropping batch of " + std::to_string(insert.rows) +
+                          " rows after " + std::to_string(max_retries_) + " attempts.");
+            }
 
-            // 4. NETWORK IO
-            if (!outgoing_buffer.empty()) {
-                send_to_clickhouse(outgoing_buffer);
-                outgoing_buffer.clear(); // Ready for next swap
+            {
+                std::lock_guard<std::mutex> lock(inflight_mutex_);
+                inflight_count_--;
+            }
+            space_cv_.notify_one();
+        }
+    }
+
+    // =========================================================
+    // Send to ClickHouse (Retry with Exponential Backoff)
+    // =========================================================
+    WriteResult StorageEngine::send_to_clickhouse(const PendingInsert& insert) {
+        auto backoff = retry_backoff_;
+
+        for (int attempt = 1; attempt <= max_retries_; ++attempt) {
+            const WriteResult result = client_->execute(insert.query);
+            if (result != WriteResult::Retry) {
+                return result;
             }
+
+            common::Metrics::instance().inc_db_errors(1);
+
+            // Shutting down: one attempt only, don't hold up the exit
+            if (!running_ || attempt == max_retries_) break;
+
+            std::this_thread::sleep_for(backoff);
+            backoff = std::min(backoff * 2, MAX_BACKOFF);
+        }
+        return WriteResult::Retry;
+    }
+
+    void StorageEngine::reject(size_t rows) {
+        common::Metrics::instance().inc_db_errors(1);
+        common::Metrics::instance().inc_db_batches_rejected(1);
+        common::Metrics::instance().inc_db_rows_dropped(rows);
+        LOG_ERROR("Dropping batch of " + std::to_string(rows) + " rows rejected by ClickHouse.");
+    }
+
+    // =========================================================
+    // Disk Spool
+    // =========================================================
+    bool StorageEngine::spool(const PendingInsert& insert) {
+        if (!spool_ || !spool_->append(insert.query, static_cast<uint32_t>(insert.rows))) {
+            return false;
         }
+        common::Metrics::instance().inc_spool_rows_written(insert.rows);
+        return true;
     }
 
     // =========================================================
-    // Send to ClickHouse (Mock Implementation)
+    // Replay Worker (Background Thread)
     // =========================================================
-    void StorageEngine::send_to_clickhouse(const std::vector<DBRow>& batch) {
-        // In production, this uses libcurl to POST INSERT to ClickHouse
-        
-        // Example SQL Construction:
-        // INSERT INTO sentry.logs VALUES (time, service, msg, score, is_threat) ...
-        
-        // std::cout << "[STORAGE] Flushed " << batch.size() << " logs to DB." << std::endl;
-        total_written_ += batch.size();
-        
-        // Simulating IO latency
-        // std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    void StorageEngine::replay_worker() {
+        common::ThreadUtils::set_current_thread_name("BB_DbReplay");
+        using clock = std::chrono::steady_clock;
+
+        // Token bucket: at most one second of burst
+        const double rate = static_cast<double>(replay_rows_per_sec_);
+        double tokens = rate;
+        auto last_refill = clock::now();
+        auto backoff = retry_backoff_;
+
+        std::string payload;
+        uint32_t rows = 0;
+
+        auto update_gauges = [this] {
+            common::Metrics::instance().set_spool_depth(
+                spool_->depth_bytes(), spool_->depth_rows(), spool_->oldest_age_ms());
+        };
+
+        while (running_) {
+            update_gauges();
+
+            std::chrono::milliseconds wait{0};
+
+            if (!spool_->peek(payload, rows)) {
+                wait = std::chrono::milliseconds(1000); // Idle: poll for new spooled batches
+            } else {
+                // Refill, then wait until the bucket covers this batch
+                auto now = clock::now();
+                tokens = std::min(rate, tokens + rate * std::chrono::duration<double>(now - last_refill).count());
+                last_refill = now;
+
+                const double needed = std::min<double>(rows, rate);
+                if (tokens < needed) {
+                    wait = std::chrono::milliseconds(
+                        static_cast<int64_t>((needed - tokens) * 1000.0 / rate) + 1);
+                } else if (const WriteResult result = client_->execute(payload); result == WriteResult::Ok) {
+                    tokens -= needed;
+                    spool_->commit();
+                    backoff = retry_backoff_;
+                    clickhouse_healthy_.store(true, std::memory_order_relaxed);
+                    total_written_.fetch_add(rows, std::memory_order_relaxed);
+                    common::Metrics::instance().inc_db_rows_written(rows);
+                    common::Metrics::instance().inc_spool_rows_replayed(rows);
+                    continue;
+                } else if (result == WriteResult::Rejected) {
+                    // Poison record: drop it so the ones behind it can go through
+                    tokens -= needed;
+                    spool_->commit();
+                    backoff = retry_backoff_;
+                    reject(rows);
+                    continue;
+                } else {
+                    // Still down: probe again later
+                    common::Metrics::instance().inc_db_errors(1);
+                    clickhouse_healthy_.store(false, std::memory_order_relaxed);
+                    wait = backoff;
+                    backoff = std::min(backoff * 2, MAX_BACKOFF);
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(replay_mutex_);
+            replay_cv_.wait_for(lock, wait, [this] { return !running_; });
+        }
+
+        update_gauges();
     }
 
-} // namespace blackbox::storage
\ No newline at end of file
+} // namespace blackbox::storage
@@ -0,0 +1,206 @@
+/**
+ * @file test_ingest.cpp
+ * @brief TCP stream framing (StreamFramer) and RingBuffer::push_batch.
+ *
+ * A stream mixing octet-counted frames, LF and CRLF lines, digit-led
+ * lines and frames over the 4 KB slot size is cut at random read
+ * boundaries (including inside length headers) and must always yield
+ * the same frames. push_batch must take a prefix up to the free space
+ * and deliver it in order.
+ *
+ * Plain executable: prints each failure and exits non-zero (ctest).
+ */
+
+#include "blackbox/common/settings.h"
+#include "blackbox/ingest/ring_buffer.h"
+#include "blackbox/ingest/stream_framer.h"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace blackbox;
+using ingest::RawMessage;
+using ingest::StreamFramer;
+
+namespace {
+
+    int g_failures = 0;
+
+#define CHECK_EQ(actual, expected, what)                                              \
+    do {                                                                              \
+        const auto a_ = (actual);                                                     \
+        const auto e_ = (expected);                                                   \
+        if (!(a_ == e_)) {                                                            \
+            if (++g_failures <= 20) {                                                 \
+                std::printf("FAIL %s:%d %s\n", __FILE__, __LINE__, std::string(what).c_str()); \
+            }                                                                         \
+        }                                                                             \
+    } while (0)
+
+    constexpr size_t FRAMES = 20000;
+    constexpr size_t SPLIT_TRIALS = 20;
+
+    // Feeds 'stream' in reads of the given sizes, collecting every frame
+    std::vector<std::string> frame(const std::string& stream, const std::vector<size_t>& reads, size_t batch) {
+        auto framer = std::make_unique<StreamFramer>();
+        std::vector<std::string> frames;
+        std::vector<RawMessage> out(batch);
+
+        size_t pos = 0;
+        for (size_t read : reads) {
+            // Each read lands in a fresh buffer, as with a reused socket buffer
+            const std::string chunk = stream.substr(pos, read);
+            pos += read;
+
+            const char* cursor = chunk.data();
+            const char* end = cursor + chunk.size();
+            while (cursor < end) {
+                const size_t n = framer->extract(cursor, end, out.data(), batch);
+                for (size_t i = 0; i < n; ++i) {
+                    frames.emplace_back(out[i].data, out[i].length);
+                    CHECK_EQ(out[i].sample_weight, 1u, "frame weight");
+                }
+            }
+        }
+        return frames;
+    }
+
+    std::vector<std::string> frame(const std::string& stream) {
+        return frame(stream, {stream.size()}, 64);
+    }
+
+    void test_fixed_cases() {
+        using V = std::vector<std::string>;
+
+        CHECK_EQ(frame("<13>a\n<13>b\n"), (V{"<13>a", "<13>b"}), "LF lines");
+        CHECK_EQ(frame("<13>a\r\n<13>b\r\n"), (V{"<13>a", "<13>b"}), "CRLF lines");
+        CHECK_EQ(frame("6 <13>a\n11 <13>b\nline2"), (V{"<13>a\n", "<13>b\nline2"}), "octet-counted, multi-line");
+        CHECK_EQ(frame("5 <13>a5 <13>b"), (V{"<13>a", "<13>b"}), "back-to-back counted frames");
+        CHECK_EQ(frame("5 <13>a\n<13>b\n"), (V{"<13>a", "<13>b"}), "counted then LF (trailer skipped)");
+        CHECK_EQ(frame("2024-01-01 up\n"), (V{"2024-01-01 up"}), "digit-led line is not a length");
+        CHECK_EQ(frame("\n\n\r\n<13>a\n"), (V{"<13>a"}), "blank lines skipped");
+        CHECK_EQ(frame("<13>no newline yet"), V{}, "partial line held back");
+
+        // Split inside the length header and inside the payload
+        CHECK_EQ(frame("10 <13>hello\n", {1, 2, 4, 6}, 64), (V{"<13>hello\n"}), "split counted frame");
+        CHECK_EQ(frame("<13>hello\n<13>x\n", {3, 3, 10}, 64), (V{"<13>hello", "<13>x"}), "split line");
+
+        // Oversized frames are cut to one slot, not dropped
+        const std::string big(6000, 'x');
+        const std::string cut = big.substr(0, StreamFramer::MAX_FRAME);
+        CHECK_EQ(frame(big + "\n<13>a\n"), (V{cut, "<13>a"}), "long line truncated");
+        CHECK_EQ(frame(big + "\n<13>a\n", {1000, 3000, 2002, 6}, 64), (V{cut, "<13>a"}), "long split line truncated");
+        CHECK_EQ(frame("6000 " + big + "<13>a\n"), (V{cut, "<13>a"}), "long counted frame truncated");
+        CHECK_EQ(frame("6000 " + big + "<13>a\n", {10, 4000, 1995, 6}, 64), (V{cut, "<13>a"}),
+                 "long split counted frame truncated");
+    }
+
+    void test_random_splits() {
+        std::mt19937 rng(6587);
+        std::vector<std::string> expected;
+        std::string stream;
+
+        for (size_t i = 0; i < FRAMES; ++i) {
+            const size_t len = rng() % 3 == 0 ? rng() % 6000 : 1 + rng() % 300;
+            std::string msg = "<";
+            msg += std::to_string(rng() % 191);
+            msg += '>';
+            while (msg.size() < len) msg += static_cast<char>('a' + rng() % 26);
+
+            switch (rng() % 5) {
+                case 0: {  // Octet-counted, multi-line payload
+                    const std::string payload = msg + "\nline2";
+                    stream += std::to_string(payload.size()) + " " + payload;
+                    expected.push_back(payload.substr(0, StreamFramer::MAX_FRAME));
+                    break;
+                }
+                case 1:    // CRLF
+                    stream += msg + "\r\n";
+                    expected.push_back(msg.substr(0, StreamFramer::MAX_FRAME));
+                    break;
+                case 2: {  // Digit-led plain line
+                    const std::string line = "2024-01-01 " + msg;
+                    stream += line + "\n";
+                    expected.push_back(line.substr(0, StreamFramer::MAX_FRAME));
+                    break;
+                }
+                case 3:    // Octet-counted with an LF trailer
+                    stream += std::to_string(msg.size()) + " " + msg + "\n";
+                    expected.push_back(msg.substr(0, StreamFramer::MAX_FRAME));
+                    break;
+                default:   // LF plus a blank line
+                    stream += msg + "\n\n";
+                    expected.push_back(msg.substr(0, StreamFramer::MAX_FRAME));
+                    break;
+            }
+        }
+
+        for (size_t trial = 0; trial < SPLIT_TRIALS; ++trial) {
+            std::vector<size_t> reads;
+            for (size_t left = stream.size(); left > 0;) {
+                const size_t read = trial == 0 ? 65536 : std::min(left, 1 + rng() % (trial * 500));
+                reads.push_back(std::min(left, read));
+                left -= reads.back();
+            }
+            const size_t batch = 1 + trial % 7;   // Small batches force early returns
+            const auto frames = frame(stream, reads, batch);
+
+            CHECK_EQ(frames.size(), expected.size(), "random split frame count, trial " + std::to_string(trial));
+            CHECK_EQ(frames == expected, true, "random split frames, trial " + std::to_string(trial));
+        }
+    }
+
+    void test_push_batch() {
+        // Plain pages, faulted in as the ring fills (no startup prefault)
+        common::MemoryPolicy policy;
+        policy.huge_pages = false;
+        policy.prefault = false;
+        auto ring = std::make_unique<ingest::RingBuffer<65536>>(policy);
+
+        std::vector<std::string> texts;
+        for (int i = 0; i < 100; ++i) texts.push_back("msg " + std::to_string(i));
+        std::vector<RawMessage> batch;
+        for (const auto& text : texts) batch.push_back({text.data(), text.size(), static_cast<uint32_t>(text.size())});
+
+        // Fill: every call takes a prefix of the free space
+        size_t pushed = 0;
+        for (;;) {
+            const size_t n = ring->push_batch(batch.data(), batch.size());
+            pushed += n;
+            if (n < batch.size()) break;
+        }
+        CHECK_EQ(pushed, ring->capacity() - 1, "push_batch fills all but one slot");
+        CHECK_EQ(ring->push_batch(batch.data(), batch.size()), size_t{0}, "push_batch on a full ring");
+
+        ingest::LogEvent event;
+        size_t popped = 0;
+        bool in_order = true;
+        while (ring->pop(event)) {
+            const std::string& text = texts[popped % texts.size()];
+            in_order = in_order && std::string(event.raw_data, event.length) == text &&
+                       event.sample_weight == text.size();
+            ++popped;
+        }
+        CHECK_EQ(popped, pushed, "everything pushed is popped");
+        CHECK_EQ(in_order, true, "batched events keep order, bytes and weights");
+        CHECK_EQ(ring->push_batch(batch.data(), 3), size_t{3}, "push_batch after draining");
+    }
+
+} // namespace
+
+int main() {
+    common::Settings::instance().load_from_env();
+
+    test_fixed_cases();
+    test_random_splits();
+    test_push_batch();
+
+    if (g_failures > 0) {
+        std::printf("test_ingest: %d failures\n", g_failures);
+        return 1;
+    }
+    std::printf("test_ingest: OK\n");
+    return 0;
+}
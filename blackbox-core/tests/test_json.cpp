@@ -0,0 +1,177 @@
+/**
+ * @file test_json.cpp
+ * @brief JsonWriter string escaping and UTF-8 validation.
+ *
+ * Fixed cases cover the RFC 8259 escapes and the ill-formed UTF-8 forms
+ * (stray continuations, overlongs, surrogates, values past U+10FFFF,
+ * truncated sequences), which must come out as U+FFFD. Random strings
+ * are run through both the 32-byte and the scalar path: well-formed
+ * input must be copied unchanged, and any input must produce output
+ * that decodes as UTF-8 with no raw control characters.
+ *
+ * Plain executable: prints each failure and exits non-zero (ctest).
+ */
+
+#include "blackbox/common/json_writer.h"
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using blackbox::common::JsonWriter;
+
+namespace {
+
+    int g_failures = 0;
+
+#define CHECK_EQ(actual, expected, what)                                              \
+    do {                                                                              \
+        const auto a_ = (actual);                                                     \
+        const auto e_ = (expected);                                                   \
+        if (!(a_ == e_)) {                                                            \
+            if (++g_failures <= 20) {                                                 \
+                std::printf("FAIL %s:%d %s\n", __FILE__, __LINE__, std::string(what).c_str()); \
+            }                                                                         \
+        }                                                                             \
+    } while (0)
+
+    constexpr size_t RANDOM_CASES = 50000;
+    const std::string FFFD = "\xEF\xBF\xBD";
+
+    // value(str) without the surrounding quotes
+    std::string escaped(const std::string& str) {
+        std::vector<char> buf(JsonWriter::max_escaped_size(str.size()));
+        JsonWriter json(buf.data(), buf.size());
+        json.value(std::string_view(str));
+        CHECK_EQ(json.ok(), true, "max_escaped_size is enough");
+        const std::string_view out = json.view();
+        return std::string(out.substr(1, out.size() - 2));
+    }
+
+    // Independent decoder: true if 'text' is well-formed UTF-8
+    bool is_utf8(const std::string& text) {
+        size_t i = 0;
+        while (i < text.size()) {
+            const auto b = static_cast<unsigned char>(text[i]);
+            uint32_t cp;
+            size_t extra;
+            if (b < 0x80) { cp = b; extra = 0; }
+            else if ((b & 0xE0) == 0xC0) { cp = b & 0x1F; extra = 1; }
+            else if ((b & 0xF0) == 0xE0) { cp = b & 0x0F; extra = 2; }
+            else if ((b & 0xF8) == 0xF0) { cp = b & 0x07; extra = 3; }
+            else return false;
+            if (i + extra >= text.size()) return false;
+            for (size_t k = 1; k <= extra; ++k) {
+                const auto c = static_cast<unsigned char>(text[i + k]);
+                if ((c & 0xC0) != 0x80) return false;
+                cp = (cp << 6) | (c & 0x3F);
+            }
+            static constexpr uint32_t MIN_FOR_LENGTH[] = {0, 0x80, 0x800, 0x10000};
+            if (cp < MIN_FOR_LENGTH[extra] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+            i += extra + 1;
+        }
+        return true;
+    }
+
+    std::string encode(uint32_t cp) {
+        std::string out;
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        return out;
+    }
+
+    void test_fixed_cases() {
+        CHECK_EQ(escaped("plain text"), std::string("plain text"), "ASCII copied");
+        CHECK_EQ(escaped("a\"b\\c"), std::string("a\\\"b\\\\c"), "quote and backslash");
+        CHECK_EQ(escaped("\n\r\t\b\f"), std::string("\\n\\r\\t\\b\\f"), "short escapes");
+        CHECK_EQ(escaped(std::string("\x01\x1F", 2)), std::string("\\u0001\\u001f"), "control characters");
+        CHECK_EQ(escaped(std::string("\0", 1)), std::string("\\u0000"), "NUL");
+
+        // Well-formed: 2, 3 and 4 byte sequences, the range ends
+        CHECK_EQ(escaped("M\xC3\xBCnchen"), std::string("M\xC3\xBCnchen"), "2-byte kept");
+        CHECK_EQ(escaped("\xE2\x82\xAC 5"), std::string("\xE2\x82\xAC 5"), "3-byte kept");
+        CHECK_EQ(escaped("\xF0\x9F\x94\x92"), std::string("\xF0\x9F\x94\x92"), "4-byte kept");
+        CHECK_EQ(escaped("\xED\x9F\xBF\xEE\x80\x80\xF4\x8F\xBF\xBF"), std::string("\xED\x9F\xBF\xEE\x80\x80\xF4\x8F\xBF\xBF"),
+                 "U+D7FF, U+E000, U+10FFFF kept");
+
+        // Ill-formed: one U+FFFD per maximal subpart
+        CHECK_EQ(escaped("a\x80z"), "a" + FFFD + "z", "stray continuation");
+        CHECK_EQ(escaped("\xFF\xFE"), FFFD + FFFD, "FF FE");
+        CHECK_EQ(escaped("\xC0\xAF"), FFFD + FFFD, "overlong '/' (C0 AF)");
+        CHECK_EQ(escaped("\xE0\x80\xAF"), FFFD + FFFD + FFFD, "overlong 3-byte");
+        CHECK_EQ(escaped("\xED\xA0\x80"), FFFD + FFFD + FFFD, "surrogate U+D800");
+        CHECK_EQ(escaped("\xF4\x90\x80\x80"), FFFD + FFFD + FFFD + FFFD, "past U+10FFFF");
+        CHECK_EQ(escaped("\xE2\x82" "x"), FFFD + "x", "truncated 3-byte, then ASCII");
+        CHECK_EQ(escaped("\xF0\x9F\x94"), FFFD, "truncated 4-byte at the end");
+        CHECK_EQ(escaped("\xC3"), FFFD, "lone lead byte at the end");
+        CHECK_EQ(escaped("\xC3\"\x80"), FFFD + "\\\"" + FFFD, "truncated before a quote");
+
+        // Same bytes past the 32-byte vector step
+        const std::string pad(40, 'p');
+        CHECK_EQ(escaped(pad + "\xFF" + pad), pad + FFFD + pad, "invalid byte after a SIMD block");
+        CHECK_EQ(escaped(pad + "\xC3\xBC" + pad), pad + "\xC3\xBC" + pad, "valid byte after a SIMD block");
+
+        // Worst case still fits max_escaped_size (checked inside escaped())
+        escaped(std::string(100, '\x01'));
+        escaped(std::string(100, '\xFF'));
+    }
+
+    void test_random(std::mt19937& rng) {
+        for (size_t i = 0; i < RANDOM_CASES; ++i) {
+            const size_t len = rng() % 100;
+
+            // Well-formed text without characters that need escaping: unchanged
+            std::string valid;
+            while (valid.size() < len) {
+                uint32_t cp;
+                switch (rng() % 4) {
+                    case 0:  cp = 0x20 + rng() % 0x5F; break;
+                    case 1:  cp = 0x80 + rng() % 0x780; break;
+                    case 2:  cp = 0x800 + rng() % 0xF800; break;
+                    default: cp = 0x10000 + rng() % 0x100000; break;
+                }
+                if (cp == '"' || cp == '\\' || (cp >= 0xD800 && cp <= 0xDFFF)) continue;
+                valid += encode(cp);
+            }
+            CHECK_EQ(escaped(valid), valid, "well-formed text copied unchanged");
+
+            // Arbitrary bytes: output is UTF-8 with every control character escaped
+            std::string bytes;
+            for (size_t k = 0; k < len; ++k) bytes += static_cast<char>(rng() & 0xFF);
+            const std::string out = escaped(bytes);
+            bool raw_control = false;
+            for (char c : out) raw_control = raw_control || static_cast<unsigned char>(c) < 0x20;
+            CHECK_EQ(is_utf8(out), true, "random bytes give UTF-8");
+            CHECK_EQ(raw_control, false, "random bytes give no raw control characters");
+        }
+    }
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(8259);
+
+    test_fixed_cases();
+    test_random(rng);
+
+    if (g_failures > 0) {
+        std::printf("test_json: %d failures\n", g_failures);
+        return 1;
+    }
+    std::printf("test_json: OK\n");
+    return 0;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file test_parser.cpp
+ * @brief Timestamp parsing/formatting (TimeUtils) against libc.
+ *
+ * The parsers do their own calendar math, so random instants across
+ * 1970-2100 are formatted with gmtime_r/strftime and must parse back
+ * exactly; the formatters must match gmtime_r for the same instants.
+ * Fixed cases cover the edge rules (padding, year inference, zones).
+ *
+ * Plain executable: prints each failure and exits non-zero (ctest).
+ */
+
+#include "blackbox/common/time_utils.h"
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <random>
+#include <string>
+
+using blackbox::common::TimeUtils;
+
+namespace {
+
+    int g_failures = 0;
+
+#define CHECK_EQ(actual, expected, what)                                              \
+    do {                                                                              \
+        const auto a_ = (actual);                                                     \
+        const auto e_ = (expected);                                                   \
+        if (!(a_ == e_)) {                                                            \
+            if (++g_failures <= 20) {                                                 \
+                std::printf("FAIL %s:%d %s\n", __FILE__, __LINE__, std::string(what).c_str()); \
+            }                                                                         \
+        }                                                                             \
+    } while (0)
+
+    constexpr uint64_t NS = 1000000000ull;
+    constexpr size_t RANDOM_CASES = 200000;
+
+    // 1970-01-01 .. 2099-12-31
+    constexpr uint64_t MAX_SECONDS = 4102444799ull;
+
+    std::string strftime_utc(uint64_t seconds, const char* format) {
+        const std::time_t t = static_cast<std::time_t>(seconds);
+        std::tm tm{};
+        gmtime_r(&t, &tm);
+        char buf[64];
+        const size_t len = std::strftime(buf, sizeof(buf), format, &tm);
+        return std::string(buf, len);
+    }
+
+    void test_formatters(std::mt19937_64& rng) {
+        char out[TimeUtils::CLICKHOUSE_MS_LENGTH];
+        for (size_t i = 0; i < RANDOM_CASES; ++i) {
+            const uint64_t ms = rng() % (MAX_SECONDS * 1000);
+            char millis[8];
+            std::snprintf(millis, sizeof(millis), ".%03u", static_cast<unsigned>(ms % 1000));
+
+            const std::string expected = strftime_utc(ms / 1000, "%Y-%m-%d %H:%M:%S");
+            CHECK_EQ(TimeUtils::to_clickhouse_format(ms), expected, "to_clickhouse_format " + expected);
+
+            TimeUtils::format_clickhouse_ms(ms, out);
+            CHECK_EQ(std::string(out, sizeof(out)), expected + millis, "format_clickhouse_ms " + expected);
+
+            CHECK_EQ(TimeUtils::to_iso_8601(ms), strftime_utc(ms / 1000, "%Y-%m-%dT%H:%M:%S") + millis + "Z",
+                     "to_iso_8601 " + expected);
+        }
+    }
+
+    void test_rfc3339_random(std::mt19937_64& rng) {
+        for (size_t i = 0; i < RANDOM_CASES; ++i) {
+            const uint64_t seconds = rng() % MAX_SECONDS;
+            const uint64_t frac = rng() % NS;
+            const std::string base = strftime_utc(seconds, "%Y-%m-%dT%H:%M:%S");
+
+            CHECK_EQ(TimeUtils::parse_rfc3339(base + "Z"), seconds * NS, "rfc3339 " + base);
+
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), ".%09llu", static_cast<unsigned long long>(frac));
+            size_t consumed = 0;
+            const std::string text = base + buf + "Z trailing";
+            CHECK_EQ(TimeUtils::parse_rfc3339(text, &consumed), seconds * NS + frac, "rfc3339 frac " + text);
+            CHECK_EQ(consumed, base.size() + 11, "rfc3339 consumed " + text);
+
+            // Same instant written in a +05:30 zone
+            if (seconds >= 19800) {
+                const std::string zoned = strftime_utc(seconds + 19800, "%Y-%m-%dT%H:%M:%S") + "+05:30";
+                CHECK_EQ(TimeUtils::parse_rfc3339(zoned), seconds * NS, "rfc3339 zone " + zoned);
+            }
+        }
+    }
+
+    void test_rfc3164_random(std::mt19937_64& rng) {
+        for (size_t i = 0; i < RANDOM_CASES; ++i) {
+            // Event up to ~300 days before "now"; same year or the previous one
+            const uint64_t now = 86400ull * 400 + rng() % (MAX_SECONDS - 86400ull * 400);
+            const uint64_t seconds = now - rng() % (86400ull * 300);
+
+            const std::time_t t = static_cast<std::time_t>(seconds);
+            std::tm tm{};
+            gmtime_r(&t, &tm);
+            const std::string text = strftime_utc(seconds, "%b %e %H:%M:%S");  // Space-padded day
+
+            CHECK_EQ(TimeUtils::parse_rfc3164(text, now * NS), seconds * NS, "rfc3164 " + text);
+        }
+    }
+
+    void test_fixed_cases() {
+        // 2024-03-01T12:00:00Z = 1709294400
+        constexpr uint64_t MARCH_1 = 1709294400ull * NS;
+
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-03-01T12:00:00Z"), MARCH_1, "rfc3339 basic");
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-03-01 12:00:00z"), MARCH_1, "rfc3339 space, lower z");
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-03-01t13:00:00+01:00"), MARCH_1, "rfc3339 positive offset");
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-03-01T11:00:00-01:00"), MARCH_1, "rfc3339 negative offset");
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-03-01T12:00:00.1234567891234Z"), MARCH_1 + 123456789,
+                 "rfc3339 extra fraction digits");
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-02-29T00:00:00Z"), (1709294400ull - 86400 - 43200) * NS,
+                 "rfc3339 leap day");
+
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-03-01T12:00:00"), 0ull, "rfc3339 missing zone");
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-13-01T12:00:00Z"), 0ull, "rfc3339 month 13");
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-03-01T24:00:00Z"), 0ull, "rfc3339 hour 24");
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-03-01T12:00:00.Z"), 0ull, "rfc3339 empty fraction");
+        CHECK_EQ(TimeUtils::parse_rfc3339("2024-03-01T12:00:00+0100"), 0ull, "rfc3339 offset without colon");
+        CHECK_EQ(TimeUtils::parse_rfc3339("not a timestamp at all"), 0ull, "rfc3339 garbage");
+
+        // Year inference: "now" is 2024-03-01 12:00
+        CHECK_EQ(TimeUtils::parse_rfc3164("Mar  1 12:00:00", MARCH_1), MARCH_1, "rfc3164 padded day");
+        CHECK_EQ(TimeUtils::parse_rfc3164("Mar 1 12:00:00", MARCH_1), MARCH_1, "rfc3164 unpadded day");
+        CHECK_EQ(TimeUtils::parse_rfc3164("Mar 03 12:00:00", MARCH_1), MARCH_1 + 2 * 86400 * NS,
+                 "rfc3164 two days ahead stays in this year");
+        CHECK_EQ(TimeUtils::parse_rfc3164("Dec 31 23:59:59", MARCH_1),
+                 (TimeUtils::days_from_civil(2023, 12, 31) * 86400ull + 86399) * NS,
+                 "rfc3164 December read in March is last year");
+
+        CHECK_EQ(TimeUtils::parse_rfc3164("Foo  1 12:00:00", MARCH_1), 0ull, "rfc3164 bad month");
+        CHECK_EQ(TimeUtils::parse_rfc3164("Mar 32 12:00:00", MARCH_1), 0ull, "rfc3164 day 32");
+        CHECK_EQ(TimeUtils::parse_rfc3164("Mar  1 12:60:00", MARCH_1), 0ull, "rfc3164 minute 60");
+        CHECK_EQ(TimeUtils::parse_rfc3164("Mar  1", MARCH_1), 0ull, "rfc3164 truncated");
+
+        CHECK_EQ(TimeUtils::days_from_civil(1970, 1, 1), 0ll, "epoch day");
+        CHECK_EQ(TimeUtils::days_from_civil(2000, 3, 1), 11017ll, "2000-03-01");
+    }
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(20240301);
+
+    test_fixed_cases();
+    test_formatters(rng);
+    test_rfc3339_random(rng);
+    test_rfc3164_random(rng);
+
+    if (g_failures > 0) {
+        std::printf("test_parser: %d failures\n", g_failures);
+        return 1;
+    }
+    std::printf("test_parser: OK\n");
+    return 0;
+}
@@ -21,9 +21,16 @@ CREATE TABLE IF NOT EXISTS sentry.logs
 
     -- 5. AI Enrichment
     anomaly_score Float32 CODEC(Gorilla), -- Gorilla codec is great for floats
-    is_threat UInt8
+    is_threat UInt8,
+
+    -- 6. Overload Sampling (rows kept 1 in N stand for N events:
+    --    use sum(sample_weight) instead of count() for volumes)
+    sample_weight UInt32 DEFAULT 1 CODEC(T64, ZSTD(1))
 )
 ENGINE = MergeTree()
 PARTITION BY toYYYYMMDD(timestamp) -- Daily partitions
 ORDER BY (timestamp, service, host) -- Sort key for fast retrieval
-TTL timestamp + INTERVAL 30 DAY;   -- Auto-delete data older than 30 days
\ No newline at end of file
+TTL timestamp + INTERVAL 30 DAY;   -- Auto-delete data older than 30 days
+
+-- Upgrade path for tables created before sample_weight existed
+ALTER TABLE sentry.logs ADD COLUMN IF NOT EXISTS sample_weight UInt32 DEFAULT 1 CODEC(T64, ZSTD(1));